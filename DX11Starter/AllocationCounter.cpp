@@ -0,0 +1,208 @@
+// -----------------------------------------------
+// Include statements.
+// -----------------------------------------------
+#include "AllocationCounter.h"
+#include <cstdlib>
+#include <new>
+
+#ifdef _MSC_VER
+#include <malloc.h>
+#endif
+
+// -----------------------------------------------
+// Data members.
+// -----------------------------------------------
+
+// Plain integers, so counting needs no initialization
+// (operator new may run before anything else has).
+static thread_local unsigned long long allocationCount = 0;
+static thread_local unsigned long long allocationBytes = 0;
+
+// -----------------------------------------------
+// Static methods.
+// -----------------------------------------------
+
+/// <summary>
+/// Were operator new and delete replaced in this build?
+/// If not, the counts are always zero.
+/// </summary>
+bool AllocationCounter::IsCounting()
+{
+	return COUNT_ALLOCATIONS != 0;
+}
+
+/// <summary>
+/// Number of allocations the calling thread has made.
+/// </summary>
+unsigned long long AllocationCounter::GetCount()
+{
+	return allocationCount;
+}
+
+/// <summary>
+/// Number of bytes the calling thread has allocated.
+/// </summary>
+unsigned long long AllocationCounter::GetBytes()
+{
+	return allocationBytes;
+}
+
+/// <summary>
+/// Count one allocation on the calling thread.
+/// </summary>
+/// <param name="bytes">Size asked for.</param>
+void AllocationCounter::Record(size_t bytes)
+{
+	allocationCount++;
+	allocationBytes += bytes;
+}
+
+// -----------------------------------------------
+// Replacement operators.
+// ---
+// Only in builds with COUNT_ALLOCATIONS=1. The
+// aligned ones exist when the compiler does C++17
+// aligned new; without it over-aligned types go
+// through the plain operator new anyway.
+// -----------------------------------------------
+
+#if COUNT_ALLOCATIONS
+
+/// <summary>
+/// Counts the allocation, then takes the memory from malloc.
+/// </summary>
+void* operator new(size_t size)
+{
+	AllocationCounter::Record(size);
+	void* memory = std::malloc(size > 0 ? size : 1);
+	if (!memory)
+		throw std::bad_alloc();
+	return memory;
+}
+
+/// <summary>
+/// Arrays are counted the same way.
+/// </summary>
+void* operator new[](size_t size)
+{
+	return operator new(size);
+}
+
+/// <summary>
+/// Returns memory from operator new to malloc.
+/// </summary>
+void operator delete(void* memory) noexcept
+{
+	std::free(memory);
+}
+
+/// <summary>
+/// Returns memory from operator new[] to malloc.
+/// </summary>
+void operator delete[](void* memory) noexcept
+{
+	std::free(memory);
+}
+
+/// <summary>
+/// Sized delete (C++14); the size isn't needed.
+/// </summary>
+void operator delete(void* memory, size_t) noexcept
+{
+	std::free(memory);
+}
+
+/// <summary>
+/// Sized array delete (C++14); the size isn't needed.
+/// </summary>
+void operator delete[](void* memory, size_t) noexcept
+{
+	std::free(memory);
+}
+
+#ifdef __cpp_aligned_new
+
+/// <summary>
+/// Takes aligned memory from the C runtime: _aligned_malloc
+/// with MSVC (its memory has to go back to _aligned_free),
+/// aligned_alloc elsewhere (which wants a whole number of
+/// alignments).
+/// </summary>
+static void* AlignedAllocate(size_t size, size_t alignment)
+{
+#ifdef _MSC_VER
+	return _aligned_malloc(size > 0 ? size : 1, alignment);
+#else
+	size_t rounded = (size + alignment - 1) / alignment * alignment;
+	return std::aligned_alloc(alignment, rounded > 0 ? rounded : alignment);
+#endif
+}
+
+/// <summary>
+/// Returns memory from AlignedAllocate().
+/// </summary>
+static void AlignedFree(void* memory)
+{
+#ifdef _MSC_VER
+	_aligned_free(memory);
+#else
+	std::free(memory);
+#endif
+}
+
+/// <summary>
+/// Counts the allocation, then takes aligned memory
+/// from the C runtime.
+/// </summary>
+void* operator new(size_t size, std::align_val_t alignment)
+{
+	AllocationCounter::Record(size);
+	void* memory = AlignedAllocate(size, static_cast<size_t>(alignment));
+	if (!memory)
+		throw std::bad_alloc();
+	return memory;
+}
+
+/// <summary>
+/// Aligned arrays are counted the same way.
+/// </summary>
+void* operator new[](size_t size, std::align_val_t alignment)
+{
+	return operator new(size, alignment);
+}
+
+/// <summary>
+/// Returns memory from aligned operator new.
+/// </summary>
+void operator delete(void* memory, std::align_val_t) noexcept
+{
+	AlignedFree(memory);
+}
+
+/// <summary>
+/// Returns memory from aligned operator new[].
+/// </summary>
+void operator delete[](void* memory, std::align_val_t) noexcept
+{
+	AlignedFree(memory);
+}
+
+/// <summary>
+/// Sized aligned delete; the size isn't needed.
+/// </summary>
+void operator delete(void* memory, size_t, std::align_val_t) noexcept
+{
+	AlignedFree(memory);
+}
+
+/// <summary>
+/// Sized aligned array delete; the size isn't needed.
+/// </summary>
+void operator delete[](void* memory, size_t, std::align_val_t) noexcept
+{
+	AlignedFree(memory);
+}
+
+#endif
+
+#endif
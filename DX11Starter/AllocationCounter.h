@@ -0,0 +1,56 @@
+#pragma once
+
+// -----------------------------------------------
+// Include statements.
+// -----------------------------------------------
+#include <cstddef>
+
+// -----------------------------------------------
+// AllocationCounter.h
+// ---
+// Counts heap allocations made through operator
+// new, per thread. When COUNT_ALLOCATIONS is 1,
+// the program's operator new and delete (aligned
+// ones too) are replaced in AllocationCounter.cpp
+// with versions that count and then forward to
+// the C runtime. Otherwise nothing is replaced
+// and the counts stay at zero.
+//
+// Take a count before and after a piece of code
+// on the same thread to see how many allocations
+// it made, e.g. to check that a per-draw path
+// makes none.
+// -----------------------------------------------
+
+// -----------------------------------------------
+// Build flag.
+// ---
+// Define COUNT_ALLOCATIONS=1 in the project
+// settings for a benchmark build. Off by default,
+// so the game keeps the runtime's (debug) heap.
+// -----------------------------------------------
+
+#ifndef COUNT_ALLOCATIONS
+#define COUNT_ALLOCATIONS 0
+#endif
+
+class AllocationCounter
+{
+public:
+	// -----------------------------------------------
+	// Static methods.
+	// -----------------------------------------------
+
+	static bool IsCounting();				// Were operator new/delete replaced in this build?
+	static unsigned long long GetCount();	// Allocations made by the calling thread so far.
+	static unsigned long long GetBytes();	// Bytes those allocations asked for.
+	static void Record(size_t bytes);		// Called by operator new.
+
+private:
+
+	// -----------------------------------------------
+	// Constructors.
+	// -----------------------------------------------
+
+	AllocationCounter() = delete;
+};
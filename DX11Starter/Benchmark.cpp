@@ -0,0 +1,1780 @@
+// -----------------------------------------------
+// Include statements.
+// -----------------------------------------------
+#include "Benchmark.h"
+#include "AllocationCounter.h"
+#include "Camera.h"
+#include "Check.h"
+#include "CommandBuffer.h"
+#include "FrameGraph.h"
+#include "FrustumCuller.h"
+#include "InstanceBuffer.h"
+#include "InputMap.h"
+#include "LodSelector.h"
+#include "OcclusionCuller.h"
+#include "PlatformTimer.h"
+#include "RenderCounters.h"
+#include "RenderBackend.h"
+#include "RenderQueue.h"
+#include "RenderStateCache.h"
+#include "RingAllocator.h"
+#include "ShaderConstants.h"
+#include "ShaderReflectionCache.h"
+#include "SimpleShader.h"
+#include "SoftwareRasterizer.h"
+#include "Vertex.h"
+#include "WorkerPool.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <random>
+
+// -----------------------------------------------
+// Registered benchmarks.
+// -----------------------------------------------
+
+const Benchmark::Entry Benchmark::entries[] =
+{
+	{ "render-queue", "Build and radix sort 100k draw keys", &Benchmark::RenderQueueSort },
+	{ "frustum-cull", "Cull 1M bounding spheres against the camera frustum", &Benchmark::FrustumCull },
+	{ "multi-view-cull", "Cull 1M bounding spheres against 5 views in one pass and in one pass per view", &Benchmark::MultiViewCull },
+	{ "occlusion-cull", "Rasterize 16 wall occluders and test 100k boxes behind them", &Benchmark::OcclusionCull },
+	{ "command-buffer", "Record 100k draws into command buffers and replay them", &Benchmark::CommandBufferRecord },
+	{ "state-cache", "Send 100k sorted draws through the render state cache to a counting mock backend", &Benchmark::StateCache },
+	{ "constant-ring", "Allocate per-draw constants from a ring over 1000 frames, checking for overlaps", &Benchmark::ConstantRing },
+	{ "frame-graph", "Build and compile a 64 pass frame graph, checking order and aliasing", &Benchmark::FrameGraphCompile },
+	{ "software-raster", "Draw and shade 600 cubes at 1280x720 on the CPU", &Benchmark::SoftwareRaster },
+	{ "lod-select", "Pick detail levels for 100k entities as the camera moves, with and without hysteresis", &Benchmark::LodSelect },
+	{ "render-counters", "Count 200k events per thread from every worker, checking the frame totals", &Benchmark::RenderCounterAdd },
+	{ "shader-handles", "Set per-draw shader variables 100k times by name and by handle, counting allocations", &Benchmark::ShaderHandles },
+	{ "constant-ranges", "Upload 100k draws of constants that mostly change in part, whole and by dirty range", &Benchmark::ConstantRanges },
+	{ "reflection-cache", "Write and read back cached reflections of 1000 synthetic shaders", &Benchmark::ReflectionCache },
+	{ "instancing", "Draw a rotated, moved triangle on WARP 1000 times per object and as 1000 instances, checking both images match", &Benchmark::InstancingMatch },
+	{ "input-map", "Resolve 100k frames of synthetic key events against 512 bindings", &Benchmark::InputMapUpdate },
+	{ nullptr, nullptr, nullptr }
+};
+
+// -----------------------------------------------
+// Static methods.
+// -----------------------------------------------
+
+/// <summary>
+/// Run one benchmark by name, or every benchmark for "all".
+/// </summary>
+/// <param name="name">Benchmark name.</param>
+/// <returns>Returns false if no benchmark has that name, or a check failed.</returns>
+bool Benchmark::Run(const std::string& name)
+{
+	unsigned int benchmarks = 0;
+	unsigned int failures = 0;
+	for (const Entry* entry = entries; entry->name; entry++)
+	{
+		if (name != "all" && name != entry->name)
+			continue;
+
+		printf("== %s: %s\n", entry->name, entry->description);
+		failures += entry->function() ? 0 : 1;
+		fflush(stdout);
+		benchmarks++;
+	}
+
+	if (benchmarks == 0)
+	{
+		printf("Unknown benchmark '%s'.\n", name.c_str());
+		List();
+		return false;
+	}
+
+	if (failures > 0)
+		printf("Benchmarks: checks FAILED in %u of %u\n", failures, benchmarks);
+	fflush(stdout);
+	return failures == 0;
+}
+
+/// <summary>
+/// Print the available benchmarks.
+/// </summary>
+void Benchmark::List()
+{
+	printf("Benchmarks (run with --benchmark NAME, or --benchmark all):\n");
+	for (const Entry* entry = entries; entry->name; entry++)
+		printf("  %-16s %s\n", entry->name, entry->description);
+	fflush(stdout);
+}
+
+// -----------------------------------------------
+// Benchmarks.
+// -----------------------------------------------
+
+/// <summary>
+/// Build a queue of 100k draws spread over 64 materials
+/// and 256 meshes, then sort it. std::sort on the same
+/// keys is timed as a baseline.
+/// </summary>
+bool Benchmark::RenderQueueSort()
+{
+	const unsigned int drawCount = 100000;
+	const unsigned int iterations = 200;
+	const float nearPlane = 0.1f;
+	const float farPlane = 100.0f;
+
+	// Fixed inputs, so runs are comparable.
+	std::mt19937 random(12345);
+	std::uniform_int_distribution<unsigned int> materials(0, 63);
+	std::uniform_int_distribution<unsigned int> meshes(0, 255);
+	std::uniform_real_distribution<float> depths(nearPlane, farPlane);
+
+	struct Draw { unsigned int material; unsigned int mesh; float depth; };
+	std::vector<Draw> draws(drawCount);
+	for (Draw& draw : draws)
+	{
+		draw.material = materials(random);
+		draw.mesh = meshes(random);
+		draw.depth = depths(random);
+	}
+
+	RenderQueue queue;
+	queue.Reserve(drawCount);
+	std::vector<RenderQueue::SortKey> baseline;
+	baseline.reserve(drawCount);
+
+	std::vector<float> buildTimes, sortTimes, baselineTimes;
+	bool sorted = true;
+
+	for (unsigned int i = 0; i < iterations; i++)
+	{
+		// Build.
+		PlatformTimer::Timestamp start = PlatformTimer::Now();
+		queue.Clear();
+		for (unsigned int d = 0; d < drawCount; d++)
+		{
+			const Draw& draw = draws[d];
+			unsigned int depth = RenderQueue::QuantizeDepth(draw.depth, nearPlane, farPlane);
+			queue.Submit(RenderQueue::MakeKey(RenderQueue::RP_OPAQUE, draw.material, draw.mesh, depth), d);
+		}
+		buildTimes.push_back(PlatformTimer::MillisecondsSince(start));
+
+		// Baseline copy of the unsorted keys.
+		baseline.clear();
+		for (const RenderQueue::Item& item : queue)
+			baseline.push_back(item.key);
+
+		// Radix sort.
+		start = PlatformTimer::Now();
+		queue.Sort();
+		sortTimes.push_back(PlatformTimer::MillisecondsSince(start));
+
+		// Comparison sort.
+		start = PlatformTimer::Now();
+		std::sort(baseline.begin(), baseline.end());
+		baselineTimes.push_back(PlatformTimer::MillisecondsSince(start));
+
+		for (size_t k = 1; k < queue.GetCount() && sorted; k++)
+			sorted = queue[k - 1].key <= queue[k].key;
+	}
+
+	Report("build", buildTimes);
+	Report("radix sort", sortTimes);
+	Report("std::sort", baselineTimes);
+	printf("  %u draws x %u iterations, output %s\n", drawCount, iterations, sorted ? "sorted" : "NOT SORTED");
+	return sorted;
+}
+
+/// <summary>
+/// Scatter 1M bounding spheres through a cube around the
+/// default camera and cull them against its frustum, with
+/// SSE and one sphere at a time. Filling the culler is
+/// timed too, since the game refills it every frame.
+/// </summary>
+bool Benchmark::FrustumCull()
+{
+	const unsigned int sphereCount = 1000000;
+	const unsigned int iterations = 50;
+
+	// Fixed inputs, so runs are comparable.
+	std::mt19937 random(12345);
+	std::uniform_real_distribution<float> positions(-100.0f, 100.0f);
+	std::uniform_real_distribution<float> radii(0.1f, 2.0f);
+
+	std::vector<DirectX::XMFLOAT4> spheres(sphereCount);
+	for (DirectX::XMFLOAT4& sphere : spheres)
+		sphere = DirectX::XMFLOAT4(positions(random), positions(random), positions(random), radii(random));
+
+	Camera camera = Camera::GetDefaultCamera();
+	FrustumCuller::Planes planes = camera.GetFrustumPlanes();
+
+	FrustumCuller culler;
+	culler.Reserve(sphereCount);
+	std::vector<unsigned int> simdVisible;
+
+	std::vector<float> fillTimes, simdTimes, scalarTimes;
+	bool match = true;
+
+	for (unsigned int i = 0; i < iterations; i++)
+	{
+		// Fill.
+		PlatformTimer::Timestamp start = PlatformTimer::Now();
+		culler.Clear();
+		for (const DirectX::XMFLOAT4& sphere : spheres)
+			culler.Add(sphere);
+		fillTimes.push_back(PlatformTimer::MillisecondsSince(start));
+
+		// SIMD.
+		start = PlatformTimer::Now();
+		culler.Cull(planes);
+		simdTimes.push_back(PlatformTimer::MillisecondsSince(start));
+		simdVisible = culler.GetVisible();
+
+		// Scalar.
+		start = PlatformTimer::Now();
+		culler.CullScalar(planes);
+		scalarTimes.push_back(PlatformTimer::MillisecondsSince(start));
+
+		match = match && simdVisible == culler.GetVisible();
+	}
+
+	Report("fill", fillTimes);
+	Report("simd cull", simdTimes);
+	Report("scalar cull", scalarTimes);
+	printf("  %u spheres x %u iterations, %u visible (%.2f%%), results %s\n",
+		sphereCount, iterations, (unsigned int)simdVisible.size(),
+		100.0 * simdVisible.size() / sphereCount, match ? "match" : "DIFFER");
+	return match;
+}
+
+/// <summary>
+/// Cull 1M spheres against five views: the default camera,
+/// three depth slices of it (standing in for shadow cascades)
+/// and a second player looking the other way. Once with one
+/// CullViews() pass and once with a Cull() per view, checking
+/// that each view's bits match its own cull.
+/// </summary>
+bool Benchmark::MultiViewCull()
+{
+	const unsigned int sphereCount = 1000000;
+	const unsigned int iterations = 50;
+
+	std::mt19937 random(12345);
+	std::uniform_real_distribution<float> positions(-100.0f, 100.0f);
+	std::uniform_real_distribution<float> radii(0.1f, 2.0f);
+
+	FrustumCuller culler;
+	culler.Reserve(sphereCount);
+	for (unsigned int i = 0; i < sphereCount; i++)
+		culler.Add(DirectX::XMFLOAT4(positions(random), positions(random), positions(random), radii(random)));
+
+	std::vector<FrustumCuller::Planes> views;
+	Camera camera = Camera::GetDefaultCamera();
+	views.push_back(camera.GetFrustumPlanes());
+
+	const float splits[4] = { 0.1f, 15.0f, 40.0f, 100.0f };
+	for (unsigned int c = 0; c < 3; c++)
+	{
+		Camera cascade = Camera::GetDefaultCamera();
+		cascade.SetClippingPlane(splits[c], splits[c + 1]);
+		cascade.Update();
+		views.push_back(cascade.GetFrustumPlanes());
+	}
+
+	Camera second = Camera::GetDefaultCamera();
+	second.UpdateRotation(DirectX::XMFLOAT3(3.14159265f, 0.0f, 0.0f), false);
+	second.Update();
+	views.push_back(second.GetFrustumPlanes());
+
+	const unsigned int viewCount = (unsigned int)views.size();
+	std::vector<unsigned int> masks;
+	std::vector<size_t> viewVisible(viewCount, 0);
+	std::vector<float> onePassTimes, perViewTimes;
+	bool match = true;
+
+	for (unsigned int i = 0; i < iterations; i++)
+	{
+		PlatformTimer::Timestamp start = PlatformTimer::Now();
+		culler.CullViews(views);
+		onePassTimes.push_back(PlatformTimer::MillisecondsSince(start));
+		masks = culler.GetViewMasks();
+
+		float perView = 0.0f;
+		for (unsigned int v = 0; v < viewCount; v++)
+		{
+			start = PlatformTimer::Now();
+			culler.Cull(views[v]);
+			perView += PlatformTimer::MillisecondsSince(start);
+
+			// Every sphere Cull() kept has bit v, and no others do.
+			viewVisible[v] = culler.GetVisibleCount();
+			size_t kept = 0, withBit = 0;
+			for (unsigned int index : culler.GetVisible())
+				kept += (masks[index] >> v) & 1;
+			for (unsigned int mask : masks)
+				withBit += (mask >> v) & 1;
+			match = match && kept == viewVisible[v] && withBit == kept;
+		}
+		perViewTimes.push_back(perView);
+	}
+
+	Report("one pass", onePassTimes);
+	Report("pass per view", perViewTimes);
+	printf("  %u spheres x %u views x %u iterations, visible per view:", sphereCount, viewCount, iterations);
+	for (size_t visibleCount : viewVisible)
+		printf(" %u", (unsigned int)visibleCount);
+	printf(", results %s\n", match ? "match" : "DIFFER");
+	return match;
+}
+
+/// <summary>
+/// Put a row of 16 box walls in front of the camera and
+/// 100k small boxes scattered behind and around them, then
+/// rasterize the walls and test every box. Runs once on the
+/// calling thread only and once with the worker pool.
+/// </summary>
+bool Benchmark::OcclusionCull()
+{
+	using namespace DirectX;
+
+	const unsigned int wallCount = 16;
+	const unsigned int boxCount = 100000;
+	const unsigned int iterations = 100;
+
+	// A unit cube, 12 triangles.
+	const XMFLOAT3 cube[8] = {
+		XMFLOAT3(-0.5f, -0.5f, -0.5f), XMFLOAT3(0.5f, -0.5f, -0.5f), XMFLOAT3(0.5f, 0.5f, -0.5f), XMFLOAT3(-0.5f, 0.5f, -0.5f),
+		XMFLOAT3(-0.5f, -0.5f, 0.5f), XMFLOAT3(0.5f, -0.5f, 0.5f), XMFLOAT3(0.5f, 0.5f, 0.5f), XMFLOAT3(-0.5f, 0.5f, 0.5f)
+	};
+	const unsigned int cubeIndices[36] = {
+		0, 2, 1, 0, 3, 2,	4, 5, 6, 4, 6, 7,	0, 1, 5, 0, 5, 4,
+		3, 6, 2, 3, 7, 6,	0, 4, 7, 0, 7, 3,	1, 2, 6, 1, 6, 5
+	};
+
+	// Walls 20 units ahead, side by side with small gaps.
+	std::vector<XMFLOAT4X4> walls(wallCount);
+	for (unsigned int w = 0; w < wallCount; w++)
+	{
+		float x = ((float)w - (wallCount - 1) * 0.5f) * 2.2f;
+		XMStoreFloat4x4(&walls[w], XMMatrixMultiply(XMMatrixScaling(2.0f, 6.0f, 0.5f), XMMatrixTranslation(x, 0.0f, 20.0f)));
+	}
+
+	// Boxes from just in front of the walls to far behind them.
+	std::mt19937 random(12345);
+	std::uniform_real_distribution<float> across(-40.0f, 40.0f);
+	std::uniform_real_distribution<float> height(-8.0f, 8.0f);
+	std::uniform_real_distribution<float> distance(15.0f, 90.0f);
+
+	std::vector<XMFLOAT3> boxes(boxCount);
+	for (XMFLOAT3& box : boxes)
+		box = XMFLOAT3(across(random), height(random), distance(random));
+
+	Camera camera = Camera::GetDefaultCamera();
+	XMMATRIX viewProjection = XMMatrixTranspose(XMLoadFloat4x4(&camera.GetViewProjectionMatrix()));
+
+	// Once on the calling thread alone, once with the worker pool.
+	const unsigned int threadCounts[2] = { 0, WorkerPool::DEFAULT_THREADS };
+	for (unsigned int threads : threadCounts)
+	{
+		OcclusionCuller culler(threads);
+		std::vector<float> rasterTimes, testTimes;
+		unsigned int occluded = 0;
+
+		for (unsigned int i = 0; i < iterations; i++)
+		{
+			PlatformTimer::Timestamp start = PlatformTimer::Now();
+			culler.Begin(viewProjection);
+			for (const XMFLOAT4X4& wall : walls)
+				culler.AddOccluder(cube, cubeIndices, 36, XMLoadFloat4x4(&wall));
+			culler.Rasterize();
+			rasterTimes.push_back(PlatformTimer::MillisecondsSince(start));
+
+			start = PlatformTimer::Now();
+			occluded = 0;
+			for (const XMFLOAT3& box : boxes)
+			{
+				XMFLOAT3 boxMin(box.x - 0.5f, box.y - 0.5f, box.z - 0.5f);
+				XMFLOAT3 boxMax(box.x + 0.5f, box.y + 0.5f, box.z + 0.5f);
+				occluded += culler.IsVisible(boxMin, boxMax) ? 0 : 1;
+			}
+			testTimes.push_back(PlatformTimer::MillisecondsSince(start));
+		}
+
+		printf("  %u worker thread(s):\n", culler.GetThreadCount());
+		Report("rasterize", rasterTimes);
+		Report("test", testTimes);
+		printf("  %u walls (%u triangles), %u boxes, %u occluded (%.2f%%)\n",
+			wallCount, culler.GetStatistics().triangles, boxCount, occluded, 100.0 * occluded / boxCount);
+	}
+	return true;
+}
+
+/// <summary>
+/// Record 100k draws (shaders, buffers, 64 bytes of
+/// constants and the draw itself) into command buffers,
+/// once on the calling thread and once split across the
+/// worker pool, then validate them and replay them into
+/// the null backend. The recorded pointers are never
+/// dereferenced, so made-up handles are fine.
+/// </summary>
+bool Benchmark::CommandBufferRecord()
+{
+	const unsigned int drawCount = 100000;
+	const unsigned int iterations = 50;
+
+	struct Draw
+	{
+		uintptr_t material;
+		uintptr_t mesh;
+		float constants[16];
+	};
+
+	std::mt19937 random(12345);
+	std::uniform_int_distribution<unsigned int> materials(1, 64);
+	std::uniform_int_distribution<unsigned int> meshes(1, 256);
+	std::vector<Draw> draws(drawCount);
+	for (unsigned int i = 0; i < drawCount; i++)
+	{
+		draws[i].material = materials(random);
+		draws[i].mesh = meshes(random);
+		for (unsigned int k = 0; k < 16; k++)
+			draws[i].constants[k] = (float)(i + k);
+	}
+
+	// Records draws [begin, end) the way Game::DrawEntity does.
+	auto record = [&draws](CommandBuffer* commands, size_t begin, size_t end)
+	{
+		ID3D11Buffer* constants = reinterpret_cast<ID3D11Buffer*>((uintptr_t)0x1000);
+		for (size_t i = begin; i < end; i++)
+		{
+			const Draw& draw = draws[i];
+			commands->SetVertexShader(reinterpret_cast<ID3D11VertexShader*>(draw.material << 4));
+			commands->SetPixelShader(reinterpret_cast<ID3D11PixelShader*>(draw.material << 4));
+			commands->UpdateConstantBuffer(constants, draw.constants, sizeof(draw.constants));
+			commands->SetVSConstantBuffer(1, constants);
+			commands->SetVertexBuffer(reinterpret_cast<ID3D11Buffer*>(draw.mesh << 8), 32, 0);
+			commands->SetIndexBuffer(reinterpret_cast<ID3D11Buffer*>((draw.mesh << 8) | 0x80), DXGI_FORMAT_R32_UINT, 0);
+			commands->DrawIndexed(36, 0, 0);
+		}
+	};
+
+	// Once on the calling thread alone, once with the worker pool.
+	const unsigned int threadCounts[2] = { 0, WorkerPool::DEFAULT_THREADS };
+	bool allValid = true;
+	for (unsigned int threads : threadCounts)
+	{
+		WorkerPool workers(threads);
+		unsigned int chunks = workers.GetThreadCount() + 1;
+		std::vector<std::unique_ptr<CommandBuffer>> buffers;
+		for (unsigned int c = 0; c < chunks; c++)
+			buffers.push_back(std::unique_ptr<CommandBuffer>(new CommandBuffer()));
+
+		NullRenderBackend target;
+		std::vector<float> recordTimes, replayTimes;
+
+		for (unsigned int i = 0; i < iterations; i++)
+		{
+			PlatformTimer::Timestamp start = PlatformTimer::Now();
+			workers.Run(chunks, [&](unsigned int chunk)
+			{
+				buffers[chunk]->Reset();
+				record(buffers[chunk].get(), (size_t)drawCount * chunk / chunks, (size_t)drawCount * (chunk + 1) / chunks);
+			});
+			recordTimes.push_back(PlatformTimer::MillisecondsSince(start));
+
+			target.ResetStatistics();
+			start = PlatformTimer::Now();
+			for (const std::unique_ptr<CommandBuffer>& commands : buffers)
+				commands->Execute(&target);
+			replayTimes.push_back(PlatformTimer::MillisecondsSince(start));
+		}
+
+		size_t bytes = 0;
+		unsigned int commandCount = 0;
+		std::string error;
+		bool valid = true;
+		for (const std::unique_ptr<CommandBuffer>& commands : buffers)
+		{
+			bytes += commands->GetSize();
+			commandCount += commands->GetCommandCount();
+			valid = valid && commands->Validate(&error);
+		}
+
+		printf("  %u worker thread(s), %u command buffer(s):\n", workers.GetThreadCount(), chunks);
+		Report("record", recordTimes);
+		Report("replay", replayTimes);
+		printf("  %u commands, %.2f MB (%.1f bytes per draw), %llu draws replayed, %s\n",
+			commandCount, bytes / (1024.0 * 1024.0), (double)bytes / drawCount,
+			target.GetStatistics().draws, valid ? "valid" : error.c_str());
+		allValid = allValid && valid && target.GetStatistics().draws == drawCount;
+	}
+	return allValid;
+}
+
+/// <summary>
+/// Send 100k draws, sorted by material and mesh as the render
+/// queue leaves them, through a RenderStateCache to a mock
+/// backend that counts every state call reaching it. Checks
+/// the cache issues exactly the calls that change something
+/// and that the mock sees the same, that a bind after
+/// WriteVSConstants() to its slot is issued (the slot may
+/// hold a ring slice), and that Invalidate()
+/// lets the same binds through again. Times the stream with
+/// and without the cache in front.
+/// </summary>
+bool Benchmark::StateCache()
+{
+	typedef RenderStateTracker Tracker;
+
+	const unsigned int drawCount = 100000;
+	const unsigned int iterations = 50;
+
+	// Counts each kind of state call, and does nothing else.
+	class CountingBackend : public IRenderBackend
+	{
+	public:
+		unsigned long long calls[Tracker::SC_COUNT] = {};
+
+		void Clear(ID3D11RenderTargetView*, ID3D11DepthStencilView*, const float[4]) {}
+		void SetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY) { calls[Tracker::SC_TOPOLOGY]++; }
+		void SetInputLayout(ID3D11InputLayout*) { calls[Tracker::SC_INPUT_LAYOUT]++; }
+		void SetVertexShader(ID3D11VertexShader*) { calls[Tracker::SC_VERTEX_SHADER]++; }
+		void SetPixelShader(ID3D11PixelShader*) { calls[Tracker::SC_PIXEL_SHADER]++; }
+		void SetVSConstantBuffer(unsigned int, ID3D11Buffer*) { calls[Tracker::SC_VS_CONSTANT_BUFFER]++; }
+		void SetPSConstantBuffer(unsigned int, ID3D11Buffer*) { calls[Tracker::SC_PS_CONSTANT_BUFFER]++; }
+		void SetVertexBuffer(ID3D11Buffer*, unsigned int, unsigned int) { calls[Tracker::SC_VERTEX_BUFFER]++; }
+		void SetIndexBuffer(ID3D11Buffer*, DXGI_FORMAT, unsigned int) { calls[Tracker::SC_INDEX_BUFFER]++; }
+		void DrawIndexed(unsigned int, unsigned int, int) { stats.draws++; }
+		void SetInstanceBuffer(ID3D11Buffer*, unsigned int, unsigned int) { calls[Tracker::SC_INSTANCE_BUFFER]++; }
+		void DrawIndexedInstanced(unsigned int, unsigned int, unsigned int, int, unsigned int) { stats.instancedDraws++; }
+		void UpdateDynamicBuffer(ID3D11Buffer*, const void*, unsigned int) {}
+		void UpdateConstantBuffer(ID3D11Buffer*, const void*, unsigned int) {}
+		void WriteVSConstants(unsigned int, ID3D11Buffer*, const void*, unsigned int) {}
+		HRESULT Present(unsigned int, unsigned int) { return S_OK; }
+		bool IsNull() const { return true; }
+	};
+
+	struct Draw { uintptr_t material; uintptr_t mesh; };
+	std::mt19937 random(12345);
+	std::uniform_int_distribution<unsigned int> materials(1, 64);
+	std::uniform_int_distribution<unsigned int> meshes(1, 256);
+	std::vector<Draw> draws(drawCount);
+	for (Draw& draw : draws)
+	{
+		draw.material = materials(random);
+		draw.mesh = meshes(random);
+	}
+	std::sort(draws.begin(), draws.end(), [](const Draw& a, const Draw& b)
+	{
+		return (a.material != b.material) ? a.material < b.material : a.mesh < b.mesh;
+	});
+
+	// The binds Game::DrawEntity makes for each draw. Objects are
+	// made up addresses, only ever compared. Materials share
+	// one of four input layouts.
+	ID3D11Buffer* perFrame = reinterpret_cast<ID3D11Buffer*>((uintptr_t)0x1000);
+	ID3D11Buffer* perObject = reinterpret_cast<ID3D11Buffer*>((uintptr_t)0x2000);
+	auto bind = [&](IRenderBackend* backend, const Draw& draw)
+	{
+		backend->SetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+		backend->SetInputLayout(reinterpret_cast<ID3D11InputLayout*>((draw.material % 4 + 1) << 4));
+		backend->SetVertexShader(reinterpret_cast<ID3D11VertexShader*>(draw.material << 8));
+		backend->SetPixelShader(reinterpret_cast<ID3D11PixelShader*>(draw.material << 8));
+		backend->SetVSConstantBuffer(0, perFrame);
+		backend->SetVSConstantBuffer(1, perObject);
+		backend->SetPSConstantBuffer(0, perFrame);
+		backend->SetVertexBuffer(reinterpret_cast<ID3D11Buffer*>(draw.mesh << 16), 32, 0);
+		backend->SetIndexBuffer(reinterpret_cast<ID3D11Buffer*>((draw.mesh << 16) | 0x100), DXGI_FORMAT_R32_UINT, 0);
+	};
+	auto submit = [&](IRenderBackend* backend)
+	{
+		for (const Draw& draw : draws)
+		{
+			bind(backend, draw);
+			backend->DrawIndexed(36, 0, 0);
+		}
+	};
+
+	// What should get through: the first of each bind, then
+	// only changes (the constant buffers never change).
+	unsigned long long expected[Tracker::SC_COUNT] = {};
+	expected[Tracker::SC_TOPOLOGY] = 1;
+	expected[Tracker::SC_VS_CONSTANT_BUFFER] = 2;
+	expected[Tracker::SC_PS_CONSTANT_BUFFER] = 1;
+	for (size_t i = 0; i < draws.size(); i++)
+	{
+		bool first = (i == 0);
+		bool newMaterial = first || draws[i].material != draws[i - 1].material;
+		bool newLayout = first || draws[i].material % 4 != draws[i - 1].material % 4;
+		bool newMesh = newMaterial || draws[i].mesh != draws[i - 1].mesh;
+		expected[Tracker::SC_INPUT_LAYOUT] += newLayout ? 1 : 0;
+		expected[Tracker::SC_VERTEX_SHADER] += newMaterial ? 1 : 0;
+		expected[Tracker::SC_PIXEL_SHADER] += newMaterial ? 1 : 0;
+		expected[Tracker::SC_VERTEX_BUFFER] += newMesh ? 1 : 0;
+		expected[Tracker::SC_INDEX_BUFFER] += newMesh ? 1 : 0;
+	}
+
+	// Each frame starts from unknown state, as after ClearState().
+	CountingBackend* mock = new CountingBackend();
+	RenderStateCache cache(mock);
+	std::vector<float> cachedTimes, directTimes;
+	bool counted = true;
+	for (unsigned int it = 0; it < iterations; it++)
+	{
+		CountingBackend direct;
+		PlatformTimer::Timestamp start = PlatformTimer::Now();
+		submit(&direct);
+		directTimes.push_back(PlatformTimer::MillisecondsSince(start));
+
+		*mock = CountingBackend();
+		cache.ResetStatistics();
+		cache.Invalidate();
+		start = PlatformTimer::Now();
+		submit(&cache);
+		cachedTimes.push_back(PlatformTimer::MillisecondsSince(start));
+
+		const Tracker::Counters& counters = cache.GetCounters();
+		for (int call = 0; call < Tracker::SC_COUNT; call++)
+		{
+			counted = counted && counters.issued[call] == expected[call] && mock->calls[call] == expected[call]
+				&& counters.issued[call] + counters.skipped[call] == direct.calls[call];
+		}
+		counted = counted && mock->GetStatistics().draws == drawCount;
+	}
+
+	// A slot written per draw may hold a ring slice rather than
+	// the buffer, so the next bind of the buffer goes through.
+	*mock = CountingBackend();
+	cache.SetVSConstantBuffer(2, perObject);
+	cache.WriteVSConstants(2, perObject, nullptr, 0);
+	cache.SetVSConstantBuffer(2, perObject);
+	bool written = mock->calls[Tracker::SC_VS_CONSTANT_BUFFER] == 2;
+
+	// Binding the same state again is skipped until the cache
+	// is told something else may have changed it.
+	*mock = CountingBackend();
+	cache.ResetCounters();
+	bind(&cache, draws.back());
+	bool repeated = true;
+	for (int call = 0; call < Tracker::SC_COUNT; call++)
+		repeated = repeated && mock->calls[call] == 0 && cache.GetCounters().issued[call] == 0;
+
+	cache.Invalidate();
+	cache.SetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+	cache.SetVSConstantBuffer(0, perFrame);
+	cache.SetVertexBuffer(reinterpret_cast<ID3D11Buffer*>(draws.back().mesh << 16), 32, 0);
+	bool invalidated = mock->calls[Tracker::SC_TOPOLOGY] == 1 && mock->calls[Tracker::SC_VS_CONSTANT_BUFFER] == 1
+		&& mock->calls[Tracker::SC_VERTEX_BUFFER] == 1;
+
+	unsigned long long issued = 0, skipped = 0;
+	for (int call = 0; call < Tracker::SC_COUNT; call++)
+	{
+		issued += expected[call];
+		skipped += cache.GetCounters().skipped[call];
+	}
+
+	Report("direct", directTimes);
+	Report("cached", cachedTimes);
+	printf("  %llu of %u state calls per frame issued\n", issued, drawCount * 9);
+
+	bool passed = true;
+	CHECK(counted);
+	CHECK(written);
+	CHECK(repeated);
+	CHECK(invalidated);
+	return passed;
+}
+
+/// <summary>
+/// Run the constant ring's bookkeeping (no device) through
+/// 1000 frames of 2000 per-draw allocations, with the GPU
+/// two frames behind. Every 100th frame is much larger than
+/// the ring allows, to force a discard. A second pass marks
+/// which frame owns each 256 byte block and checks that no
+/// NO_OVERWRITE allocation lands on a block still in flight.
+/// </summary>
+bool Benchmark::ConstantRing()
+{
+	const unsigned int capacity = 4 * 1024 * 1024;
+	const unsigned int alignment = 256;
+	const unsigned int frameCount = 1000;
+	const unsigned int latency = 2;
+
+	// Same sizes for both passes.
+	std::mt19937 random(12345);
+	std::uniform_int_distribution<unsigned int> sizes(64, 512);
+	std::vector<std::vector<unsigned int>> frames(frameCount);
+	for (unsigned int f = 0; f < frameCount; f++)
+	{
+		frames[f].resize((f % 100 == 99) ? 20000 : 2000);
+		for (unsigned int& size : frames[f])
+			size = sizes(random);
+	}
+
+	// Timed pass.
+	RingAllocator ring(capacity, alignment);
+	std::vector<float> frameTimes;
+	for (unsigned int f = 0; f < frameCount; f++)
+	{
+		PlatformTimer::Timestamp start = PlatformTimer::Now();
+		unsigned int offset;
+		RingAllocator::RingMap map;
+		for (unsigned int size : frames[f])
+			ring.Allocate(size, &offset, &map);
+		ring.EndFrame(f + 1);
+		if (f + 1 > latency)
+			ring.Retire(f + 1 - latency);
+		frameTimes.push_back(PlatformTimer::MillisecondsSince(start));
+	}
+	const RingAllocator::Statistics timed = ring.GetStatistics();
+
+	// Checked pass - blockFence holds the fence of the frame that
+	// last wrote each block (0 if the ring was discarded since).
+	ring.Reset(capacity, alignment);
+	ring.ResetStatistics();
+	std::vector<unsigned long long> blockFence(capacity / alignment, 0);
+	unsigned long long completed = 0;
+	const char* problem = nullptr;
+	for (unsigned int f = 0; f < frameCount && !problem; f++)
+	{
+		unsigned long long fence = f + 1;
+		for (unsigned int size : frames[f])
+		{
+			unsigned int offset;
+			RingAllocator::RingMap map;
+			if (!ring.Allocate(size, &offset, &map))
+			{
+				problem = "allocation failed";
+				break;
+			}
+			if (offset % alignment != 0 || offset + size > capacity)
+			{
+				problem = "allocation misaligned or out of range";
+				break;
+			}
+
+			if (map == RingAllocator::RM_DISCARD)
+				std::fill(blockFence.begin(), blockFence.end(), 0);
+
+			unsigned int firstBlock = offset / alignment;
+			unsigned int lastBlock = (offset + size - 1) / alignment;
+			for (unsigned int b = firstBlock; b <= lastBlock; b++)
+			{
+				if (blockFence[b] > completed && blockFence[b] != fence)
+					problem = "overwrote a block still in flight";
+				blockFence[b] = fence;
+			}
+		}
+
+		ring.EndFrame(fence);
+		if (fence > latency)
+		{
+			completed = fence - latency;
+			ring.Retire(completed);
+		}
+	}
+
+	Report("frame", frameTimes);
+	printf("  %llu allocations (%.1f MB), %llu wraps, %llu discards, %u frames in flight at the end\n",
+		timed.allocations, timed.bytes / (1024.0 * 1024.0), timed.wraps, timed.discards,
+		(unsigned int)ring.GetFramesInFlight());
+	printf("  bookkeeping: %s\n", problem ? problem : "ok");
+	return !problem;
+}
+
+/// <summary>
+/// Build and compile a frame graph of 64 passes. Each
+/// pass writes one transient texture (three sizes and
+/// formats) and reads up to two earlier ones; every 16th
+/// pass feeds the back buffer, so the passes nothing
+/// leads from get culled. The result is then checked:
+/// writers run before readers, nothing that runs reads
+/// a culled pass's output, and textures sharing a
+/// physical texture are never alive at once.
+/// </summary>
+bool Benchmark::FrameGraphCompile()
+{
+	const unsigned int passCount = 64;
+	const unsigned int iterations = 10000;
+
+	const FrameGraph::TextureDesc descs[3] = {
+		{ 1280, 720, DXGI_FORMAT_R16G16B16A16_FLOAT },
+		{ 1280, 720, DXGI_FORMAT_R8G8B8A8_UNORM },
+		{ 640, 360, DXGI_FORMAT_R16G16B16A16_FLOAT }
+	};
+
+	// The same random wiring for every iteration.
+	std::mt19937 random(12345);
+	std::vector<unsigned int> inputs(passCount * 2);
+	for (unsigned int p = 0; p < passCount; p++)
+	{
+		for (unsigned int k = 0; k < 2; k++)
+		{
+			// Mostly recent textures, with some long-lived ones.
+			unsigned int back = 1 + (random() % ((random() % 4 == 0) ? 16 : 3));
+			inputs[p * 2 + k] = (p >= back) ? p - back : FrameGraph::INVALID_HANDLE;
+		}
+	}
+
+	FrameGraph graph;
+	std::vector<FrameGraph::Handle> outputs(passCount);
+	std::vector<float> buildTimes, compileTimes;
+	std::string error;
+	bool compiledOk = true;
+
+	for (unsigned int i = 0; i < iterations && compiledOk; i++)
+	{
+		PlatformTimer::Timestamp start = PlatformTimer::Now();
+		graph.Clear();
+		FrameGraph::Handle backBuffer = graph.ImportTexture("back buffer", descs[1]);
+		for (unsigned int p = 0; p < passCount; p++)
+		{
+			FrameGraph::Handle pass = graph.AddPass("pass");
+			outputs[p] = graph.CreateTexture("texture", descs[p % 3]);
+			graph.Write(pass, outputs[p]);
+			for (unsigned int k = 0; k < 2; k++)
+			{
+				if (inputs[p * 2 + k] != FrameGraph::INVALID_HANDLE)
+					graph.Read(pass, outputs[inputs[p * 2 + k]]);
+			}
+			if (p % 16 == 15)
+				graph.Write(pass, backBuffer);
+		}
+		buildTimes.push_back(PlatformTimer::MillisecondsSince(start));
+
+		start = PlatformTimer::Now();
+		compiledOk = graph.Compile(&error);
+		compileTimes.push_back(PlatformTimer::MillisecondsSince(start));
+	}
+
+	// Check the last compile.
+	const char* problem = compiledOk ? nullptr : error.c_str();
+	const std::vector<FrameGraph::Handle>& order = graph.GetOrder();
+	std::vector<unsigned int> position(passCount + 1, FrameGraph::INVALID_HANDLE);
+	for (unsigned int i = 0; i < order.size(); i++)
+		position[order[i]] = i;
+
+	for (unsigned int p = 0; p < passCount && !problem; p++)
+	{
+		// Pass p writes texture p + 1 (texture 0 is the back buffer).
+		for (unsigned int k = 0; k < 2; k++)
+		{
+			unsigned int input = inputs[p * 2 + k];
+			if (input == FrameGraph::INVALID_HANDLE || graph.IsCulled(p))
+				continue;
+			if (graph.IsCulled(input))
+				problem = "a pass that runs reads a culled pass's output";
+			else if (position[input] >= position[p])
+				problem = "a pass runs before the pass it reads from";
+		}
+	}
+
+	for (unsigned int a = 0; a < passCount && !problem; a++)
+	{
+		unsigned int firstA, lastA, firstB, lastB;
+		if (!graph.GetLifetime(outputs[a], &firstA, &lastA))
+			continue;
+		for (unsigned int b = a + 1; b < passCount && !problem; b++)
+		{
+			if (graph.GetPhysicalTexture(outputs[b]) != graph.GetPhysicalTexture(outputs[a]) ||
+				!graph.GetLifetime(outputs[b], &firstB, &lastB))
+				continue;
+			if (firstA <= lastB && firstB <= lastA)
+				problem = "two textures alive at once share a physical texture";
+		}
+	}
+
+	const FrameGraph::Statistics& stats = graph.GetStatistics();
+	Report("build", buildTimes);
+	Report("compile", compileTimes);
+	printf("  %u passes, %u culled, %u transient textures on %u physical, %.1f MB instead of %.1f MB\n",
+		stats.passes, stats.culledPasses, stats.transientTextures, stats.physicalTextures,
+		stats.allocatedBytes / (1024.0 * 1024.0), stats.requestedBytes / (1024.0 * 1024.0));
+	printf("  checks: %s\n", problem ? problem : "ok");
+	return !problem;
+}
+
+/// <summary>
+/// Draw a field of 600 spinning cubes at 1280x720 with the
+/// software rasterizer, once on the calling thread only and
+/// once with the worker pool, and report triangle and pixel
+/// throughput. Both runs must produce the same image.
+/// </summary>
+bool Benchmark::SoftwareRaster()
+{
+	using namespace DirectX;
+
+	const unsigned int width = 1280;
+	const unsigned int height = 720;
+	const unsigned int columns = 30;
+	const unsigned int rows = 20;
+	const unsigned int iterations = 50;
+
+	// A unit cube, 12 triangles, with corner normals (smooth shaded).
+	const XMFLOAT3 cube[8] = {
+		XMFLOAT3(-0.5f, -0.5f, -0.5f), XMFLOAT3(0.5f, -0.5f, -0.5f), XMFLOAT3(0.5f, 0.5f, -0.5f), XMFLOAT3(-0.5f, 0.5f, -0.5f),
+		XMFLOAT3(-0.5f, -0.5f, 0.5f), XMFLOAT3(0.5f, -0.5f, 0.5f), XMFLOAT3(0.5f, 0.5f, 0.5f), XMFLOAT3(-0.5f, 0.5f, 0.5f)
+	};
+	const unsigned int cubeIndices[36] = {
+		0, 2, 1, 0, 3, 2,	4, 5, 6, 4, 6, 7,	0, 1, 5, 0, 5, 4,
+		3, 6, 2, 3, 7, 6,	0, 4, 7, 0, 7, 3,	1, 2, 6, 1, 6, 5
+	};
+	XMFLOAT3 normals[8];
+	for (unsigned int v = 0; v < 8; v++)
+		XMStoreFloat3(&normals[v], XMVector3Normalize(XMLoadFloat3(&cube[v])));
+
+	// The game's lights and clear color.
+	const DirectionalLight light1 = { XMFLOAT4(0.6f, 0.1f, 0.1f, 1.0f), XMFLOAT4(0.1f, 0.24f, 1.0f, 1.0f), XMFLOAT3(1.0f, 0.0f, 1.0f) };
+	const DirectionalLight light2 = { XMFLOAT4(0.1f, 0.1f, 0.5f, 1.0f), XMFLOAT4(1.0f, 0.6f, 0.5f, 1.0f), XMFLOAT3(-1.0f, -1.0f, 0.0f) };
+	const float clearColor[4] = { 0.4f, 0.6f, 0.75f, 0.0f };
+
+	// Cubes from 4 to 42 units ahead, random colors and spins.
+	std::mt19937 random(12345);
+	std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+	struct Cube { XMFLOAT3 position; float spin; XMFLOAT4 surface; };
+	std::vector<Cube> cubes(columns * rows);
+	for (unsigned int i = 0; i < cubes.size(); i++)
+	{
+		float x = ((float)(i % columns) - (columns - 1) * 0.5f) * 1.4f;
+		float z = 4.0f + (float)(i / columns) * 2.0f;
+		cubes[i].position = XMFLOAT3(x, (unit(random) - 0.5f) * 6.0f, z);
+		cubes[i].spin = unit(random) * 6.28f;
+		cubes[i].surface = XMFLOAT4(unit(random), unit(random), unit(random), 1.0f);
+	}
+
+	Camera camera = Camera::GetDefaultCamera();
+	XMMATRIX viewProjection = XMMatrixTranspose(XMLoadFloat4x4(&camera.GetViewProjectionMatrix()));
+
+	// Once on the calling thread alone, once with the worker pool.
+	const unsigned int threadCounts[2] = { 0, WorkerPool::DEFAULT_THREADS };
+	std::vector<unsigned int> images[2];
+	for (unsigned int run = 0; run < 2; run++)
+	{
+		SoftwareRasterizer rasterizer(threadCounts[run]);
+		rasterizer.Resize(width, height);
+		std::vector<float> setupTimes, rasterTimes;
+		unsigned long long triangles = 0, pixels = 0;
+		double seconds = 0.0, rasterSeconds = 0.0;
+
+		for (unsigned int i = 0; i < iterations; i++)
+		{
+			PlatformTimer::Timestamp start = PlatformTimer::Now();
+			rasterizer.BeginFrame(viewProjection, light1, light2, clearColor);
+			for (const Cube& c : cubes)
+			{
+				XMMATRIX world = XMMatrixMultiply(XMMatrixRotationRollPitchYaw(c.spin, c.spin + i * 0.05f, 0.0f),
+					XMMatrixTranslation(c.position.x, c.position.y, c.position.z));
+				rasterizer.DrawMesh(cube, normals, cubeIndices, 36, world, c.surface);
+			}
+			setupTimes.push_back(PlatformTimer::MillisecondsSince(start));
+
+			start = PlatformTimer::Now();
+			rasterizer.Render();
+			rasterTimes.push_back(PlatformTimer::MillisecondsSince(start));
+
+			triangles += rasterizer.GetStatistics().triangles;
+			pixels += rasterizer.GetStatistics().pixels;
+			seconds += (setupTimes.back() + rasterTimes.back()) / 1000.0;
+			rasterSeconds += rasterTimes.back() / 1000.0;
+		}
+
+		images[run].resize(width * height);
+		for (unsigned int y = 0; y < height; y++)
+			std::copy_n(rasterizer.GetColorBuffer() + y * rasterizer.GetPitch(), width, &images[run][y * width]);
+
+		const SoftwareRasterizer::Statistics& stats = rasterizer.GetStatistics();
+		printf("  %u worker thread(s):\n", rasterizer.GetThreadCount());
+		Report("setup", setupTimes);
+		Report("rasterize", rasterTimes);
+		printf("  %u triangles, %u rasterized, %u tile bins, %llu pixels shaded per frame\n",
+			stats.triangles, stats.rasterized, stats.binned, stats.pixels);
+		printf("  %.2f Mtris/s, %.2f Mpix/s\n", triangles / seconds / 1e6, pixels / rasterSeconds / 1e6);
+	}
+
+
+	// The image mustn't depend on the number of threads.
+	bool passed = true;
+	CHECK(images[0] == images[1]);
+	return passed;
+}
+
+/// <summary>
+/// Pick detail levels for 100k entities over 600 frames while
+/// the camera drifts forward and shakes slightly, once without
+/// hysteresis and once with the default margin. Reports the
+/// SIMD and scalar times, checks they pick the same levels,
+/// and counts the level changes (popping) in each run.
+/// </summary>
+bool Benchmark::LodSelect()
+{
+	using namespace DirectX;
+
+	const unsigned int entityCount = 100000;
+	const unsigned int frames = 600;
+	const float projectionScale = 1.0f / tanf(0.25f * 3.14159265f * 0.5f);
+
+	std::mt19937 random(12345);
+	std::uniform_real_distribution<float> across(-100.0f, 100.0f);
+	std::uniform_real_distribution<float> sizes(0.2f, 2.0f);
+	std::uniform_int_distribution<unsigned int> levelCounts(1, 4);
+
+	std::vector<XMFLOAT4> spheres(entityCount);
+	std::vector<unsigned int> levelCount(entityCount);
+	for (unsigned int i = 0; i < entityCount; i++)
+	{
+		spheres[i] = XMFLOAT4(across(random), across(random) * 0.1f, across(random) + 100.0f, sizes(random));
+		levelCount[i] = levelCounts(random);
+	}
+
+	const float margins[2] = { 0.0f, LodSelector().GetHysteresis() };
+	bool allMatch = true;
+	for (float margin : margins)
+	{
+		LodSelector simd, scalar;
+		simd.SetHysteresis(margin);
+		scalar.SetHysteresis(margin);
+		simd.Resize(entityCount);
+		scalar.Resize(entityCount);
+		for (unsigned int i = 0; i < entityCount; i++)
+		{
+			simd.Set(i, spheres[i], levelCount[i]);
+			scalar.Set(i, spheres[i], levelCount[i]);
+		}
+
+		std::vector<float> simdTimes, scalarTimes;
+		unsigned long long changes = 0;
+		bool match = true;
+		for (unsigned int frame = 0; frame < frames; frame++)
+		{
+			// Forward at 0.1 units a frame, shaking by 0.05.
+			float shake = (frame % 2) ? 0.05f : -0.05f;
+			XMFLOAT3 camera(shake, 0.0f, frame * 0.1f + shake);
+
+			PlatformTimer::Timestamp start = PlatformTimer::Now();
+			unsigned int changed = simd.Select(camera, projectionScale);
+			simdTimes.push_back(PlatformTimer::MillisecondsSince(start));
+
+			start = PlatformTimer::Now();
+			scalar.SelectScalar(camera, projectionScale);
+			scalarTimes.push_back(PlatformTimer::MillisecondsSince(start));
+
+			// The first frame moves everyone off level 0.
+			if (frame > 0)
+				changes += changed;
+			for (unsigned int i = 0; i < entityCount && match; i++)
+				match = simd.GetLevel(i) == scalar.GetLevel(i);
+		}
+
+		printf("  hysteresis %.2f:\n", margin);
+		Report("simd", simdTimes);
+		Report("scalar", scalarTimes);
+		printf("  %llu level changes over %u frames (%.2f per frame), results %s\n",
+			changes, frames, (double)changes / (frames - 1), match ? "match" : "DIFFER");
+		allMatch = allMatch && match;
+	}
+	return allMatch;
+}
+
+/// <summary>
+/// Count from every worker at once, with the per-thread render
+/// counters and with one shared atomic, and check that each
+/// frame's totals add up.
+/// </summary>
+bool Benchmark::RenderCounterAdd()
+{
+	const unsigned int frames = 100;
+	const unsigned int addsPerTask = 100000;
+
+	WorkerPool workers;
+	unsigned int tasks = workers.GetThreadCount() + 1;
+	unsigned long long expected = (unsigned long long)tasks * addsPerTask;
+
+	RenderCounters& counters = RenderCounters::Get();
+	counters.Reset();
+
+	std::atomic<unsigned long long> shared(0);
+	std::vector<float> counterTimes, sharedTimes;
+	bool match = true;
+	for (unsigned int frame = 0; frame < frames; frame++)
+	{
+		PlatformTimer::Timestamp start = PlatformTimer::Now();
+		workers.Run(tasks, [addsPerTask](unsigned int task)
+		{
+			for (unsigned int i = 0; i < addsPerTask; i++)
+			{
+				RenderCounters::Add(RenderCounters::RC_DRAWS);
+				RenderCounters::Add(RenderCounters::RC_TRIANGLES, 12);
+			}
+		});
+		counters.EndFrame();
+		counterTimes.push_back(PlatformTimer::MillisecondsSince(start));
+
+		const RenderCounters::Values& counted = counters.GetLastFrame();
+		match = match && counted.counts[RenderCounters::RC_DRAWS] == expected && counted.counts[RenderCounters::RC_TRIANGLES] == expected * 12;
+
+		shared.store(0);
+		start = PlatformTimer::Now();
+		workers.Run(tasks, [addsPerTask, &shared](unsigned int task)
+		{
+			for (unsigned int i = 0; i < addsPerTask; i++)
+			{
+				shared.fetch_add(1, std::memory_order_relaxed);
+				shared.fetch_add(12, std::memory_order_relaxed);
+			}
+		});
+		sharedTimes.push_back(PlatformTimer::MillisecondsSince(start));
+		match = match && shared.load() == expected * 13;
+	}
+
+	Report("per-thread", counterTimes);
+	Report("shared", sharedTimes);
+	printf("  %u tasks x %u adds per frame, totals %s\n", tasks, addsPerTask * 2, match ? "match" : "DIFFER");
+
+	// Don't leave the benchmark's counts behind.
+	counters.Reset();
+	return match;
+}
+
+/// <summary>
+/// Set the per-draw variables of VertexShader.cso ("world",
+/// "surface") and write its "perObject" buffer for 100k
+/// draws, by name and through handles, on a WARP device.
+/// Counts the heap allocations each way makes (in builds
+/// with COUNT_ALLOCATIONS=1) and checks both leave the same
+/// bytes in the buffer.
+/// </summary>
+bool Benchmark::ShaderHandles()
+{
+	using namespace DirectX;
+
+	const unsigned int draws = 100000;
+	const unsigned int iterations = 20;
+
+	ID3D11Device* device = nullptr;
+	ID3D11DeviceContext* context = nullptr;
+	if (FAILED(D3D11CreateDevice(0, D3D_DRIVER_TYPE_WARP, 0, 0, 0, 0, D3D11_SDK_VERSION, &device, nullptr, &context)))
+	{
+		printf("  skipped: could not create a WARP device\n");
+		return true;
+	}
+
+	bool passed = true;
+	{
+		SimpleVertexShader shader(device, context);
+		if (!shader.LoadShaderFile(L"VertexShader.cso"))
+		{
+			printf("  skipped: could not load VertexShader.cso\n");
+			context->Release();
+			device->Release();
+			return true;
+		}
+
+		SimpleShaderVariableHandle world = shader.GetVariableHandle("world");
+		SimpleShaderVariableHandle surface = shader.GetVariableHandle("surface");
+		int perObject = shader.GetBufferIndex("perObject");
+		const SimpleConstantBuffer* buffer = (perObject >= 0) ? shader.GetBufferInfo((unsigned int)perObject) : nullptr;
+
+		// A few distinct values, so most sets change the buffer.
+		std::vector<XMFLOAT4X4> matrices(64);
+		std::vector<XMFLOAT4> colors(64);
+		for (unsigned int i = 0; i < 64; i++)
+		{
+			XMStoreFloat4x4(&matrices[i], XMMatrixTranspose(XMMatrixTranslation((float)i, 0.0f, 1.0f)));
+			colors[i] = XMFLOAT4(i / 64.0f, 0.5f, 1.0f, 1.0f);
+		}
+
+		std::vector<float> nameTimes, handleTimes;
+		unsigned long long nameAllocations = 0, handleAllocations = 0;
+		bool match = world.IsValid() && surface.IsValid() && buffer;
+		std::vector<unsigned char> byName;
+
+		for (unsigned int it = 0; it < iterations && match; it++)
+		{
+			unsigned long long allocations = AllocationCounter::GetCount();
+			PlatformTimer::Timestamp start = PlatformTimer::Now();
+			for (unsigned int d = 0; d < draws; d++)
+			{
+				shader.SetMatrix4x4("world", matrices[d % 64]);
+				shader.SetFloat4("surface", colors[(d * 7) % 64]);
+				shader.MarkBufferClean("perObject");
+			}
+			nameTimes.push_back(PlatformTimer::MillisecondsSince(start));
+			nameAllocations += AllocationCounter::GetCount() - allocations;
+			byName.assign(buffer->LocalDataBuffer, buffer->LocalDataBuffer + buffer->Size);
+
+			allocations = AllocationCounter::GetCount();
+			start = PlatformTimer::Now();
+			for (unsigned int d = 0; d < draws; d++)
+			{
+				shader.SetMatrix4x4(world, matrices[d % 64]);
+				shader.SetFloat4(surface, colors[(d * 7) % 64]);
+				shader.MarkBufferClean((unsigned int)perObject);
+			}
+			handleTimes.push_back(PlatformTimer::MillisecondsSince(start));
+			handleAllocations += AllocationCounter::GetCount() - allocations;
+
+			match = std::equal(byName.begin(), byName.end(), buffer->LocalDataBuffer);
+		}
+
+		// Names the shader doesn't have give handles that set nothing.
+		SimpleShaderVariableHandle missing = shader.GetVariableHandle("no such variable");
+		CHECK(match);
+		CHECK(!missing.IsValid() && !shader.SetFloat(missing, 1.0f));
+		CHECK(!shader.SetFloat4(world, colors[0]));	// Wrong size.
+
+		// No allocations only means something if the counter sees
+		// them: one plain and one over-aligned must both count.
+		if (AllocationCounter::IsCounting())
+		{
+			struct alignas(64) Aligned { float values[16]; };
+			unsigned long long allocations = AllocationCounter::GetCount();
+			int* volatile plain = new int(0);
+			Aligned* volatile aligned = new Aligned();
+			delete plain;
+			delete aligned;
+			CHECK(AllocationCounter::GetCount() - allocations == 2);
+			CHECK(handleAllocations == 0);
+		}
+
+		Report("by name", nameTimes);
+		Report("by handle", handleTimes);
+		if (AllocationCounter::IsCounting())
+		{
+			printf("  %u draws x %u iterations, allocations: %llu by name, %llu by handle\n",
+				draws, iterations, nameAllocations, handleAllocations);
+		}
+		else
+		{
+			printf("  %u draws x %u iterations, allocations not counted (build with COUNT_ALLOCATIONS=1)\n",
+				draws, iterations);
+		}
+	}
+
+	context->Release();
+	device->Release();
+	return passed;
+}
+
+/// <summary>
+/// Copy VertexShader.cso's "perObject" buffer for 100k draws
+/// on a WARP device, where "world" changes every draw and
+/// "surface" every 100: whole buffers, then dirty ranges.
+/// Checks the null backend is sent exactly the changed
+/// bytes, that a command buffer (which records whole
+/// buffers) is counted as sending whole buffers, and that
+/// unchanged buffers aren't sent at all.
+/// </summary>
+bool Benchmark::ConstantRanges()
+{
+	using namespace DirectX;
+
+	const unsigned int draws = 100000;
+	const unsigned int iterations = 10;
+
+	ID3D11Device* device = nullptr;
+	ID3D11DeviceContext* context = nullptr;
+	if (FAILED(D3D11CreateDevice(0, D3D_DRIVER_TYPE_WARP, 0, 0, 0, 0, D3D11_SDK_VERSION, &device, nullptr, &context)))
+	{
+		printf("  skipped: could not create a WARP device\n");
+		return true;
+	}
+
+	bool passed = true;
+	{
+		SimpleVertexShader shader(device, context);
+		if (!shader.LoadShaderFile(L"VertexShader.cso"))
+		{
+			printf("  skipped: could not load VertexShader.cso\n");
+			context->Release();
+			device->Release();
+			return true;
+		}
+
+		SimpleShaderVariableHandle world = shader.GetVariableHandle("world");
+		SimpleShaderVariableHandle surface = shader.GetVariableHandle("surface");
+		int perObject = shader.GetBufferIndex("perObject");
+		const SimpleConstantBuffer* buffer = (perObject >= 0) ? shader.GetBufferInfo((unsigned int)perObject) : nullptr;
+		CHECK(world.IsValid() && surface.IsValid() && buffer);	// VertexShader.cso's perObject buffer.
+		if (!passed)
+		{
+			context->Release();
+			device->Release();
+			return false;
+		}
+
+		std::vector<XMFLOAT4X4> matrices(64);
+		std::vector<XMFLOAT4> colors(64);
+		for (unsigned int i = 0; i < 64; i++)
+		{
+			XMStoreFloat4x4(&matrices[i], XMMatrixTranspose(XMMatrixTranslation((float)i, 0.0f, 1.0f)));
+			colors[i] = XMFLOAT4(i / 64.0f, 0.5f, 1.0f, 1.0f);
+		}
+
+		// Bytes each variable dirties, in whole 16 byte constants.
+		unsigned int worldBegin = world.ByteOffset & ~15u;
+		unsigned int worldEnd = (world.ByteOffset + world.Size + 15) & ~15u;
+		unsigned int surfaceBegin = surface.ByteOffset & ~15u;
+		unsigned int surfaceEnd = (surface.ByteOffset + surface.Size + 15) & ~15u;
+		unsigned int bothBytes = ((worldEnd > surfaceEnd) ? worldEnd : surfaceEnd)
+			- ((worldBegin < surfaceBegin) ? worldBegin : surfaceBegin);
+
+		std::vector<float> wholeTimes, rangeTimes;
+		for (unsigned int it = 0; it < iterations; it++)
+		{
+			PlatformTimer::Timestamp start = PlatformTimer::Now();
+			for (unsigned int d = 0; d < draws; d++)
+			{
+				shader.SetMatrix4x4(world, matrices[d % 64]);
+				shader.SetFloat4(surface, colors[(d / 100) % 64]);
+				shader.CopyBufferData((unsigned int)perObject);
+			}
+			wholeTimes.push_back(PlatformTimer::MillisecondsSince(start));
+
+			start = PlatformTimer::Now();
+			for (unsigned int d = 0; d < draws; d++)
+			{
+				shader.SetMatrix4x4(world, matrices[d % 64]);
+				shader.SetFloat4(surface, colors[(d / 100) % 64]);
+				shader.CopyAllBufferData();
+			}
+			rangeTimes.push_back(PlatformTimer::MillisecondsSince(start));
+		}
+
+		// The same draws through the null backend, predicting the
+		// bytes each upload should send ("world" always changes).
+		NullRenderBackend backend;
+		unsigned long long expected = 0;
+		unsigned int uploads = 0;
+		unsigned long long counted = RenderCounters::Get().GetTotals().counts[RenderCounters::RC_CONSTANT_BYTES];
+		for (unsigned int d = 0; d < draws; d++)
+		{
+			bool surfaceChanged = (d == 0 || (d / 100) % 64 != ((d - 1) / 100) % 64);
+			shader.SetMatrix4x4(world, matrices[d % 64]);
+			shader.SetFloat4(surface, colors[(d / 100) % 64]);
+			expected += surfaceChanged ? bothBytes : worldEnd - worldBegin;
+			uploads += backend.UploadConstants(&shader, (unsigned int)perObject) ? 1 : 0;
+		}
+		counted = RenderCounters::Get().GetTotals().counts[RenderCounters::RC_CONSTANT_BYTES] - counted;
+
+		// Setting what the buffer already holds leaves it clean,
+		// and clean buffers aren't copied.
+		unsigned long long before = RenderCounters::Get().GetTotals().counts[RenderCounters::RC_CONSTANT_BYTES];
+		shader.SetMatrix4x4(world, matrices[(draws - 1) % 64]);
+		bool skipped = !shader.IsBufferDirty((unsigned int)perObject)
+			&& !backend.UploadConstants(&shader, (unsigned int)perObject);
+		shader.CopyAllBufferData();
+		skipped = skipped && RenderCounters::Get().GetTotals().counts[RenderCounters::RC_CONSTANT_BYTES] == before;
+
+		// Recorded into a command buffer, which can't know if its
+		// target does partial updates, each upload is the whole
+		// buffer - and has to be counted as that.
+		CommandBuffer commands;
+		unsigned int recorded = 0;
+		unsigned long long recordedBytes = RenderCounters::Get().GetTotals().counts[RenderCounters::RC_CONSTANT_BYTES];
+		for (unsigned int d = 0; d < 100; d++)
+		{
+			shader.SetMatrix4x4(world, matrices[d % 64]);
+			recorded += commands.UploadConstants(&shader, (unsigned int)perObject) ? 1 : 0;
+		}
+		recordedBytes = RenderCounters::Get().GetTotals().counts[RenderCounters::RC_CONSTANT_BYTES] - recordedBytes;
+		bool wholeCounted = recorded == 100 && recordedBytes == 100ull * buffer->Size;
+
+		const RenderBackendStatistics& stats = backend.GetStatistics();
+		Report("whole buffer", wholeTimes);
+		Report("dirty range", rangeTimes);
+		printf("  %u draws: %llu bytes by range, %llu whole (%u uploads)\n",
+			draws, stats.constantBytes, (unsigned long long)uploads * buffer->Size, uploads);
+		CHECK(stats.constantBytes == expected);
+		CHECK(counted == expected);
+		CHECK(uploads == draws);
+		CHECK(wholeCounted);
+		CHECK(skipped);
+	}
+
+	context->Release();
+	device->Release();
+	return passed;
+}
+
+/// <summary>
+/// Serialize and deserialize the reflections of 1000 made up
+/// shaders (4 constant buffers of 12 variables, 3 textures
+/// and 2 samplers each), as SimpleShader does with its
+/// sidecar files. What's read back is checked field by
+/// field in the "reflection-cache" unit test.
+/// </summary>
+bool Benchmark::ReflectionCache()
+{
+	typedef ShaderReflectionCache Cache;
+
+	const unsigned int shaders = 1000;
+	const unsigned int iterations = 20;
+
+	std::mt19937 random(12345);
+	std::uniform_int_distribution<unsigned int> counts(1, 4);
+
+	std::vector<Cache::Reflection> library(shaders);
+	std::vector<unsigned long long> hashes(shaders);
+	for (unsigned int s = 0; s < shaders; s++)
+	{
+		Cache::Reflection& reflection = library[s];
+		for (unsigned int r = 0; r < 5; r++)
+		{
+			Cache::Resource resource;
+			resource.name = (r < 3 ? "texture" : "sampler") + std::to_string(r);
+			resource.kind = (r < 3) ? Cache::RK_TEXTURE : Cache::RK_SAMPLER;
+			resource.bindIndex = (r < 3) ? r : r - 3;
+			reflection.resources.push_back(resource);
+		}
+		for (unsigned int b = 0; b < 4; b++)
+		{
+			Cache::Buffer buffer;
+			buffer.name = "buffer" + std::to_string(b);
+			buffer.type = 0;
+			buffer.bindIndex = b;
+			buffer.size = 0;
+			for (unsigned int v = 0; v < 12; v++)
+			{
+				// Whole 16 byte constants, as HLSL packs a float4.
+				Cache::Variable variable;
+				variable.name = "shader" + std::to_string(s) + "_variable" + std::to_string(v);
+				variable.offset = buffer.size;
+				variable.size = 16 * counts(random);
+				buffer.size += variable.size;
+				buffer.variables.push_back(variable);
+			}
+			reflection.buffers.push_back(buffer);
+		}
+		hashes[s] = Cache::Hash(&s, sizeof(s));
+	}
+
+	std::vector<std::vector<unsigned char>> sidecars(shaders);
+	std::vector<float> writeTimes, readTimes;
+	bool read = true;
+	size_t totalBytes = 0;
+	for (unsigned int it = 0; it < iterations; it++)
+	{
+		PlatformTimer::Timestamp start = PlatformTimer::Now();
+		for (unsigned int s = 0; s < shaders; s++)
+			Cache::Serialize(library[s], hashes[s], &sidecars[s]);
+		writeTimes.push_back(PlatformTimer::MillisecondsSince(start));
+
+		std::vector<Cache::Reflection> loaded(shaders);
+		start = PlatformTimer::Now();
+		for (unsigned int s = 0; s < shaders; s++)
+			read = Cache::Deserialize(sidecars[s].data(), sidecars[s].size(), hashes[s], &loaded[s]) && read;
+		readTimes.push_back(PlatformTimer::MillisecondsSince(start));
+	}
+	for (const std::vector<unsigned char>& sidecar : sidecars)
+		totalBytes += sidecar.size();
+
+	Report("serialize", writeTimes);
+	Report("deserialize", readTimes);
+	printf("  %u shaders, %zu sidecar bytes\n", shaders, totalBytes);
+
+	bool passed = true;
+	CHECK(read);
+	return passed;
+}
+
+// -----------------------------------------------
+// Helper methods.
+// -----------------------------------------------
+
+/// <summary>
+/// Resolve 100k frames against 512 chord bindings, once with
+/// a random key going down or up every frame and once with a
+/// change every 16th frame (what play looks like). How actions
+/// resolve is checked in the "input-map" unit test.
+/// </summary>
+bool Benchmark::InputMapUpdate()
+{
+	const unsigned int frames = 10000;
+	const unsigned int iterations = 10;
+
+	std::mt19937 random(12345);
+	std::uniform_int_distribution<unsigned int> keyCodes(0, InputMap::KEY_COUNT - 1);
+	std::uniform_int_distribution<unsigned int> chordSizes(1, 3);
+
+	InputMap map;
+	for (unsigned int i = 0; i < InputMap::MAX_BINDINGS; i++)
+	{
+		InputMap::KeyCode chord[3] = {};
+		unsigned int size = chordSizes(random);
+		for (unsigned int k = 0; k < size; k++)
+			chord[k] = (InputMap::KeyCode)keyCodes(random);
+		if (size == 1) map.Bind(i % InputMap::MAX_ACTIONS, { chord[0] });
+		else if (size == 2) map.Bind(i % InputMap::MAX_ACTIONS, { chord[0], chord[1] });
+		else map.Bind(i % InputMap::MAX_ACTIONS, { chord[0], chord[1], chord[2] });
+	}
+
+	// The same events for every iteration: a key flips each frame.
+	std::vector<InputMap::KeyCode> events(frames);
+	for (unsigned int f = 0; f < frames; f++)
+		events[f] = (InputMap::KeyCode)keyCodes(random);
+
+	const unsigned int spacings[2] = { 1, 16 };
+	unsigned int downCount = 0;
+	for (unsigned int spacing : spacings)
+	{
+		std::vector<float> times;
+		for (unsigned int it = 0; it < iterations; it++)
+		{
+			PlatformTimer::Timestamp start = PlatformTimer::Now();
+			for (unsigned int f = 0; f < frames; f++)
+			{
+				if (f % spacing == 0)
+				{
+					InputMap::KeyCode key = events[f];
+					if (map.IsKeyDown(key)) map.OnKeyUp(key);
+					else map.OnKeyDown(key);
+				}
+				map.Update();
+				downCount += map.AnyDown() ? 1 : 0;
+			}
+			times.push_back(PlatformTimer::MillisecondsSince(start));
+		}
+
+		printf("  a key change every %u frame(s):\n", spacing);
+		Report("update", times);
+		map.ReleaseAll();
+		map.Update();
+	}
+
+	printf("  %u frames with an action down\n", downCount);
+	return true;
+}
+
+/// <summary>
+/// Draw one triangle on a WARP device, turned and moved by a
+/// world matrix, 1000 times with VertexShader.cso's per-object
+/// constants and as 1000 instances of InstancedVertexShader.cso
+/// (the instance buffer holding the matrix as GameEntity gives
+/// it). Both must give the same 64x64 image, and the triangle
+/// must land where the matrix puts it: a wrong side multiply
+/// in either shader moves or loses it.
+/// </summary>
+bool Benchmark::InstancingMatch()
+{
+	using namespace DirectX;
+
+	const unsigned int draws = 1000;
+	const unsigned int iterations = 10;
+	const unsigned int size = 64;
+
+	ID3D11Device* device = nullptr;
+	ID3D11DeviceContext* context = nullptr;
+	if (FAILED(D3D11CreateDevice(0, D3D_DRIVER_TYPE_WARP, 0, 0, 0, 0, D3D11_SDK_VERSION, &device, nullptr, &context)))
+	{
+		printf("  skipped: could not create a WARP device\n");
+		return true;
+	}
+
+	bool passed = true;
+	{
+		SimpleVertexShader vertexShader(device, context);
+		SimpleVertexShader instancedShader(device, context);
+		SimplePixelShader pixelShader(device, context);
+		if (!vertexShader.LoadShaderFile(L"VertexShader.cso") || !instancedShader.LoadShaderFile(L"InstancedVertexShader.cso")
+			|| !pixelShader.LoadShaderFile(L"PixelShader.cso"))
+		{
+			printf("  skipped: could not load the shaders\n");
+			context->Release();
+			device->Release();
+			return true;
+		}
+
+		// Clip space in, so view and projection are identity. The
+		// world matrix turns the triangle 30 degrees and moves it
+		// up and right, stored transposed as the entities store it.
+		XMFLOAT4X4 identity;
+		XMStoreFloat4x4(&identity, XMMatrixIdentity());
+		XMFLOAT4X4 world;
+		XMStoreFloat4x4(&world, XMMatrixTranspose(XMMatrixRotationZ(0.5236f) * XMMatrixTranslation(0.4f, 0.3f, 0.0f)));
+		XMFLOAT4 surface(1.0f, 0.5f, 0.25f, 1.0f);
+
+		ShaderConstants::VertexShader::perFrame vertexFrame = {};
+		vertexFrame.view = identity;
+		vertexFrame.projection = identity;
+		vertexShader.SetBufferData(vertexFrame);
+		ShaderConstants::VertexShader::perObject perObject = {};
+		perObject.world = world;
+		perObject.surface = surface;
+		vertexShader.SetBufferData(perObject);
+		vertexShader.CopyAllBufferData();
+
+		ShaderConstants::InstancedVertexShader::perFrame instancedFrame = {};
+		instancedFrame.view = identity;
+		instancedFrame.projection = identity;
+		instancedShader.SetBufferData(instancedFrame);
+		instancedShader.CopyAllBufferData();
+
+		ShaderConstants::PixelShader::perFrame pixelFrame = {};
+		pixelFrame.light1 = { XMFLOAT4(0.2f, 0.2f, 0.2f, 1.0f), XMFLOAT4(1.0f, 1.0f, 1.0f, 1.0f), XMFLOAT3(0.0f, 0.0f, 1.0f) };
+		pixelShader.SetBufferData(pixelFrame);
+		pixelShader.CopyAllBufferData();
+
+		// Clockwise on screen, facing the camera.
+		Vertex vertices[3] = {
+			{ XMFLOAT3(-0.3f, -0.3f, 0.5f), XMFLOAT3(0.0f, 0.0f, -1.0f), XMFLOAT2(0.0f, 0.0f) },
+			{ XMFLOAT3(0.0f, 0.3f, 0.5f), XMFLOAT3(0.0f, 0.0f, -1.0f), XMFLOAT2(0.0f, 0.0f) },
+			{ XMFLOAT3(0.3f, -0.3f, 0.5f), XMFLOAT3(0.0f, 0.0f, -1.0f), XMFLOAT2(0.0f, 0.0f) }
+		};
+		unsigned int indices[3] = { 0, 1, 2 };
+		std::vector<InstanceBuffer::Instance> instances(draws, InstanceBuffer::Instance{ world, surface });
+
+		ID3D11Buffer* vertexBuffer = nullptr;
+		ID3D11Buffer* indexBuffer = nullptr;
+		ID3D11Buffer* instanceBuffer = nullptr;
+		ID3D11Texture2D* target = nullptr;
+		ID3D11Texture2D* staging = nullptr;
+		ID3D11RenderTargetView* targetView = nullptr;
+		ID3D11RasterizerState* noCulling = nullptr;
+
+		D3D11_BUFFER_DESC bufferDesc = {};
+		bufferDesc.Usage = D3D11_USAGE_IMMUTABLE;
+		bufferDesc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
+		D3D11_SUBRESOURCE_DATA initial = {};
+		bufferDesc.ByteWidth = sizeof(vertices);
+		initial.pSysMem = vertices;
+		device->CreateBuffer(&bufferDesc, &initial, &vertexBuffer);
+		bufferDesc.ByteWidth = (UINT)(sizeof(InstanceBuffer::Instance) * instances.size());
+		initial.pSysMem = instances.data();
+		device->CreateBuffer(&bufferDesc, &initial, &instanceBuffer);
+		bufferDesc.BindFlags = D3D11_BIND_INDEX_BUFFER;
+		bufferDesc.ByteWidth = sizeof(indices);
+		initial.pSysMem = indices;
+		device->CreateBuffer(&bufferDesc, &initial, &indexBuffer);
+
+		D3D11_TEXTURE2D_DESC textureDesc = {};
+		textureDesc.Width = size;
+		textureDesc.Height = size;
+		textureDesc.MipLevels = 1;
+		textureDesc.ArraySize = 1;
+		textureDesc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+		textureDesc.SampleDesc.Count = 1;
+		textureDesc.Usage = D3D11_USAGE_DEFAULT;
+		textureDesc.BindFlags = D3D11_BIND_RENDER_TARGET;
+		device->CreateTexture2D(&textureDesc, nullptr, &target);
+		textureDesc.Usage = D3D11_USAGE_STAGING;
+		textureDesc.BindFlags = 0;
+		textureDesc.CPUAccessFlags = D3D11_CPU_ACCESS_READ;
+		device->CreateTexture2D(&textureDesc, nullptr, &staging);
+		if (target)
+			device->CreateRenderTargetView(target, nullptr, &targetView);
+
+		D3D11_RASTERIZER_DESC rasterizerDesc = {};
+		rasterizerDesc.FillMode = D3D11_FILL_SOLID;
+		rasterizerDesc.CullMode = D3D11_CULL_NONE;
+		rasterizerDesc.DepthClipEnable = TRUE;
+		device->CreateRasterizerState(&rasterizerDesc, &noCulling);
+
+		bool created = vertexBuffer && indexBuffer && instanceBuffer && staging && targetView && noCulling;
+		D3D11_VIEWPORT viewport = { 0.0f, 0.0f, (float)size, (float)size, 0.0f, 1.0f };
+		const float clearColor[4] = { 1.0f, 0.0f, 1.0f, 1.0f };
+
+		// Draws one way, then copies the image back.
+		auto render = [&](bool instanced, std::vector<unsigned int>* image)
+		{
+			context->OMSetRenderTargets(1, &targetView, nullptr);
+			context->RSSetViewports(1, &viewport);
+			context->RSSetState(noCulling);
+			context->ClearRenderTargetView(targetView, clearColor);
+			context->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+			context->IASetIndexBuffer(indexBuffer, DXGI_FORMAT_R32_UINT, 0);
+
+			ID3D11Buffer* buffers[2] = { vertexBuffer, instanceBuffer };
+			UINT strides[2] = { sizeof(Vertex), sizeof(InstanceBuffer::Instance) };
+			UINT offsets[2] = { 0, 0 };
+			context->IASetVertexBuffers(0, instanced ? 2 : 1, buffers, strides, offsets);
+			pixelShader.SetShader();
+			if (instanced)
+			{
+				instancedShader.SetShader();
+				context->DrawIndexedInstanced(3, draws, 0, 0, 0);
+			}
+			else
+			{
+				vertexShader.SetShader();
+				for (unsigned int d = 0; d < draws; d++)
+					context->DrawIndexed(3, 0, 0);
+			}
+
+			context->CopyResource(staging, target);
+			D3D11_MAPPED_SUBRESOURCE mapped = {};
+			image->assign(size * size, 0);
+			if (FAILED(context->Map(staging, 0, D3D11_MAP_READ, 0, &mapped)))
+				return;
+			for (unsigned int y = 0; y < size; y++)
+				memcpy(&(*image)[y * size], (const unsigned char*)mapped.pData + y * mapped.RowPitch, size * 4);
+			context->Unmap(staging, 0);
+		};
+
+		std::vector<float> perObjectTimes, instancedTimes;
+		std::vector<unsigned int> perObjectImage, instancedImage;
+		for (unsigned int it = 0; it < iterations && created; it++)
+		{
+			PlatformTimer::Timestamp start = PlatformTimer::Now();
+			render(false, &perObjectImage);
+			perObjectTimes.push_back(PlatformTimer::MillisecondsSince(start));
+
+			start = PlatformTimer::Now();
+			render(true, &instancedImage);
+			instancedTimes.push_back(PlatformTimer::MillisecondsSince(start));
+		}
+
+		// The shaders multiply in different orders, so an edge
+		// pixel may round the other way - but only a few.
+		unsigned int covered = 0, different = 0;
+		unsigned int clear = perObjectImage.empty() ? 0 : perObjectImage[0];
+		for (size_t i = 0; i < perObjectImage.size(); i++)
+		{
+			covered += perObjectImage[i] != clear ? 1 : 0;
+			different += perObjectImage[i] != instancedImage[i] ? 1 : 0;
+		}
+
+		// The turned and moved centroid, (0.45, 0.21), is pixel
+		// (46, 25); not moved, the triangle would cover the middle.
+		bool placed = created && perObjectImage[25 * size + 46] != clear && perObjectImage[32 * size + 32] == clear;
+
+		Report("per object", perObjectTimes);
+		Report("instanced", instancedTimes);
+		printf("  %u pixels covered, %u differ\n", covered, different);
+		CHECK(placed);
+		CHECK(covered > 100);
+		CHECK(different <= covered / 50);
+
+		if (noCulling) noCulling->Release();
+		if (targetView) targetView->Release();
+		if (staging) staging->Release();
+		if (target) target->Release();
+		if (instanceBuffer) instanceBuffer->Release();
+		if (indexBuffer) indexBuffer->Release();
+		if (vertexBuffer) vertexBuffer->Release();
+	}
+
+	context->Release();
+	device->Release();
+	return passed;
+}
+
+/// <summary>
+/// Print timing percentiles for a set of samples.
+/// </summary>
+/// <param name="label">Row label.</param>
+/// <param name="milliseconds">Samples (sorted in place).</param>
+void Benchmark::Report(const char* label, std::vector<float>& milliseconds)
+{
+	if (milliseconds.empty())
+		return;
+
+	std::sort(milliseconds.begin(), milliseconds.end());
+
+	double total = 0.0;
+	for (float sample : milliseconds)
+		total += sample;
+
+	size_t last = milliseconds.size() - 1;
+	printf("  %-12s avg %8.4fms  min %8.4fms  p50 %8.4fms  p99 %8.4fms\n",
+		label, total / milliseconds.size(), milliseconds[0],
+		milliseconds[last / 2], milliseconds[(last * 99) / 100]);
+}
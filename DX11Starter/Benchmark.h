@@ -0,0 +1,72 @@
+#pragma once
+
+// -----------------------------------------------
+// Include statements.
+// -----------------------------------------------
+#include <string>
+#include <vector>
+
+// -----------------------------------------------
+// Benchmark.h
+// ---
+// CPU micro-benchmarks for engine systems, run
+// with "--benchmark NAME" (or "all") instead of
+// the game. Results are printed to the console,
+// and a failed check fails the run.
+// -----------------------------------------------
+
+class Benchmark
+{
+public:
+	// -----------------------------------------------
+	// Static methods.
+	// -----------------------------------------------
+
+	static bool Run(const std::string& name);	// Returns false if no benchmark has that name, or a check failed.
+	static void List();
+
+private:
+
+	// -----------------------------------------------
+	// Internal structs.
+	// -----------------------------------------------
+
+	/// <summary>
+	/// A named benchmark.
+	/// </summary>
+	struct Entry
+	{
+		const char* name;
+		const char* description;
+		bool (*function)();	// Returns false if a check failed.
+	};
+
+	static const Entry entries[];
+
+	// -----------------------------------------------
+	// Benchmarks.
+	// -----------------------------------------------
+
+	static bool RenderQueueSort();
+	static bool FrustumCull();
+	static bool MultiViewCull();
+	static bool OcclusionCull();
+	static bool CommandBufferRecord();
+	static bool StateCache();
+	static bool ConstantRing();
+	static bool FrameGraphCompile();
+	static bool SoftwareRaster();
+	static bool LodSelect();
+	static bool RenderCounterAdd();
+	static bool ShaderHandles();
+	static bool ConstantRanges();
+	static bool ReflectionCache();
+	static bool InputMapUpdate();
+	static bool InstancingMatch();
+
+	// -----------------------------------------------
+	// Helper methods.
+	// -----------------------------------------------
+
+	static void Report(const char* label, std::vector<float>& milliseconds);
+};
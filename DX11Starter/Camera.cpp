@@ -280,10 +280,13 @@ void swap(TransformDescription& lhs, TransformDescription& rhs)
 	// Swap the members.
 	swap(lhs.heading, rhs.heading);
 	swap(lhs.up, rhs.up);
+	swap(lhs.right, rhs.right);
+	swap(lhs.rotation, rhs.rotation);
 	swap(lhs.position_start, rhs.position_start);
 	swap(lhs.position, rhs.position);
 	swap(lhs.orientation_start, rhs.orientation_start);
 	swap(lhs.orientation, rhs.orientation);
+	swap(lhs.version, rhs.version);
 }
 
 // ---------------------
@@ -319,11 +322,13 @@ TransformDescription::TransformDescription(
 	XMFLOAT3 _rotation)
 	: heading{ UnitVector::GetDefaultForward() },
 	up{ UnitVector::GetDefaultUp() },
+	right{ UnitVector::GetDefaultRight() },
+	rotation(0.0f, 0.0f, 0.0f, 1.0f),
 	position_start(_position), position(_position),
-	orientation_start(_rotation), orientation(_rotation)
+	orientation_start(_rotation), orientation(_rotation),
+	version(0)
 {
-	this->CalculateHeading();
-	this->CalculateUp();
+	this->CalculateBasis();
 }
 
 /// <summary>
@@ -367,10 +372,13 @@ TransformDescription::TransformDescription(const TransformDescription& other)
 	// Assign member data.
 	this->heading = other.heading;
 	this->up = other.up;
+	this->right = other.right;
+	this->rotation = other.rotation;
 	this->position_start = other.position_start;
 	this->position = other.position;
 	this->orientation_start = other.orientation_start;
 	this->orientation = other.orientation;
+	this->version = other.version;
 }
 
 /// <summary>
@@ -506,6 +514,43 @@ void TransformDescription::GetUp(XMFLOAT3& target) const
 	target = XMFLOAT3(up.Get());
 }
 
+/// <summary>
+/// Gets the current right direction.
+/// </summary>
+/// <returns>Returns float vector.</returns>
+XMFLOAT3 TransformDescription::GetRight() const
+{
+	return this->right.Get();
+}
+
+/// <summary>
+/// Gets the current right direction.
+/// </summary>
+/// <param name="target">The target.</param>
+void TransformDescription::GetRight(XMFLOAT3& target) const
+{
+	target = XMFLOAT3(right.Get());
+}
+
+/// <summary>
+/// Gets the orientation as a quaternion.
+/// </summary>
+/// <returns>Returns the quaternion the heading, up and right vectors were rotated by.</returns>
+const XMFLOAT4& TransformDescription::GetRotation() const
+{
+	return this->rotation;
+}
+
+/// <summary>
+/// Gets the version, which changes whenever the position or
+/// orientation does. Lets cameras skip rebuilding matrices.
+/// </summary>
+/// <returns>Returns the version.</returns>
+unsigned int TransformDescription::GetVersion() const
+{
+	return this->version;
+}
+
 
 // ---------------------
 // Mutators.
@@ -529,6 +574,7 @@ void TransformDescription::Translate(XMFLOAT3 delta)
 	position.x += delta.x;
 	position.y += delta.y;
 	position.z += delta.z;
+	version++;
 }
 
 /// <summary>
@@ -540,8 +586,7 @@ void TransformDescription::Rotate(DirectX::XMFLOAT3 delta)
 	orientation.x += delta.x;
 	orientation.y += delta.y;
 	orientation.z += delta.z;
-	CalculateHeading();
-	CalculateUp();
+	CalculateBasis();
 }
 
 /// <summary>
@@ -551,6 +596,7 @@ void TransformDescription::Rotate(DirectX::XMFLOAT3 delta)
 void TransformDescription::SetPosition(XMFLOAT3 absolute)
 {
 	position = XMFLOAT3(absolute);
+	version++;
 }
 
 /// <summary>
@@ -560,8 +606,7 @@ void TransformDescription::SetPosition(XMFLOAT3 absolute)
 void TransformDescription::SetRotation(XMFLOAT3 absolute)
 {
 	orientation = XMFLOAT3(absolute);
-	CalculateHeading();
-	CalculateUp();
+	CalculateBasis();
 }
 
 // -------------
@@ -617,9 +662,6 @@ void TransformDescription::UpdateRotation(
 		{
 			this->Rotate(delta);
 		}
-
-		CalculateHeading();
-		CalculateUp();
 	}
 }
 
@@ -676,9 +718,6 @@ void TransformDescription::UpdateRotation(
 		{
 			this->Rotate(delta);
 		}
-
-		CalculateHeading();
-		CalculateUp();
 	}
 }
 
@@ -690,57 +729,35 @@ void TransformDescription::UpdateRotation(
 // Helper methods.
 
 /// <summary>
-/// Calculates the heading.
+/// Builds the orientation quaternion once and rotates the
+/// default forward, up and right vectors by it.
 /// </summary>
-void TransformDescription::CalculateHeading()
+void TransformDescription::CalculateBasis()
 {
-	// Get default Forward (Z) vector.
-	XMFLOAT3 forward_safe = UnitVector::GetDefaultForward().Get();
-	XMVECTOR forward = XMLoadFloat3(&forward_safe);
-
 	// Get the current orientation as a quaternion. Pitch(y), Yaw(x), Roll(z)
-	XMVECTOR rotation = XMQuaternionRotationRollPitchYaw(
+	XMVECTOR quaternion = XMQuaternionRotationRollPitchYaw(
 		this->orientation.y,
 		this->orientation.x,
 		this->orientation.z
 	);
-	
-	// Apply current orientation to forward default.
-	XMVECTOR direction = XMVector3Rotate(forward, rotation);
-	
-	// Store the direction in a safe format.
-	XMFLOAT3 direction_safe;
-	XMStoreFloat3(&direction_safe, direction);
+	XMStoreFloat4(&this->rotation, quaternion);
 
-	// Store the calculated result.
-	this->heading.Set(direction_safe);
-}
-
-/// <summary>
-/// Calculates the up vector.
-/// </summary>
-void TransformDescription::CalculateUp()
-{
-	// Get default Up (Y) vector.
+	// Default Forward (Z), Up (Y) and Right (X) vectors.
+	XMFLOAT3 forward_safe = UnitVector::GetDefaultForward().Get();
 	XMFLOAT3 global_up_safe = UnitVector::GetDefaultUp().Get();
-	XMVECTOR global_up = XMLoadFloat3(&global_up_safe);
+	XMFLOAT3 global_right_safe = UnitVector::GetDefaultRight().Get();
 
-	// Get the current orientation as a quaternion. Pitch(y), Yaw(x), Roll(z)
-	XMVECTOR rotation = XMQuaternionRotationRollPitchYaw(
-		this->orientation.y,
-		this->orientation.x,
-		this->orientation.z
-	);
-
-	// Apply current orientation to forward default.
-	XMVECTOR relative_up = XMVector3Rotate(global_up, rotation);
-
-	// Store the direction in a safe format.
-	XMFLOAT3 relative_up_safe;
-	XMStoreFloat3(&relative_up_safe, relative_up);
+	// Apply current orientation to each default.
+	XMFLOAT3 direction_safe, relative_up_safe, relative_right_safe;
+	XMStoreFloat3(&direction_safe, XMVector3Rotate(XMLoadFloat3(&forward_safe), quaternion));
+	XMStoreFloat3(&relative_up_safe, XMVector3Rotate(XMLoadFloat3(&global_up_safe), quaternion));
+	XMStoreFloat3(&relative_right_safe, XMVector3Rotate(XMLoadFloat3(&global_right_safe), quaternion));
 
-	// Store the calculated result.
+	// Store the calculated results.
+	this->heading.Set(direction_safe);
 	this->up.Set(relative_up_safe);
+	this->right.Set(relative_right_safe);
+	version++;
 }
 #pragma endregion
 
@@ -1365,6 +1382,14 @@ void swap(Camera& lhs, Camera& rhs)
 	swap(lhs.settings, rhs.settings);
 	swap(lhs.view, rhs.view);
 	swap(lhs.projection, rhs.projection);
+	swap(lhs.viewProjection, rhs.viewProjection);
+	swap(lhs.inverseView, rhs.inverseView);
+	swap(lhs.inverseProjection, rhs.inverseProjection);
+	swap(lhs.inverseViewProjection, rhs.inverseViewProjection);
+	swap(lhs.frustumPlanes, rhs.frustumPlanes);
+	swap(lhs.version, rhs.version);
+	swap(lhs.transformVersion, rhs.transformVersion);
+	swap(lhs.projectionDirty, rhs.projectionDirty);
 	swap(lhs.tracker, rhs.tracker);
 }
 
@@ -1390,7 +1415,13 @@ Camera::Camera(CameraOptions options)
 /// <param name="transform">The transform.</param>
 Camera::Camera(CameraOptions options, TransformDescription transform)
 	: settings{ options }, transform{ transform },
-	  view(), projection(), tracker() {}
+	  view(), projection(), viewProjection(), inverseView(), inverseProjection(), inverseViewProjection(),
+	  frustumPlanes(), version(0), transformVersion(0), projectionDirty(true), tracker()
+{
+	// Build every matrix now, so a new camera is ready to use.
+	this->transformVersion = this->transform.GetVersion() - 1;
+	this->Update();
+}
 
 /// <summary>
 /// Initializes a new instance of the <see cref="Camera"/> class.
@@ -1456,6 +1487,14 @@ Camera::Camera(const Camera& other)
 	this->settings = other.settings; // We wrote our own copy assignment!
 	this->view = other.view;
 	this->projection = other.projection;
+	this->viewProjection = other.viewProjection;
+	this->inverseView = other.inverseView;
+	this->inverseProjection = other.inverseProjection;
+	this->inverseViewProjection = other.inverseViewProjection;
+	this->frustumPlanes = other.frustumPlanes;
+	this->version = other.version;
+	this->transformVersion = other.transformVersion;
+	this->projectionDirty = other.projectionDirty;
 	this->tracker = other.tracker;
 }
 
@@ -1487,7 +1526,7 @@ Camera& Camera::operator=(Camera other)
 /// Gets the view matrix.
 /// </summary>
 /// <returns>Returns a matrix.</returns>
-XMFLOAT4X4 Camera::GetViewMatrix() const
+const XMFLOAT4X4& Camera::GetViewMatrix() const
 {
 	return this->view;
 }
@@ -1505,7 +1544,7 @@ void Camera::GetViewMatrix(XMFLOAT4X4& target) const
 /// Gets the projection matrix.
 /// </summary>
 /// <returns>Returns a matrix.</returns>
-XMFLOAT4X4 Camera::GetProjectionMatrix() const
+const XMFLOAT4X4& Camera::GetProjectionMatrix() const
 {
 	return this->projection;
 }
@@ -1519,11 +1558,50 @@ void Camera::GetProjectionMatrix(XMFLOAT4X4& target) const
 	target = this->projection;
 }
 
+/// <summary>
+/// Gets the view-projection matrix (transposed, like the
+/// view and projection matrices).
+/// </summary>
+/// <returns>Returns a matrix.</returns>
+const XMFLOAT4X4& Camera::GetViewProjectionMatrix() const
+{
+	return this->viewProjection;
+}
+
+/// <summary>
+/// Gets the inverse of the view matrix (the camera's world
+/// matrix), transposed.
+/// </summary>
+/// <returns>Returns a matrix.</returns>
+const XMFLOAT4X4& Camera::GetInverseViewMatrix() const
+{
+	return this->inverseView;
+}
+
+/// <summary>
+/// Gets the inverse of the projection matrix, transposed.
+/// </summary>
+/// <returns>Returns a matrix.</returns>
+const XMFLOAT4X4& Camera::GetInverseProjectionMatrix() const
+{
+	return this->inverseProjection;
+}
+
+/// <summary>
+/// Gets the inverse of the view-projection matrix (clip
+/// space back to world space), transposed.
+/// </summary>
+/// <returns>Returns a matrix.</returns>
+const XMFLOAT4X4& Camera::GetInverseViewProjectionMatrix() const
+{
+	return this->inverseViewProjection;
+}
+
 /// <summary>
 /// Gets the transform.
 /// </summary>
 /// <returns>Returns the transform.</returns>
-TransformDescription Camera::GetTransform() const
+const TransformDescription& Camera::GetTransform() const
 {
 	return this->transform;
 }
@@ -1555,6 +1633,28 @@ void Camera::GetMouseTracker(MouseTracker& target) const
 	target = tracker;
 }
 
+/// <summary>
+/// Gets the view frustum's planes. A point p is inside a plane
+/// when dot(plane.xyz, p) + plane.w >= 0; the planes are
+/// normalized, so that value is also the distance to the plane.
+/// </summary>
+/// <returns>Returns the left, right, bottom, top, near and far planes.</returns>
+const std::array<XMFLOAT4, 6>& Camera::GetFrustumPlanes() const
+{
+	return this->frustumPlanes;
+}
+
+/// <summary>
+/// Gets the version, bumped each time Update() recalculates
+/// the matrices. Compare against a saved version to skip work
+/// that depends on the camera when it hasn't moved.
+/// </summary>
+/// <returns>Returns the version.</returns>
+unsigned int Camera::GetVersion() const
+{
+	return this->version;
+}
+
 // ---------------------
 // Mutators.
 
@@ -1565,6 +1665,7 @@ void Camera::GetMouseTracker(MouseTracker& target) const
 void Camera::SetFOV(float fov)
 {
 	this->settings.SetFieldOfView(fov);
+	this->projectionDirty = true;
 }
 
 /// <summary>
@@ -1588,6 +1689,7 @@ void Camera::SetClippingPlane(float nearPlane, float farPlane)
 {
 	this->settings.SetNearClippingPlane(nearPlane);
 	this->settings.SetFarClippingPlane(farPlane);
+	this->projectionDirty = true;
 }
 
 // ---------------------
@@ -1599,8 +1701,7 @@ void Camera::SetClippingPlane(float nearPlane, float farPlane)
 void Camera::Reset()
 {
 	this->transform.Reset();
-	this->UpdateViewMatrix();
-	this->UpdateProjectionMatrix();
+	this->projectionDirty = true;
 }
 
 /// <summary>
@@ -1625,7 +1726,6 @@ void Camera::UpdatePosition(
 	XMFLOAT3 speed, bool isRelative /* = true */)
 {
 	this->transform.UpdatePosition(speed, isRelative);
-	this->UpdateViewMatrix();
 }
 
 /// <summary>
@@ -1637,7 +1737,6 @@ void Camera::UpdateRotation(
 	XMFLOAT3 speed, bool isRelative /* = true */)
 {
 	this->transform.UpdateRotation(speed, isRelative);
-	this->UpdateViewMatrix();
 }
 
 /// <summary>
@@ -1652,7 +1751,6 @@ void Camera::UpdatePosition(
 	XMFLOAT3 speed, bool isRelative /* = true */) 
 {
 	this->transform.UpdatePosition(deltaTime, totalTime, speed, isRelative);
-	this->UpdateViewMatrix();
 }
 
 /// <summary>
@@ -1667,23 +1765,54 @@ void Camera::UpdateRotation(
 	XMFLOAT3 speed, bool isRelative /* = true */) 
 {
 	this->transform.UpdateRotation(deltaTime, totalTime, speed, isRelative);
-	this->UpdateViewMatrix();
 }
 
 /// <summary>
-/// Updates the view matrix.
+/// Rebuilds whatever the changes since the last call affect:
+/// the view matrix if the transform's version moved, the
+/// projection matrix if a setting changed, and then the
+/// view-projection matrix, inverses and frustum planes from
+/// them. Mutators only record changes, so a camera moved and
+/// turned several times in a frame is rebuilt once.
+/// </summary>
+/// <returns>Returns false if nothing changed.</returns>
+bool Camera::Update()
+{
+	bool viewDirty = this->transformVersion != this->transform.GetVersion();
+	if (!viewDirty && !this->projectionDirty)
+		return false;
+
+	if (viewDirty)
+	{
+		this->view = CalculateViewMatrix();
+		this->transformVersion = this->transform.GetVersion();
+	}
+	if (this->projectionDirty)
+	{
+		this->projection = CalculateProjectionMatrix();
+		this->projectionDirty = false;
+	}
+
+	CalculateDerivedMatrices();
+	this->version++;
+	return true;
+}
+
+/// <summary>
+/// Updates the view matrix (and everything built from it).
 /// </summary>
 void Camera::UpdateViewMatrix()
 {
-	this->view = CalculateViewMatrix();
+	this->Update();
 }
 
 /// <summary>
-/// Updates the projection matrix.
+/// Updates the projection matrix (and everything built from it).
 /// </summary>
 void Camera::UpdateProjectionMatrix()
 {
-	this->projection = CalculateProjectionMatrix();
+	this->projectionDirty = true;
+	this->Update();
 }
 
 /// <summary>
@@ -1748,10 +1877,10 @@ void Camera::GetCurrentOrientation(XMFLOAT3& target) const
 }
 
 /// <summary>
-/// Gets the current orientation.
+/// Gets the camera settings.
 /// </summary>
-/// <returns>Returns float vector.</returns>
-CameraOptions Camera::GetSettings() const 
+/// <returns>Returns the settings.</returns>
+const CameraOptions& Camera::GetSettings() const
 {
 	return this->settings;
 }
@@ -1767,7 +1896,6 @@ CameraOptions Camera::GetSettings() const
 void Camera::MoveBy(XMFLOAT3 delta)
 {
 	this->transform.Translate(delta);
-	this->UpdateViewMatrix();
 }
 
 /// <summary>
@@ -1777,7 +1905,6 @@ void Camera::MoveBy(XMFLOAT3 delta)
 void Camera::MoveTo(XMFLOAT3 absolute) 
 {
 	this->transform.SetPosition(absolute);
-	this->UpdateViewMatrix();
 }
 
 /// <summary>
@@ -1787,7 +1914,6 @@ void Camera::MoveTo(XMFLOAT3 absolute)
 void Camera::RotateBy(XMFLOAT3 delta) 
 {
 	this->transform.Rotate(delta);
-	this->UpdateViewMatrix();
 }
 
 /// <summary>
@@ -1797,7 +1923,6 @@ void Camera::RotateBy(XMFLOAT3 delta)
 void Camera::RotateTo(XMFLOAT3 absolute)
 {
 	this->transform.SetRotation(absolute);
-	this->UpdateViewMatrix();
 }
 
 // ---------------------
@@ -1809,7 +1934,7 @@ void Camera::RotateTo(XMFLOAT3 absolute)
 void Camera::OnResize()
 {
 	this->settings.UpdateAspectRatio();
-	this->UpdateProjectionMatrix();
+	this->projectionDirty = true;
 }
 
 /// <summary>
@@ -1818,7 +1943,8 @@ void Camera::OnResize()
 /// <returns>Returns the matrix in XMFLOAT4X4 format.</returns>
 XMFLOAT4X4 Camera::CalculateViewMatrix()
 {
-	// Get view matrix data.
+	// Get view matrix data (heading and up were already
+	// rotated by the transform when it last turned).
 	XMFLOAT3 p = this->GetCurrentPosition();
 	XMFLOAT3 d = this->transform.GetHeading();
 	XMFLOAT3 u = this->transform.GetUp();
@@ -1871,4 +1997,37 @@ XMFLOAT4X4 Camera::CalculateProjectionMatrix()
 	return proj;
 }
 
-#pragma endregion
\ No newline at end of file
+#pragma endregion
+
+/// <summary>
+/// Calculates the matrices built from the view and projection
+/// matrices, and the frustum planes (Gribb/Hartmann).
+/// </summary>
+void Camera::CalculateDerivedMatrices()
+{
+	// Both matrices are stored transposed, so their product
+	// is the transposed view-projection matrix, whose rows
+	// are the columns the planes are built from.
+	XMMATRIX VIEW = XMLoadFloat4x4(&this->view);
+	XMMATRIX PROJ = XMLoadFloat4x4(&this->projection);
+	XMMATRIX clip = XMMatrixMultiply(PROJ, VIEW);
+	XMStoreFloat4x4(&this->viewProjection, clip);
+
+	// The inverse of a transpose is the transpose of the
+	// inverse, so these are stored transposed as well.
+	XMStoreFloat4x4(&this->inverseView, XMMatrixInverse(nullptr, VIEW));
+	XMStoreFloat4x4(&this->inverseProjection, XMMatrixInverse(nullptr, PROJ));
+	XMStoreFloat4x4(&this->inverseViewProjection, XMMatrixInverse(nullptr, clip));
+
+	XMVECTOR planes[6] = {
+		XMVectorAdd(clip.r[3], clip.r[0]),		// Left:   w + x >= 0
+		XMVectorSubtract(clip.r[3], clip.r[0]),	// Right:  w - x >= 0
+		XMVectorAdd(clip.r[3], clip.r[1]),		// Bottom: w + y >= 0
+		XMVectorSubtract(clip.r[3], clip.r[1]),	// Top:    w - y >= 0
+		clip.r[2],								// Near:   z >= 0 (Direct3D depth range)
+		XMVectorSubtract(clip.r[3], clip.r[2])	// Far:    w - z >= 0
+	};
+
+	for (int i = 0; i < 6; i++)
+		XMStoreFloat4(&this->frustumPlanes[i], XMPlaneNormalize(planes[i]));
+}
@@ -199,6 +199,12 @@ struct TransformDescription {
 	DirectX::XMFLOAT3 GetHeading() const;
 	void GetHeading(DirectX::XMFLOAT3& target) const;
 
+	DirectX::XMFLOAT3 GetRight() const;
+	void GetRight(DirectX::XMFLOAT3& target) const;
+
+	const DirectX::XMFLOAT4& GetRotation() const; // Orientation as a quaternion.
+	unsigned int GetVersion() const; // Changes whenever the position or orientation does.
+
 	// -------------
 	// Mutators.
 
@@ -225,16 +231,18 @@ private:
 
 	UnitVector up; // Up vector.
 	UnitVector heading; // Forward vector.
+	UnitVector right; // Right vector.
+	DirectX::XMFLOAT4 rotation; // Quaternion built from the orientation.
 	DirectX::XMFLOAT3 position_start; // Starting position in local space.
 	DirectX::XMFLOAT3 position; // Position of user camera in local space.
 	DirectX::XMFLOAT3 orientation_start; // Yaw (x), Pitch (y), Roll (z) for base orientation.
 	DirectX::XMFLOAT3 orientation; // Yaw (x), Pitch (y), Roll (z) for camera rotation. Rotation around z-axis is usually locked.
+	unsigned int version; // Bumped by every change.
 
 	// -------------
 	// Helper members.
 
-	void CalculateHeading();
-	void CalculateUp();
+	void CalculateBasis(); // Quaternion, then heading, up and right from it.
 
 };
 
@@ -381,18 +389,31 @@ public:
 	// Accessors.
 	// ------------------------------------
 
-	DirectX::XMFLOAT4X4 GetViewMatrix() const;
+	// Matrices are stored transposed (ready for HLSL), as of the last Update().
+
+	const DirectX::XMFLOAT4X4& GetViewMatrix() const;
 	void GetViewMatrix(DirectX::XMFLOAT4X4& target) const;
 
-	DirectX::XMFLOAT4X4 GetProjectionMatrix() const;
+	const DirectX::XMFLOAT4X4& GetProjectionMatrix() const;
 	void GetProjectionMatrix(DirectX::XMFLOAT4X4& target) const;
 
-	TransformDescription GetTransform() const;
+	const DirectX::XMFLOAT4X4& GetViewProjectionMatrix() const;
+	const DirectX::XMFLOAT4X4& GetInverseViewMatrix() const;
+	const DirectX::XMFLOAT4X4& GetInverseProjectionMatrix() const;
+	const DirectX::XMFLOAT4X4& GetInverseViewProjectionMatrix() const;
+
+	const TransformDescription& GetTransform() const;
 	void GetTransform(TransformDescription& target) const;
 
 	const MouseTracker& GetMouseTracker() const;
 	void GetMouseTracker(MouseTracker& target) const;
 
+	const CameraOptions& GetSettings() const;
+
+	const std::array<DirectX::XMFLOAT4, 6>& GetFrustumPlanes() const; // Left, right, bottom, top, near, far. Normals (xyz) face inward.
+
+	unsigned int GetVersion() const; // Bumped each time Update() recalculates anything.
+
 	// ------------------------------------
 	// Mutators.
 	// ------------------------------------
@@ -412,6 +433,7 @@ public:
 	void UpdatePosition(float deltaTime, float totalTime, DirectX::XMFLOAT3 speed, bool isRelative = true); // Relative translation.
 	void UpdateRotation(float deltaTime, float totalTime, DirectX::XMFLOAT3 speed, bool isRelative = true); // Relative rotation.
 
+	bool Update(); // Recalculates what the changes since the last call affect. Returns false if nothing changed.
 	void UpdateViewMatrix();
 	void UpdateProjectionMatrix();
 	
@@ -429,6 +451,14 @@ private:
 	CameraOptions settings; // Contains the settings for the camera object.
 	DirectX::XMFLOAT4X4 view; // Stores the view matrix.
 	DirectX::XMFLOAT4X4 projection; // Stores the projection matrix.
+	DirectX::XMFLOAT4X4 viewProjection; // Product of the two (projection * view, as both are transposed).
+	DirectX::XMFLOAT4X4 inverseView;
+	DirectX::XMFLOAT4X4 inverseProjection;
+	DirectX::XMFLOAT4X4 inverseViewProjection;
+	std::array<DirectX::XMFLOAT4, 6> frustumPlanes; // From the view-projection matrix.
+	unsigned int version; // Bumped by each Update() that changed something.
+	unsigned int transformVersion; // Transform version the view matrix was built from.
+	bool projectionDirty; // Settings changed since the projection matrix was built.
 
 	// ------------------------------------
 	// Accessors.
@@ -440,8 +470,6 @@ private:
 	DirectX::XMFLOAT3 GetCurrentOrientation() const;
 	void GetCurrentOrientation(DirectX::XMFLOAT3& target) const;
 
-	CameraOptions GetSettings() const;
-
 	// ------------------------------------
 	// Mutators.
 	// ------------------------------------
@@ -462,4 +490,6 @@ private:
 
 	DirectX::XMFLOAT4X4 CalculateProjectionMatrix();
 
+	void CalculateDerivedMatrices(); // View-projection, inverses and frustum planes.
+
 };
@@ -0,0 +1,28 @@
+#pragma once
+
+// -----------------------------------------------
+// Include statements.
+// -----------------------------------------------
+#include <cstdio>
+
+// -----------------------------------------------
+// Check.h
+// ---
+// The assertion used by the unit tests and by the
+// benchmarks' correctness checks. A condition that
+// doesn't hold is printed with its file and line,
+// and fails the test or benchmark it's in, which
+// declares "bool passed". Unlike assert(), it's
+// kept in release builds and doesn't stop at the
+// first failure.
+// -----------------------------------------------
+
+#define CHECK(condition) \
+	do \
+	{ \
+		if (!(condition)) \
+		{ \
+			printf("  %s(%d): CHECK(%s) failed\n", __FILE__, __LINE__, #condition); \
+			passed = false; \
+		} \
+	} while (0)
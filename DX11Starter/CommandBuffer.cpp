@@ -0,0 +1,534 @@
+// -----------------------------------------------
+// Include statements.
+// -----------------------------------------------
+#include "CommandBuffer.h"
+#include <cstring>
+
+// -----------------------------------------------
+// Constructors.
+// -----------------------------------------------
+
+/// <summary>
+/// Create an empty command buffer.
+/// </summary>
+/// <param name="reserveBytes">Memory to allocate up front.</param>
+CommandBuffer::CommandBuffer(size_t reserveBytes)
+	: IRenderBackend(), memory(reserveBytes), size{ 0 }, commandCount{ 0 }
+{}
+
+/// <summary>
+/// Nothing to release; the recorded pointers aren't owned.
+/// </summary>
+CommandBuffer::~CommandBuffer() {}
+
+// -----------------------------------------------
+// Static methods.
+// -----------------------------------------------
+
+/// <summary>
+/// Short name of a command.
+/// </summary>
+const char* CommandBuffer::GetCommandName(CommandType type)
+{
+	static const char* names[CT_COUNT] = {
+		"clear", "topology", "input layout", "vertex shader", "pixel shader",
+		"VS constants", "PS constants", "vertex buffer", "index buffer", "draw indexed",
+		"instance buffer", "draw indexed instanced", "update dynamic buffer",
+		"update constant buffer", "present", "write VS constants"
+	};
+	return (type >= 0 && type < CT_COUNT) ? names[type] : "?";
+}
+
+// -----------------------------------------------
+// Accessors.
+// -----------------------------------------------
+
+/// <summary>
+/// Bytes recorded since the last Reset().
+/// </summary>
+size_t CommandBuffer::GetSize() const
+{
+	return size;
+}
+
+/// <summary>
+/// Bytes that can be recorded before growing.
+/// </summary>
+size_t CommandBuffer::GetCapacity() const
+{
+	return memory.size();
+}
+
+/// <summary>
+/// Commands recorded since the last Reset().
+/// </summary>
+unsigned int CommandBuffer::GetCommandCount() const
+{
+	return commandCount;
+}
+
+/// <summary>
+/// Has nothing been recorded?
+/// </summary>
+bool CommandBuffer::IsEmpty() const
+{
+	return commandCount == 0;
+}
+
+// -----------------------------------------------
+// Service methods.
+// -----------------------------------------------
+
+/// <summary>
+/// Drop every command. The memory is kept for the next frame.
+/// </summary>
+void CommandBuffer::Reset()
+{
+	size = 0;
+	commandCount = 0;
+	stats = {};
+}
+
+/// <summary>
+/// Replay every command, in order, into another backend.
+/// The buffer itself is unchanged and can be replayed again.
+/// </summary>
+/// <param name="target">Backend to submit to.</param>
+/// <returns>Returns the result of the last recorded Present(), or S_OK.</returns>
+HRESULT CommandBuffer::Execute(IRenderBackend* target) const
+{
+	HRESULT result = S_OK;
+	const unsigned char* packet = memory.data();
+	const unsigned char* end = packet + size;
+
+	while (packet < end)
+	{
+		Header header;
+		memcpy(&header, packet, sizeof(Header));
+		const unsigned char* payload = packet + sizeof(Header);
+
+		switch (header.type)
+		{
+		case CT_CLEAR:
+		{
+			ClearCommand command;
+			memcpy(&command, payload, sizeof(command));
+			target->Clear(command.renderTarget, command.depthStencil, command.color);
+			break;
+		}
+		case CT_TOPOLOGY:
+		{
+			TopologyCommand command;
+			memcpy(&command, payload, sizeof(command));
+			target->SetPrimitiveTopology(command.topology);
+			break;
+		}
+		case CT_INPUT_LAYOUT:
+		{
+			InputLayoutCommand command;
+			memcpy(&command, payload, sizeof(command));
+			target->SetInputLayout(command.layout);
+			break;
+		}
+		case CT_VERTEX_SHADER:
+		{
+			VertexShaderCommand command;
+			memcpy(&command, payload, sizeof(command));
+			target->SetVertexShader(command.shader);
+			break;
+		}
+		case CT_PIXEL_SHADER:
+		{
+			PixelShaderCommand command;
+			memcpy(&command, payload, sizeof(command));
+			target->SetPixelShader(command.shader);
+			break;
+		}
+		case CT_VS_CONSTANT_BUFFER:
+		case CT_PS_CONSTANT_BUFFER:
+		{
+			ConstantBufferCommand command;
+			memcpy(&command, payload, sizeof(command));
+			if (header.type == CT_VS_CONSTANT_BUFFER)
+				target->SetVSConstantBuffer(command.slot, command.buffer);
+			else
+				target->SetPSConstantBuffer(command.slot, command.buffer);
+			break;
+		}
+		case CT_VERTEX_BUFFER:
+		case CT_INSTANCE_BUFFER:
+		{
+			BufferCommand command;
+			memcpy(&command, payload, sizeof(command));
+			if (header.type == CT_VERTEX_BUFFER)
+				target->SetVertexBuffer(command.buffer, command.stride, command.offset);
+			else
+				target->SetInstanceBuffer(command.buffer, command.stride, command.offset);
+			break;
+		}
+		case CT_INDEX_BUFFER:
+		{
+			IndexBufferCommand command;
+			memcpy(&command, payload, sizeof(command));
+			target->SetIndexBuffer(command.buffer, command.format, command.offset);
+			break;
+		}
+		case CT_DRAW_INDEXED:
+		{
+			DrawIndexedCommand command;
+			memcpy(&command, payload, sizeof(command));
+			target->DrawIndexed(command.indexCount, command.startIndex, command.baseVertex);
+			break;
+		}
+		case CT_DRAW_INDEXED_INSTANCED:
+		{
+			DrawIndexedInstancedCommand command;
+			memcpy(&command, payload, sizeof(command));
+			target->DrawIndexedInstanced(command.indexCount, command.instanceCount,
+				command.startIndex, command.baseVertex, command.startInstance);
+			break;
+		}
+		case CT_UPDATE_DYNAMIC_BUFFER:
+		case CT_UPDATE_CONSTANT_BUFFER:
+		{
+			// The data sits right after the payload.
+			UpdateCommand command;
+			memcpy(&command, payload, sizeof(command));
+			const unsigned char* data = payload + sizeof(UpdateCommand);
+			if (header.type == CT_UPDATE_DYNAMIC_BUFFER)
+				target->UpdateDynamicBuffer(command.buffer, data, command.size);
+			else
+				target->UpdateConstantBuffer(command.buffer, data, command.size);
+			break;
+		}
+		case CT_PRESENT:
+		{
+			PresentCommand command;
+			memcpy(&command, payload, sizeof(command));
+			result = target->Present(command.syncInterval, command.flags);
+			break;
+		}
+		case CT_WRITE_VS_CONSTANTS:
+		{
+			ConstantsCommand command;
+			memcpy(&command, payload, sizeof(command));
+			target->WriteVSConstants(command.slot, command.buffer, payload + sizeof(ConstantsCommand), command.size);
+			break;
+		}
+		}
+
+		packet += header.size;
+	}
+
+	return result;
+}
+
+/// <summary>
+/// Walk the packets and check that each one is a known
+/// command, large enough for its payload and data, and
+/// inside the recorded range. Execute() trusts all of this.
+/// </summary>
+/// <param name="error">Receives a description of the first bad packet.</param>
+/// <returns>Returns true if the stream can be replayed.</returns>
+bool CommandBuffer::Validate(std::string* error) const
+{
+	size_t offset = 0;
+	unsigned int count = 0;
+	std::string problem;
+
+	while (offset < size && problem.empty())
+	{
+		Header header;
+		if (size - offset < sizeof(Header))
+		{
+			problem = "truncated header";
+			break;
+		}
+		memcpy(&header, memory.data() + offset, sizeof(Header));
+
+		if (header.type >= CT_COUNT)
+		{
+			problem = "unknown command " + std::to_string(header.type);
+			break;
+		}
+
+		CommandType type = (CommandType)header.type;
+		size_t needed = sizeof(Header) + GetPayloadSize(type);
+		if (header.size >= needed && size - offset >= needed)
+		{
+			const unsigned char* payload = memory.data() + offset + sizeof(Header);
+			if (type == CT_UPDATE_DYNAMIC_BUFFER || type == CT_UPDATE_CONSTANT_BUFFER)
+			{
+				UpdateCommand command;
+				memcpy(&command, payload, sizeof(command));
+				needed += command.size;
+			}
+			else if (type == CT_WRITE_VS_CONSTANTS)
+			{
+				ConstantsCommand command;
+				memcpy(&command, payload, sizeof(command));
+				needed += command.size;
+			}
+		}
+
+		if (header.size % PACKET_ALIGNMENT != 0)
+			problem = std::string(GetCommandName(type)) + " is not aligned";
+		else if (header.size < needed)
+			problem = std::string(GetCommandName(type)) + " is too small";
+		else if (header.size > size - offset)
+			problem = std::string(GetCommandName(type)) + " runs past the end";
+		else
+		{
+			offset += header.size;
+			count++;
+		}
+	}
+
+	if (problem.empty() && count != commandCount)
+		problem = "expected " + std::to_string(commandCount) + " commands, found " + std::to_string(count);
+
+	if (!problem.empty())
+	{
+		if (error)
+			*error = "Command " + std::to_string(count) + " at byte " + std::to_string(offset) + ": " + problem;
+		return false;
+	}
+	return true;
+}
+
+// -----------------------------------------------
+// IRenderBackend.
+// -----------------------------------------------
+
+/// <summary>
+/// Records a clear.
+/// </summary>
+void CommandBuffer::Clear(ID3D11RenderTargetView* renderTarget, ID3D11DepthStencilView* depthStencil, const float color[4])
+{
+	ClearCommand command = { renderTarget, depthStencil, { color[0], color[1], color[2], color[3] } };
+	Record(CT_CLEAR, command);
+	stats.clears++;
+}
+
+/// <summary>
+/// Records a topology change.
+/// </summary>
+void CommandBuffer::SetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY topology)
+{
+	TopologyCommand command = { topology };
+	Record(CT_TOPOLOGY, command);
+	stats.topologyChanges++;
+}
+
+/// <summary>
+/// Records an input layout bind.
+/// </summary>
+void CommandBuffer::SetInputLayout(ID3D11InputLayout* layout)
+{
+	InputLayoutCommand command = { layout };
+	Record(CT_INPUT_LAYOUT, command);
+	stats.inputLayoutBinds++;
+}
+
+/// <summary>
+/// Records a vertex shader bind.
+/// </summary>
+void CommandBuffer::SetVertexShader(ID3D11VertexShader* shader)
+{
+	VertexShaderCommand command = { shader };
+	Record(CT_VERTEX_SHADER, command);
+	stats.shaderBinds++;
+}
+
+/// <summary>
+/// Records a pixel shader bind.
+/// </summary>
+void CommandBuffer::SetPixelShader(ID3D11PixelShader* shader)
+{
+	PixelShaderCommand command = { shader };
+	Record(CT_PIXEL_SHADER, command);
+	stats.shaderBinds++;
+}
+
+/// <summary>
+/// Records a vertex shader constant buffer bind.
+/// </summary>
+void CommandBuffer::SetVSConstantBuffer(unsigned int slot, ID3D11Buffer* buffer)
+{
+	ConstantBufferCommand command = { buffer, slot };
+	Record(CT_VS_CONSTANT_BUFFER, command);
+	stats.constantBufferBinds++;
+}
+
+/// <summary>
+/// Records a pixel shader constant buffer bind.
+/// </summary>
+void CommandBuffer::SetPSConstantBuffer(unsigned int slot, ID3D11Buffer* buffer)
+{
+	ConstantBufferCommand command = { buffer, slot };
+	Record(CT_PS_CONSTANT_BUFFER, command);
+	stats.constantBufferBinds++;
+}
+
+/// <summary>
+/// Records a vertex buffer bind.
+/// </summary>
+void CommandBuffer::SetVertexBuffer(ID3D11Buffer* buffer, unsigned int stride, unsigned int offset)
+{
+	BufferCommand command = { buffer, stride, offset };
+	Record(CT_VERTEX_BUFFER, command);
+	stats.vertexBufferBinds++;
+}
+
+/// <summary>
+/// Records an index buffer bind.
+/// </summary>
+void CommandBuffer::SetIndexBuffer(ID3D11Buffer* buffer, DXGI_FORMAT format, unsigned int offset)
+{
+	IndexBufferCommand command = { buffer, format, offset };
+	Record(CT_INDEX_BUFFER, command);
+	stats.indexBufferBinds++;
+}
+
+/// <summary>
+/// Records an indexed draw.
+/// </summary>
+void CommandBuffer::DrawIndexed(unsigned int indexCount, unsigned int startIndex, int baseVertex)
+{
+	DrawIndexedCommand command = { indexCount, startIndex, baseVertex };
+	Record(CT_DRAW_INDEXED, command);
+	stats.draws++;
+	stats.indices += indexCount;
+}
+
+/// <summary>
+/// Records an instance buffer bind.
+/// </summary>
+void CommandBuffer::SetInstanceBuffer(ID3D11Buffer* buffer, unsigned int stride, unsigned int offset)
+{
+	BufferCommand command = { buffer, stride, offset };
+	Record(CT_INSTANCE_BUFFER, command);
+	stats.instanceBufferBinds++;
+}
+
+/// <summary>
+/// Records an instanced draw.
+/// </summary>
+void CommandBuffer::DrawIndexedInstanced(unsigned int indexCount, unsigned int instanceCount, unsigned int startIndex, int baseVertex, unsigned int startInstance)
+{
+	DrawIndexedInstancedCommand command = { indexCount, instanceCount, startIndex, baseVertex, startInstance };
+	Record(CT_DRAW_INDEXED_INSTANCED, command);
+	stats.draws++;
+	stats.instancedDraws++;
+	stats.instances += instanceCount;
+	stats.indices += (unsigned long long)indexCount * instanceCount;
+}
+
+/// <summary>
+/// Records a dynamic buffer update, copying the data.
+/// </summary>
+void CommandBuffer::UpdateDynamicBuffer(ID3D11Buffer* buffer, const void* data, unsigned int size)
+{
+	UpdateCommand command = { buffer, size };
+	Record(CT_UPDATE_DYNAMIC_BUFFER, command, data, size);
+	stats.dynamicBufferUpdates++;
+	stats.dynamicBytes += size;
+}
+
+/// <summary>
+/// Records a constant buffer update, copying the data.
+/// </summary>
+void CommandBuffer::UpdateConstantBuffer(ID3D11Buffer* buffer, const void* data, unsigned int size)
+{
+	UpdateCommand command = { buffer, size };
+	Record(CT_UPDATE_CONSTANT_BUFFER, command, data, size);
+	stats.constantBufferUpdates++;
+	stats.constantBytes += size;
+}
+
+/// <summary>
+/// Records a present. The real result comes from Execute().
+/// </summary>
+HRESULT CommandBuffer::Present(unsigned int syncInterval, unsigned int flags)
+{
+	PresentCommand command = { syncInterval, flags };
+	Record(CT_PRESENT, command);
+	stats.frames++;
+	return S_OK;
+}
+
+/// <summary>
+/// Records per-draw constants, copying the data.
+/// </summary>
+void CommandBuffer::WriteVSConstants(unsigned int slot, ID3D11Buffer* buffer, const void* data, unsigned int size)
+{
+	ConstantsCommand command = { buffer, slot, size };
+	Record(CT_WRITE_VS_CONSTANTS, command, data, size);
+	stats.constantBufferUpdates++;
+	stats.constantBytes += size;
+	stats.constantBufferBinds++;
+}
+
+// -----------------------------------------------
+// Helper methods.
+// -----------------------------------------------
+
+/// <summary>
+/// Append a packet: header, payload, then any data,
+/// padded to the packet alignment. Grows by doubling.
+/// </summary>
+/// <param name="type">Command type.</param>
+/// <param name="command">Payload.</param>
+/// <param name="data">Data to copy after the payload (optional).</param>
+/// <param name="dataSize">Bytes of data.</param>
+template <typename T>
+void CommandBuffer::Record(CommandType type, const T& command, const void* data, unsigned int dataSize)
+{
+	size_t packetSize = sizeof(Header) + sizeof(T) + dataSize;
+	packetSize = (packetSize + PACKET_ALIGNMENT - 1) & ~(size_t)(PACKET_ALIGNMENT - 1);
+
+	if (size + packetSize > memory.size())
+	{
+		size_t capacity = memory.empty() ? 4096 : memory.size() * 2;
+		while (capacity < size + packetSize)
+			capacity *= 2;
+		memory.resize(capacity);
+	}
+
+	unsigned char* packet = memory.data() + size;
+	Header header = { (unsigned int)type, (unsigned int)packetSize };
+	memcpy(packet, &header, sizeof(Header));
+	memcpy(packet + sizeof(Header), &command, sizeof(T));
+	if (dataSize > 0)
+		memcpy(packet + sizeof(Header) + sizeof(T), data, dataSize);
+
+	size += packetSize;
+	commandCount++;
+}
+
+/// <summary>
+/// Size of a command's payload, not counting its header or data.
+/// </summary>
+size_t CommandBuffer::GetPayloadSize(CommandType type)
+{
+	switch (type)
+	{
+	case CT_CLEAR: return sizeof(ClearCommand);
+	case CT_TOPOLOGY: return sizeof(TopologyCommand);
+	case CT_INPUT_LAYOUT: return sizeof(InputLayoutCommand);
+	case CT_VERTEX_SHADER: return sizeof(VertexShaderCommand);
+	case CT_PIXEL_SHADER: return sizeof(PixelShaderCommand);
+	case CT_VS_CONSTANT_BUFFER:
+	case CT_PS_CONSTANT_BUFFER: return sizeof(ConstantBufferCommand);
+	case CT_VERTEX_BUFFER:
+	case CT_INSTANCE_BUFFER: return sizeof(BufferCommand);
+	case CT_INDEX_BUFFER: return sizeof(IndexBufferCommand);
+	case CT_DRAW_INDEXED: return sizeof(DrawIndexedCommand);
+	case CT_DRAW_INDEXED_INSTANCED: return sizeof(DrawIndexedInstancedCommand);
+	case CT_UPDATE_DYNAMIC_BUFFER:
+	case CT_UPDATE_CONSTANT_BUFFER: return sizeof(UpdateCommand);
+	case CT_PRESENT: return sizeof(PresentCommand);
+	case CT_WRITE_VS_CONSTANTS: return sizeof(ConstantsCommand);
+	default: return 0;
+	}
+}
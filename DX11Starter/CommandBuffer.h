@@ -0,0 +1,172 @@
+#pragma once
+
+// -----------------------------------------------
+// Include statements.
+// -----------------------------------------------
+#include "RenderBackend.h"
+#include <string>
+#include <vector>
+
+// -----------------------------------------------
+// CommandBuffer.h
+// ---
+// A backend that records instead of submitting.
+// Every call is written as a small fixed-size
+// packet (plain data, 8 byte aligned) to the end
+// of one linear block of memory; constant and
+// dynamic buffer contents are copied in after
+// their packet. Execute() later replays the
+// packets, in order, into another backend.
+//
+// Command buffers don't touch the device, so
+// several threads can each record their own at
+// once. Only Execute() has to run on the thread
+// that owns the context.
+//
+// Reset() rewinds without freeing, so a buffer
+// reused every frame stops allocating once it
+// has seen its largest frame.
+// -----------------------------------------------
+
+class CommandBuffer : public IRenderBackend
+{
+public:
+	// -----------------------------------------------
+	// Internal enum.
+	// -----------------------------------------------
+
+	/// <summary>
+	/// COMMAND_TYPE determines the layout of a packet.
+	/// </summary>
+	typedef enum _COMMAND_TYPE
+	{
+		CT_CLEAR = 0,
+		CT_TOPOLOGY = 1,
+		CT_INPUT_LAYOUT = 2,
+		CT_VERTEX_SHADER = 3,
+		CT_PIXEL_SHADER = 4,
+		CT_VS_CONSTANT_BUFFER = 5,
+		CT_PS_CONSTANT_BUFFER = 6,
+		CT_VERTEX_BUFFER = 7,
+		CT_INDEX_BUFFER = 8,
+		CT_DRAW_INDEXED = 9,
+		CT_INSTANCE_BUFFER = 10,
+		CT_DRAW_INDEXED_INSTANCED = 11,
+		CT_UPDATE_DYNAMIC_BUFFER = 12,
+		CT_UPDATE_CONSTANT_BUFFER = 13,
+		CT_PRESENT = 14,
+		CT_WRITE_VS_CONSTANTS = 15,
+		CT_COUNT = 16
+	} COMMAND_TYPE;
+
+	/// <summary>
+	/// Wrapper for COMMAND_TYPE enum.
+	/// </summary>
+	typedef COMMAND_TYPE CommandType;
+
+	// Packets start (and end) on this boundary.
+	static const unsigned int PACKET_ALIGNMENT = 8;
+
+	// -----------------------------------------------
+	// Constructors.
+	// -----------------------------------------------
+
+	CommandBuffer(size_t reserveBytes = 0);
+	~CommandBuffer();
+
+	// -----------------------------------------------
+	// Static methods.
+	// -----------------------------------------------
+
+	static const char* GetCommandName(CommandType type);
+
+	// -----------------------------------------------
+	// Accessors.
+	// -----------------------------------------------
+
+	size_t GetSize() const;			// Bytes recorded.
+	size_t GetCapacity() const;		// Bytes reserved.
+	unsigned int GetCommandCount() const;
+	bool IsEmpty() const;
+
+	// -----------------------------------------------
+	// Service methods.
+	// -----------------------------------------------
+
+	void Reset();	// Drop every command, keep the memory.
+	HRESULT Execute(IRenderBackend* target) const;	// Returns the last Present() result, or S_OK.
+	bool Validate(std::string* error = nullptr) const;
+
+	// -----------------------------------------------
+	// IRenderBackend.
+	// -----------------------------------------------
+
+	void Clear(ID3D11RenderTargetView* renderTarget, ID3D11DepthStencilView* depthStencil, const float color[4]);
+	void SetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY topology);
+	void SetInputLayout(ID3D11InputLayout* layout);
+	void SetVertexShader(ID3D11VertexShader* shader);
+	void SetPixelShader(ID3D11PixelShader* shader);
+	void SetVSConstantBuffer(unsigned int slot, ID3D11Buffer* buffer);
+	void SetPSConstantBuffer(unsigned int slot, ID3D11Buffer* buffer);
+	void SetVertexBuffer(ID3D11Buffer* buffer, unsigned int stride, unsigned int offset);
+	void SetIndexBuffer(ID3D11Buffer* buffer, DXGI_FORMAT format, unsigned int offset);
+	void DrawIndexed(unsigned int indexCount, unsigned int startIndex, int baseVertex);
+	void SetInstanceBuffer(ID3D11Buffer* buffer, unsigned int stride, unsigned int offset);
+	void DrawIndexedInstanced(unsigned int indexCount, unsigned int instanceCount, unsigned int startIndex, int baseVertex, unsigned int startInstance);
+	void UpdateDynamicBuffer(ID3D11Buffer* buffer, const void* data, unsigned int size);	// Copies the data.
+	void UpdateConstantBuffer(ID3D11Buffer* buffer, const void* data, unsigned int size);	// Copies the data. Range updates record the whole buffer, as the target may not do partial ones.
+	void WriteVSConstants(unsigned int slot, ID3D11Buffer* buffer, const void* data, unsigned int size);	// Copies the data.
+	HRESULT Present(unsigned int syncInterval, unsigned int flags);	// Recorded; always returns S_OK.
+	bool IsNull() const { return false; }
+
+private:
+
+	// -----------------------------------------------
+	// Internal structs.
+	// -----------------------------------------------
+
+	/// <summary>
+	/// Starts every packet. Size includes the header,
+	/// the payload, any copied data and the padding.
+	/// </summary>
+	struct Header
+	{
+		unsigned int type;
+		unsigned int size;
+	};
+
+	// Packet payloads, one per command type.
+	struct ClearCommand { ID3D11RenderTargetView* renderTarget; ID3D11DepthStencilView* depthStencil; float color[4]; };
+	struct TopologyCommand { D3D11_PRIMITIVE_TOPOLOGY topology; };
+	struct InputLayoutCommand { ID3D11InputLayout* layout; };
+	struct VertexShaderCommand { ID3D11VertexShader* shader; };
+	struct PixelShaderCommand { ID3D11PixelShader* shader; };
+	struct ConstantBufferCommand { ID3D11Buffer* buffer; unsigned int slot; };
+	struct BufferCommand { ID3D11Buffer* buffer; unsigned int stride; unsigned int offset; };	// Vertex and instance buffers.
+	struct IndexBufferCommand { ID3D11Buffer* buffer; DXGI_FORMAT format; unsigned int offset; };
+	struct DrawIndexedCommand { unsigned int indexCount; unsigned int startIndex; int baseVertex; };
+	struct DrawIndexedInstancedCommand { unsigned int indexCount; unsigned int instanceCount; unsigned int startIndex; int baseVertex; unsigned int startInstance; };
+	struct UpdateCommand { ID3D11Buffer* buffer; unsigned int size; };	// Followed by size bytes.
+	struct PresentCommand { unsigned int syncInterval; unsigned int flags; };
+	struct ConstantsCommand { ID3D11Buffer* buffer; unsigned int slot; unsigned int size; };	// Followed by size bytes.
+
+	// -----------------------------------------------
+	// Data members.
+	// -----------------------------------------------
+
+	std::vector<unsigned char> memory;
+	size_t size;
+	unsigned int commandCount;
+
+	// -----------------------------------------------
+	// Helper methods.
+	// -----------------------------------------------
+
+	template <typename T>
+	void Record(CommandType type, const T& command, const void* data = nullptr, unsigned int dataSize = 0);
+	static size_t GetPayloadSize(CommandType type);
+
+	// Not copyable - packets hold raw pointers.
+	CommandBuffer(const CommandBuffer&) = delete;
+	CommandBuffer& operator=(const CommandBuffer&) = delete;
+};
@@ -0,0 +1,127 @@
+// -----------------------------------------------
+// Include statements.
+// -----------------------------------------------
+#include "CommandLine.h"
+#include <algorithm>
+#include <cstdlib>
+#include <sstream>
+#include <vector>
+
+// -----------------------------------------------
+// Static methods.
+// -----------------------------------------------
+
+/// <summary>
+/// Parse whitespace separated options. Unknown options are ignored.
+/// </summary>
+/// <param name="commandLine">Raw command line (without the executable name).</param>
+/// <returns>Returns parsed options.</returns>
+CommandLineOptions CommandLineOptions::Parse(const char* commandLine)
+{
+	CommandLineOptions options;
+	if (!commandLine)
+		return options;
+
+	// Split into tokens.
+	std::vector<std::string> tokens;
+	std::istringstream stream(commandLine);
+	std::string token;
+	while (stream >> token)
+		tokens.push_back(token);
+
+	// Match tokens (and their values, if any).
+	for (size_t i = 0; i < tokens.size(); i++)
+	{
+		const std::string& option = tokens[i];
+		bool hasValue = (i + 1) < tokens.size();
+
+		if (option == "--headless")
+		{
+			options.headless = true;
+		}
+		else if (option == "--frames" && hasValue)
+		{
+			options.frameLimit = static_cast<unsigned int>(std::strtoul(tokens[++i].c_str(), nullptr, 10));
+		}
+		else if (option == "--fps" && hasValue)
+		{
+			options.frameRate = std::max(static_cast<int>(std::strtol(tokens[++i].c_str(), nullptr, 10)), 0);
+		}
+		else if (option == "--seed" && hasValue)
+		{
+			options.fixedSeed = true;
+			options.seed = static_cast<unsigned int>(std::strtoul(tokens[++i].c_str(), nullptr, 10));
+		}
+		else if (option == "--record" && hasValue)
+		{
+			options.recordPath = tokens[++i];
+		}
+		else if (option == "--playback" && hasValue)
+		{
+			options.playbackPath = tokens[++i];
+		}
+		else if (option == "--log" && hasValue)
+		{
+			options.logPath = tokens[++i];
+		}
+		else if (option == "--no-state-cache")
+		{
+			options.stateCache = false;
+		}
+		else if (option == "--benchmark" && hasValue)
+		{
+			options.benchmark = tokens[++i];
+		}
+		else if (option == "--no-instancing")
+		{
+			options.instancing = false;
+		}
+		else if (option == "--entities" && hasValue)
+		{
+			options.entityCount = static_cast<unsigned int>(std::strtoul(tokens[++i].c_str(), nullptr, 10));
+		}
+		else if (option == "--no-culling")
+		{
+			options.frustumCulling = false;
+		}
+		else if (option == "--no-occlusion")
+		{
+			options.occlusionCulling = false;
+		}
+		else if (option == "--snapshot" && hasValue)
+		{
+			options.snapshotPath = tokens[++i];
+		}
+		else if (option == "--no-lod")
+		{
+			options.detailLevels = false;
+		}
+		else if (option == "--counters" && hasValue)
+		{
+			options.countersPath = tokens[++i];
+		}
+		else if (option == "--budget" && hasValue)
+		{
+			options.counterBudgets.push_back(tokens[++i]);
+		}
+		else if (option == "--late-latch")
+		{
+			options.lateLatch = true;
+		}
+	}
+
+	return options;
+}
+
+// -----------------------------------------------
+// Constructor(s).
+// -----------------------------------------------
+
+/// <summary>
+/// Initializes the default (windowed, no frame limit) options.
+/// </summary>
+CommandLineOptions::CommandLineOptions()
+	: headless{ false }, frameLimit{ 0 }, frameRate{ -1 },
+	fixedSeed{ false }, seed{ 0 }, stateCache{ true },
+	instancing{ true }, entityCount{ 0 }, frustumCulling{ true },
+	occlusionCulling{ true }, detailLevels{ true }, lateLatch{ false } {}
@@ -0,0 +1,56 @@
+#pragma once
+
+// -----------------------------------------------
+// Include statements.
+// -----------------------------------------------
+#include <string>
+#include <vector>
+
+// -----------------------------------------------
+// CommandLine.h
+// ---
+// Options parsed from the command line that
+// change how DXCore runs the game loop.
+// -----------------------------------------------
+
+/// <summary>
+/// Run options for the application.
+/// </summary>
+struct CommandLineOptions
+{
+public:
+
+	// --------------------
+	// Static methods.
+
+	static CommandLineOptions Parse(const char* commandLine);
+
+	// --------------------
+	// Constructor(s).
+
+	CommandLineOptions();
+
+	// --------------------
+	// Data members.
+
+	bool headless;				// --headless : No window, no swap chain, null rendering backend.
+	unsigned int frameLimit;	// --frames N : Exit after N frames (0 runs until closed).
+	int frameRate;				// --fps N    : Target frame rate (0 is unlimited, -1 picks a default).
+	bool fixedSeed;				// --seed N   : Seed the random number generator with N...
+	unsigned int seed;			//              ...instead of the clock.
+	std::string recordPath;		// --record F : Record each frame's input to F.
+	std::string playbackPath;	// --playback F : Drive the game from the input recorded in F.
+	std::string logPath;		// --log F    : Also write log messages to F.
+	bool stateCache;			// --no-state-cache : Send every bind to the device, even redundant ones.
+	std::string benchmark;		// --benchmark NAME : Run a CPU benchmark (or "all") instead of the game.
+	bool instancing;			// --no-instancing : One draw per entity instead of one per mesh/material group.
+	unsigned int entityCount;	// --entities N : Create N entities (0 keeps the default).
+	bool frustumCulling;		// --no-culling : Draw every entity, even those outside the view.
+	bool occlusionCulling;		// --no-occlusion : Skip the CPU occlusion test (needs frustum culling).
+	std::string snapshotPath;	// --snapshot F : Also draw the last frame on the CPU and save it to F (TGA).
+	bool detailLevels;			// --no-lod : Always draw the most detailed level of each mesh.
+	std::string countersPath;	// --counters F : Write each frame's render counters to F (CSV).
+	std::vector<std::string> counterBudgets;	// --budget NAME=N : Fail the run if a frame counts more than N (repeatable).
+	bool lateLatch;				// --late-latch : Apply mouse input that arrives during the frame just before its draws are sent.
+
+};
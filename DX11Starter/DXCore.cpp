@@ -1,6 +1,8 @@
 #include "DXCore.h"
 #include <WindowsX.h>
 #include <sstream>
+#include <climits>
+#include <cstdio>
 #include <ctime>
 
 #pragma warning( push )
@@ -11,6 +13,9 @@
 // message handling function below can talk to our object
 DXCore* DXCore::DXCoreInstance = 0;
 
+// Input timestamp meaning "no input waiting"
+static const PlatformTimer::Timestamp NO_INPUT = LLONG_MAX;
+
 // --------------------------------------------------------
 // The global callback function for handling windows OS-level messages.
 //
@@ -30,13 +35,15 @@ LRESULT DXCore::WindowProc(HWND hWnd, UINT uMsg, WPARAM wParam, LPARAM lParam)
 // windowWidth	- Width of the window's client (internal) area
 // windowHeight - Height of the window's client (internal) area
 // debugTitleBarStats - Show debug stats in the title bar, like FPS?
+// options      - Command line options (headless mode, frame limit)
 // --------------------------------------------------------
 DXCore::DXCore(
 	HINSTANCE hInstance,		// The application's handle
 	char* titleBarText,			// Text for the window's title bar
 	unsigned int windowWidth,	// Width of the window's client area
 	unsigned int windowHeight,	// Height of the window's client area
-	bool debugTitleBarStats)	// Show extra stats (fps) in title bar?
+	bool debugTitleBarStats,	// Show extra stats (fps) in title bar?
+	const CommandLineOptions& options)	// Headless mode, frame limit
 {
 	// Save a static reference to this object.
 	//  - Since the OS-level message function must be a non-member (global) function,
@@ -50,21 +57,53 @@ DXCore::DXCore(
 	this->width = windowWidth;
 	this->height = windowHeight;
 	this->titleBarStats = debugTitleBarStats;
+	this->options = options;
 
 	// Initialize fields
 	fpsFrameCount = 0;
 	fpsTimeElapsed = 0.0f;
-
+	frameCount = 0;
+	randomSeed = 0;
+	minimized = false;
+	active = true;
+	pendingMouseInput = NO_INPUT;
+	pendingKeyInput = NO_INPUT;
+	resolvedKeyInput = NO_INPUT;
+
+	hWnd = 0;
 	device = 0;
 	context = 0;
 	swapChain = 0;
 	backBufferRTV = 0;
 	depthStencilView = 0;
-
-	// Query performance counter for accurate timing information
-	__int64 perfFreq;
-	QueryPerformanceFrequency((LARGE_INTEGER*)&perfFreq);
-	perfCounterSeconds = 1.0 / (double)perfFreq;
+	backend = 0;
+	stateCache = 0;
+
+	// Headless runs advance a fixed 60hz step per frame, so
+	// the simulation is identical from one run to the next
+	if (options.headless)
+		timer.SetFixedStep(1.0f / 60.0f);
+
+	// Pace frames instead of spinning flat out
+	//  - Windowed runs default to the display's refresh rate
+	//  - Headless runs default to unlimited, for benchmarking
+	float frameRate = (float)options.frameRate;
+	if (options.frameRate < 0)
+		frameRate = options.headless ? 0.0f : GetDisplayRefreshRate();
+	pacer.SetFrameRate(FramePacer::PM_ACTIVE, frameRate);
+
+	// Log messages are formatted and written on a background
+	// thread, so logging doesn't stall the frame
+	if (!options.logPath.empty() && !Logger::Get().OpenFile(options.logPath))
+		printf("Could not open log file '%s'.\n", options.logPath.c_str());
+	Logger::Get().Start();
+
+	// Per-frame limits on the render counters ("--budget draws=500")
+	for (const std::string& budget : options.counterBudgets)
+	{
+		if (!RenderCounters::Get().SetBudget(budget))
+			printf("Unknown counter budget '%s'.\n", budget.c_str());
+	}
 }
 
 // --------------------------------------------------------
@@ -72,6 +111,12 @@ DXCore::DXCore(
 // --------------------------------------------------------
 DXCore::~DXCore()
 {
+	// Write out anything still queued
+	Logger::Get().Stop();
+
+	// The backend doesn't own any of the objects below
+	delete backend;
+
 	// Release all DirectX resources
 	if (depthStencilView) { depthStencilView->Release(); }
 	if (backBufferRTV) { backBufferRTV->Release(); }
@@ -86,6 +131,14 @@ DXCore::~DXCore()
 // --------------------------------------------------------
 HRESULT DXCore::InitWindow()
 {
+	// Headless runs have no window; just make sure
+	// printf() output reaches the launching console
+	if (options.headless)
+	{
+		AttachParentConsole();
+		return S_OK;
+	}
+
 	// Start window creation by filling out the
 	// appropriate window class struct
 	WNDCLASS wndClass = {}; // Zero out the memory
@@ -158,11 +211,31 @@ HRESULT DXCore::InitWindow()
 	return S_OK;
 }
 
+// --------------------------------------------------------
+// Points stdout/stderr at the console that launched this
+// (windows subsystem) program, so headless runs and
+// benchmarks can print results.  Does nothing if output
+// is already redirected or there's no parent console.
+// --------------------------------------------------------
+void DXCore::AttachParentConsole()
+{
+	if (GetStdHandle(STD_OUTPUT_HANDLE) == NULL && AttachConsole(ATTACH_PARENT_PROCESS))
+	{
+		FILE* stream;
+		freopen_s(&stream, "CONOUT$", "w", stdout);
+		freopen_s(&stream, "CONOUT$", "w", stderr);
+	}
+}
+
 
 // --------------------------------------------------------
 // Initializes DirectX, which requires a window.  This method
 // also creates several DirectX objects we'll need to start
 // drawing things to the screen.
+//
+// Headless runs get a WARP (software) device with no swap
+// chain or views, so shaders and meshes still load on a
+// machine with no GPU, and a null backend that drops draws.
 // --------------------------------------------------------
 HRESULT DXCore::InitDirectX()
 {
@@ -177,6 +250,28 @@ HRESULT DXCore::InitDirectX()
 	deviceFlags |= D3D11_CREATE_DEVICE_DEBUG;
 #endif
 
+	// Result variable for below function calls
+	HRESULT hr = S_OK;
+
+	if (options.headless)
+	{
+		hr = D3D11CreateDevice(
+			0,						// Default adapter
+			D3D_DRIVER_TYPE_WARP,	// Software rasterizer - works without a GPU
+			0,
+			deviceFlags,
+			0,
+			0,
+			D3D11_SDK_VERSION,
+			&device,
+			&dxFeatureLevel,
+			&context);
+		if (FAILED(hr)) return hr;
+
+		CreateBackend(new NullRenderBackend());
+		return S_OK;
+	}
+
 	// Create a description of how our swap
 	// chain should work
 	DXGI_SWAP_CHAIN_DESC swapDesc = {};
@@ -196,9 +291,6 @@ HRESULT DXCore::InitDirectX()
 	swapDesc.SwapEffect = DXGI_SWAP_EFFECT_DISCARD;
 	swapDesc.Windowed = true;
 
-	// Result variable for below function calls
-	HRESULT hr = S_OK;
-
 	// Attempt to initialize DirectX
 	hr = D3D11CreateDeviceAndSwapChain(
 		0,							// Video adapter (physical GPU) to use, or null for default
@@ -268,6 +360,9 @@ HRESULT DXCore::InitDirectX()
 	viewport.MaxDepth = 1.0f;
 	context->RSSetViewports(1, &viewport);
 
+	// Draw calls go through to the context
+	CreateBackend(new D3D11RenderBackend(context, swapChain));
+
 	// Return the "everything is ok" HRESULT value
 	return S_OK;
 }
@@ -282,6 +377,10 @@ HRESULT DXCore::InitDirectX()
 // --------------------------------------------------------
 void DXCore::OnResize()
 {
+	// Nothing to resize without a swap chain (headless)
+	if (!swapChain)
+		return;
+
 	// Release existing DirectX views and buffers
 	if (depthStencilView) { depthStencilView->Release(); }
 	if (backBufferRTV) { backBufferRTV->Release(); }
@@ -348,19 +447,29 @@ HRESULT DXCore::Run()
 {
 	// Grab the start time now that
 	// the game loop is running
-	__int64 now;
-	QueryPerformanceCounter((LARGE_INTEGER*)&now);
-	startTime = now;
-	currentTime = now;
-	previousTime = now;
+	timer.Start();
 
 	// -----------------
 	// Seed the random number generator.
-	srand((unsigned int)(time(NULL)) + GetCurrentProcessId());
+	//  - "--seed N" and headless runs use a fixed seed
+	//    so every run builds exactly the same scene
+	if (options.fixedSeed)
+		randomSeed = options.seed;
+	else if (options.headless)
+		randomSeed = 0;
+	else
+		randomSeed = (unsigned int)(time(NULL)) + GetCurrentProcessId();
+	srand(randomSeed);
 
 	// Give subclass a chance to initialize
 	Init();
 
+	// Don't let the time spent in Init() show
+	// up as the first frame's duration (or its counts)
+	timer.Restart();
+	pacer.Start();
+	RenderCounters::Get().Reset();
+
 	// Our overall game and message loop
 	MSG msg = {};
 	while (msg.message != WM_QUIT)
@@ -377,15 +486,63 @@ HRESULT DXCore::Run()
 		{
 			// Update timer and title bar (if necessary)
 			UpdateTimer();
-			if (titleBarStats)
+			if (titleBarStats && hWnd)
 				UpdateTitleBarStats();
+			UpdatePacingMode();
+
+			// The game loop, timing each half separately
+			float deltaTime = timer.GetDeltaTime();
+			float totalTime = timer.GetTotalTime();
 
-			// The game loop
+			// Key events waiting now are resolved by this Update()
+			if (pendingKeyInput < resolvedKeyInput)
+				resolvedKeyInput = pendingKeyInput;
+			pendingKeyInput = NO_INPUT;
+
+			PlatformTimer::Timestamp phaseStart = timer.GetFrameTimestamp();
 			Update(deltaTime, totalTime);
-			Draw(deltaTime, totalTime);
+			frameStats.AddSample(FrameStatistics::P_UPDATE, PlatformTimer::MillisecondsSince(phaseStart));
+
+			if (pacer.GetMode() == FramePacer::PM_IDLE)
+			{
+				// Nothing is visible, so skip drawing - but keep
+				// testing whether the window has been uncovered
+				if (!minimized)
+					backend->Present(0, DXGI_PRESENT_TEST);
+			}
+			else
+			{
+				phaseStart = PlatformTimer::Now();
+				Draw(deltaTime, totalTime);
+				frameStats.AddSample(FrameStatistics::P_DRAW, PlatformTimer::MillisecondsSince(phaseStart));
+			}
+
+			// Close this frame's render counters (see RenderCounters.h)
+			RenderCounters::Get().EndFrame();
+
+			// Sleep until the next frame is due, and record how
+			// far the frame landed from its target interval
+			float pacingError = pacer.Wait();
+			if (pacer.IsLimited() && pacer.GetMode() == FramePacer::PM_ACTIVE)
+				frameStats.AddSample(FrameStatistics::P_PACING, pacingError);
+
+			// Stop after a fixed number of frames, if asked
+			frameCount++;
+			if (options.frameLimit > 0 && frameCount == options.frameLimit)
+				Quit();
 		}
 	}
 
+	// Save the frame statistics for this session
+	if (options.headless)
+		PrintHeadlessSummary();
+	DumpFrameStatistics();
+
+	// A frame over a counter budget fails the run, so
+	// scripted (headless) runs can catch regressions
+	if (!CheckCounterBudgets())
+		return E_FAIL;
+
 	// We'll end up here once we get a WM_QUIT message,
 	// which usually comes from the user closing the window
 	return (HRESULT)msg.wParam;
@@ -395,34 +552,136 @@ HRESULT DXCore::Run()
 // --------------------------------------------------------
 // Sends an OS-level window close message to our process, which
 // will be handled by our message processing function
+//
+// Without a window there's nothing to close, so post the
+// quit message directly
 // --------------------------------------------------------
 void DXCore::Quit()
 {
-	PostMessage(this->hWnd, WM_CLOSE, NULL, NULL);
+	if (hWnd)
+		PostMessage(this->hWnd, WM_CLOSE, NULL, NULL);
+	else
+		PostQuitMessage(0);
 }
 
 
+// --------------------------------------------------------
+// Handles the mouse and keyboard messages waiting for our
+// window right now, without returning to the game loop
+//  - Lets the frame pick up input that arrived while it
+//    was updating and culling (late latching)
+//  - Other messages (resizing, closing) stay queued for the
+//    game loop, so nothing but input changes mid-frame
+// --------------------------------------------------------
+bool DXCore::PumpInputMessages()
+{
+	if (!hWnd)
+		return false;
+
+	bool handled = false;
+	MSG msg = {};
+	while (PeekMessage(&msg, hWnd, WM_MOUSEFIRST, WM_MOUSELAST, PM_REMOVE) ||
+		PeekMessage(&msg, hWnd, WM_KEYFIRST, WM_KEYLAST, PM_REMOVE))
+	{
+		TranslateMessage(&msg);
+		DispatchMessage(&msg);
+		handled = true;
+	}
+	return handled;
+}
+
+// --------------------------------------------------------
+// The frame's draws are being sent: every mouse event so
+// far, and every key event the last Update() resolved, is
+// now on its way to the screen
+//  - Records one input latency sample, from the oldest of
+//    them, if there were any
+// --------------------------------------------------------
+void DXCore::MarkInputSubmitted()
+{
+	PlatformTimer::Timestamp oldest = (pendingMouseInput < resolvedKeyInput) ? pendingMouseInput : resolvedKeyInput;
+	if (oldest == NO_INPUT)
+		return;
+
+	frameStats.AddSample(FrameStatistics::P_INPUT, PlatformTimer::MillisecondsSince(oldest));
+	pendingMouseInput = NO_INPUT;
+	resolvedKeyInput = NO_INPUT;
+}
+
+// --------------------------------------------------------
+// Remembers when an input message arrived
+//  - Windows stamps each message when it's queued, so time
+//    spent waiting in the queue (while the frame was busy)
+//    counts too - but only to the millisecond tick
+// --------------------------------------------------------
+void DXCore::NoteInputEvent(bool keyboard)
+{
+	DWORD queuedFor = GetTickCount() - (DWORD)GetMessageTime();
+	PlatformTimer::Timestamp arrival = PlatformTimer::Now() - PlatformTimer::TicksFromSeconds(queuedFor / 1000.0);
+
+	PlatformTimer::Timestamp& pending = keyboard ? pendingKeyInput : pendingMouseInput;
+	if (arrival < pending)
+		pending = arrival;
+}
+
 // --------------------------------------------------------
 // Uses high resolution time stamps to get very accurate
 // timing information, and calculates useful time stats
 // --------------------------------------------------------
 void DXCore::UpdateTimer()
 {
-	// Grab the current time
-	__int64 now;
-	QueryPerformanceCounter((LARGE_INTEGER*)&now);
-	currentTime = now;
+	// Advance the timer (delta and total time)
+	timer.Tick();
+
+	// Record the frame time (in ms) for percentile stats
+	//  - Always wall clock, even when the game itself
+	//    is stepping at a fixed rate
+	frameStats.AddSample(FrameStatistics::P_FRAME, timer.GetRealDeltaTime() * 1000.0f);
+}
+
+// --------------------------------------------------------
+// Picks the pacing mode from the window's state:
+//  - Minimized or fully covered: idle (no drawing)
+//  - Visible but in the background: reduced frame rate
+//  - Otherwise: the target frame rate
+// --------------------------------------------------------
+void DXCore::UpdatePacingMode()
+{
+	if (minimized || backend->IsOccluded())
+		pacer.SetMode(FramePacer::PM_IDLE);
+	else if (!active)
+		pacer.SetMode(FramePacer::PM_BACKGROUND);
+	else
+		pacer.SetMode(FramePacer::PM_ACTIVE);
+}
 
-	// Calculate delta time and clamp to zero
-	//  - Could go negative if CPU goes into power save mode
-	//    or the process itself gets moved to another core
-	deltaTime = max((float)((currentTime - previousTime) * perfCounterSeconds), 0.0f);
+// --------------------------------------------------------
+// Returns the refresh rate of the primary display, or 60hz
+// if Windows reports the hardware default
+// --------------------------------------------------------
+float DXCore::GetDisplayRefreshRate()
+{
+	DEVMODE displayMode = {};
+	displayMode.dmSize = sizeof(DEVMODE);
+	if (EnumDisplaySettings(NULL, ENUM_CURRENT_SETTINGS, &displayMode) && displayMode.dmDisplayFrequency > 1)
+		return (float)displayMode.dmDisplayFrequency;
+
+	return 60.0f;
+}
 
-	// Calculate the total time from start to now
-	totalTime = (float)((currentTime - startTime) * perfCounterSeconds);
+// --------------------------------------------------------
+// Writes the frame statistics (percentiles, histogram and
+// the most recent frame times) to a CSV file
+//
+// filename - Path of the CSV file to write
+// --------------------------------------------------------
+bool DXCore::DumpFrameStatistics(const std::string& filename) const
+{
+	// Per-frame render counters too, if asked for ("--counters F")
+	if (!options.countersPath.empty() && !RenderCounters::Get().DumpCSV(options.countersPath))
+		printf("Could not write render counters to '%s'.\n", options.countersPath.c_str());
 
-	// Save current time for next frame
-	previousTime = currentTime;
+	return frameStats.DumpCSV(filename);
 }
 
 
@@ -438,13 +697,16 @@ void DXCore::UpdateTitleBarStats()
 	fpsFrameCount++;
 
 	// Only calc FPS and update title bar once per second
-	float timeDiff = totalTime - fpsTimeElapsed;
+	float timeDiff = timer.GetTotalTime() - fpsTimeElapsed;
 	if (timeDiff < 1.0f)
 		return;
 
 	// How long did each frame take?  (Approx)
 	float mspf = 1000.0f / (float)fpsFrameCount;
 
+	// Tail latency over the rolling window
+	FrameStatistics::Summary frameSummary = frameStats.Summarize(FrameStatistics::P_FRAME);
+
 	// Quick and dirty title bar text (mostly for debugging)
 	std::ostringstream output;
 	output.precision(6);
@@ -452,7 +714,20 @@ void DXCore::UpdateTitleBarStats()
 		"    Width: " << width <<
 		"    Height: " << height <<
 		"    FPS: " << fpsFrameCount <<
-		"    Frame Time: " << mspf << "ms";
+		"    Frame Time: " << mspf << "ms" <<
+		"    p99: " << frameSummary.p99 << "ms";
+
+	// How steadily the pacer is hitting its target
+	if (pacer.IsLimited())
+	{
+		FrameStatistics::Summary pacingSummary = frameStats.Summarize(FrameStatistics::P_PACING);
+		output << "    Jitter p99: " << pacingSummary.p99 << "ms";
+	}
+
+	// How long input waits to reach the screen
+	FrameStatistics::Summary inputSummary = frameStats.Summarize(FrameStatistics::P_INPUT);
+	if (inputSummary.samples > 0)
+		output << "    Input p99: " << inputSummary.p99 << "ms";
 
 	// Append the version of DirectX the app is using
 	switch (dxFeatureLevel)
@@ -473,6 +748,109 @@ void DXCore::UpdateTitleBarStats()
 	fpsTimeElapsed += 1.0f;
 }
 
+// --------------------------------------------------------
+// Sets up frame submission, putting the state cache in
+// front of the given backend unless it's been turned off
+// --------------------------------------------------------
+void DXCore::CreateBackend(IRenderBackend* submission)
+{
+	if (options.stateCache)
+	{
+		stateCache = new RenderStateCache(submission);
+		backend = stateCache;
+	}
+	else
+	{
+		stateCache = 0;
+		backend = submission;
+	}
+}
+
+// --------------------------------------------------------
+// Prints a summary of a headless run to stdout: frame,
+// update and draw timings plus everything the null
+// backend was asked to do
+// --------------------------------------------------------
+void DXCore::PrintHeadlessSummary()
+{
+	const RenderBackendStatistics& submitted = backend->GetStatistics();
+
+	printf("Headless run: %u frames, %.3f simulated seconds\n", frameCount, timer.GetTotalTime());
+	for (int phase = 0; phase < FrameStatistics::P_COUNT; phase++)
+	{
+		FrameStatistics::FramePhase framePhase = (FrameStatistics::FramePhase)phase;
+		FrameStatistics::Summary summary = frameStats.Summarize(framePhase);
+		printf("  %-6s avg %8.4fms  p50 %8.4fms  p90 %8.4fms  p99 %8.4fms  max %8.4fms\n",
+			FrameStatistics::GetPhaseName(framePhase), summary.average, summary.p50, summary.p90, summary.p99, summary.max);
+	}
+	printf("  draws %llu  indices %llu  vertex buffers %llu  index buffers %llu  clears %llu  presents %llu\n",
+		submitted.draws, submitted.indices, submitted.vertexBufferBinds,
+		submitted.indexBufferBinds, submitted.clears, submitted.frames);
+
+	// Constant uploads, averaged per frame
+	double frames = submitted.frames > 0 ? (double)submitted.frames : 1.0;
+	printf("  constant buffer updates %llu (%.1f/frame)  constant bytes %llu (%.1f/frame)\n",
+		submitted.constantBufferUpdates, submitted.constantBufferUpdates / frames,
+		submitted.constantBytes, submitted.constantBytes / frames);
+	printf("  constant ring writes %llu (%.1f/frame)  ring bytes %llu (%.1f/frame)\n",
+		submitted.ringConstantWrites, submitted.ringConstantWrites / frames,
+		submitted.ringConstantBytes, submitted.ringConstantBytes / frames);
+	printf("  instanced draws %llu  instances %llu  instance buffers %llu  dynamic bytes %llu (%.1f/frame)\n",
+		submitted.instancedDraws, submitted.instances, submitted.instanceBufferBinds,
+		submitted.dynamicBytes, submitted.dynamicBytes / frames);
+	printf("  shaders %llu  input layouts %llu  constant buffer binds %llu  topology %llu\n",
+		submitted.shaderBinds, submitted.inputLayoutBinds,
+		submitted.constantBufferBinds, submitted.topologyChanges);
+
+	// Calls the state cache passed on vs. dropped as redundant
+	if (stateCache)
+	{
+		const RenderStateTracker::Counters& counters = stateCache->GetCounters();
+		printf("  state cache (issued/skipped):");
+		for (int call = 0; call < RenderStateTracker::SC_COUNT; call++)
+		{
+			printf(" %s %llu/%llu%s", RenderStateTracker::GetCallName((RenderStateTracker::StateCall)call),
+				counters.issued[call], counters.skipped[call], (call + 1 < RenderStateTracker::SC_COUNT) ? "," : "\n");
+		}
+	}
+
+	// Render counters, averaged per frame and at their worst
+	RenderCounters& renderCounters = RenderCounters::Get();
+	RenderCounters::Values totals = renderCounters.GetTotals();
+	double counted = renderCounters.GetFrameCount() > 0 ? (double)renderCounters.GetFrameCount() : 1.0;
+	printf("  render counters (per frame avg/peak):\n");
+	for (int counter = 0; counter < RenderCounters::RC_COUNT; counter++)
+	{
+		printf("    %-22s %12.1f %10llu\n", RenderCounters::GetName((RenderCounters::Counter)counter),
+			totals.counts[counter] / counted, renderCounters.GetPeak().counts[counter]);
+	}
+	fflush(stdout);
+}
+
+// --------------------------------------------------------
+// Compares the largest frame of each counter that has a
+// budget against it, printing those that went over
+//
+// Returns false if any counter went over its budget
+// --------------------------------------------------------
+bool DXCore::CheckCounterBudgets()
+{
+	const RenderCounters& renderCounters = RenderCounters::Get();
+	bool withinBudget = true;
+	for (int c = 0; c < RenderCounters::RC_COUNT; c++)
+	{
+		RenderCounters::Counter counter = (RenderCounters::Counter)c;
+		if (!renderCounters.IsOverBudget(counter))
+			continue;
+
+		printf("Over budget: %s peaked at %llu per frame (budget %llu)\n", RenderCounters::GetName(counter),
+			renderCounters.GetPeak().counts[counter], renderCounters.GetBudget(counter));
+		withinBudget = false;
+	}
+	fflush(stdout);
+	return withinBudget;
+}
+
 // --------------------------------------------------------
 // Allocates a console window we can print to for debugging
 //
@@ -546,7 +924,9 @@ LRESULT DXCore::ProcessMessage(HWND hWnd, UINT uMsg, WPARAM wParam, LPARAM lPara
 		// Don't adjust anything when minimizing,
 		// since we end up with a width/height of zero
 		// and that doesn't play well with DirectX
-		if (wParam == SIZE_MINIMIZED)
+		//  - The game loop throttles itself while minimized
+		minimized = (wParam == SIZE_MINIMIZED);
+		if (minimized)
 			return 0;
 
 		// Save the new client area dimensions.
@@ -564,6 +944,7 @@ LRESULT DXCore::ProcessMessage(HWND hWnd, UINT uMsg, WPARAM wParam, LPARAM lPara
 	case WM_LBUTTONDOWN:
 	case WM_MBUTTONDOWN:
 	case WM_RBUTTONDOWN:
+		NoteInputEvent(false);
 		OnMouseDown(wParam, GET_X_LPARAM(lParam), GET_Y_LPARAM(lParam));
 		return 0;
 
@@ -571,16 +952,41 @@ LRESULT DXCore::ProcessMessage(HWND hWnd, UINT uMsg, WPARAM wParam, LPARAM lPara
 	case WM_LBUTTONUP:
 	case WM_MBUTTONUP:
 	case WM_RBUTTONUP:
+		NoteInputEvent(false);
 		OnMouseUp(wParam, GET_X_LPARAM(lParam), GET_Y_LPARAM(lParam));
 		return 0;
 
 		// Cursor moves over the window (or outside, while we're currently capturing it)
 	case WM_MOUSEMOVE:
+		NoteInputEvent(false);
 		OnMouseMove(wParam, GET_X_LPARAM(lParam), GET_Y_LPARAM(lParam));
 		return 0;
 
+		// Focus moves to or from another application
+	case WM_ACTIVATEAPP:
+		active = (wParam != FALSE);
+		if (!active)
+			OnFocusLost();
+		return 0;
+
+		// Key pressed (F9 also saves the current frame statistics - not
+		// F12, which breaks into an attached debugger by default)
+	case WM_KEYDOWN:
+		if (wParam == VK_F9)
+			DumpFrameStatistics();
+		NoteInputEvent(true);
+		OnKeyDown(wParam);
+		return 0;
+
+		// Key released
+	case WM_KEYUP:
+		NoteInputEvent(true);
+		OnKeyUp(wParam);
+		return 0;
+
 		// Mouse wheel is scrolled
 	case WM_MOUSEWHEEL:
+		NoteInputEvent(false);
 		OnMouseWheel(GET_WHEEL_DELTA_WPARAM(wParam) / (float)WHEEL_DELTA, GET_X_LPARAM(lParam), GET_Y_LPARAM(lParam));
 		return 0;
 	}
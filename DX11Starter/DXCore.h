@@ -3,6 +3,14 @@
 #include <Windows.h>
 #include <d3d11.h>
 #include <string>
+#include "FrameStatistics.h"
+#include "CommandLine.h"
+#include "PlatformTimer.h"
+#include "FramePacer.h"
+#include "RenderBackend.h"
+#include "RenderStateCache.h"
+#include "RenderCounters.h"
+#include "Logger.h"
 
 // We can include the correct library files here
 // instead of in Visual Studio settings if we want
@@ -16,7 +24,8 @@ public:
 		char* titleBarText,			// Text for the window's title bar
 		unsigned int windowWidth,	// Width of the window's client area
 		unsigned int windowHeight,	// Height of the window's client area
-		bool debugTitleBarStats);	// Show extra stats (fps) in title bar?
+		bool debugTitleBarStats,	// Show extra stats (fps) in title bar?
+		const CommandLineOptions& options = CommandLineOptions());	// Headless mode, frame limit
 	~DXCore();
 
 	// Static requirements for OS-level message processing
@@ -38,6 +47,22 @@ public:
 	void Quit();
 	virtual void OnResize();
 
+	// Running without a window or swap chain?
+	bool IsHeadless() const { return options.headless; }
+
+	// Sends printf() output to the console that launched us, if any
+	static void AttachParentConsole();
+
+	// Seed given to srand() for this session
+	unsigned int GetRandomSeed() const { return randomSeed; }
+
+	// Frames finished so far (the one being drawn isn't counted)
+	unsigned int GetFrameCount() const { return frameCount; }
+
+	// Frame time statistics (percentiles, histogram, CSV export)
+	const FrameStatistics& GetFrameStatistics() const { return frameStats; }
+	bool DumpFrameStatistics(const std::string& filename = "FrameStatistics.csv") const;
+
 	// Pure virtual methods for setup and game functionality
 	virtual void Init() = 0;
 	virtual void Update(float deltaTime, float totalTime) = 0;
@@ -50,6 +75,11 @@ public:
 	virtual void OnMouseMove(WPARAM buttonState, int x, int y) { }
 	virtual void OnMouseWheel(float wheelDelta, int x, int y) { }
 
+	// Keyboard input, also from OS-level messages
+	virtual void OnKeyDown(WPARAM key) { }
+	virtual void OnKeyUp(WPARAM key) { }
+	virtual void OnFocusLost() { }
+
 protected:
 	HINSTANCE	hInstance;		// The handle to the application
 	HWND		hWnd;			// The handle to the window itself
@@ -69,23 +99,60 @@ protected:
 	ID3D11RenderTargetView* backBufferRTV;
 	ID3D11DepthStencilView* depthStencilView;
 
+	// Frame submission - forwards to the context and swap
+	// chain, or only counts calls when running headless
+	//  - Wrapped in a state cache (which backend points to)
+	//    unless "--no-state-cache" is given
+	IRenderBackend*			backend;
+	RenderStateCache*		stateCache;
+
+	// Options given on the command line
+	CommandLineOptions options;
+	unsigned int randomSeed;
+
 	// Helper function for allocating a console window
 	void CreateConsoleWindow(int bufferLines, int bufferColumns, int windowLines, int windowColumns);
 
+	// Late latching and input latency
+	//  - PumpInputMessages handles mouse and keyboard messages
+	//    that arrived since the frame started, mid-frame
+	//  - Call MarkInputSubmitted as the frame's draws are sent;
+	//    it records how long the input they reflect waited
+	bool PumpInputMessages();	// Returns true if any were handled
+	void MarkInputSubmitted();
+
 private:
 	// Timing related data
-	double perfCounterSeconds;
-	float totalTime;
-	float deltaTime;
-	__int64 startTime;
-	__int64 currentTime;
-	__int64 previousTime;
+	PlatformTimer timer;
+	unsigned int frameCount;
+
+	// Frame pacing, and the window state that throttles it
+	FramePacer pacer;
+	bool minimized;
+	bool active;
 
 	// FPS calculation
 	int fpsFrameCount;
 	float fpsTimeElapsed;
 
+	// Rolling frame time statistics, fed by UpdateTimer()
+	// and by the update/draw halves of the game loop
+	FrameStatistics frameStats;
+
+	// When the oldest input event not yet submitted arrived
+	//  - Key events only reach the camera in the next Update(),
+	//    so they wait there before they count as submittable
+	PlatformTimer::Timestamp pendingMouseInput;
+	PlatformTimer::Timestamp pendingKeyInput;
+	PlatformTimer::Timestamp resolvedKeyInput;
+	void NoteInputEvent(bool keyboard);	// Called for each input message
+
 	void UpdateTimer();			// Updates the timer for this frame
+	void UpdatePacingMode();	// Throttles when minimized, occluded or unfocused
+	static float GetDisplayRefreshRate();	// Refresh rate of the primary display
 	void UpdateTitleBarStats();	// Puts debug info in the title bar
+	void PrintHeadlessSummary();	// Prints timings and backend counts after a headless run
+	bool CheckCounterBudgets();	// Prints the counters whose peak frame went over budget
+	void CreateBackend(IRenderBackend* submission);	// Wraps it in the state cache, if enabled
 };
 
@@ -0,0 +1,528 @@
+// -----------------------------------------------
+// Include statements.
+// -----------------------------------------------
+#include "FrameGraph.h"
+#include <algorithm>
+#include <functional>
+#include <queue>
+
+// -----------------------------------------------
+// Constructors.
+// -----------------------------------------------
+
+/// <summary>
+/// Create an empty graph.
+/// </summary>
+FrameGraph::FrameGraph()
+	: stats{}, compiled{ false }, invalid{ false }
+{}
+
+// -----------------------------------------------
+// Static methods.
+// -----------------------------------------------
+
+/// <summary>
+/// Size of one pixel of a format. Formats the graph
+/// doesn't know are counted as 4 bytes.
+/// </summary>
+unsigned int FrameGraph::GetBytesPerPixel(Format format)
+{
+	switch (format)
+	{
+	case 2:		// DXGI_FORMAT_R32G32B32A32_FLOAT
+		return 16;
+	case 10:	// DXGI_FORMAT_R16G16B16A16_FLOAT
+	case 16:	// DXGI_FORMAT_R32G32_FLOAT
+		return 8;
+	case 61:	// DXGI_FORMAT_R8_UNORM
+		return 1;
+	case 54:	// DXGI_FORMAT_R16_FLOAT
+	case 55:	// DXGI_FORMAT_D16_UNORM
+		return 2;
+	default:
+		return 4;
+	}
+}
+
+/// <summary>
+/// Memory a texture needs (one mip, no padding).
+/// </summary>
+unsigned long long FrameGraph::GetTextureBytes(const TextureDesc& desc)
+{
+	return (unsigned long long)desc.width * desc.height * GetBytesPerPixel(desc.format);
+}
+
+// -----------------------------------------------
+// Accessors.
+// -----------------------------------------------
+
+/// <summary>
+/// Has the graph been compiled since it last changed?
+/// </summary>
+bool FrameGraph::IsCompiled() const
+{
+	return compiled;
+}
+
+/// <summary>
+/// Results of the last Compile().
+/// </summary>
+const FrameGraph::Statistics& FrameGraph::GetStatistics() const
+{
+	return stats;
+}
+
+/// <summary>
+/// Passes that survived culling, in the order they run.
+/// </summary>
+const std::vector<FrameGraph::Handle>& FrameGraph::GetOrder() const
+{
+	return order;
+}
+
+/// <summary>
+/// Name of a pass.
+/// </summary>
+const std::string& FrameGraph::GetPassName(Handle pass) const
+{
+	return passes[pass].name;
+}
+
+/// <summary>
+/// Name of a texture.
+/// </summary>
+const std::string& FrameGraph::GetTextureName(Handle texture) const
+{
+	return textures[texture].name;
+}
+
+/// <summary>
+/// Was the pass dropped by the last Compile()?
+/// </summary>
+bool FrameGraph::IsCulled(Handle pass) const
+{
+	return passes[pass].culled;
+}
+
+/// <summary>
+/// First and last position (in GetOrder()) of a pass
+/// that uses a texture.
+/// </summary>
+/// <param name="texture">Texture to look up.</param>
+/// <param name="first">Receives the first position.</param>
+/// <param name="last">Receives the last position.</param>
+/// <returns>Returns false if no pass that runs uses the texture.</returns>
+bool FrameGraph::GetLifetime(Handle texture, unsigned int* first, unsigned int* last) const
+{
+	const Texture& t = textures[texture];
+	if (t.firstUse == INVALID_HANDLE)
+		return false;
+
+	*first = t.firstUse;
+	*last = t.lastUse;
+	return true;
+}
+
+/// <summary>
+/// Physical texture a transient texture was given.
+/// </summary>
+FrameGraph::Handle FrameGraph::GetPhysicalTexture(Handle texture) const
+{
+	return textures[texture].physical;
+}
+
+/// <summary>
+/// Textures to actually create, indexed by GetPhysicalTexture().
+/// </summary>
+const std::vector<FrameGraph::TextureDesc>& FrameGraph::GetPhysicalTextures() const
+{
+	return physicalTextures;
+}
+
+// -----------------------------------------------
+// Service methods.
+// -----------------------------------------------
+
+/// <summary>
+/// Remove every pass and texture.
+/// </summary>
+void FrameGraph::Clear()
+{
+	textures.clear();
+	passes.clear();
+	order.clear();
+	physicalTextures.clear();
+	physicalLastUse.clear();
+	stats = {};
+	compiled = false;
+	invalid = false;
+}
+
+/// <summary>
+/// Declare a texture that only lives for the frame.
+/// </summary>
+/// <param name="name">Name, for debugging.</param>
+/// <param name="desc">Size and format.</param>
+/// <returns>Returns the texture's handle.</returns>
+FrameGraph::Handle FrameGraph::CreateTexture(const std::string& name, const TextureDesc& desc)
+{
+	return AddTexture(name, desc, false);
+}
+
+/// <summary>
+/// Declare a texture that lives outside the graph.
+/// </summary>
+/// <param name="name">Name, for debugging.</param>
+/// <param name="desc">Size and format.</param>
+/// <returns>Returns the texture's handle.</returns>
+FrameGraph::Handle FrameGraph::ImportTexture(const std::string& name, const TextureDesc& desc)
+{
+	return AddTexture(name, desc, true);
+}
+
+/// <summary>
+/// Declare a pass. Passes run in declaration order
+/// unless their reads and writes say otherwise.
+/// </summary>
+/// <param name="name">Name, for debugging.</param>
+/// <param name="execute">Called when the pass runs.</param>
+/// <returns>Returns the pass's handle.</returns>
+FrameGraph::Handle FrameGraph::AddPass(const std::string& name, ExecuteFunction execute)
+{
+	Pass pass = {};
+	pass.name = name;
+	pass.execute = execute;
+	passes.push_back(pass);
+	compiled = false;
+	return (Handle)(passes.size() - 1);
+}
+
+/// <summary>
+/// The pass reads the texture, so it runs after the
+/// texture's writers.
+/// </summary>
+void FrameGraph::Read(Handle pass, Handle texture)
+{
+	compiled = false;
+	if (pass >= passes.size() || texture >= textures.size())
+	{
+		invalid = true;
+		return;
+	}
+
+	passes[pass].reads.push_back(texture);
+	textures[texture].readers.push_back(pass);
+}
+
+/// <summary>
+/// The pass writes the texture. Writers of one texture
+/// run in the order they were declared.
+/// </summary>
+void FrameGraph::Write(Handle pass, Handle texture)
+{
+	compiled = false;
+	if (pass >= passes.size() || texture >= textures.size())
+	{
+		invalid = true;
+		return;
+	}
+
+	passes[pass].writes.push_back(texture);
+	textures[texture].writers.push_back(pass);
+}
+
+/// <summary>
+/// Cull, order, find lifetimes and alias.
+/// </summary>
+/// <param name="error">Receives the reason compiling failed.</param>
+/// <returns>Returns false on a bad handle or a dependency cycle.</returns>
+bool FrameGraph::Compile(std::string* error)
+{
+	compiled = false;
+	order.clear();
+	physicalTextures.clear();
+	physicalLastUse.clear();
+	stats = {};
+
+	if (invalid)
+	{
+		if (error)
+			*error = "A pass read or wrote a handle that doesn't exist.";
+		return false;
+	}
+
+	CullPasses();
+	if (!SortPasses())
+	{
+		if (error)
+			*error = "The passes' reads and writes form a cycle.";
+		return false;
+	}
+	ComputeLifetimes();
+	AliasTextures();
+
+	stats.passes = (unsigned int)passes.size();
+	stats.culledPasses = (unsigned int)(passes.size() - order.size());
+	compiled = true;
+	return true;
+}
+
+/// <summary>
+/// Run every compiled pass, in order. Does nothing
+/// if the graph changed since it was compiled.
+/// </summary>
+void FrameGraph::Execute() const
+{
+	if (!compiled)
+		return;
+
+	for (Handle pass : order)
+	{
+		if (passes[pass].execute)
+			passes[pass].execute();
+	}
+}
+
+// -----------------------------------------------
+// Helper methods.
+// -----------------------------------------------
+
+/// <summary>
+/// Add a texture with no users.
+/// </summary>
+FrameGraph::Handle FrameGraph::AddTexture(const std::string& name, const TextureDesc& desc, bool imported)
+{
+	Texture texture = {};
+	texture.name = name;
+	texture.desc = desc;
+	texture.imported = imported;
+	texture.firstUse = INVALID_HANDLE;
+	texture.lastUse = INVALID_HANDLE;
+	texture.physical = INVALID_HANDLE;
+	textures.push_back(texture);
+	compiled = false;
+	return (Handle)(textures.size() - 1);
+}
+
+/// <summary>
+/// Drop passes that write nothing anyone reads. Starting
+/// from the unread textures, each writer loses a reference;
+/// a writer left with none is culled, which in turn takes
+/// a reference from everything it read. Passes that write
+/// an imported texture are always kept.
+/// </summary>
+void FrameGraph::CullPasses()
+{
+	std::vector<Handle> unread;
+
+	for (Pass& pass : passes)
+	{
+		pass.culled = false;
+		pass.references = (unsigned int)pass.writes.size();
+	}
+	// A pass that reads and writes a texture (e.g. blending
+	// onto it) doesn't count as one of its readers.
+	for (Handle t = 0; t < textures.size(); t++)
+	{
+		Texture& texture = textures[t];
+		texture.references = 0;
+		for (Handle r : texture.readers)
+		{
+			if (std::find(texture.writers.begin(), texture.writers.end(), r) == texture.writers.end())
+				texture.references++;
+		}
+		if (texture.references == 0 && !texture.imported)
+			unread.push_back(t);
+	}
+
+	// Passes that write nothing have nothing to keep them.
+	for (Handle p = 0; p < passes.size(); p++)
+	{
+		if (passes[p].writes.empty())
+		{
+			passes[p].culled = true;
+			for (Handle t : passes[p].reads)
+			{
+				if (textures[t].references > 0 && --textures[t].references == 0 && !textures[t].imported)
+					unread.push_back(t);
+			}
+		}
+	}
+
+	while (!unread.empty())
+	{
+		Handle t = unread.back();
+		unread.pop_back();
+
+		for (Handle p : textures[t].writers)
+		{
+			Pass& pass = passes[p];
+			if (pass.culled || pass.references == 0 || --pass.references > 0)
+				continue;
+
+			// Writing an imported texture keeps the pass.
+			bool keep = false;
+			for (Handle w : pass.writes)
+				keep = keep || textures[w].imported;
+			if (keep)
+				continue;
+
+			pass.culled = true;
+			for (Handle r : pass.reads)
+			{
+				if (std::find(pass.writes.begin(), pass.writes.end(), r) != pass.writes.end())
+					continue;
+				if (textures[r].references > 0 && --textures[r].references == 0 && !textures[r].imported)
+					unread.push_back(r);
+			}
+		}
+	}
+}
+
+/// <summary>
+/// Order the passes that survived culling so that every
+/// texture's writers run before its readers (a pass that
+/// reads and writes a texture follows the earlier writers
+/// only). Ties keep declaration order.
+/// </summary>
+/// <returns>Returns false if the dependencies form a cycle.</returns>
+bool FrameGraph::SortPasses()
+{
+	std::vector<std::vector<Handle>> next(passes.size());
+	std::vector<unsigned int> waiting(passes.size(), 0);
+
+	for (const Texture& texture : textures)
+	{
+		// Live writers, in declaration order.
+		std::vector<Handle> writers;
+		for (Handle w : texture.writers)
+		{
+			if (!passes[w].culled && std::find(writers.begin(), writers.end(), w) == writers.end())
+				writers.push_back(w);
+		}
+
+		for (size_t i = 1; i < writers.size(); i++)
+		{
+			next[writers[i - 1]].push_back(writers[i]);
+			waiting[writers[i]]++;
+		}
+
+		for (Handle r : texture.readers)
+		{
+			if (passes[r].culled)
+				continue;
+
+			size_t limit = std::find(writers.begin(), writers.end(), r) - writers.begin();
+			for (size_t i = 0; i < limit; i++)
+			{
+				next[writers[i]].push_back(r);
+				waiting[r]++;
+			}
+		}
+	}
+
+	// Kahn's algorithm, lowest declaration index first.
+	std::priority_queue<Handle, std::vector<Handle>, std::greater<Handle>> ready;
+	unsigned int live = 0;
+	for (Handle p = 0; p < passes.size(); p++)
+	{
+		if (passes[p].culled)
+			continue;
+		live++;
+		if (waiting[p] == 0)
+			ready.push(p);
+	}
+
+	while (!ready.empty())
+	{
+		Handle p = ready.top();
+		ready.pop();
+		order.push_back(p);
+
+		for (Handle n : next[p])
+		{
+			if (--waiting[n] == 0)
+				ready.push(n);
+		}
+	}
+
+	return order.size() == live;
+}
+
+/// <summary>
+/// Find the first and last position in the order at
+/// which each texture is read or written.
+/// </summary>
+void FrameGraph::ComputeLifetimes()
+{
+	for (Texture& texture : textures)
+	{
+		texture.firstUse = INVALID_HANDLE;
+		texture.lastUse = INVALID_HANDLE;
+		texture.physical = INVALID_HANDLE;
+	}
+
+	for (unsigned int position = 0; position < order.size(); position++)
+	{
+		const Pass& pass = passes[order[position]];
+		for (int list = 0; list < 2; list++)
+		{
+			for (Handle t : (list == 0) ? pass.reads : pass.writes)
+			{
+				Texture& texture = textures[t];
+				if (texture.firstUse == INVALID_HANDLE)
+					texture.firstUse = position;
+				texture.lastUse = position;
+			}
+		}
+	}
+}
+
+/// <summary>
+/// Give each used transient texture a physical texture,
+/// reusing one with the same size and format whose last
+/// user ran before this texture's first. Textures are
+/// placed in order of first use.
+/// </summary>
+void FrameGraph::AliasTextures()
+{
+	std::vector<Handle> transient;
+	for (Handle t = 0; t < textures.size(); t++)
+	{
+		if (!textures[t].imported && textures[t].firstUse != INVALID_HANDLE)
+			transient.push_back(t);
+	}
+	std::stable_sort(transient.begin(), transient.end(),
+		[this](Handle a, Handle b) { return textures[a].firstUse < textures[b].firstUse; });
+
+	for (Handle t : transient)
+	{
+		Texture& texture = textures[t];
+		stats.transientTextures++;
+		stats.requestedBytes += GetTextureBytes(texture.desc);
+
+		for (Handle p = 0; p < physicalTextures.size(); p++)
+		{
+			const TextureDesc& desc = physicalTextures[p];
+			bool same = desc.width == texture.desc.width && desc.height == texture.desc.height && desc.format == texture.desc.format;
+			if (same && physicalLastUse[p] < texture.firstUse)
+			{
+				texture.physical = p;
+				break;
+			}
+		}
+
+		if (texture.physical == INVALID_HANDLE)
+		{
+			texture.physical = (Handle)physicalTextures.size();
+			physicalTextures.push_back(texture.desc);
+			physicalLastUse.push_back(texture.lastUse);
+			stats.allocatedBytes += GetTextureBytes(texture.desc);
+		}
+		else
+		{
+			physicalLastUse[texture.physical] = texture.lastUse;
+		}
+	}
+	stats.physicalTextures = (unsigned int)physicalTextures.size();
+}
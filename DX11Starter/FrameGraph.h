@@ -0,0 +1,181 @@
+#pragma once
+
+// -----------------------------------------------
+// Include statements.
+// -----------------------------------------------
+#include <functional>
+#include <string>
+#include <vector>
+
+// -----------------------------------------------
+// FrameGraph.h
+// ---
+// Describes a frame as passes that read and write
+// textures, then works out what to run and what
+// to allocate before anything is submitted.
+//
+// Compile() drops passes whose output nobody
+// uses, orders the rest so every texture is
+// written before it is read, finds the first and
+// last pass to touch each texture, and lets
+// transient textures whose lifetimes don't overlap
+// share one physical texture. Direct3D 11 can't
+// place two resources in the same memory, so only
+// textures with the same size and format share.
+//
+// Imported textures (e.g. the back buffer) live
+// outside the graph. Writing one is what keeps a
+// pass, and everything it depends on, alive.
+//
+// Compiling is plain CPU work and needs no device.
+// Formats are DXGI_FORMAT values, kept as plain
+// numbers so the graph builds without the
+// Direct3D headers.
+// -----------------------------------------------
+
+class FrameGraph
+{
+public:
+	// -----------------------------------------------
+	// Internal structs.
+	// -----------------------------------------------
+
+	/// <summary>
+	/// Index of a pass or texture.
+	/// </summary>
+	typedef unsigned int Handle;
+
+	/// <summary>
+	/// A DXGI_FORMAT value.
+	/// </summary>
+	typedef unsigned int Format;
+
+	/// <summary>
+	/// Size and format of a 2D texture.
+	/// </summary>
+	struct TextureDesc
+	{
+		unsigned int width;
+		unsigned int height;
+		Format format;
+	};
+
+	/// <summary>
+	/// Results of the last Compile().
+	/// </summary>
+	struct Statistics
+	{
+		unsigned int passes;
+		unsigned int culledPasses;
+		unsigned int transientTextures;		// Used by a pass that runs.
+		unsigned int physicalTextures;		// After aliasing.
+		unsigned long long requestedBytes;	// Transient textures, one allocation each.
+		unsigned long long allocatedBytes;	// Physical textures.
+	};
+
+	/// <summary>
+	/// Records a pass's work. Called by Execute().
+	/// </summary>
+	typedef std::function<void()> ExecuteFunction;
+
+	// No pass, texture or physical texture.
+	static const Handle INVALID_HANDLE = 0xFFFFFFFF;
+
+	// -----------------------------------------------
+	// Constructors.
+	// -----------------------------------------------
+
+	FrameGraph();
+
+	// -----------------------------------------------
+	// Static methods.
+	// -----------------------------------------------
+
+	static unsigned int GetBytesPerPixel(Format format);
+	static unsigned long long GetTextureBytes(const TextureDesc& desc);
+
+	// -----------------------------------------------
+	// Accessors.
+	// -----------------------------------------------
+
+	bool IsCompiled() const;
+	const Statistics& GetStatistics() const;
+	const std::vector<Handle>& GetOrder() const;	// Passes that run, in order.
+	const std::string& GetPassName(Handle pass) const;
+	const std::string& GetTextureName(Handle texture) const;
+	bool IsCulled(Handle pass) const;
+	bool GetLifetime(Handle texture, unsigned int* first, unsigned int* last) const;	// Positions in GetOrder(). False if unused.
+	Handle GetPhysicalTexture(Handle texture) const;	// INVALID_HANDLE for imported or unused textures.
+	const std::vector<TextureDesc>& GetPhysicalTextures() const;
+
+	// -----------------------------------------------
+	// Service methods.
+	// -----------------------------------------------
+
+	void Clear();	// Remove every pass and texture.
+	Handle CreateTexture(const std::string& name, const TextureDesc& desc);	// Transient: owned by the graph.
+	Handle ImportTexture(const std::string& name, const TextureDesc& desc);	// External: never aliased or culled.
+	Handle AddPass(const std::string& name, ExecuteFunction execute = ExecuteFunction());
+	void Read(Handle pass, Handle texture);
+	void Write(Handle pass, Handle texture);
+	bool Compile(std::string* error = nullptr);	// Returns false on a bad handle or a cycle.
+	void Execute() const;	// Runs the compiled passes in order.
+
+private:
+
+	// -----------------------------------------------
+	// Internal structs.
+	// -----------------------------------------------
+
+	/// <summary>
+	/// A texture and who uses it.
+	/// </summary>
+	struct Texture
+	{
+		std::string name;
+		TextureDesc desc;
+		bool imported;
+		std::vector<Handle> writers;	// In declaration order.
+		std::vector<Handle> readers;
+		unsigned int references;		// Readers still alive while culling.
+		unsigned int firstUse;			// Positions in the order.
+		unsigned int lastUse;
+		Handle physical;
+	};
+
+	/// <summary>
+	/// A pass and what it touches.
+	/// </summary>
+	struct Pass
+	{
+		std::string name;
+		ExecuteFunction execute;
+		std::vector<Handle> reads;
+		std::vector<Handle> writes;
+		unsigned int references;		// Outputs still needed while culling.
+		bool culled;
+	};
+
+	// -----------------------------------------------
+	// Data members.
+	// -----------------------------------------------
+
+	std::vector<Texture> textures;
+	std::vector<Pass> passes;
+	std::vector<Handle> order;
+	std::vector<TextureDesc> physicalTextures;
+	std::vector<unsigned int> physicalLastUse;
+	Statistics stats;
+	bool compiled;
+	bool invalid;	// A bad handle was passed to Read() or Write().
+
+	// -----------------------------------------------
+	// Helper methods.
+	// -----------------------------------------------
+
+	Handle AddTexture(const std::string& name, const TextureDesc& desc, bool imported);
+	void CullPasses();
+	bool SortPasses();	// Returns false on a cycle.
+	void ComputeLifetimes();
+	void AliasTextures();
+};
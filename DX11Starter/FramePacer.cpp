@@ -0,0 +1,246 @@
+// -----------------------------------------------
+// Include statements.
+// -----------------------------------------------
+#include "FramePacer.h"
+#include <chrono>
+#include <cmath>
+#include <thread>
+
+#if defined(_WIN32)
+#include <Windows.h>
+#pragma comment(lib, "winmm.lib")
+#endif
+
+// -----------------------------------------------
+// Static members.
+// -----------------------------------------------
+
+const float FramePacer::DEFAULT_BACKGROUND_FRAME_RATE = 30.0f;
+const float FramePacer::DEFAULT_IDLE_FRAME_RATE = 10.0f;
+const float FramePacer::DEFAULT_SPIN_THRESHOLD = 2.0f; // Sleep() overshoots by up to ~1ms at 1ms resolution.
+
+// -----------------------------------------------
+// Constructors.
+// -----------------------------------------------
+
+/// <summary>
+/// Initializes an unlimited pacer.
+/// </summary>
+FramePacer::FramePacer()
+	: mode{ PM_ACTIVE }, spinThreshold{ DEFAULT_SPIN_THRESHOLD },
+	lastSleep{ 0.0f }, lastSpin{ 0.0f }, timerResolutionRaised{ false }
+{
+	frameRates[PM_ACTIVE] = 0.0f;
+	frameRates[PM_BACKGROUND] = DEFAULT_BACKGROUND_FRAME_RATE;
+	frameRates[PM_IDLE] = DEFAULT_IDLE_FRAME_RATE;
+	this->Start();
+}
+
+/// <summary>
+/// Restores the OS timer resolution.
+/// </summary>
+FramePacer::~FramePacer()
+{
+	this->RestoreTimerResolution();
+}
+
+// -----------------------------------------------
+// Accessors.
+// -----------------------------------------------
+
+/// <summary>
+/// Frame rate used in a mode.
+/// </summary>
+/// <param name="mode">Pacing mode.</param>
+/// <returns>Returns frames per second, or zero if unlimited.</returns>
+float FramePacer::GetFrameRate(PacingMode mode) const
+{
+	return frameRates[mode];
+}
+
+/// <summary>
+/// Frame rate used in the current mode.
+/// </summary>
+/// <returns>Returns frames per second, or zero if unlimited.</returns>
+float FramePacer::GetCurrentFrameRate() const
+{
+	return frameRates[mode];
+}
+
+/// <summary>
+/// Current pacing mode.
+/// </summary>
+FramePacer::PacingMode FramePacer::GetMode() const
+{
+	return mode;
+}
+
+/// <summary>
+/// Is the current mode holding to a frame rate?
+/// </summary>
+bool FramePacer::IsLimited() const
+{
+	return GetCurrentFrameRate() > 0.0f;
+}
+
+/// <summary>
+/// Time the last Wait() spent asleep, in milliseconds.
+/// </summary>
+float FramePacer::GetLastSleepMilliseconds() const
+{
+	return lastSleep;
+}
+
+/// <summary>
+/// Time the last Wait() spent spinning, in milliseconds.
+/// </summary>
+float FramePacer::GetLastSpinMilliseconds() const
+{
+	return lastSpin;
+}
+
+// -----------------------------------------------
+// Mutators.
+// -----------------------------------------------
+
+/// <summary>
+/// Set the frame rate for a mode.
+/// </summary>
+/// <param name="mode">Pacing mode.</param>
+/// <param name="framesPerSecond">Target rate, or zero for unlimited.</param>
+void FramePacer::SetFrameRate(PacingMode mode, float framesPerSecond)
+{
+	frameRates[mode] = (framesPerSecond > 0.0f) ? framesPerSecond : 0.0f;
+}
+
+/// <summary>
+/// Switch modes. The next deadline is re-anchored,
+/// so leaving idle doesn't produce a burst of frames.
+/// </summary>
+/// <param name="mode">Pacing mode.</param>
+void FramePacer::SetMode(PacingMode mode)
+{
+	if (this->mode == mode)
+		return;
+
+	this->mode = mode;
+	nextDeadline = PlatformTimer::Now();
+}
+
+/// <summary>
+/// Set how much of the frame is spun rather than slept.
+/// </summary>
+/// <param name="milliseconds">Spin window.</param>
+void FramePacer::SetSpinThreshold(float milliseconds)
+{
+	spinThreshold = (milliseconds > 0.0f) ? milliseconds : 0.0f;
+}
+
+// -----------------------------------------------
+// Service methods.
+// -----------------------------------------------
+
+/// <summary>
+/// Anchors the first deadline to now.
+/// </summary>
+void FramePacer::Start()
+{
+	nextDeadline = PlatformTimer::Now();
+	previousFrame = nextDeadline;
+	lastSleep = 0.0f;
+	lastSpin = 0.0f;
+}
+
+/// <summary>
+/// Block until the next frame is due.
+/// </summary>
+/// <returns>Returns how far (in ms) the frame interval missed the target, or zero if unlimited.</returns>
+float FramePacer::Wait()
+{
+	lastSleep = 0.0f;
+	lastSpin = 0.0f;
+
+	PlatformTimer::Timestamp now = PlatformTimer::Now();
+	if (!IsLimited())
+	{
+		previousFrame = now;
+		nextDeadline = now;
+		return 0.0f;
+	}
+
+	// Sleep() is only accurate to the OS timer period.
+	RaiseTimerResolution();
+
+	// Step the deadline forward by a whole frame, rather
+	// than from now, so small overshoots don't accumulate.
+	double interval = 1.0 / GetCurrentFrameRate();
+	PlatformTimer::Timestamp period = PlatformTimer::TicksFromSeconds(interval);
+	nextDeadline += period;
+
+	// Fell more than a frame behind (hitch, breakpoint):
+	// start over from now instead of rushing to catch up.
+	if (now - nextDeadline > period)
+		nextDeadline = now;
+
+	// Sleep through most of the remaining time...
+	float remaining = static_cast<float>(PlatformTimer::SecondsBetween(now, nextDeadline) * 1000.0);
+	if (remaining > spinThreshold)
+	{
+		int sleepMilliseconds = static_cast<int>(remaining - spinThreshold);
+		if (sleepMilliseconds > 0)
+		{
+			std::this_thread::sleep_for(std::chrono::milliseconds(sleepMilliseconds));
+			lastSleep = PlatformTimer::MillisecondsSince(now);
+		}
+	}
+
+	// ...then spin for the rest.
+	PlatformTimer::Timestamp spinStart = PlatformTimer::Now();
+	while (PlatformTimer::Now() < nextDeadline)
+	{
+#if defined(_WIN32)
+		YieldProcessor();
+#else
+		std::this_thread::yield();
+#endif
+	}
+	lastSpin = PlatformTimer::MillisecondsSince(spinStart);
+
+	// Measure the interval actually achieved.
+	now = PlatformTimer::Now();
+	double actual = PlatformTimer::SecondsBetween(previousFrame, now);
+	previousFrame = now;
+	return static_cast<float>(std::fabs(actual - interval) * 1000.0);
+}
+
+// -----------------------------------------------
+// Helper methods.
+// -----------------------------------------------
+
+/// <summary>
+/// Ask for 1ms scheduler resolution while pacing.
+/// </summary>
+void FramePacer::RaiseTimerResolution()
+{
+	if (timerResolutionRaised)
+		return;
+
+#if defined(_WIN32)
+	timeBeginPeriod(1);
+#endif
+	timerResolutionRaised = true;
+}
+
+/// <summary>
+/// Give the scheduler resolution back.
+/// </summary>
+void FramePacer::RestoreTimerResolution()
+{
+	if (!timerResolutionRaised)
+		return;
+
+#if defined(_WIN32)
+	timeEndPeriod(1);
+#endif
+	timerResolutionRaised = false;
+}
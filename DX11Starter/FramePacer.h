@@ -0,0 +1,107 @@
+#pragma once
+
+// -----------------------------------------------
+// Include statements.
+// -----------------------------------------------
+#include "PlatformTimer.h"
+
+// -----------------------------------------------
+// FramePacer.h
+// ---
+// Holds the game loop to a target frame rate.
+// Sleeps for most of the remaining frame time,
+// then spins for the last stretch so frames land
+// on time without burning a core in between.
+// -----------------------------------------------
+
+class FramePacer
+{
+public:
+	// -----------------------------------------------
+	// Internal enum/structs.
+	// -----------------------------------------------
+
+	/// <summary>
+	/// PACING_MODE picks which frame rate applies.
+	/// </summary>
+	typedef enum _PACING_MODE
+	{
+		PM_ACTIVE = 0,		// Focused and visible: target frame rate.
+		PM_BACKGROUND = 1,	// Visible but unfocused: background frame rate.
+		PM_IDLE = 2,		// Minimized or occluded: idle frame rate.
+		PM_COUNT = 3
+	} PACING_MODE;
+
+	/// <summary>
+	/// Wrapper for PACING_MODE enum.
+	/// </summary>
+	typedef PACING_MODE PacingMode;
+
+	// Default frame rates, in frames per second.
+	static const float DEFAULT_BACKGROUND_FRAME_RATE;
+	static const float DEFAULT_IDLE_FRAME_RATE;
+
+	// Default time (in milliseconds) left to spin rather than sleep.
+	static const float DEFAULT_SPIN_THRESHOLD;
+
+	// -----------------------------------------------
+	// Constructors.
+	// -----------------------------------------------
+
+	FramePacer();
+	~FramePacer();
+
+	// -----------------------------------------------
+	// Accessors.
+	// -----------------------------------------------
+
+	float GetFrameRate(PacingMode mode) const;
+	float GetCurrentFrameRate() const;
+	PacingMode GetMode() const;
+	bool IsLimited() const;
+	float GetLastSleepMilliseconds() const;
+	float GetLastSpinMilliseconds() const;
+
+	// -----------------------------------------------
+	// Mutators.
+	// -----------------------------------------------
+
+	void SetFrameRate(PacingMode mode, float framesPerSecond); // Zero is unlimited.
+	void SetMode(PacingMode mode);
+	void SetSpinThreshold(float milliseconds);
+
+	// -----------------------------------------------
+	// Service methods.
+	// -----------------------------------------------
+
+	void Start();	// Anchors the first deadline to now.
+	float Wait();	// Blocks until the next frame is due; returns the interval's error in ms.
+
+private:
+
+	// -----------------------------------------------
+	// Data members.
+	// -----------------------------------------------
+
+	float frameRates[PM_COUNT];
+	PacingMode mode;
+	float spinThreshold;
+
+	// Time the next frame is due, and when the last one went.
+	PlatformTimer::Timestamp nextDeadline;
+	PlatformTimer::Timestamp previousFrame;
+
+	// Where the last Wait() spent its time.
+	float lastSleep;
+	float lastSpin;
+
+	// Raised OS timer resolution (so short sleeps are accurate)?
+	bool timerResolutionRaised;
+
+	// -----------------------------------------------
+	// Helper methods.
+	// -----------------------------------------------
+
+	void RaiseTimerResolution();
+	void RestoreTimerResolution();
+};
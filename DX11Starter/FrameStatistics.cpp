@@ -0,0 +1,245 @@
+// -----------------------------------------------
+// Include statements.
+// -----------------------------------------------
+#include "FrameStatistics.h"
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+
+// -----------------------------------------------
+// Static members.
+// -----------------------------------------------
+
+const float FrameStatistics::HISTOGRAM_BASE = 0.0625f; // 1/16th of a millisecond.
+
+// -----------------------------------------------
+// Constructors.
+// -----------------------------------------------
+
+/// <summary>
+/// Initializes an empty set of statistics.
+/// </summary>
+FrameStatistics::FrameStatistics()
+{
+	this->Reset();
+}
+
+// -----------------------------------------------
+// Static methods.
+// -----------------------------------------------
+
+/// <summary>
+/// Returns the short name of a phase, as used in reports.
+/// </summary>
+/// <param name="phase">Frame phase.</param>
+/// <returns>Returns phase name.</returns>
+const char* FrameStatistics::GetPhaseName(FramePhase phase)
+{
+	static const char* names[P_COUNT] = { "frame", "update", "draw", "pacing", "input" };
+	return (phase >= 0 && phase < P_COUNT) ? names[phase] : "unknown";
+}
+
+/// <summary>
+/// Returns the log2 histogram bucket for a frame time.
+/// Bucket 0 holds everything below HISTOGRAM_BASE, and
+/// each following bucket doubles the upper bound.
+/// </summary>
+/// <param name="milliseconds">Sample duration.</param>
+/// <returns>Returns bucket index.</returns>
+unsigned int FrameStatistics::GetBucketIndex(float milliseconds)
+{
+	if (!(milliseconds >= HISTOGRAM_BASE))
+		return 0;
+
+	int bucket = static_cast<int>(std::floor(std::log2(milliseconds / HISTOGRAM_BASE))) + 1;
+	return static_cast<unsigned int>(std::min(bucket, static_cast<int>(HISTOGRAM_BUCKETS) - 1));
+}
+
+/// <summary>
+/// Returns the (exclusive) upper bound of a histogram bucket, in milliseconds.
+/// </summary>
+/// <param name="bucket">Bucket index.</param>
+/// <returns>Returns upper bound.</returns>
+float FrameStatistics::GetBucketUpperBound(unsigned int bucket)
+{
+	return HISTOGRAM_BASE * std::ldexp(1.0f, static_cast<int>(bucket));
+}
+
+// -----------------------------------------------
+// Accessors.
+// -----------------------------------------------
+
+/// <summary>
+/// Returns the number of frames recorded.
+/// </summary>
+/// <returns>Returns frame count.</returns>
+unsigned long long FrameStatistics::GetFrameCount() const
+{
+	return sampleCounts[P_FRAME];
+}
+
+/// <summary>
+/// Returns the session histogram for a phase.
+/// </summary>
+/// <param name="phase">Frame phase.</param>
+/// <returns>Returns histogram reference.</returns>
+const FrameStatistics::Histogram& FrameStatistics::GetHistogram(FramePhase phase) const
+{
+	return histograms[phase];
+}
+
+/// <summary>
+/// Computes average and percentiles over the rolling window.
+/// </summary>
+/// <param name="phase">Frame phase.</param>
+/// <returns>Returns summary in milliseconds.</returns>
+FrameStatistics::Summary FrameStatistics::Summarize(FramePhase phase) const
+{
+	Summary summary = {};
+	unsigned int count = GetWindowCount(phase);
+	summary.samples = count;
+	if (count == 0)
+		return summary;
+
+	// Copy into scratch so the ring itself keeps its order.
+	const SampleWindow& window = windows[phase];
+	std::copy(window.begin(), window.begin() + count, scratch.begin());
+
+	float total = 0.0f;
+	float largest = 0.0f;
+	for (unsigned int i = 0; i < count; i++)
+	{
+		total += scratch[i];
+		largest = std::max(largest, scratch[i]);
+	}
+	summary.average = total / static_cast<float>(count);
+	summary.max = largest;
+
+	// Nearest-rank percentiles, selected in increasing order so
+	// each nth_element only has to partition the upper range.
+	const float percentiles[] = { 0.50f, 0.90f, 0.99f };
+	float* results[] = { &summary.p50, &summary.p90, &summary.p99 };
+	SampleWindow::iterator first = scratch.begin();
+	for (unsigned int p = 0; p < 3; p++)
+	{
+		unsigned int rank = static_cast<unsigned int>(std::ceil(percentiles[p] * count));
+		rank = std::max(rank, 1u) - 1;
+		SampleWindow::iterator nth = scratch.begin() + rank;
+		std::nth_element(first, nth, scratch.begin() + count);
+		*results[p] = *nth;
+		first = nth;
+	}
+
+	return summary;
+}
+
+// -----------------------------------------------
+// Service methods.
+// -----------------------------------------------
+
+/// <summary>
+/// Record a duration for the given phase.
+/// </summary>
+/// <param name="phase">Frame phase.</param>
+/// <param name="milliseconds">Duration of the phase.</param>
+void FrameStatistics::AddSample(FramePhase phase, float milliseconds)
+{
+	unsigned long long& count = sampleCounts[phase];
+	windows[phase][count % WINDOW_SIZE] = milliseconds;
+	histograms[phase][GetBucketIndex(milliseconds)]++;
+	count++;
+}
+
+/// <summary>
+/// Write the summary, histogram and raw window to a CSV file.
+/// </summary>
+/// <param name="filename">Output path.</param>
+/// <returns>Returns true if the file was written.</returns>
+bool FrameStatistics::DumpCSV(const std::string& filename) const
+{
+	std::ofstream csv(filename);
+	if (!csv.is_open())
+		return false;
+
+	// Percentile summary.
+	csv << "phase,samples,average_ms,p50_ms,p90_ms,p99_ms,max_ms\n";
+	for (unsigned int p = 0; p < P_COUNT; p++)
+	{
+		Summary s = Summarize(static_cast<FramePhase>(p));
+		csv << GetPhaseName(static_cast<FramePhase>(p)) << ',' << s.samples << ',' << s.average << ','
+			<< s.p50 << ',' << s.p90 << ',' << s.p99 << ',' << s.max << '\n';
+	}
+
+	// Log-scale histogram.
+	csv << "\nbucket_upper_ms";
+	for (unsigned int p = 0; p < P_COUNT; p++)
+		csv << ',' << GetPhaseName(static_cast<FramePhase>(p));
+	csv << '\n';
+
+	for (unsigned int b = 0; b < HISTOGRAM_BUCKETS; b++)
+	{
+		if (b == HISTOGRAM_BUCKETS - 1)
+			csv << "inf";
+		else
+			csv << GetBucketUpperBound(b);
+
+		for (unsigned int p = 0; p < P_COUNT; p++)
+			csv << ',' << histograms[p][b];
+		csv << '\n';
+	}
+
+	// Raw rolling window, oldest sample first.
+	// Phases may hold fewer samples than the frame (no
+	// pacing while unlimited), so rows run to the longest.
+	csv << "\nsample";
+	unsigned int rows = 0;
+	for (unsigned int p = 0; p < P_COUNT; p++)
+	{
+		csv << ',' << GetPhaseName(static_cast<FramePhase>(p)) << "_ms";
+		rows = std::max(rows, GetWindowCount(static_cast<FramePhase>(p)));
+	}
+	csv << '\n';
+	for (unsigned int i = 0; i < rows; i++)
+	{
+		csv << i;
+		for (unsigned int p = 0; p < P_COUNT; p++)
+		{
+			unsigned long long total = sampleCounts[p];
+			unsigned int count = GetWindowCount(static_cast<FramePhase>(p));
+			csv << ',';
+			if (i < count)
+				csv << windows[p][(total - count + i) % WINDOW_SIZE];
+		}
+		csv << '\n';
+	}
+
+	return csv.good();
+}
+
+/// <summary>
+/// Clear all recorded samples.
+/// </summary>
+void FrameStatistics::Reset()
+{
+	for (unsigned int p = 0; p < P_COUNT; p++)
+	{
+		windows[p].fill(0.0f);
+		histograms[p].fill(0);
+		sampleCounts[p] = 0;
+	}
+	scratch.fill(0.0f);
+}
+
+// -----------------------------------------------
+// Helper methods.
+// -----------------------------------------------
+
+/// <summary>
+/// Number of valid samples currently in the window.
+/// </summary>
+/// <param name="phase">Frame phase.</param>
+/// <returns>Returns sample count.</returns>
+unsigned int FrameStatistics::GetWindowCount(FramePhase phase) const
+{
+	return static_cast<unsigned int>(std::min<unsigned long long>(sampleCounts[phase], WINDOW_SIZE));
+}
@@ -0,0 +1,124 @@
+#pragma once
+
+// -----------------------------------------------
+// Include statements.
+// -----------------------------------------------
+#include <array>
+#include <string>
+
+// -----------------------------------------------
+// FrameStatistics.h
+// ---
+// Collects frame times (and the update/draw phases
+// of each frame) into a rolling window so that
+// percentiles can be reported instead of averages.
+// Input latency (from the oldest input event a
+// frame reflects to the frame's submission) is
+// kept the same way, for frames that had input.
+// -----------------------------------------------
+
+class FrameStatistics
+{
+public:
+	// -----------------------------------------------
+	// Internal enum/structs.
+	// -----------------------------------------------
+
+	/// <summary>
+	/// FRAME_PHASE determines which part of the frame
+	/// a sample was measured from.
+	/// </summary>
+	typedef enum _FRAME_PHASE
+	{
+		P_FRAME = 0,	// Entire frame, as seen by the timer.
+		P_UPDATE = 1,	// Time spent in Update().
+		P_DRAW = 2,		// Time spent in Draw().
+		P_PACING = 3,	// Distance of the frame interval from the pacer's target.
+		P_INPUT = 4,	// Input event to submission of the frame it changed.
+		P_COUNT = 5
+	} FRAME_PHASE;
+
+	/// <summary>
+	/// Wrapper for FRAME_PHASE enum.
+	/// </summary>
+	typedef FRAME_PHASE FramePhase;
+
+	// Number of samples kept in the rolling window.
+	static const unsigned int WINDOW_SIZE = 1024;
+
+	// Number of log2-scaled histogram buckets.
+	static const unsigned int HISTOGRAM_BUCKETS = 20;
+
+	// Upper bound (in milliseconds) of the first histogram bucket.
+	static const float HISTOGRAM_BASE;
+
+	/// <summary>
+	/// Percentile summary of the rolling window, in milliseconds.
+	/// </summary>
+	struct Summary
+	{
+		unsigned int samples;
+		float average;
+		float p50;
+		float p90;
+		float p99;
+		float max;
+	};
+
+	typedef std::array<float, WINDOW_SIZE> SampleWindow;
+	typedef std::array<unsigned long long, HISTOGRAM_BUCKETS> Histogram;
+
+	// -----------------------------------------------
+	// Constructors.
+	// -----------------------------------------------
+
+	FrameStatistics();
+
+	// -----------------------------------------------
+	// Static methods.
+	// -----------------------------------------------
+
+	static const char* GetPhaseName(FramePhase phase);
+	static unsigned int GetBucketIndex(float milliseconds);
+	static float GetBucketUpperBound(unsigned int bucket);
+
+	// -----------------------------------------------
+	// Accessors.
+	// -----------------------------------------------
+
+	unsigned long long GetFrameCount() const;
+	const Histogram& GetHistogram(FramePhase phase) const;
+	Summary Summarize(FramePhase phase) const;
+
+	// -----------------------------------------------
+	// Service methods.
+	// -----------------------------------------------
+
+	void AddSample(FramePhase phase, float milliseconds);
+	bool DumpCSV(const std::string& filename) const;
+	void Reset();
+
+private:
+
+	// -----------------------------------------------
+	// Data members.
+	// -----------------------------------------------
+
+	// Rolling window of samples, one per phase.
+	std::array<SampleWindow, P_COUNT> windows;
+
+	// Session-long log-scale histogram, one per phase.
+	std::array<Histogram, P_COUNT> histograms;
+
+	// Total samples received per phase.
+	std::array<unsigned long long, P_COUNT> sampleCounts;
+
+	// Scratch space for percentile selection (avoids allocating per query).
+	mutable SampleWindow scratch;
+
+	// -----------------------------------------------
+	// Helper methods.
+	// -----------------------------------------------
+
+	unsigned int GetWindowCount(FramePhase phase) const;
+};
@@ -0,0 +1,268 @@
+// -----------------------------------------------
+// Include statements.
+// -----------------------------------------------
+#include "FrustumCuller.h"
+#include <cfloat>
+#include <emmintrin.h>
+
+// -----------------------------------------------
+// Namespace statements.
+// -----------------------------------------------
+using namespace DirectX;
+
+// -----------------------------------------------
+// Constructors.
+// -----------------------------------------------
+
+/// <summary>
+/// Initializes an empty culler.
+/// </summary>
+FrustumCuller::FrustumCuller()
+	: count{ 0 }
+{}
+
+// -----------------------------------------------
+// Accessors.
+// -----------------------------------------------
+
+/// <summary>
+/// Number of spheres added since the last Clear().
+/// </summary>
+size_t FrustumCuller::GetCount() const
+{
+	return count;
+}
+
+/// <summary>
+/// Number of spheres that passed the last cull.
+/// </summary>
+size_t FrustumCuller::GetVisibleCount() const
+{
+	return visible.size();
+}
+
+/// <summary>
+/// Indices (in add order) of the spheres that passed the last cull.
+/// </summary>
+const std::vector<unsigned int>& FrustumCuller::GetVisible() const
+{
+	return visible;
+}
+
+/// <summary>
+/// Per sphere view masks from the last CullViews(). Bit v is set
+/// if the sphere is at least partly inside view v.
+/// </summary>
+const std::vector<unsigned int>& FrustumCuller::GetViewMasks() const
+{
+	return viewMasks;
+}
+
+// -----------------------------------------------
+// Service methods.
+// -----------------------------------------------
+
+/// <summary>
+/// Reserve room for a number of spheres.
+/// </summary>
+void FrustumCuller::Reserve(size_t capacity)
+{
+	size_t padded = (capacity + LANES - 1) / LANES * LANES;
+	centerX.reserve(padded);
+	centerY.reserve(padded);
+	centerZ.reserve(padded);
+	radius.reserve(padded);
+	visible.reserve(padded);
+	viewMasks.reserve(padded);
+}
+
+/// <summary>
+/// Drop every sphere and the last result.
+/// </summary>
+void FrustumCuller::Clear()
+{
+	centerX.clear();
+	centerY.clear();
+	centerZ.clear();
+	radius.clear();
+	visible.clear();
+	viewMasks.clear();
+	count = 0;
+}
+
+/// <summary>
+/// Add a sphere to test.
+/// </summary>
+/// <param name="sphere">Center (xyz) and radius (w).</param>
+void FrustumCuller::Add(const XMFLOAT4& sphere)
+{
+	// Overwrite padding left by the last Pad(), if any.
+	centerX.resize(count);
+	centerY.resize(count);
+	centerZ.resize(count);
+	radius.resize(count);
+
+	centerX.push_back(sphere.x);
+	centerY.push_back(sphere.y);
+	centerZ.push_back(sphere.z);
+	radius.push_back(sphere.w);
+	count++;
+}
+
+/// <summary>
+/// Test every sphere, four at a time. A sphere is culled once
+/// it lies fully behind any plane; spheres crossing a plane
+/// are kept.
+/// </summary>
+/// <param name="planes">Normalized, inward facing frustum planes.</param>
+/// <returns>Returns the number of visible spheres.</returns>
+size_t FrustumCuller::Cull(const Planes& planes)
+{
+	Pad();
+	size_t padded = centerX.size();
+
+	// One plane component splatted across all four lanes.
+	__m128 planeX[6], planeY[6], planeZ[6], planeW[6];
+	for (int p = 0; p < 6; p++)
+	{
+		planeX[p] = _mm_set1_ps(planes[p].x);
+		planeY[p] = _mm_set1_ps(planes[p].y);
+		planeZ[p] = _mm_set1_ps(planes[p].z);
+		planeW[p] = _mm_set1_ps(planes[p].w);
+	}
+
+	// Write indices unconditionally and only advance past
+	// the visible ones, so there's no branch per sphere.
+	visible.resize(padded);
+	unsigned int* out = visible.data();
+	size_t visibleCount = 0;
+	const __m128 zero = _mm_setzero_ps();
+
+	for (size_t i = 0; i < padded; i += LANES)
+	{
+		__m128 x = _mm_loadu_ps(&centerX[i]);
+		__m128 y = _mm_loadu_ps(&centerY[i]);
+		__m128 z = _mm_loadu_ps(&centerZ[i]);
+		__m128 r = _mm_loadu_ps(&radius[i]);
+
+		// Inside a plane: dot(normal, center) + w + radius >= 0.
+		__m128 inside = _mm_cmpeq_ps(zero, zero);
+		for (int p = 0; p < 6; p++)
+		{
+			__m128 distance = _mm_add_ps(
+				_mm_add_ps(_mm_mul_ps(planeX[p], x), _mm_mul_ps(planeY[p], y)),
+				_mm_add_ps(_mm_mul_ps(planeZ[p], z), _mm_add_ps(planeW[p], r)));
+			inside = _mm_and_ps(inside, _mm_cmpge_ps(distance, zero));
+		}
+
+		int mask = _mm_movemask_ps(inside);
+		for (unsigned int lane = 0; lane < LANES; lane++)
+		{
+			out[visibleCount] = (unsigned int)(i + lane);
+			visibleCount += (mask >> lane) & 1;
+		}
+	}
+
+	visible.resize(visibleCount);
+	return visibleCount;
+}
+
+/// <summary>
+/// Same test as Cull(), one sphere at a time, stopping at
+/// the first plane it fails.
+/// </summary>
+/// <param name="planes">Normalized, inward facing frustum planes.</param>
+/// <returns>Returns the number of visible spheres.</returns>
+size_t FrustumCuller::CullScalar(const Planes& planes)
+{
+	visible.clear();
+	for (size_t i = 0; i < count; i++)
+	{
+		bool inside = true;
+		for (int p = 0; p < 6 && inside; p++)
+		{
+			float distance = (planes[p].x * centerX[i] + planes[p].y * centerY[i])
+				+ (planes[p].z * centerZ[i] + (planes[p].w + radius[i]));
+			inside = distance >= 0.0f;
+		}
+
+		if (inside)
+			visible.push_back((unsigned int)i);
+	}
+	return visible.size();
+}
+
+/// <summary>
+/// Test every sphere against several frusta in one pass: each
+/// group of four spheres is loaded once and tested against
+/// every view while it's in registers, rather than sweeping
+/// the arrays once per view.
+/// </summary>
+/// <param name="views">Normalized, inward facing planes of each view (at most MAX_VIEWS).</param>
+/// <returns>Returns the number of spheres inside at least one view.</returns>
+size_t FrustumCuller::CullViews(const std::vector<Planes>& views)
+{
+	Pad();
+	size_t padded = centerX.size();
+	unsigned int viewCount = (views.size() < MAX_VIEWS) ? (unsigned int)views.size() : MAX_VIEWS;
+
+	viewMasks.resize(padded);
+	visible.resize(padded);
+	unsigned int* out = visible.data();
+	size_t visibleCount = 0;
+	const __m128 zero = _mm_setzero_ps();
+
+	for (size_t i = 0; i < padded; i += LANES)
+	{
+		__m128 x = _mm_loadu_ps(&centerX[i]);
+		__m128 y = _mm_loadu_ps(&centerY[i]);
+		__m128 z = _mm_loadu_ps(&centerZ[i]);
+		__m128 r = _mm_loadu_ps(&radius[i]);
+
+		// Each lane gathers its sphere's bits.
+		__m128i masks = _mm_setzero_si128();
+		for (unsigned int v = 0; v < viewCount; v++)
+		{
+			const Planes& planes = views[v];
+			__m128 inside = _mm_cmpeq_ps(zero, zero);
+			for (int p = 0; p < 6; p++)
+			{
+				__m128 distance = _mm_add_ps(
+					_mm_add_ps(_mm_mul_ps(_mm_load1_ps(&planes[p].x), x), _mm_mul_ps(_mm_load1_ps(&planes[p].y), y)),
+					_mm_add_ps(_mm_mul_ps(_mm_load1_ps(&planes[p].z), z), _mm_add_ps(_mm_load1_ps(&planes[p].w), r)));
+				inside = _mm_and_ps(inside, _mm_cmpge_ps(distance, zero));
+			}
+			masks = _mm_or_si128(masks, _mm_and_si128(_mm_castps_si128(inside), _mm_set1_epi32((int)(1u << v))));
+		}
+		_mm_storeu_si128((__m128i*)&viewMasks[i], masks);
+
+		// Same branch free compaction as Cull(), on "any view".
+		int mask = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(masks, _mm_setzero_si128())));
+		for (unsigned int lane = 0; lane < LANES; lane++)
+		{
+			out[visibleCount] = (unsigned int)(i + lane);
+			visibleCount += ((mask >> lane) & 1) ^ 1;
+		}
+	}
+
+	viewMasks.resize(count);
+	visible.resize(visibleCount);
+	return visibleCount;
+}
+
+// -----------------------------------------------
+// Helper methods.
+// -----------------------------------------------
+
+/// <summary>
+/// Round the arrays up to a multiple of four. Padding has
+/// a hugely negative radius, so it fails every plane.
+/// </summary>
+void FrustumCuller::Pad()
+{
+	size_t padded = (count + LANES - 1) / LANES * LANES;
+	centerX.resize(padded, 0.0f);
+	centerY.resize(padded, 0.0f);
+	centerZ.resize(padded, 0.0f);
+	radius.resize(padded, -FLT_MAX);
+}
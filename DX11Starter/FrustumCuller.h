@@ -0,0 +1,96 @@
+#pragma once
+
+// -----------------------------------------------
+// Include statements.
+// -----------------------------------------------
+#include <DirectXMath.h>
+#include <array>
+#include <cstddef>
+#include <vector>
+
+// -----------------------------------------------
+// FrustumCuller.h
+// ---
+// Tests bounding spheres against the six planes
+// of a view frustum, four spheres at a time with
+// SSE, and collects the indices of the ones that
+// are at least partly inside.
+//
+// Spheres are kept as separate x/y/z/radius
+// arrays (structure of arrays) so that one SSE
+// load fetches the same component of four spheres.
+// The arrays are padded to a multiple of four with
+// spheres that can never pass, so the loop needs
+// no scalar tail.
+//
+// CullViews() tests against several frusta (main
+// camera, shadow cascades, a split screen view)
+// in one sweep over the spheres, and gives each
+// sphere a mask with one bit per view it is in.
+// -----------------------------------------------
+
+class FrustumCuller
+{
+public:
+	// -----------------------------------------------
+	// Internal structs.
+	// -----------------------------------------------
+
+	/// <summary>
+	/// Frustum planes, as Camera::GetFrustumPlanes() returns them.
+	/// </summary>
+	typedef std::array<DirectX::XMFLOAT4, 6> Planes;
+
+	// Spheres tested per SIMD step.
+	static const unsigned int LANES = 4;
+
+	// Most views CullViews() takes (one mask bit each).
+	static const unsigned int MAX_VIEWS = 32;
+
+	// -----------------------------------------------
+	// Constructors.
+	// -----------------------------------------------
+
+	FrustumCuller();
+
+	// -----------------------------------------------
+	// Accessors.
+	// -----------------------------------------------
+
+	size_t GetCount() const;							// Spheres added.
+	size_t GetVisibleCount() const;
+	const std::vector<unsigned int>& GetVisible() const;	// Indices passed by the last cull, ascending.
+	const std::vector<unsigned int>& GetViewMasks() const;	// One per sphere from the last CullViews(); bit v set if in view v.
+
+	// -----------------------------------------------
+	// Service methods.
+	// -----------------------------------------------
+
+	void Reserve(size_t count);
+	void Clear();	// Call at the start of each frame. Keeps the memory.
+	void Add(const DirectX::XMFLOAT4& sphere);	// Center (xyz) and radius (w). Index is the add order.
+	size_t Cull(const Planes& planes);			// Returns the visible count.
+	size_t CullScalar(const Planes& planes);	// One sphere at a time, for comparison.
+	size_t CullViews(const std::vector<Planes>& views);	// Returns the count in any view. Views past MAX_VIEWS are ignored.
+
+private:
+
+	// -----------------------------------------------
+	// Data members.
+	// -----------------------------------------------
+
+	std::vector<float> centerX;
+	std::vector<float> centerY;
+	std::vector<float> centerZ;
+	std::vector<float> radius;
+	size_t count;
+	std::vector<unsigned int> visible;
+	std::vector<unsigned int> viewMasks;
+
+	// -----------------------------------------------
+	// Helper methods.
+	// -----------------------------------------------
+
+	void Pad();	// Fill the last group of four with spheres that always fail.
+
+};
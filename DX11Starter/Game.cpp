@@ -1,12 +1,24 @@
 #include "Game.h"
 #include "Vertex.h"
 #include "Camera.h"
+#include "RenderCounters.h"
+#include "ShaderConstants.h"
+#include <algorithm>
 #include <cstdlib>
+#include <fstream>
 #include <map>
 
 // For the DirectX Math library
 using namespace DirectX;
 
+// Occluders drawn per frame, and how large an entity must
+// look (bounding radius over view depth) to be one
+static const unsigned int MAX_OCCLUDERS = 8;
+static const float OCCLUDER_MIN_SIZE = 0.05f;
+
+// Background color (Cornflower Blue in this case) for clearing
+static const float CLEAR_COLOR[4] = { 0.4f, 0.6f, 0.75f, 0.0f };
+
 // --------------------------------------------------------
 // Constructor
 //
@@ -14,20 +26,23 @@ using namespace DirectX;
 // DirectX itself, and our window, are not ready yet!
 //
 // hInstance - the application's OS-level handle (unique ID)
+// options   - command line options, passed through to DXCore
 // --------------------------------------------------------
-Game::Game(HINSTANCE hInstance)
+Game::Game(HINSTANCE hInstance, const CommandLineOptions& options)
 	: DXCore(
 		hInstance,		// The application's handle
 		"DirectX Game",	   	// Text for the window's title bar
 		1280,			// Width of the window's client area
 		720,			// Height of the window's client area
-		true) // Show extra stats (fps) in title bar?
+		true, // Show extra stats (fps) in title bar?
+		options) // Headless mode, frame limit
 {
 	// -----------------
 	// Initialize fields
 
 	// Initialize shaders.
 	vertexShader = 0;
+	instancedVertexShader = 0;
 	pixelShader = 0;
 	sharedMaterial = 0;
 
@@ -51,12 +66,12 @@ Game::Game(HINSTANCE hInstance)
 	prevMousePos = POINT();
 
 	// Initialize the key mapping.
-	keyMap = KeyMappings();
-	keyCodes = KeyCodes();
+	input = InputMap();
+	replayingInput = false;
 
 	// Initialize the meshes.
 	meshCount = 3;
-	gameEntityCount = 18;
+	gameEntityCount = (options.entityCount > 0) ? (int)options.entityCount : 18;
 
 	meshObjects = MeshCollection();
 	gameEntities = GameEntityCollection();
@@ -64,15 +79,20 @@ Game::Game(HINSTANCE hInstance)
 #if defined(DEBUG) || defined(_DEBUG)
 	// -----------------
 	// Do we want a console window?  Probably only in debug mode
-	CreateConsoleWindow(500, 120, 32, 120);
-	printf("| Foundations of Game Graphics Programming: ---------------------------------- |\n");
-	printf("| Console window created successfully.  Feel free to printf() here.            |\n");
-	printf("| ---------------------------------------------------------------------------- |\n");
-	printf("| Controls: ------------------------------------------------------------------ |\n");
-	printf("| ------------ MOVEMENT [ X ('A'/'D') | Y ('W'/'S') | Z ('Q'/'E') ] ---------- |\n");
-	// printf("| ----------------------- SCALE 'F'-key + [ ('A'/'D') ] ---------------------- |\n");
-	printf("| -- ROTATION 'R'-key + [ YAW ('A'/'D') | PITCH ('W'/'S') | ROLL ('Q'/'E') ] - |\n");
-	printf("| ---------------------------------------------------------------------------- |\n");
+	//  - Headless runs print to the console that launched them
+	if (!IsHeadless())
+	{
+		CreateConsoleWindow(500, 120, 32, 120);
+		printf("| Foundations of Game Graphics Programming: ---------------------------------- |\n");
+		printf("| Console window created successfully.  Feel free to printf() here.            |\n");
+		printf("| ---------------------------------------------------------------------------- |\n");
+		printf("| Controls: ------------------------------------------------------------------ |\n");
+		printf("| ------------ MOVEMENT [ X ('A'/'D') | Y ('W'/'S') | Z ('Q'/'E') ] ---------- |\n");
+		// printf("| ----------------------- SCALE 'F'-key + [ ('A'/'D') ] ---------------------- |\n");
+		printf("| -- ROTATION 'R'-key + [ YAW ('A'/'D') | PITCH ('W'/'S') | ROLL ('Q'/'E') ] - |\n");
+		printf("| ---------------- STATISTICS 'F9' saves FrameStatistics.csv ----------------- |\n");
+		printf("| ---------------------------------------------------------------------------- |\n");
+	}
 #endif
 
 }
@@ -112,6 +132,7 @@ Game::~Game()
 	// Delete our simple shader objects, which
 	// will clean up their own internal DirectX stuff
 	delete vertexShader;
+	delete instancedVertexShader;
 	delete pixelShader;
 	delete sharedMaterial;
 }
@@ -129,12 +150,14 @@ void Game::Init()
 	CreateInput();
 	CreateMatrices();
 	CreateBasicGeometry();
+	StartInputRecorder();
 	CreateEntities();
+	CreateFrameGraph();
 
 	// Tell the input assembler stage of the pipeline what kind of
 	// geometric primitives (points, lines or triangles) we want to draw.
 	// Essentially: "What kind of shape should the GPU draw with our data?"
-	context->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+	backend->SetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
 }
 
 // --------------------------------------------------------
@@ -148,6 +171,9 @@ void Game::LoadShaders()
 	vertexShader = new SimpleVertexShader(device, context);
 	vertexShader->LoadShaderFile(L"VertexShader.cso");
 
+	instancedVertexShader = new SimpleVertexShader(device, context);
+	instancedVertexShader->LoadShaderFile(L"InstancedVertexShader.cso");
+
 	pixelShader = new SimplePixelShader(device, context);
 	pixelShader->LoadShaderFile(L"PixelShader.cso");
 
@@ -160,35 +186,49 @@ void Game::CreateInput()
 	// Assign mappings.
 
 	// Camera movement.
-	keyMap[ACTION::CAMERA_MOVE_UP] = "SPACEBAR";
-	keyMap[ACTION::CAMERA_MOVE_DOWN] = 'X';
-	keyMap[ACTION::CAMERA_MOVE_FORWARD] = 'W';
-	keyMap[ACTION::CAMERA_MOVE_BACKWARD] = 'S';
-	keyMap[ACTION::CAMERA_MOVE_LEFT] = 'A';
-	keyMap[ACTION::CAMERA_MOVE_RIGHT] = 'D';
-
-	keyMap[ACTION::CAMERA_TURN_LEFT] = 'Q';
-	keyMap[ACTION::CAMERA_TURN_RIGHT] = 'E';
-	keyMap[ACTION::CAMERA_PITCH_UP] = "RW";
-	keyMap[ACTION::CAMERA_PITCH_DOWN] = "RS";
-	keyMap[ACTION::CAMERA_ROLL_LEFT] = "RA";
-	keyMap[ACTION::CAMERA_ROLL_RIGHT] = "RD";
-
-	keyMap[ACTION::MODIFIER_ROTATE] = "R";
-	keyMap[ACTION::MODIFIER_RESET] = "TAB";
-
-	// Assign codes by looping through the mappings.
-	for (auto const& mapping : keyMap)
-	{
-		// Get the key and the associated value.
-		ACTION key = mapping.first;
-		std::string input = mapping.second;
+	input.Bind(ACTION::CAMERA_MOVE_UP, { VK_SPACE });
+	input.Bind(ACTION::CAMERA_MOVE_DOWN, "X");
+	input.Bind(ACTION::CAMERA_MOVE_FORWARD, "W");
+	input.Bind(ACTION::CAMERA_MOVE_BACKWARD, "S");
+	input.Bind(ACTION::CAMERA_MOVE_LEFT, "A");
+	input.Bind(ACTION::CAMERA_MOVE_RIGHT, "D");
+
+	input.Bind(ACTION::CAMERA_TURN_LEFT, "Q");
+	input.Bind(ACTION::CAMERA_TURN_RIGHT, "E");
+	input.Bind(ACTION::CAMERA_PITCH_UP, "RW");
+	input.Bind(ACTION::CAMERA_PITCH_DOWN, "RS");
+	input.Bind(ACTION::CAMERA_ROLL_LEFT, "RA");
+	input.Bind(ACTION::CAMERA_ROLL_RIGHT, "RD");
+
+	input.Bind(ACTION::MODIFIER_ROTATE, "R");
+	input.Bind(ACTION::MODIFIER_RESET, { VK_TAB });
+
+	input.Bind(ACTION::GAME_QUIT, { VK_ESCAPE });
+}
 
-		// Assign all values to false.
-		if (input.length() > 0) {
-			keyCodes[input] = false;
-		}
+// --------------------------------------------------------
+// Starts recording or playing back input, if asked to on
+// the command line.  Runs before the entities are created,
+// since playback has to reseed them to match the recording.
+// --------------------------------------------------------
+void Game::StartInputRecorder()
+{
+	unsigned int seed = GetRandomSeed();
+
+	if (!options.playbackPath.empty())
+	{
+		if (recorder.StartPlayback(options.playbackPath))
+			seed = recorder.GetSeed();
+		else
+			LOG_ERROR(LC_INPUT, "Could not load input recording '%s'.", options.playbackPath);
+	}
+	else if (!options.recordPath.empty())
+	{
+		if (!recorder.StartRecording(options.recordPath, seed))
+			LOG_ERROR(LC_INPUT, "Could not create input recording '%s'.", options.recordPath);
 	}
+
+	GameEntity::SetRandomSeed(seed);
 }
 
 // --------------------------------------------------------
@@ -197,10 +237,9 @@ void Game::CreateInput()
 // --------------------------------------------------------
 void Game::CreateMatrices()
 {
-	// Initial updates to create the matrices.
-	camera.GetTransform().SetPosition(XMFLOAT3(0.0f, 0.0f, -5.0f)); // Absolutely move camera back.
-	camera.UpdateViewMatrix();
-	camera.UpdateProjectionMatrix();
+	// The camera builds its matrices when it's created (already
+	// moved back, see the constructor) and after any change.
+	camera.Update();
 		
 	// Set up world matrix
 	// - In an actual game, each object will need one of these and they should
@@ -361,6 +400,17 @@ void Game::CreateBasicGeometry()
 		char* charArr = &(filepaths[m])[0];
 		meshCount++;
 		meshObjects.push_back(std::make_shared<Mesh>(charArr, device));
+
+		// Coarser versions saved next to the model, as name_lod1.obj,
+		// name_lod2.obj and so on, become its detail levels.
+		std::string basePath = filepaths[m].substr(0, filepaths[m].size() - 4);
+		for (unsigned int level = 1; level < LodSelector::MAX_LEVELS; level++)
+		{
+			std::string levelPath = basePath + "_lod" + std::to_string(level) + ".obj";
+			if (!std::ifstream(levelPath).good())
+				break;
+			meshObjects.back()->AddDetailLevel(std::make_shared<Mesh>(&levelPath[0], device));
+		}
 	}
 }
 
@@ -424,6 +474,9 @@ void Game::OnResize()
 	// Update the camera size.
 	this->camera.SetDimensions((float) width, (float) height); // Updates the aspect ratio and updates the projection matrix.
 
+	// Screen-sized textures change size with the window.
+	CreateFrameGraph();
+
 	// ORIGINAL: Update our projection matrix since the window size changed
 	/* XMMATRIX P = XMMatrixPerspectiveFovLH(
 		0.25f * 3.1415926535f,	// Field of View Angle
@@ -438,48 +491,30 @@ void Game::OnResize()
 // --------------------------------------------------------
 void Game::Update(float deltaTime, float totalTime)
 {
-	// Quit if the escape key is pressed
-	if (GetAsyncKeyState(VK_ESCAPE)) { Quit(); }
-
-	// No input on this frame flag.
-	bool keyPressed = false;
-
-	// Update key input states.
-	for (auto const& keys : keyCodes) 
+	if (recorder.IsPlaying())
 	{
-		// Get the input string.
-		std::string input = keys.first;
-
-		// If input key is zero-length string, continue.
-		if (input.length() == 0) { continue; }
-		
-		// Update states.
-		// Handle special cases.
-		if (input == "SPACEBAR") 
-		{
-			keyCodes[input] = GetAsyncKeyState(VK_SPACE);
-			keyPressed = true;
-		}
-		else if (input == "TAB") 
-		{
-			keyCodes[input] = GetAsyncKeyState(VK_TAB);
-			keyPressed = true;
-		}
-		else
-		{
-			// Placeholder value.
-			bool check = true;
+		// Drive this frame from the recording instead of the
+		// keyboard and mouse, including its timing.
+		const InputRecorder::Frame* frame = recorder.NextFrame();
+		if (!frame) { Quit(); return; }
+
+		deltaTime = frame->deltaTime;
+		totalTime = frame->totalTime;
+		ReplayMouseEvents(*frame);
+		input.Apply(frame->actions);
+	}
+	else
+	{
+		// Resolve this frame's key events into action states.
+		input.Update();
+		recorder.RecordFrame(deltaTime, totalTime, input.GetActions());
+	}
 
-			// Each character must be valid in order for check to succeed.
-			for (int i = 0; i < input.length(); i++) 
-			{
-				check = check && (GetAsyncKeyState(input[i]) & 0x8000);
-			}
+	// Quit if the escape key is pressed
+	if (input.IsDown(ACTION::GAME_QUIT)) { Quit(); }
 
-			keyCodes[input] = check;
-			keyPressed = check ? true : keyPressed;
-		}	
-	}
+	// No input on this frame flag.
+	bool keyPressed = input.AnyDown();
 	
 	// Calculate the speed.
 	float speed = 5.0f;
@@ -498,22 +533,21 @@ void Game::Update(float deltaTime, float totalTime)
 	// Set up skip if no key pressed.
 	if (keyPressed)
 	{
-		bool rotationModifier = keyCodes[keyMap[ACTION::MODIFIER_ROTATE]];
+		bool rotationModifier = input.IsDown(ACTION::MODIFIER_ROTATE);
 
 		// Check for keyboard input.
-		for (auto const& mapping : keyMap)
+		for (int action = 0; action < ACTION::ACTION_COUNT; action++)
 		{
-			// Get the key and the associated value.
-			ACTION key = mapping.first;
-			std::string input = mapping.second;
-			bool keyDown = keyCodes[input];
+			// Get the action and its state.
+			ACTION key = (ACTION)action;
+			bool keyDown = input.IsDown(key);
 
 			// If a key has been pressed.
 			if (keyDown)
 			{
 				if (key == ACTION::MODIFIER_RESET)
 				{
-					printf("Camera > Reset [%s] \n", input.c_str());
+					LOG_DEBUG(LC_CAMERA, "Camera > Reset");
 					camera.Reset();
 				}
 				else 
@@ -526,31 +560,31 @@ void Game::Update(float deltaTime, float totalTime)
 						{
 							// Rotation.
 						case ACTION::CAMERA_TURN_RIGHT:
-							printf("Camera > Turn > Right [%s] \n", input.c_str());
+							LOG_DEBUG(LC_CAMERA, "Camera > Turn > Right");
 							cam_deltaRotation.x += deltaRadians;
 							break;
 						case ACTION::CAMERA_TURN_LEFT:
-							printf("Camera > Turn > Left [%s] \n", input.c_str());
+							LOG_DEBUG(LC_CAMERA, "Camera > Turn > Left");
 							cam_deltaRotation.x -= deltaRadians;
 							break;
 						case ACTION::CAMERA_PITCH_UP:
-							printf("Camera > Pitch > Up [%s] \n", input.c_str());
+							LOG_DEBUG(LC_CAMERA, "Camera > Pitch > Up");
 							cam_deltaRotation.y -= deltaRadians;
 							break;
 						case ACTION::CAMERA_PITCH_DOWN:
-							printf("Camera > Pitch > Down [%s] \n", input.c_str());
+							LOG_DEBUG(LC_CAMERA, "Camera > Pitch > Down");
 							cam_deltaRotation.y += deltaRadians;
 							break;
 						case ACTION::CAMERA_ROLL_RIGHT:
-							printf("Camera > Roll > Right [%s] \n", input.c_str());
+							LOG_DEBUG(LC_CAMERA, "Camera > Roll > Right");
 							cam_deltaRotation.z -= deltaRadians;
 							break;
 						case ACTION::CAMERA_ROLL_LEFT:
-							printf("Camera > Roll > Left [%s] \n", input.c_str());
+							LOG_DEBUG(LC_CAMERA, "Camera > Roll > Left");
 							cam_deltaRotation.z += deltaRadians;
 							break;
 						case ACTION::MODIFIER_ROTATE:
-							printf("Rotation Modifier [%s] \n", input.c_str());
+							LOG_DEBUG(LC_INPUT, "Rotation Modifier");
 						}
 					}
 					else
@@ -560,25 +594,25 @@ void Game::Update(float deltaTime, float totalTime)
 						{
 							// Rotation.
 						case ACTION::CAMERA_TURN_RIGHT:
-							printf("Camera > Turn > Right [%s] \n", input.c_str());
+							LOG_DEBUG(LC_CAMERA, "Camera > Turn > Right");
 							cam_deltaRotation.x += deltaRadians;
 							break;
 						case ACTION::CAMERA_TURN_LEFT:
-							printf("Camera > Turn > Left [%s] \n", input.c_str());
+							LOG_DEBUG(LC_CAMERA, "Camera > Turn > Left");
 							cam_deltaRotation.x -= deltaRadians;
 							break;
 
 							// Movement.
 						case ACTION::CAMERA_MOVE_UP:
-							printf("Camera > Move > Up [%s] \n", input.c_str());
+							LOG_DEBUG(LC_CAMERA, "Camera > Move > Up");
 							cam_deltaPosition.y += deltaSpeed; // Movement regardless of position.
 							break;
 						case ACTION::CAMERA_MOVE_DOWN:
-							printf("Camera > Move > Down [%s] \n", input.c_str());
+							LOG_DEBUG(LC_CAMERA, "Camera > Move > Down");
 							cam_deltaPosition.y -= deltaSpeed; // Movement regardless of position.
 							break;
 						case ACTION::CAMERA_MOVE_FORWARD:
-							printf("Camera > Move > Forward [%s] \n", input.c_str());
+							LOG_DEBUG(LC_CAMERA, "Camera > Move > Forward");
 
 							{
 								// Get the current heading.
@@ -595,7 +629,7 @@ void Game::Update(float deltaTime, float totalTime)
 
 							break;
 						case ACTION::CAMERA_MOVE_BACKWARD:
-							printf("Camera > Move > Backward [%s] \n", input.c_str());
+							LOG_DEBUG(LC_CAMERA, "Camera > Move > Backward");
 
 							{
 								// Get the current heading.
@@ -612,7 +646,7 @@ void Game::Update(float deltaTime, float totalTime)
 
 							break;
 						case ACTION::CAMERA_MOVE_LEFT:
-							printf("Camera > Move > Left [%s] \n", input.c_str());
+							LOG_DEBUG(LC_CAMERA, "Camera > Move > Left");
 
 							{
 								// Get the left vector.
@@ -642,7 +676,7 @@ void Game::Update(float deltaTime, float totalTime)
 
 							break;
 						case ACTION::CAMERA_MOVE_RIGHT:
-							printf("Camera > Move > Right [%s] \n", input.c_str());
+							LOG_DEBUG(LC_CAMERA, "Camera > Move > Right");
 
 							{
 								// Get the right vector.
@@ -801,93 +835,477 @@ void Game::Update(float deltaTime, float totalTime)
 }
 
 // --------------------------------------------------------
-// Clear the screen, redraw everything, present to the user
+// Describes the frame's passes.  There is one for now: the
+// scene, drawn straight into the back buffer.  Passes that
+// render into their own textures (shadows, post effects)
+// declare them here, and the graph orders the passes and
+// shares texture memory between them
+// --------------------------------------------------------
+void Game::CreateFrameGraph()
+{
+	frameGraph.Clear();
+	FrameGraph::Handle backBuffer = frameGraph.ImportTexture("back buffer", { width, height, DXGI_FORMAT_R8G8B8A8_UNORM });
+	FrameGraph::Handle depthBuffer = frameGraph.ImportTexture("depth buffer", { width, height, DXGI_FORMAT_D24_UNORM_S8_UINT });
+
+	FrameGraph::Handle scene = frameGraph.AddPass("scene", [this]() { DrawScene(); });
+	frameGraph.Write(scene, backBuffer);
+	frameGraph.Write(scene, depthBuffer);
+
+	std::string error;
+	if (!frameGraph.Compile(&error))
+		LOG_ERROR(LC_RENDER, "Could not compile the frame graph: %s", error.c_str());
+}
+
+// --------------------------------------------------------
+// Run the frame's passes, present to the user
 // --------------------------------------------------------
 void Game::Draw(float deltaTime, float totalTime)
 {
-	// ----------
-	// Background color (Cornflower Blue in this case) for clearing
-	const float color[4] = { 0.4f, 0.6f, 0.75f, 0.0f };
+	// Rebuild the camera's matrices and frustum once, for
+	// every change made to it since the last frame
+	camera.Update();
+
+	// Every pass (see CreateFrameGraph)
+	frameGraph.Execute();
 
+	// Draw the last frame of the run (or the first, without a
+	// frame limit) again on the CPU and save it, if asked to
+	unsigned int snapshotFrame = (options.frameLimit > 0) ? options.frameLimit - 1 : 0;
+	if (!options.snapshotPath.empty() && GetFrameCount() == snapshotFrame)
+		SaveSnapshot(options.snapshotPath);
+
+	// Present the back buffer to the user
+	//  - Puts the final frame we're drawing into the window so the user can see it
+	//  - Do this exactly ONCE PER FRAME (always at the very end of the frame)
+	backend->Present(0, 0);
+}
+
+// --------------------------------------------------------
+// Clear the screen and redraw everything
+// --------------------------------------------------------
+void Game::DrawScene()
+{
 	// ----------
 	// Clear the render target and depth buffer (erases what's on the screen)
 	//  - Do this ONCE PER FRAME
 	//  - At the beginning of Draw (before drawing *anything*)
-	context->ClearRenderTargetView(backBufferRTV, color);
-	context->ClearDepthStencilView(
-		depthStencilView,
-		D3D11_CLEAR_DEPTH | D3D11_CLEAR_STENCIL,
-		1.0f,
-		0);
+	backend->Clear(backBufferRTV, depthStencilView, CLEAR_COLOR);
 
 	// ----------
-	// For each object
-	// - send data to shader variables.
-	// - copy all buffer data.
-	for (int i = 0; i < gameEntityCount; i++)
+	// Per-frame data (camera, lights) is the same for every
+	// object, so send it once - and only if it changed
+	UploadFrameConstants();
+
+	// ----------
+	// Queue every visible object with a key that groups draws by
+	// material, then mesh, then front to back (see RenderQueue.h)
+	// - objects whose bounding sphere lies fully outside the
+	//   view frustum are dropped first (see FrustumCuller.h)
+	XMMATRIX view = XMMatrixTranspose(XMLoadFloat4x4(&camera.GetViewMatrix()));
+	const CameraOptions& settings = camera.GetSettings();
+
+	// - each entity's detail level is picked from its size on
+	//   screen first, since the queue sorts by the mesh drawn
+	SelectDetailLevels();
+
+	renderQueue.Clear();
+	if (options.frustumCulling)
 	{
-		pixelShader->SetData(
-			"light1",
-			&directionalLight1,
-			sizeof(DirectionalLight)
-		);
+		culler.Clear();
+		for (int i = 0; i < gameEntityCount; i++)
+			culler.Add(gameEntities[i]->GetBoundingSphere());
+		culler.Cull(camera.GetFrustumPlanes());
+
+		// - the largest entities on screen are then drawn into a
+		//   small CPU depth buffer, and the rest are dropped if
+		//   they're hidden behind them (see OcclusionCuller.h)
+		if (options.occlusionCulling)
+		{
+			XMMATRIX viewProjection = XMMatrixTranspose(XMLoadFloat4x4(&camera.GetViewProjectionMatrix()));
+			RasterizeOccluders(culler.GetVisible(), view, viewProjection);
+		}
 
-		pixelShader->SetData(
-			"light2",
-			&directionalLight2,
-			sizeof(DirectionalLight)
-		);
-		
-		// For each frame.
-		gameEntities[i]->PrepareMaterial(camera.GetViewMatrix(), camera.GetProjectionMatrix());
+		unsigned int queued = 0;
+		for (unsigned int i : culler.GetVisible())
+		{
+			if (options.occlusionCulling && IsOccluded(i))
+				continue;
+			QueueEntity(i, view, settings);
+			queued++;
+		}
 
+		LOG_TRACE(LC_RENDER, "Culling > %u in view, %u unoccluded, of %u entities",
+			(unsigned int)culler.GetVisibleCount(), queued, (unsigned int)gameEntityCount);
+		RenderCounters::Add(RenderCounters::RC_ENTITIES_CULLED, gameEntityCount - queued);
+	}
+	else
+	{
+		for (int i = 0; i < gameEntityCount; i++)
+			QueueEntity((unsigned int)i, view, settings);
+	}
+	RenderCounters::Add(RenderCounters::RC_ENTITIES_VISIBLE, renderQueue.GetCount());
+	renderQueue.Sort();
+
+	// ----------
+	// With instancing, sorted draws that share a mesh and
+	// material sit next to each other - pack every object's
+	// world matrix and color into the instance buffer (in
+	// queue order) and upload it all at once
+	bool instancing = options.instancing && instancedVertexShader->GetPerInstanceCompatible();
+	if (instancing)
+	{
+		instances.Clear();
+		for (const RenderQueue::Item& item : renderQueue)
+		{
+			GameEntity* entity = gameEntities[item.index].get();
+			instances.Add(entity->GetWorldMatrix(), entity->GetColor());
+		}
 
-		// - set matrices.
-		// vertexShader->SetMatrix4x4("world", entityWorldMatrix);
-		// vertexShader->SetMatrix4x4("view", camera.GetViewMatrix());
-		// vertexShader->SetMatrix4x4("projection", camera.GetProjectionMatrix());
+		if (!instances.Upload(device, backend))
+		{
+			LOG_ERROR(LC_RENDER, "Could not create a buffer for %u instances.", instances.GetCount());
+			instancing = false;
+		}
+	}
 
-		// Send buffer data to the vertex shader.
-		// vertexShader->CopyAllBufferData();
+	if (instancing)
+	{
+		// ----------
+		// Find each run of matching draws - each becomes one
+		// instanced call (instance i of the buffer is queue entry i)
+		batches.clear();
+		size_t count = renderQueue.GetCount();
+		size_t first = 0;
+		while (first < count)
+		{
+			RenderQueue::SortKey batch = RenderQueue::GetBatchKey(renderQueue[first].key);
+			size_t last = first + 1;
+			while (last < count && RenderQueue::GetBatchKey(renderQueue[last].key) == batch)
+				last++;
 
-		// Send buffer data to the vertex shader.
-		// vertexShader->CopyAllBufferData();
+			batches.push_back(std::make_pair(first, last - first));
+			first = last;
+		}
 
-		// Set the vertex and pixel shaders to use for the next Draw() command
-		//  - These don't technically need to be set every frame...YET
-		//  - Once you start applying different shaders to different objects,
-		//    you'll need to swap the current shaders before each draw
-		// vertexShader->SetShader();
-		// pixelShader->SetShader();
-		
-		// Get reference to the bufferMesh.
-		pSharedMesh bufferMesh = gameEntities[i]->GetMesh();
+		// ----------
+		// Record the runs in parallel, a contiguous slice per
+		// command buffer - recording only reads shared state
+		unsigned int chunks = workers.GetThreadCount() + 1;
+		if (chunks > batches.size())
+			chunks = (unsigned int)batches.size();
+		while (commandBuffers.size() < chunks)
+			commandBuffers.push_back(std::unique_ptr<CommandBuffer>(new CommandBuffer()));
 
-		// Collect the buffers from the meshes.
-		ID3D11Buffer* buffers[2] = {
-			bufferMesh->GetVertexBuffer(),
-			bufferMesh->GetIndexBuffer()
-		};
+		workers.Run(chunks, [this, chunks](unsigned int chunk)
+		{
+			CommandBuffer* commands = commandBuffers[chunk].get();
+			commands->Reset();
+
+			size_t begin = batches.size() * chunk / chunks;
+			size_t end = batches.size() * (chunk + 1) / chunks;
+			for (size_t b = begin; b < end; b++)
+				DrawInstanced(commands, batches[b].first, batches[b].second, (unsigned int)batches[b].first);
+		});
+
+		LateLatchCamera();
+		for (unsigned int chunk = 0; chunk < chunks; chunk++)
+			commandBuffers[chunk]->Execute(backend);
+	}
+	else
+	{
+		// ----------
+		// Without instancing, draw each object on its own
+		// - send data to shader variables.
+		// - copy changed buffer data.
+		// - bind shaders and buffers (the backend's state cache
+		//   drops binds that match what's already bound).
+		// - recorded on this thread: every entity writes its
+		//   constants through the same shader objects.
+		if (commandBuffers.empty())
+			commandBuffers.push_back(std::unique_ptr<CommandBuffer>(new CommandBuffer()));
+
+		CommandBuffer* commands = commandBuffers[0].get();
+		commands->Reset();
+		for (const RenderQueue::Item& item : renderQueue)
+			DrawEntity(commands, gameEntities[item.index].get());
+
+		LateLatchCamera();
+		commands->Execute(backend);
+	}
 
-		UINT stride = sizeof(Vertex); // Question for Professor: Where would stride and offset be tied to? Is it input alongside the Vertex data?
-		UINT offset = 0;
-		context->IASetVertexBuffers(0, 1, &buffers[0], &stride, &offset);
-		context->IASetIndexBuffer(buffers[1], DXGI_FORMAT_R32_UINT, 0);
+	// End of object loops.
+}
 
-		context->DrawIndexed(
-			bufferMesh->GetIndexCount(),     // The number of indices to use (we could draw a subset if we wanted)
-			0,     // Offset to the first index we want to use
-			0	   // Offset to add to each index when looking up vertices
-		);
+// --------------------------------------------------------
+// Sets the per-frame shader data (camera, lights) and sends
+// it to the shaders' per-frame constant buffers
+// --------------------------------------------------------
+void Game::UploadFrameConstants()
+{
+	// Whole buffers, laid out by CBufferGen (see ShaderConstants.h)
+	ShaderConstants::VertexShader::perFrame vertexFrame = {};
+	vertexFrame.view = camera.GetViewMatrix();
+	vertexFrame.projection = camera.GetProjectionMatrix();
+	vertexShader->SetBufferData(vertexFrame);
+
+	ShaderConstants::InstancedVertexShader::perFrame instancedFrame = {};
+	instancedFrame.view = vertexFrame.view;
+	instancedFrame.projection = vertexFrame.projection;
+	instancedVertexShader->SetBufferData(instancedFrame);
+
+	ShaderConstants::PixelShader::perFrame pixelFrame = {};
+	pixelFrame.light1 = { directionalLight1.AmbientColor, directionalLight1.DiffuseColor, directionalLight1.Direction };
+	pixelFrame.light2 = { directionalLight2.AmbientColor, directionalLight2.DiffuseColor, directionalLight2.Direction };
+	pixelShader->SetBufferData(pixelFrame);
+
+	backend->UploadConstants(vertexShader, "perFrame");
+	backend->UploadConstants(instancedVertexShader, "perFrame");
+	backend->UploadConstants(pixelShader, "perFrame");
+}
 
+// --------------------------------------------------------
+// Called with the frame's draws recorded, just before they
+// are sent.  With "--late-latch", handles the mouse input
+// that arrived while the frame was being prepared and, if
+// it turned the camera, rebuilds only the camera matrices
+// and sends the per-frame constants again
+// - culling and detail levels keep the camera they were
+//   given, so an object turning into view at the edge can
+//   show up a frame late
+// - off while recording or playing back input, so a
+//   recording replays exactly the frames it captured
+// - either way, this is the moment input latency is
+//   measured to (see DXCore::MarkInputSubmitted)
+// --------------------------------------------------------
+void Game::LateLatchCamera()
+{
+	bool latch = options.lateLatch && !recorder.IsRecording() && !recorder.IsPlaying();
+	if (latch && PumpInputMessages() && camera.Update())
+		UploadFrameConstants();
+
+	MarkInputSubmitted();
+}
+
+// --------------------------------------------------------
+// Picks a detail level of each entity's mesh from how large
+// its bounding sphere looks (see LodSelector.h).  Levels are
+// kept between frames, so an entity near a threshold holds
+// its level instead of switching meshes every frame
+// --------------------------------------------------------
+void Game::SelectDetailLevels()
+{
+	if (!options.detailLevels)
+		return;
+
+	lodSelector.Resize((size_t)gameEntityCount);
+	for (int i = 0; i < gameEntityCount; i++)
+		lodSelector.Set((size_t)i, gameEntities[i]->GetBoundingSphere(), gameEntities[i]->GetMesh()->GetDetailLevelCount());
+
+	// _22 of the projection is 1 / tan(fov / 2) (unchanged by the transpose)
+	unsigned int changes = lodSelector.Select(camera.GetTransform().GetCurrentPosition(), camera.GetProjectionMatrix()._22);
+
+	for (int i = 0; i < gameEntityCount; i++)
+		gameEntities[i]->SetDetailLevel(lodSelector.GetLevel((size_t)i));
+
+	LOG_TRACE(LC_RENDER, "Detail levels > %u changed", changes);
+}
+
+// --------------------------------------------------------
+// Draws the entities DrawScene() just queued with the
+// software rasterizer - same meshes, matrices, colors and
+// lights - and saves the image.  Works headless, so runs
+// on machines without a GPU can still be checked by eye
+// or compared against a reference image
+//
+// filename - TGA file to write
+// --------------------------------------------------------
+void Game::SaveSnapshot(const std::string& filename)
+{
+	if (!softwareRasterizer)
+		softwareRasterizer.reset(new SoftwareRasterizer());
+	if (softwareRasterizer->GetWidth() != width || softwareRasterizer->GetHeight() != height)
+		softwareRasterizer->Resize(width, height);
+
+	// The camera's matrices are stored transposed (for HLSL)
+	XMMATRIX viewProjection = XMMatrixTranspose(XMLoadFloat4x4(&camera.GetViewProjectionMatrix()));
+
+	PlatformTimer::Timestamp start = PlatformTimer::Now();
+	softwareRasterizer->BeginFrame(viewProjection, directionalLight1, directionalLight2, CLEAR_COLOR);
+	for (const RenderQueue::Item& item : renderQueue)
+	{
+		const GameEntity* entity = gameEntities[item.index].get();
+		const Mesh* mesh = entity->GetDrawMesh();
+		if (mesh->GetIndices().empty())
+			continue;
+
+		XMFLOAT4X4 worldMatrix = entity->GetWorldMatrix();
+		softwareRasterizer->DrawMesh(mesh->GetPositions().data(), mesh->GetNormals().data(),
+			mesh->GetIndices().data(), (unsigned int)mesh->GetIndices().size(),
+			XMMatrixTranspose(XMLoadFloat4x4(&worldMatrix)), entity->GetColor());
 	}
+	softwareRasterizer->Render();
 
-	// End of object loops.
+	const SoftwareRasterizer::Statistics& stats = softwareRasterizer->GetStatistics();
+	LOG_INFO(LC_RENDER, "Snapshot > %u triangles, %llu pixels in %.2fms",
+		stats.triangles, stats.pixels, PlatformTimer::MillisecondsSince(start));
 
-	// Present the back buffer to the user
-	//  - Puts the final frame we're drawing into the window so the user can see it
-	//  - Do this exactly ONCE PER FRAME (always at the very end of the frame)
-	swapChain->Present(0, 0);
+	if (!softwareRasterizer->SaveTGA(filename))
+		LOG_ERROR(LC_RENDER, "Could not save the snapshot to '%s'.", filename.c_str());
+}
+
+// --------------------------------------------------------
+// Picks the entities that cover the most screen (largest
+// bounding radius for their depth) as occluders and draws
+// them into the occlusion culler's depth buffer
+//
+// candidates     - Entities inside the view frustum
+// view           - View matrix (not transposed)
+// viewProjection - View-projection matrix (not transposed)
+// --------------------------------------------------------
+void Game::RasterizeOccluders(const std::vector<unsigned int>& candidates, const XMMATRIX& view, const XMMATRIX& viewProjection)
+{
+	float nearPlane = camera.GetSettings().GetNearClippingPlane();
+
+	// Score every candidate by its approximate screen size.
+	std::vector<std::pair<float, unsigned int>> scored;
+	scored.reserve(candidates.size());
+	for (unsigned int i : candidates)
+	{
+		XMFLOAT4 sphere = gameEntities[i]->GetBoundingSphere();
+		float depth = XMVectorGetZ(XMVector3TransformCoord(XMVectorSet(sphere.x, sphere.y, sphere.z, 1.0f), view));
+		float size = sphere.w / (depth > nearPlane ? depth : nearPlane);
+		if (size >= OCCLUDER_MIN_SIZE)
+			scored.push_back(std::make_pair(size, i));
+	}
+
+	size_t count = scored.size() < MAX_OCCLUDERS ? scored.size() : MAX_OCCLUDERS;
+	std::partial_sort(scored.begin(), scored.begin() + count, scored.end(),
+		[](const std::pair<float, unsigned int>& a, const std::pair<float, unsigned int>& b) { return a.first > b.first; });
+
+	// Draw them.
+	occlusion.Begin(viewProjection);
+	occluders.clear();
+	for (size_t k = 0; k < count; k++)
+	{
+		const GameEntity* entity = gameEntities[scored[k].second].get();
+		const std::vector<XMFLOAT3>& positions = entity->GetMesh()->GetPositions();
+		const std::vector<unsigned int>& indices = entity->GetMesh()->GetIndices();
+		if (positions.empty() || indices.empty())
+			continue;
+
+		XMFLOAT4X4 worldMatrix = entity->GetWorldMatrix();
+		occlusion.AddOccluder(positions.data(), indices.data(), (unsigned int)indices.size(),
+			XMMatrixTranspose(XMLoadFloat4x4(&worldMatrix)));
+		occluders.push_back(scored[k].second);
+	}
+	occlusion.Rasterize();
+}
+
+// --------------------------------------------------------
+// Tests an entity's bounding box against the occluders.
+// Occluders never hide themselves.
+//
+// index - Index of the entity in gameEntities
+// --------------------------------------------------------
+bool Game::IsOccluded(unsigned int index)
+{
+	if (std::find(occluders.begin(), occluders.end(), index) != occluders.end())
+		return false;
+
+	XMFLOAT4 sphere = gameEntities[index]->GetBoundingSphere();
+	XMFLOAT3 boxMin(sphere.x - sphere.w, sphere.y - sphere.w, sphere.z - sphere.w);
+	XMFLOAT3 boxMax(sphere.x + sphere.w, sphere.y + sphere.w, sphere.z + sphere.w);
+	return !occlusion.IsVisible(boxMin, boxMax);
+}
+
+// --------------------------------------------------------
+// Adds an entity to the render queue, keyed by its material,
+// mesh and view depth
+//
+// index    - Index of the entity in gameEntities
+// view     - View matrix (not transposed)
+// settings - Camera settings, for the clipping planes
+// --------------------------------------------------------
+void Game::QueueEntity(unsigned int index, const XMMATRIX& view, const CameraOptions& settings)
+{
+	const GameEntity* entity = gameEntities[index].get();
+	XMFLOAT3 position = entity->GetPosition();
+	float depth = XMVectorGetZ(XMVector3TransformCoord(XMLoadFloat3(&position), view));
+
+	renderQueue.Submit(RenderQueue::MakeKey(
+		RenderQueue::RP_OPAQUE,
+		entity->GetMaterial().GetID(),
+		entity->GetDrawMesh()->GetID(),
+		RenderQueue::QuantizeDepth(depth, settings.GetNearClippingPlane(), settings.GetFarClippingPlane())),
+		index);
+}
+
+// --------------------------------------------------------
+// Draws one entity with its own per-object constants
+//
+// target - Backend (or command buffer) to draw with
+// entity - Entity to draw
+// --------------------------------------------------------
+void Game::DrawEntity(IRenderBackend* target, GameEntity* entity)
+{
+	// Per-object data.
+	entity->PrepareMaterial(target);
+
+	// Get the detail level of the mesh picked for this frame.
+	const Mesh* bufferMesh = entity->GetDrawMesh();
+
+	UINT stride = sizeof(Vertex);
+	UINT offset = 0;
+	target->SetVertexBuffer(bufferMesh->GetVertexBuffer(), stride, offset);
+	target->SetIndexBuffer(bufferMesh->GetIndexBuffer(), DXGI_FORMAT_R32_UINT, 0);
+
+	target->DrawIndexed(
+		bufferMesh->GetIndexCount(),     // The number of indices to use (we could draw a subset if we wanted)
+		0,     // Offset to the first index we want to use
+		0	   // Offset to add to each index when looking up vertices
+	);
+
+	// Counted here rather than by the backend, so draws
+	// recorded on worker threads land in their own counts.
+	RenderCounters::Add(RenderCounters::RC_DRAWS);
+	RenderCounters::Add(RenderCounters::RC_TRIANGLES, bufferMesh->GetIndexCount() / 3);
+}
+
+// --------------------------------------------------------
+// Draws a run of queued entities that share a mesh and
+// material with a single instanced draw
+//
+// target        - Backend (or command buffer) to draw with
+// first         - Index of the run's first entry in the render queue
+// count         - Number of entries in the run
+// startInstance - Where the run's data starts in the instance buffer
+// --------------------------------------------------------
+void Game::DrawInstanced(IRenderBackend* target, size_t first, size_t count, unsigned int startInstance)
+{
+	GameEntity* entity = gameEntities[renderQueue[first].index].get();
+
+	// The instanced vertex shader stands in for the material's,
+	// the pixel shader is the material's own.
+	target->BindShader(instancedVertexShader);
+	target->BindShader(entity->GetMaterial().GetPixelShader());
+
+	const Mesh* bufferMesh = entity->GetDrawMesh();
+
+	UINT stride = sizeof(Vertex);
+	UINT offset = 0;
+	target->SetVertexBuffer(bufferMesh->GetVertexBuffer(), stride, offset);
+	target->SetIndexBuffer(bufferMesh->GetIndexBuffer(), DXGI_FORMAT_R32_UINT, 0);
+	target->SetInstanceBuffer(instances.GetBuffer(), instances.GetStride(), 0);
+
+	target->DrawIndexedInstanced(
+		bufferMesh->GetIndexCount(),	// Indices per instance
+		(unsigned int)count,			// Number of instances
+		0,								// First index
+		0,								// Offset added to each index
+		startInstance);					// First instance in the instance buffer
+
+	RenderCounters::Add(RenderCounters::RC_DRAWS);
+	RenderCounters::Add(RenderCounters::RC_TRIANGLES, (unsigned long long)(bufferMesh->GetIndexCount() / 3) * count);
 }
 
 
@@ -900,6 +1318,8 @@ void Game::Draw(float deltaTime, float totalTime)
 // --------------------------------------------------------
 void Game::OnMouseDown(WPARAM buttonState, int x, int y)
 {
+	if (!AcceptMouseEvent(InputRecorder::ME_DOWN, buttonState, x, y)) { return; }
+
 	// Add any custom code here...
 	camera.UpdateMouse((buttonState & 0x0001), (float)x, (float)y);
 
@@ -910,7 +1330,9 @@ void Game::OnMouseDown(WPARAM buttonState, int x, int y)
 	// Capture the mouse so we keep getting mouse move
 	// events even if the mouse leaves the window.  we'll be
 	// releasing the capture once a mouse button is released
-	SetCapture(hWnd);
+	//  - Not for replayed events; the real mouse isn't involved
+	if (!replayingInput)
+		SetCapture(hWnd);
 }
 
 // --------------------------------------------------------
@@ -918,12 +1340,15 @@ void Game::OnMouseDown(WPARAM buttonState, int x, int y)
 // --------------------------------------------------------
 void Game::OnMouseUp(WPARAM buttonState, int x, int y)
 {
+	if (!AcceptMouseEvent(InputRecorder::ME_UP, buttonState, x, y)) { return; }
+
 	// Add any custom code here...
 	camera.UpdateMouse((buttonState & 0x0001), (float)x, (float)y);
 
 	// We don't care about the tracking the cursor outside
 	// the window anymore (we're not dragging if the mouse is up)
-	ReleaseCapture();
+	if (!replayingInput)
+		ReleaseCapture();
 }
 
 // --------------------------------------------------------
@@ -933,6 +1358,8 @@ void Game::OnMouseUp(WPARAM buttonState, int x, int y)
 // --------------------------------------------------------
 void Game::OnMouseMove(WPARAM buttonState, int x, int y)
 {
+	if (!AcceptMouseEvent(InputRecorder::ME_MOVE, buttonState, x, y)) { return; }
+
 	// Add any custom code here...
 	camera.UpdateMouse((buttonState & 0x0001), (float)x, (float)y);
 
@@ -973,6 +1400,75 @@ void Game::OnMouseMove(WPARAM buttonState, int x, int y)
 // --------------------------------------------------------
 void Game::OnMouseWheel(float wheelDelta, int x, int y)
 {
+	if (!AcceptMouseEvent(InputRecorder::ME_WHEEL, 0, x, y, wheelDelta)) { return; }
+
 	// Add any custom code here...
 }
-#pragma endregion
\ No newline at end of file
+#pragma endregion
+
+#pragma region Input Recording
+
+// --------------------------------------------------------
+// Called first by each mouse handler.  Records the event
+// when recording; during playback, lets only the recorded
+// events through so the live mouse can't interfere.
+// --------------------------------------------------------
+bool Game::AcceptMouseEvent(InputRecorder::MouseEventType type, WPARAM buttonState, int x, int y, float wheelDelta)
+{
+	if (recorder.IsPlaying())
+		return replayingInput;
+
+	recorder.RecordMouseEvent(type, (unsigned int)buttonState, x, y, wheelDelta);
+	return true;
+}
+
+// --------------------------------------------------------
+// Sends a recorded frame's mouse events through the same
+// handlers the OS messages would have gone to
+// --------------------------------------------------------
+void Game::ReplayMouseEvents(const InputRecorder::Frame& frame)
+{
+	replayingInput = true;
+	for (unsigned int i = 0; i < frame.eventCount; i++)
+	{
+		const InputRecorder::MouseEvent& e = recorder.GetMouseEvent(frame, i);
+		switch (e.type)
+		{
+		case InputRecorder::ME_DOWN:  OnMouseDown((WPARAM)e.buttons, e.x, e.y); break;
+		case InputRecorder::ME_UP:    OnMouseUp((WPARAM)e.buttons, e.x, e.y); break;
+		case InputRecorder::ME_MOVE:  OnMouseMove((WPARAM)e.buttons, e.x, e.y); break;
+		case InputRecorder::ME_WHEEL: OnMouseWheel(e.wheel / 120.0f, e.x, e.y); break;
+		}
+	}
+	replayingInput = false;
+}
+#pragma endregion
+
+#pragma region Keyboard Input
+
+// --------------------------------------------------------
+// Key events are only recorded here; the input map turns
+// them into action states once per frame, in Update()
+// --------------------------------------------------------
+void Game::OnKeyDown(WPARAM key)
+{
+	input.OnKeyDown((InputMap::KeyCode)key);
+}
+
+// --------------------------------------------------------
+// Helper method for key releases
+// --------------------------------------------------------
+void Game::OnKeyUp(WPARAM key)
+{
+	input.OnKeyUp((InputMap::KeyCode)key);
+}
+
+// --------------------------------------------------------
+// Key up events go to whichever window has focus, so
+// release everything rather than leave keys stuck down
+// --------------------------------------------------------
+void Game::OnFocusLost()
+{
+	input.ReleaseAll();
+}
+#pragma endregion
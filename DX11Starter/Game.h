@@ -7,6 +7,17 @@
 #include "Vertex.h"
 #include "Camera.h"
 #include "Lights.h"
+#include "RenderQueue.h"
+#include "InstanceBuffer.h"
+#include "FrustumCuller.h"
+#include "OcclusionCuller.h"
+#include "LodSelector.h"
+#include "CommandBuffer.h"
+#include "FrameGraph.h"
+#include "SoftwareRasterizer.h"
+#include "WorkerPool.h"
+#include "InputMap.h"
+#include "InputRecorder.h"
 #include <DirectXMath.h>
 #include <vector>
 #include <map>
@@ -36,7 +47,13 @@ class Game
 
 		// Key determines if rotation modifier has been selected.
 		MODIFIER_RESET,
-		MODIFIER_ROTATE
+		MODIFIER_ROTATE,
+
+		// Exit the game.
+		GAME_QUIT,
+
+		// Number of actions.
+		ACTION_COUNT
 	} ACTION;
 
 	// data.
@@ -48,12 +65,9 @@ class Game
 	typedef std::vector<Vertex> VertexCollection;
 	typedef std::vector<GameEntity::MeshReference> MeshCollection;
 	typedef GameEntity::GameEntityCollection GameEntityCollection;
-	
-	typedef std::map<ACTION, std::string> KeyMappings;
-	typedef std::map<std::string, bool> KeyCodes;
 
 public:
-	Game(HINSTANCE hInstance);
+	Game(HINSTANCE hInstance, const CommandLineOptions& options = CommandLineOptions());
 	~Game();
 
 	// Overridden setup and game loop methods, which
@@ -68,6 +82,11 @@ public:
 	void OnMouseUp(WPARAM buttonState, int x, int y);
 	void OnMouseMove(WPARAM buttonState, int x, int y);
 	void OnMouseWheel(float wheelDelta, int x, int y);
+
+	// Overridden keyboard input helper methods
+	void OnKeyDown(WPARAM key);
+	void OnKeyUp(WPARAM key);
+	void OnFocusLost();
 private:
 
 	// Initialization helper methods - feel free to customize, combine, etc.
@@ -76,6 +95,24 @@ private:
 	void CreateMatrices();
 	void CreateBasicGeometry();
 	void CreateEntities();
+	void StartInputRecorder();
+	void CreateFrameGraph();
+
+	// Drawing helpers
+	void DrawScene();
+	void UploadFrameConstants();
+	void LateLatchCamera();
+	void SelectDetailLevels();
+	void RasterizeOccluders(const std::vector<unsigned int>& candidates, const DirectX::XMMATRIX& view, const DirectX::XMMATRIX& viewProjection);
+	bool IsOccluded(unsigned int index);
+	void QueueEntity(unsigned int index, const DirectX::XMMATRIX& view, const CameraOptions& settings);
+	void DrawEntity(IRenderBackend* target, GameEntity* entity);
+	void DrawInstanced(IRenderBackend* target, size_t first, size_t count, unsigned int startInstance);
+	void SaveSnapshot(const std::string& filename);
+
+	// Input recording and playback helpers
+	bool AcceptMouseEvent(InputRecorder::MouseEventType type, WPARAM buttonState, int x, int y, float wheelDelta = 0.0f);
+	void ReplayMouseEvents(const InputRecorder::Frame& frame);
 
 	// Light.
 	DirectionalLight directionalLight1;
@@ -89,17 +126,49 @@ private:
 	int gameEntityCount;
 	GameEntityCollection gameEntities;  // Alias to std::vector<std::unique_ptr<GameEntity>>.
 
+	// Entities inside the view this frame.
+	FrustumCuller culler;
+
+	// Each entity's mesh detail level, from its size on screen.
+	LodSelector lodSelector;
+
+	// Entities hidden behind this frame's largest on-screen entities.
+	OcclusionCuller occlusion;
+	std::vector<unsigned int> occluders;
+
+	// The frame's passes.
+	FrameGraph frameGraph;
+
+	// Draws the frame on the CPU for "--snapshot" (created on first use).
+	std::unique_ptr<SoftwareRasterizer> softwareRasterizer;
+
+	// This frame's draws, sorted by state and depth.
+	RenderQueue renderQueue;
+
+	// Per-instance data for this frame's instanced draws.
+	InstanceBuffer instances;
+
+	// Draws are recorded into command buffers (in parallel, one
+	// buffer per task) and then submitted in order on this thread.
+	WorkerPool workers;
+	std::vector<std::unique_ptr<CommandBuffer>> commandBuffers;
+	std::vector<std::pair<size_t, size_t>> batches;	// Render queue runs: first, count.
+
 	// Wrappers for DirectX shaders to provide simplified functionality
 	SimpleVertexShader* vertexShader;
+	SimpleVertexShader* instancedVertexShader;	// Same as vertexShader, but reads world/surface per instance.
 	SimplePixelShader* pixelShader;
 	Material* sharedMaterial;
 
 	// The camera.
 	Camera camera;
 	
-	// Key mappings.
-	KeyMappings keyMap;
-	KeyCodes keyCodes;
+	// Key mappings (ACTION -> key chords).
+	InputMap input;
+
+	// Records input to, or plays it back from, a file.
+	InputRecorder recorder;
+	bool replayingInput;
 
 	// The matrices to go from model space to screen space
 	// DirectX::XMFLOAT4X4 worldMatrix;
@@ -2,6 +2,8 @@
 // Include statements.
 // -----------------------------------------------
 #include "GameEntity.h"
+#include "RenderCounters.h"
+#include <cmath>
 #include <errno.h>
 #include <memory>
 #include <time.h>
@@ -11,6 +13,12 @@
 // -----------------------------------------------
 using namespace DirectX;
 
+// -----------------------------------------------
+// Static members.
+// -----------------------------------------------
+
+bool GameEntity::randomSeeded = false;
+
 // -----------------------------------------------
 // -----------------------------------------------
 // PUBLIC methods.
@@ -34,6 +42,7 @@ void swap(GameEntity& lhs, GameEntity& rhs)
 	swap(lhs.transformBuffer, rhs.transformBuffer);
 	swap(lhs.local, rhs.local);
 	swap(lhs.sharedMesh, rhs.sharedMesh);
+	swap(lhs.detailLevel, rhs.detailLevel);
 	swap(lhs.surfaceColor, rhs.surfaceColor);
 }
 
@@ -50,7 +59,7 @@ void swap(GameEntity& lhs, GameEntity& rhs)
 /// <param name="_material">Material reference.</param>
 /// <param name="sharedMesh">Shared mesh reference.</param>
 GameEntity::GameEntity(Material& _material, MeshReference& mesh)
-	: material{ &_material }, sharedMesh(mesh), transformBuffer(TransformBuffer()), local(TRANSFORM()), surfaceColor(XMFLOAT4(0.0f, 0.0f, 0.0f, 1.0f))
+	: material{ &_material }, sharedMesh(mesh), detailLevel(0), transformBuffer(TransformBuffer()), local(TRANSFORM()), surfaceColor(XMFLOAT4(0.0f, 0.0f, 0.0f, 1.0f))
 {
 	// Initialize members.
 	this->CreateTransformations();  // Initialize the local.
@@ -156,6 +165,7 @@ GameEntity::GameEntity(const GameEntity& other)
 	this->material = other.material;
 	this->local = other.local;
 	this->sharedMesh = other.sharedMesh;
+	this->detailLevel = other.detailLevel;
 	this->transformBuffer = other.transformBuffer;
 	this->surfaceColor = other.surfaceColor;
 }
@@ -234,10 +244,8 @@ const float GameEntity::GetRandomFloat()
 const float GameEntity::GetRandomFloat(float min, float max)
 {
 	// https://stackoverflow.com/questions/33058848/generate-a-random-double-between-1-and-1/50539103#50539103
-	static int seedCheck = -1;
-	if (seedCheck < 0) {
-		seedCheck = 1;
-		srand((unsigned int)(time(NULL)) + GetCurrentProcessId());
+	if (!randomSeeded) {
+		SetRandomSeed((unsigned int)(time(NULL)) + GetCurrentProcessId());
 	}
 
 	if (min >= max)
@@ -250,6 +258,17 @@ const float GameEntity::GetRandomFloat(float min, float max)
 	return static_cast<float>(min + ((float)rand() / divisor));
 }
 
+/// <summary>
+/// Seed the random number generator. Without this, the
+/// first random value seeds it from the clock.
+/// </summary>
+/// <param name="seed">Seed value.</param>
+void GameEntity::SetRandomSeed(unsigned int seed)
+{
+	srand(seed);
+	randomSeeded = true;
+}
+
 /// <summary>
 /// Return a random transform with elements between [0 and 1).
 /// </summary>
@@ -414,6 +433,46 @@ const GameEntity::MeshReference& GameEntity::GetMesh() const
 	return this->sharedMesh;
 }
 
+/// <summary>
+/// Return the detail level of the shared mesh to draw.
+/// </summary>
+/// <returns>Returns the mesh itself, or a coarser version of it.</returns>
+const Mesh* GameEntity::GetDrawMesh() const
+{
+	return this->sharedMesh->GetDetailLevel(this->detailLevel);
+}
+
+/// <summary>
+/// Return the index of the detail level to draw.
+/// </summary>
+/// <returns>Returns 0 for the full detail mesh.</returns>
+unsigned int GameEntity::GetDetailLevel() const
+{
+	return this->detailLevel;
+}
+
+/// <summary>
+/// Return the mesh's bounding sphere moved into world space.
+/// The radius grows with the largest scale axis, so the
+/// sphere stays conservative under non-uniform scaling.
+/// </summary>
+/// <returns>Returns center (xyz) and radius (w).</returns>
+const XMFLOAT4 GameEntity::GetBoundingSphere() const
+{
+	XMFLOAT4 local = this->sharedMesh->GetBoundingSphere();
+	XMFLOAT4X4 worldMatrix = this->GetWorldMatrix();
+	XMFLOAT3 scale = this->GetScale();
+
+	// The stored world matrix is transposed for HLSL.
+	XMMATRIX world = XMMatrixTranspose(XMLoadFloat4x4(&worldMatrix));
+	XMVECTOR center = XMVector3TransformCoord(XMVectorSet(local.x, local.y, local.z, 1.0f), world);
+	float maxScale = fmaxf(fmaxf(fabsf(scale.x), fabsf(scale.y)), fabsf(scale.z));
+
+	XMFLOAT4 sphere;
+	XMStoreFloat4(&sphere, XMVectorSetW(center, local.w * maxScale));
+	return sphere;
+}
+
 // ----------
 // MATERIAL
 
@@ -422,6 +481,15 @@ const Material& GameEntity::GetMaterial() const
 	return *material;
 }
 
+/// <summary>
+/// Return the surface color.
+/// </summary>
+/// <returns>Returns copy of the surface color.</returns>
+const XMFLOAT4 GameEntity::GetColor() const
+{
+	return this->surfaceColor;
+}
+
 
 // -----------------------------------------------
 // Mutators.
@@ -458,30 +526,43 @@ void GameEntity::SetColor(XMFLOAT4 _surface)
 }
 
 /// <summary>
-/// Sets shaders and sends matrix data.
+/// Sets the detail level of the shared mesh to draw.
 /// </summary>
-/// <param name="_view">The view matrix.</param>
-/// <param name="_projection">The projection matrix.</param>
-void GameEntity::PrepareMaterial(XMFLOAT4X4& _view, XMFLOAT4X4& _projection)
+/// <param name="level">0 for full detail; clamped to the mesh's coarsest level when drawn.</param>
+void GameEntity::SetDetailLevel(unsigned int level)
 {
-	SimplePixelShader* ps = this->GetMaterial().GetPixelShader();
-	SimpleVertexShader* vs = this->GetMaterial().GetVertexShader();
-
-	// Add the surface color.
-	ps->SetFloat4("surface", surfaceColor);
-
-	// Set the matrices.
-	vs->SetMatrix4x4("world", this->GetWorldMatrix());
-	vs->SetMatrix4x4("view", _view);
-	vs->SetMatrix4x4("projection", _projection);
-	
-	// Copy all buffer data to the vertex shader.
-	vs->CopyAllBufferData();
-	ps->CopyAllBufferData();
+	this->detailLevel = level;
+}
 
-	// Set the material shaders.
-	vs->SetShader();
-	ps->SetShader();
+/// <summary>
+/// Sets shaders and sends this entity's constants. Per-frame
+/// constants (camera, lights) are sent once by the caller.
+/// </summary>
+/// <param name="backend">Backend that copies the constants.</param>
+void GameEntity::PrepareMaterial(IRenderBackend* backend)
+{
+	const Material& material = this->GetMaterial();
+	SimplePixelShader* ps = material.GetPixelShader();
+	SimpleVertexShader* vs = material.GetVertexShader();
+
+	// Set the world matrix and surface color. The color
+	// is passed through the vertex shader, so the same
+	// pixel shader also serves instanced draws. Handles
+	// the material resolved up front keep names (and
+	// their hashing) out of every draw.
+	vs->SetMatrix4x4(material.GetWorldHandle(), this->GetWorldMatrix());
+	vs->SetFloat4(material.GetSurfaceHandle(), surfaceColor);
+
+	// Set the material shaders (the backend's state
+	// cache drops this if they're already bound).
+	backend->BindShader(vs);
+	backend->BindShader(ps);
+
+	// Write the per-object buffer after binding, since
+	// backends with a constant ring bind a slice of it
+	// in place of the shader's own buffer.
+	if (material.GetPerObjectBufferIndex() >= 0)
+		backend->WriteConstants(vs, (unsigned int)material.GetPerObjectBufferIndex());
 }
 
 // -----------------------------------------------
@@ -830,6 +911,7 @@ void GameEntity::HandleTransformations()
 {
 	// If the buffer is not empty.
 	if (!transformBuffer.is_empty()) {
+		unsigned long long commands = 0;
 		while (!transformBuffer.is_empty()) {
 
 			// Get scope.
@@ -859,7 +941,12 @@ void GameEntity::HandleTransformations()
 
 			// Pop the next transformation off of the buffer.
 			transformBuffer.pop();
+			commands++;
 		}
+
+		// Count the entity as updated, and its commands.
+		RenderCounters::Add(RenderCounters::RC_ENTITIES_UPDATED);
+		RenderCounters::Add(RenderCounters::RC_TRANSFORM_COMMANDS, commands);
 	}
 }
 
@@ -11,6 +11,7 @@
 #include "Transform.h"
 #include "TransformBuffer.h"
 #include "Material.h"
+#include "RenderBackend.h"
 
 class GameEntity
 {
@@ -91,6 +92,7 @@ public:
 	static const DirectX::XMFLOAT3 GetRandomTransform(); // 0 to RAND_MAX.
 	static const DirectX::XMFLOAT3 GetRandomTransform(float min, float max); // [Inclusive min, Exclusive max)
 	static const DirectX::XMFLOAT3 GetRandomTransform(DirectX::XMFLOAT3 min, DirectX::XMFLOAT3 max); // [Inclusive min, Exclusive max)
+	static void SetRandomSeed(unsigned int seed); // Fixed seed, for repeatable runs.
 
 	// -----------------------------------------------
 	// Accessors.
@@ -124,10 +126,14 @@ public:
 	// ----------
 	// MESH
 	const MeshReference& GetMesh() const;
+	const Mesh* GetDrawMesh() const; // The mesh's current detail level.
+	unsigned int GetDetailLevel() const;
+	const DirectX::XMFLOAT4 GetBoundingSphere() const; // World space center (xyz) and radius (w).
 
 	// ----------
 	// Material
 	const Material& GetMaterial() const;
+	const DirectX::XMFLOAT4 GetColor() const;
 
 	// -----------------------------------------------
 	// Mutators.
@@ -143,7 +149,12 @@ public:
 
 	void SetColor(DirectX::XMFLOAT4 _surface);
 	void SetMaterial(Material& _material);
-	void PrepareMaterial(DirectX::XMFLOAT4X4& _view, DirectX::XMFLOAT4X4& _projection);
+	void PrepareMaterial(IRenderBackend* backend);
+
+	// ----------
+	// MESH
+
+	void SetDetailLevel(unsigned int level);	// Picked each frame from the entity's size on screen.
 
 	// -----------------------------------------------
 	// Service methods.
@@ -190,6 +201,9 @@ private:
 	// Stores the shared mesh.
 	MeshReference sharedMesh;
 
+	// Which of the mesh's detail levels to draw.
+	unsigned int detailLevel;
+
 	// Enqueued transformation changes. Keeps requests in the order they're received.
 	TransformBuffer transformBuffer;
 
@@ -202,6 +216,9 @@ private:
 	// Create a surface color.
 	DirectX::XMFLOAT4 surfaceColor;
 
+	// Has the random number generator been seeded?
+	static bool randomSeeded;
+
 	// -----------------------------------------------
 	// Mutators.
 	// -----------------------------------------------
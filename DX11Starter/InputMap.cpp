@@ -0,0 +1,237 @@
+// -----------------------------------------------
+// Include statements.
+// -----------------------------------------------
+#include "InputMap.h"
+
+// -----------------------------------------------
+// Constructors.
+// -----------------------------------------------
+
+/// <summary>
+/// Initializes an input map with no bindings.
+/// </summary>
+InputMap::InputMap()
+	: bindingCount{ 0 }, keysChanged{ false }
+{
+	this->ClearBindings();
+}
+
+// -----------------------------------------------
+// Accessors.
+// -----------------------------------------------
+
+/// <summary>
+/// Is the action held this frame?
+/// </summary>
+/// <param name="action">Action to test.</param>
+bool InputMap::IsDown(ActionId action) const
+{
+	return action < MAX_ACTIONS && actions[action];
+}
+
+/// <summary>
+/// Did the action go down this frame?
+/// </summary>
+/// <param name="action">Action to test.</param>
+bool InputMap::WasPressed(ActionId action) const
+{
+	return action < MAX_ACTIONS && actions[action] && !previousActions[action];
+}
+
+/// <summary>
+/// Did the action come up this frame?
+/// </summary>
+/// <param name="action">Action to test.</param>
+bool InputMap::WasReleased(ActionId action) const
+{
+	return action < MAX_ACTIONS && !actions[action] && previousActions[action];
+}
+
+/// <summary>
+/// Is any action held this frame?
+/// </summary>
+bool InputMap::AnyDown() const
+{
+	return actions.any();
+}
+
+/// <summary>
+/// Is the key held right now? (Raw state, not resolved per frame.)
+/// </summary>
+/// <param name="key">Key to test.</param>
+bool InputMap::IsKeyDown(KeyCode key) const
+{
+	return keys[key];
+}
+
+/// <summary>
+/// All action states for this frame.
+/// </summary>
+const InputMap::ActionSet& InputMap::GetActions() const
+{
+	return actions;
+}
+
+/// <summary>
+/// Number of bindings in use.
+/// </summary>
+unsigned int InputMap::GetBindingCount() const
+{
+	return bindingCount;
+}
+
+// -----------------------------------------------
+// Mutators.
+// -----------------------------------------------
+
+/// <summary>
+/// Bind an action to a chord of keys. An action may
+/// have several bindings; any one of them holds it down.
+/// </summary>
+/// <param name="action">Action to bind.</param>
+/// <param name="chord">Keys that must all be held.</param>
+/// <returns>Returns false if the action is out of range, the chord is empty or the map is full.</returns>
+bool InputMap::Bind(ActionId action, std::initializer_list<KeyCode> chord)
+{
+	KeySet set;
+	for (KeyCode key : chord)
+		set.set(key);
+	return AddBinding(action, set);
+}
+
+/// <summary>
+/// Bind an action to a chord spelled as a string of
+/// key codes - "RW" is the R and W keys held together.
+/// </summary>
+/// <param name="action">Action to bind.</param>
+/// <param name="chord">One character per key.</param>
+/// <returns>Returns false if the action is out of range, the chord is empty or the map is full.</returns>
+bool InputMap::Bind(ActionId action, const char* chord)
+{
+	KeySet set;
+	for (const char* c = chord; c && *c; c++)
+		set.set(static_cast<KeyCode>(*c));
+	return AddBinding(action, set);
+}
+
+/// <summary>
+/// Remove all bindings and clear all state.
+/// </summary>
+void InputMap::ClearBindings()
+{
+	bindingCount = 0;
+	keys.reset();
+	pressedKeys.reset();
+	actions.reset();
+	previousActions.reset();
+	keysChanged = false;
+}
+
+// -----------------------------------------------
+// Service methods.
+// -----------------------------------------------
+
+/// <summary>
+/// Record a key going down.
+/// </summary>
+/// <param name="key">Key code.</param>
+void InputMap::OnKeyDown(KeyCode key)
+{
+	// Ignore auto-repeat.
+	if (keys[key])
+		return;
+
+	keys.set(key);
+	pressedKeys.set(key);
+	keysChanged = true;
+}
+
+/// <summary>
+/// Record a key coming up.
+/// </summary>
+/// <param name="key">Key code.</param>
+void InputMap::OnKeyUp(KeyCode key)
+{
+	if (!keys[key])
+		return;
+
+	keys.reset(key);
+	keysChanged = true;
+}
+
+/// <summary>
+/// Lift every key, e.g. when the window loses focus
+/// and would otherwise never hear the key up events.
+/// </summary>
+void InputMap::ReleaseAll()
+{
+	if (keys.none() && pressedKeys.none())
+		return;
+
+	keys.reset();
+	pressedKeys.reset();
+	keysChanged = true;
+}
+
+/// <summary>
+/// Resolve key events since the last call into action
+/// states. Call once per frame, before any queries.
+/// </summary>
+void InputMap::Update()
+{
+	previousActions = actions;
+
+	// Nothing changed: every action keeps its state.
+	if (!keysChanged)
+		return;
+
+	// Keys tapped and released within the frame still count.
+	KeySet held = keys | pressedKeys;
+
+	actions.reset();
+	for (unsigned int i = 0; i < bindingCount; i++)
+	{
+		const Binding& binding = bindings[i];
+		if ((binding.chord & held) == binding.chord)
+			actions.set(binding.action);
+	}
+
+	// A tap has to be resolved again next frame (as up).
+	keysChanged = pressedKeys != (pressedKeys & keys);
+	pressedKeys.reset();
+}
+
+/// <summary>
+/// Take this frame's action states from a recording
+/// instead of from key events. Replaces Update().
+/// </summary>
+/// <param name="recorded">Recorded action states.</param>
+void InputMap::Apply(const ActionSet& recorded)
+{
+	previousActions = actions;
+	actions = recorded;
+}
+
+// -----------------------------------------------
+// Helper methods.
+// -----------------------------------------------
+
+/// <summary>
+/// Store a binding.
+/// </summary>
+/// <param name="action">Action to bind.</param>
+/// <param name="chord">Keys that must all be held.</param>
+/// <returns>Returns true if it was stored.</returns>
+bool InputMap::AddBinding(ActionId action, const KeySet& chord)
+{
+	if (action >= MAX_ACTIONS || chord.none() || bindingCount >= MAX_BINDINGS)
+		return false;
+
+	bindings[bindingCount].chord = chord;
+	bindings[bindingCount].action = action;
+	bindingCount++;
+
+	// Re-resolve against the keys already held.
+	keysChanged = true;
+	return true;
+}
@@ -0,0 +1,123 @@
+#pragma once
+
+// -----------------------------------------------
+// Include statements.
+// -----------------------------------------------
+#include <array>
+#include <bitset>
+#include <initializer_list>
+
+// -----------------------------------------------
+// InputMap.h
+// ---
+// Binds actions to key chords. Key events are
+// collected as they arrive and resolved into
+// action states once per frame, so queries are
+// a single bit test and nothing is allocated.
+// -----------------------------------------------
+
+class InputMap
+{
+public:
+	// -----------------------------------------------
+	// Internal typedef statements.
+	// -----------------------------------------------
+
+	// Maximum number of actions, bindings and key codes.
+	static const unsigned int MAX_ACTIONS = 128;
+	static const unsigned int MAX_BINDINGS = 512;
+	static const unsigned int KEY_COUNT = 256;
+
+	/// <summary>
+	/// Virtual key code (VK_* or an upper case letter/digit).
+	/// </summary>
+	typedef unsigned char KeyCode;
+
+	/// <summary>
+	/// Index of an action, in [0, MAX_ACTIONS).
+	/// </summary>
+	typedef unsigned int ActionId;
+
+	/// <summary>
+	/// One bit per key.
+	/// </summary>
+	typedef std::bitset<KEY_COUNT> KeySet;
+
+	/// <summary>
+	/// One bit per action.
+	/// </summary>
+	typedef std::bitset<MAX_ACTIONS> ActionSet;
+
+	// -----------------------------------------------
+	// Constructors.
+	// -----------------------------------------------
+
+	InputMap();
+
+	// -----------------------------------------------
+	// Accessors.
+	// -----------------------------------------------
+
+	bool IsDown(ActionId action) const;
+	bool WasPressed(ActionId action) const;		// Down this frame, up the last.
+	bool WasReleased(ActionId action) const;	// Up this frame, down the last.
+	bool AnyDown() const;
+	bool IsKeyDown(KeyCode key) const;
+	const ActionSet& GetActions() const;
+	unsigned int GetBindingCount() const;
+
+	// -----------------------------------------------
+	// Mutators.
+	// -----------------------------------------------
+
+	bool Bind(ActionId action, std::initializer_list<KeyCode> chord);
+	bool Bind(ActionId action, const char* chord);	// Each character is a key, e.g. "RW".
+	void ClearBindings();
+
+	// -----------------------------------------------
+	// Service methods.
+	// -----------------------------------------------
+
+	void OnKeyDown(KeyCode key);
+	void OnKeyUp(KeyCode key);
+	void ReleaseAll();	// Lift every key (e.g. when focus is lost).
+	void Update();		// Resolve this frame's key events into action states.
+	void Apply(const ActionSet& recorded);	// Use recorded action states instead (playback).
+
+private:
+
+	// -----------------------------------------------
+	// Internal structs.
+	// -----------------------------------------------
+
+	/// <summary>
+	/// An action is down while every key in its chord is.
+	/// </summary>
+	struct Binding
+	{
+		KeySet chord;
+		ActionId action;
+	};
+
+	// -----------------------------------------------
+	// Data members.
+	// -----------------------------------------------
+
+	std::array<Binding, MAX_BINDINGS> bindings;
+	unsigned int bindingCount;
+
+	// Keys held now, and keys pressed since the last Update()
+	// (so a tap shorter than a frame still counts once).
+	KeySet keys;
+	KeySet pressedKeys;
+	bool keysChanged;
+
+	ActionSet actions;
+	ActionSet previousActions;
+
+	// -----------------------------------------------
+	// Helper methods.
+	// -----------------------------------------------
+
+	bool AddBinding(ActionId action, const KeySet& chord);
+};
@@ -0,0 +1,308 @@
+// -----------------------------------------------
+// Include statements.
+// -----------------------------------------------
+#include "InputRecorder.h"
+#include <algorithm>
+#include <cmath>
+
+// -----------------------------------------------
+// File layout (native byte order):
+//
+//   header: u32 magic, u16 version, u16 action words, u32 seed
+//   frame:  f32 deltaTime, f32 totalTime,
+//           u64 actions[action words],
+//           u16 event count, MouseEvent events[event count]
+// -----------------------------------------------
+
+namespace
+{
+	template <typename T>
+	void WriteValue(std::ofstream& stream, const T& value)
+	{
+		stream.write(reinterpret_cast<const char*>(&value), sizeof(T));
+	}
+
+	template <typename T>
+	bool ReadValue(std::ifstream& stream, T& value)
+	{
+		return static_cast<bool>(stream.read(reinterpret_cast<char*>(&value), sizeof(T)));
+	}
+}
+
+// -----------------------------------------------
+// Constructors.
+// -----------------------------------------------
+
+/// <summary>
+/// Initializes an idle recorder.
+/// </summary>
+InputRecorder::InputRecorder()
+	: mode{ RM_OFF }, seed{ 0 }, recordedFrames{ 0 }, frameIndex{ 0 } {}
+
+/// <summary>
+/// Finishes any recording in progress.
+/// </summary>
+InputRecorder::~InputRecorder()
+{
+	this->Stop();
+}
+
+// -----------------------------------------------
+// Accessors.
+// -----------------------------------------------
+
+/// <summary>
+/// What the recorder is doing.
+/// </summary>
+InputRecorder::RecorderMode InputRecorder::GetMode() const
+{
+	return mode;
+}
+
+/// <summary>
+/// Is input being recorded?
+/// </summary>
+bool InputRecorder::IsRecording() const
+{
+	return mode == RM_RECORDING;
+}
+
+/// <summary>
+/// Is input being played back?
+/// </summary>
+bool InputRecorder::IsPlaying() const
+{
+	return mode == RM_PLAYBACK;
+}
+
+/// <summary>
+/// Random seed stored with the recording.
+/// </summary>
+unsigned int InputRecorder::GetSeed() const
+{
+	return seed;
+}
+
+/// <summary>
+/// Frames recorded so far, or frames in the loaded recording.
+/// </summary>
+unsigned int InputRecorder::GetFrameCount() const
+{
+	return IsPlaying() ? static_cast<unsigned int>(frames.size()) : recordedFrames;
+}
+
+/// <summary>
+/// Index of the next frame to play back.
+/// </summary>
+unsigned int InputRecorder::GetFrameIndex() const
+{
+	return frameIndex;
+}
+
+/// <summary>
+/// Mouse event belonging to a played back frame.
+/// </summary>
+/// <param name="frame">Frame returned by NextFrame().</param>
+/// <param name="index">Event index within the frame.</param>
+const InputRecorder::MouseEvent& InputRecorder::GetMouseEvent(const Frame& frame, unsigned int index) const
+{
+	return events[frame.firstEvent + index];
+}
+
+// -----------------------------------------------
+// Service methods.
+// -----------------------------------------------
+
+/// <summary>
+/// Begin recording to a file.
+/// </summary>
+/// <param name="filename">Output path.</param>
+/// <param name="seed">Random seed the session was started with.</param>
+/// <returns>Returns false if the file couldn't be opened.</returns>
+bool InputRecorder::StartRecording(const std::string& filename, unsigned int seed)
+{
+	this->Stop();
+
+	output.open(filename, std::ios::binary | std::ios::trunc);
+	if (!output.is_open())
+		return false;
+
+	WriteValue(output, static_cast<unsigned int>(FILE_MAGIC));
+	WriteValue(output, static_cast<unsigned short>(FILE_VERSION));
+	WriteValue(output, static_cast<unsigned short>(ACTION_WORDS));
+	WriteValue(output, seed);
+
+	this->seed = seed;
+	this->mode = RM_RECORDING;
+	this->recordedFrames = 0;
+	pendingEvents.clear();
+	pendingEvents.reserve(64);
+	return true;
+}
+
+/// <summary>
+/// Load a recording and begin playing it back.
+/// </summary>
+/// <param name="filename">Recording path.</param>
+/// <returns>Returns false if the file is missing or isn't a recording.</returns>
+bool InputRecorder::StartPlayback(const std::string& filename)
+{
+	this->Stop();
+
+	std::ifstream input(filename, std::ios::binary);
+	if (!input.is_open())
+		return false;
+
+	unsigned int magic = 0;
+	unsigned short version = 0;
+	unsigned short actionWords = 0;
+	if (!ReadValue(input, magic) || !ReadValue(input, version) ||
+		!ReadValue(input, actionWords) || !ReadValue(input, seed))
+		return false;
+	if (magic != FILE_MAGIC || version != FILE_VERSION || actionWords != ACTION_WORDS)
+		return false;
+
+	frames.clear();
+	events.clear();
+
+	// Read frames until the end of the file. A frame cut
+	// short (crash mid-write) ends the recording there.
+	for (;;)
+	{
+		Frame frame = {};
+		unsigned long long words[ACTION_WORDS] = {};
+		unsigned short eventCount = 0;
+
+		if (!ReadValue(input, frame.deltaTime) || !ReadValue(input, frame.totalTime))
+			break;
+		if (!input.read(reinterpret_cast<char*>(words), sizeof(words)) || !ReadValue(input, eventCount))
+			break;
+
+		frame.firstEvent = static_cast<unsigned int>(events.size());
+		frame.eventCount = eventCount;
+		events.resize(events.size() + eventCount);
+		if (eventCount > 0 && !input.read(reinterpret_cast<char*>(&events[frame.firstEvent]), eventCount * sizeof(MouseEvent)))
+		{
+			events.resize(frame.firstEvent);
+			break;
+		}
+
+		UnpackActions(words, frame.actions);
+		frames.push_back(frame);
+	}
+
+	mode = RM_PLAYBACK;
+	frameIndex = 0;
+	return true;
+}
+
+/// <summary>
+/// Stop recording (flushing the file) or playing back.
+/// </summary>
+void InputRecorder::Stop()
+{
+	if (output.is_open())
+		output.close();
+
+	mode = RM_OFF;
+	pendingEvents.clear();
+}
+
+/// <summary>
+/// Queue a mouse message for the frame being recorded.
+/// </summary>
+/// <param name="type">Which handler received it.</param>
+/// <param name="buttons">MK_* button state.</param>
+/// <param name="x">Cursor x.</param>
+/// <param name="y">Cursor y.</param>
+/// <param name="wheel">Wheel delta in notches (wheel events only).</param>
+void InputRecorder::RecordMouseEvent(MouseEventType type, unsigned int buttons, int x, int y, float wheel)
+{
+	if (!IsRecording())
+		return;
+
+	MouseEvent e;
+	e.type = static_cast<unsigned char>(type);
+	e.buttons = static_cast<unsigned char>(buttons & 0xFF);
+	e.x = static_cast<short>(x);
+	e.y = static_cast<short>(y);
+	e.wheel = static_cast<short>(std::lround(wheel * 120.0f));
+	pendingEvents.push_back(e);
+}
+
+/// <summary>
+/// Write one frame: its timing, action states and the
+/// mouse events received since the previous frame.
+/// </summary>
+/// <param name="deltaTime">Frame delta time.</param>
+/// <param name="totalTime">Frame total time.</param>
+/// <param name="actions">Resolved action states.</param>
+void InputRecorder::RecordFrame(float deltaTime, float totalTime, const InputMap::ActionSet& actions)
+{
+	if (!IsRecording())
+		return;
+
+	unsigned long long words[ACTION_WORDS];
+	PackActions(actions, words);
+
+	// Anything past 65535 events in one frame is dropped.
+	unsigned short eventCount = static_cast<unsigned short>(std::min<size_t>(pendingEvents.size(), 0xFFFF));
+
+	WriteValue(output, deltaTime);
+	WriteValue(output, totalTime);
+	output.write(reinterpret_cast<const char*>(words), sizeof(words));
+	WriteValue(output, eventCount);
+	if (eventCount > 0)
+		output.write(reinterpret_cast<const char*>(pendingEvents.data()), eventCount * sizeof(MouseEvent));
+
+	pendingEvents.clear();
+	recordedFrames++;
+}
+
+/// <summary>
+/// Advance playback one frame.
+/// </summary>
+/// <returns>Returns the frame, or null once the recording ends.</returns>
+const InputRecorder::Frame* InputRecorder::NextFrame()
+{
+	if (!IsPlaying() || frameIndex >= frames.size())
+		return nullptr;
+
+	return &frames[frameIndex++];
+}
+
+// -----------------------------------------------
+// Helper methods.
+// -----------------------------------------------
+
+/// <summary>
+/// Split an action set into 64-bit words, lowest actions first.
+/// </summary>
+void InputRecorder::PackActions(const InputMap::ActionSet& actions, unsigned long long words[ACTION_WORDS])
+{
+	for (unsigned int w = 0; w < ACTION_WORDS; w++)
+	{
+		words[w] = 0;
+		for (unsigned int b = 0; b < 64; b++)
+		{
+			if (actions[w * 64 + b])
+				words[w] |= (1ULL << b);
+		}
+	}
+}
+
+/// <summary>
+/// Rebuild an action set from 64-bit words.
+/// </summary>
+void InputRecorder::UnpackActions(const unsigned long long words[ACTION_WORDS], InputMap::ActionSet& actions)
+{
+	actions.reset();
+	for (unsigned int w = 0; w < ACTION_WORDS; w++)
+	{
+		for (unsigned int b = 0; b < 64; b++)
+		{
+			if (words[w] & (1ULL << b))
+				actions.set(w * 64 + b);
+		}
+	}
+}
@@ -0,0 +1,146 @@
+#pragma once
+
+// -----------------------------------------------
+// Include statements.
+// -----------------------------------------------
+#include "InputMap.h"
+#include <fstream>
+#include <string>
+#include <vector>
+
+// -----------------------------------------------
+// InputRecorder.h
+// ---
+// Records the input each frame consumes (action
+// states, mouse events and frame timing) to a
+// compact binary file, and plays it back through
+// the same code paths for repeatable runs.
+// -----------------------------------------------
+
+class InputRecorder
+{
+public:
+	// -----------------------------------------------
+	// Internal enum/structs.
+	// -----------------------------------------------
+
+	/// <summary>
+	/// RECORDER_MODE determines what the recorder is doing.
+	/// </summary>
+	typedef enum _RECORDER_MODE
+	{
+		RM_OFF = 0,
+		RM_RECORDING = 1,
+		RM_PLAYBACK = 2
+	} RECORDER_MODE;
+
+	/// <summary>
+	/// Wrapper for RECORDER_MODE enum.
+	/// </summary>
+	typedef RECORDER_MODE RecorderMode;
+
+	/// <summary>
+	/// MOUSE_EVENT_TYPE determines which handler an event replays through.
+	/// </summary>
+	typedef enum _MOUSE_EVENT_TYPE
+	{
+		ME_DOWN = 0,
+		ME_UP = 1,
+		ME_MOVE = 2,
+		ME_WHEEL = 3
+	} MOUSE_EVENT_TYPE;
+
+	/// <summary>
+	/// Wrapper for MOUSE_EVENT_TYPE enum.
+	/// </summary>
+	typedef MOUSE_EVENT_TYPE MouseEventType;
+
+	/// <summary>
+	/// One mouse message, as stored in the file (8 bytes).
+	/// </summary>
+	struct MouseEvent
+	{
+		unsigned char type;		// MouseEventType.
+		unsigned char buttons;	// MK_* button state (low byte).
+		short x;
+		short y;
+		short wheel;			// Wheel delta in 1/120ths of a notch.
+	};
+
+	/// <summary>
+	/// One frame of input.
+	/// </summary>
+	struct Frame
+	{
+		float deltaTime;
+		float totalTime;
+		InputMap::ActionSet actions;
+		unsigned int firstEvent;	// Index into the mouse event list.
+		unsigned int eventCount;
+	};
+
+	// File identification.
+	static const unsigned int FILE_MAGIC = 0x49505747; // "GWPI" little endian.
+	static const unsigned short FILE_VERSION = 1;
+
+	// -----------------------------------------------
+	// Constructors.
+	// -----------------------------------------------
+
+	InputRecorder();
+	~InputRecorder();
+
+	// -----------------------------------------------
+	// Accessors.
+	// -----------------------------------------------
+
+	RecorderMode GetMode() const;
+	bool IsRecording() const;
+	bool IsPlaying() const;
+	unsigned int GetSeed() const;
+	unsigned int GetFrameCount() const;
+	unsigned int GetFrameIndex() const;
+	const MouseEvent& GetMouseEvent(const Frame& frame, unsigned int index) const;
+
+	// -----------------------------------------------
+	// Service methods.
+	// -----------------------------------------------
+
+	bool StartRecording(const std::string& filename, unsigned int seed);
+	bool StartPlayback(const std::string& filename);
+	void Stop();
+
+	// Recording.
+	void RecordMouseEvent(MouseEventType type, unsigned int buttons, int x, int y, float wheel = 0.0f);
+	void RecordFrame(float deltaTime, float totalTime, const InputMap::ActionSet& actions);
+
+	// Playback.
+	const Frame* NextFrame(); // Returns null once the recording ends.
+
+private:
+
+	// -----------------------------------------------
+	// Data members.
+	// -----------------------------------------------
+
+	RecorderMode mode;
+	unsigned int seed;
+
+	// Recording: events since the last frame, and the output file.
+	std::vector<MouseEvent> pendingEvents;
+	std::ofstream output;
+	unsigned int recordedFrames;
+
+	// Playback: the whole recording, loaded up front.
+	std::vector<Frame> frames;
+	std::vector<MouseEvent> events;
+	unsigned int frameIndex;
+
+	// -----------------------------------------------
+	// Helper methods.
+	// -----------------------------------------------
+
+	static const unsigned int ACTION_WORDS = InputMap::MAX_ACTIONS / 64;
+	static void PackActions(const InputMap::ActionSet& actions, unsigned long long words[ACTION_WORDS]);
+	static void UnpackActions(const unsigned long long words[ACTION_WORDS], InputMap::ActionSet& actions);
+};
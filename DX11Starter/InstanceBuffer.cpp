@@ -0,0 +1,146 @@
+// -----------------------------------------------
+// Include statements.
+// -----------------------------------------------
+#include "InstanceBuffer.h"
+#include "RenderBackend.h"
+
+// -----------------------------------------------
+// Namespace statements.
+// -----------------------------------------------
+using namespace DirectX;
+
+// -----------------------------------------------
+// Constructors.
+// -----------------------------------------------
+
+/// <summary>
+/// Start empty. The GPU buffer is created on the first upload.
+/// </summary>
+InstanceBuffer::InstanceBuffer()
+	: buffer{ nullptr }, capacity{ 0 }
+{}
+
+/// <summary>
+/// Release the GPU buffer.
+/// </summary>
+InstanceBuffer::~InstanceBuffer()
+{
+	if (buffer) { buffer->Release(); }
+	buffer = nullptr;
+}
+
+// -----------------------------------------------
+// Accessors.
+// -----------------------------------------------
+
+/// <summary>
+/// The GPU buffer (null until the first upload).
+/// </summary>
+ID3D11Buffer* InstanceBuffer::GetBuffer() const
+{
+	return buffer;
+}
+
+/// <summary>
+/// Size of one instance in bytes.
+/// </summary>
+unsigned int InstanceBuffer::GetStride() const
+{
+	return sizeof(Instance);
+}
+
+/// <summary>
+/// Instances added since the last Clear().
+/// </summary>
+unsigned int InstanceBuffer::GetCount() const
+{
+	return (unsigned int)instances.size();
+}
+
+/// <summary>
+/// Instances the GPU buffer can currently hold.
+/// </summary>
+unsigned int InstanceBuffer::GetCapacity() const
+{
+	return capacity;
+}
+
+// -----------------------------------------------
+// Service methods.
+// -----------------------------------------------
+
+/// <summary>
+/// Drop this frame's instances.
+/// </summary>
+void InstanceBuffer::Clear()
+{
+	instances.clear();
+}
+
+/// <summary>
+/// Append an instance.
+/// </summary>
+/// <param name="world">Transposed world matrix.</param>
+/// <param name="surface">Surface color.</param>
+/// <returns>Returns the instance's index in the buffer.</returns>
+unsigned int InstanceBuffer::Add(const XMFLOAT4X4& world, const XMFLOAT4& surface)
+{
+	instances.push_back({ world, surface });
+	return (unsigned int)instances.size() - 1;
+}
+
+/// <summary>
+/// Copy every added instance to the GPU in one go,
+/// growing the buffer first if needed.
+/// </summary>
+/// <param name="device">Device to create the buffer with.</param>
+/// <param name="backend">Backend to upload through.</param>
+/// <returns>Returns false if the buffer couldn't be created.</returns>
+bool InstanceBuffer::Upload(ID3D11Device* device, IRenderBackend* backend)
+{
+	if (instances.empty())
+		return true;
+
+	if (!Reserve(device, (unsigned int)instances.size()))
+		return false;
+
+	backend->UpdateDynamicBuffer(buffer, instances.data(), (unsigned int)(instances.size() * sizeof(Instance)));
+	return true;
+}
+
+// -----------------------------------------------
+// Helper methods.
+// -----------------------------------------------
+
+/// <summary>
+/// Make sure the GPU buffer holds at least count instances.
+/// Grows by doubling, so a slowly rising count doesn't
+/// recreate the buffer every frame.
+/// </summary>
+/// <param name="device">Device to create the buffer with.</param>
+/// <param name="count">Instances needed.</param>
+/// <returns>Returns false if the buffer couldn't be created.</returns>
+bool InstanceBuffer::Reserve(ID3D11Device* device, unsigned int count)
+{
+	if (buffer && count <= capacity)
+		return true;
+
+	unsigned int size = (capacity > 0) ? capacity : 64;
+	while (size < count)
+		size *= 2;
+
+	D3D11_BUFFER_DESC desc = {};
+	desc.ByteWidth = size * sizeof(Instance);
+	desc.Usage = D3D11_USAGE_DYNAMIC;
+	desc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
+	desc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+
+	ID3D11Buffer* created = nullptr;
+	if (FAILED(device->CreateBuffer(&desc, 0, &created)))
+		return false;
+
+	if (buffer) { buffer->Release(); }
+	buffer = created;
+	capacity = size;
+	return true;
+}
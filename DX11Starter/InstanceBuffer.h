@@ -0,0 +1,88 @@
+#pragma once
+
+// -----------------------------------------------
+// Include statements.
+// -----------------------------------------------
+#include <d3d11.h>
+#include <DirectXMath.h>
+#include <vector>
+
+// -----------------------------------------------
+// Forward declarations.
+// -----------------------------------------------
+class IRenderBackend;
+
+// -----------------------------------------------
+// InstanceBuffer.h
+// ---
+// Per-instance vertex data for instanced draws.
+// Instances are packed on the CPU, then copied to
+// one dynamic vertex buffer with a single upload
+// per frame. Groups of instances are drawn from
+// ranges of it (see startInstance).
+//
+// The buffer grows to fit the largest frame seen
+// and is never shrunk.
+// -----------------------------------------------
+
+class InstanceBuffer
+{
+public:
+	// -----------------------------------------------
+	// Internal structs.
+	// -----------------------------------------------
+
+	/// <summary>
+	/// One instance. Must match the "_PER_INSTANCE"
+	/// inputs of InstancedVertexShader.hlsl.
+	/// </summary>
+	struct Instance
+	{
+		DirectX::XMFLOAT4X4 world;	// Transposed, as GameEntity::GetWorldMatrix() returns it.
+		DirectX::XMFLOAT4 surface;
+	};
+
+	// -----------------------------------------------
+	// Constructors.
+	// -----------------------------------------------
+
+	InstanceBuffer();
+	~InstanceBuffer();
+
+	// -----------------------------------------------
+	// Accessors.
+	// -----------------------------------------------
+
+	ID3D11Buffer* GetBuffer() const;
+	unsigned int GetStride() const;
+	unsigned int GetCount() const;
+	unsigned int GetCapacity() const;
+
+	// -----------------------------------------------
+	// Service methods.
+	// -----------------------------------------------
+
+	void Clear();	// Call at the start of each frame. Keeps the memory.
+	unsigned int Add(const DirectX::XMFLOAT4X4& world, const DirectX::XMFLOAT4& surface);	// Returns the instance's index.
+	bool Upload(ID3D11Device* device, IRenderBackend* backend);	// Returns false if the buffer couldn't be created.
+
+private:
+
+	// -----------------------------------------------
+	// Data members.
+	// -----------------------------------------------
+
+	std::vector<Instance> instances;
+	ID3D11Buffer* buffer;
+	unsigned int capacity;	// Instances the GPU buffer can hold.
+
+	// -----------------------------------------------
+	// Helper methods.
+	// -----------------------------------------------
+
+	bool Reserve(ID3D11Device* device, unsigned int count);
+
+	// Not copyable - owns a GPU buffer.
+	InstanceBuffer(const InstanceBuffer&) = delete;
+	InstanceBuffer& operator=(const InstanceBuffer&) = delete;
+};
@@ -0,0 +1,56 @@
+
+// Instanced variant of VertexShader.hlsl
+// - Draws many copies of one mesh in a single call; each copy's
+//    world matrix and surface color come from a second vertex
+//    buffer that advances once per instance instead of per vertex
+// - SimpleShader puts any input whose semantic ends in
+//    "_PER_INSTANCE" in input slot 1, stepping per instance
+
+// Constant Buffer
+// - Same per-frame data as the non-instanced shader
+cbuffer perFrame : register(b0)
+{
+	matrix view;
+	matrix projection;
+};
+
+// Struct representing a single vertex worth of data
+// - The first three members come from the mesh (slot 0)
+// - The rest come from the instance buffer (slot 1), and
+//    must match InstanceBuffer::Instance in our C++ code
+struct VertexShaderInput
+{
+	float3 position		: POSITION;
+	float3 normal		: NORMAL;
+	float2 uv			: TEXCOORD;
+	float4x4 world		: WORLD_PER_INSTANCE;	// Transposed, like the constant buffer copy
+	float4 surface		: COLOR_PER_INSTANCE;
+};
+
+// Must match the pixel shader's input
+struct VertexToPixel
+{
+	float4 position		: SV_POSITION;
+	float3 normal		: NORMAL;
+	float4 surface		: COLOR;
+};
+
+// --------------------------------------------------------
+// The entry point (main method) for our vertex shader
+// --------------------------------------------------------
+VertexToPixel main(VertexShaderInput input)
+{
+	VertexToPixel output;
+
+	// The instance matrix is stored exactly as it would be in a
+	// constant buffer (transposed), and matrix vertex inputs use
+	// the same column_major packing as constant buffers - so it
+	// loads as the world matrix, used just like VertexShader.hlsl's
+	float4 worldPosition = mul(float4(input.position, 1.0f), input.world);
+	output.position = mul(mul(worldPosition, view), projection);
+
+	output.normal = mul(input.normal, (float3x3)input.world);
+	output.surface = input.surface;
+
+	return output;
+}
@@ -0,0 +1,284 @@
+// -----------------------------------------------
+// Include statements.
+// -----------------------------------------------
+#include "LodSelector.h"
+#include <cmath>
+#include <xmmintrin.h>
+
+// -----------------------------------------------
+// Namespace statements.
+// -----------------------------------------------
+using namespace DirectX;
+
+// -----------------------------------------------
+// Constants.
+// -----------------------------------------------
+
+// Distances below this count as this (camera inside the sphere).
+static const float MIN_DISTANCE = 1e-4f;
+
+// -----------------------------------------------
+// Constructors.
+// -----------------------------------------------
+
+/// <summary>
+/// Initializes an empty selector with the default thresholds.
+/// </summary>
+LodSelector::LodSelector()
+	: count{ 0 }, thresholds{ 0.2f, 0.08f, 0.03f }, hysteresis{ 0.15f }, changes{ 0 }
+{}
+
+// -----------------------------------------------
+// Static methods.
+// -----------------------------------------------
+
+/// <summary>
+/// How large a sphere looks: its diameter as a fraction of the
+/// screen height.
+/// </summary>
+/// <param name="sphere">World space center (xyz) and radius (w).</param>
+/// <param name="cameraPosition">World space camera position.</param>
+/// <param name="projectionScale">Projection matrix _22 (1 / tan(fov / 2)).</param>
+/// <returns>Returns the screen size (1 fills the screen height).</returns>
+float LodSelector::GetScreenSize(const XMFLOAT4& sphere, const XMFLOAT3& cameraPosition, float projectionScale)
+{
+	float dx = sphere.x - cameraPosition.x;
+	float dy = sphere.y - cameraPosition.y;
+	float dz = sphere.z - cameraPosition.z;
+	float distance = sqrtf(dx * dx + dy * dy + dz * dz);
+	return sphere.w * projectionScale / fmaxf(distance, MIN_DISTANCE);
+}
+
+// -----------------------------------------------
+// Accessors.
+// -----------------------------------------------
+
+/// <summary>
+/// Number of entries.
+/// </summary>
+size_t LodSelector::GetCount() const
+{
+	return count;
+}
+
+/// <summary>
+/// Detail level picked for an entry by the last Select().
+/// </summary>
+/// <param name="index">Entry index.</param>
+unsigned int LodSelector::GetLevel(size_t index) const
+{
+	return (index < count) ? (unsigned int)levels[index] : 0;
+}
+
+/// <summary>
+/// Number of entries whose level the last Select() changed.
+/// </summary>
+unsigned int LodSelector::GetChangeCount() const
+{
+	return changes;
+}
+
+/// <summary>
+/// Screen sizes at which each coarser level starts.
+/// </summary>
+const std::vector<float>& LodSelector::GetThresholds() const
+{
+	return thresholds;
+}
+
+/// <summary>
+/// How far past a threshold (as a fraction of it) the size must
+/// be before the level changes.
+/// </summary>
+float LodSelector::GetHysteresis() const
+{
+	return hysteresis;
+}
+
+// -----------------------------------------------
+// Service methods.
+// -----------------------------------------------
+
+/// <summary>
+/// Set the screen sizes at which each coarser level starts.
+/// </summary>
+/// <param name="sizes">Descending sizes; sizes[k] starts level k + 1.</param>
+/// <returns>Returns false (and keeps the old thresholds) if they aren't descending or are too many.</returns>
+bool LodSelector::SetThresholds(const std::vector<float>& sizes)
+{
+	if (sizes.size() >= MAX_LEVELS)
+		return false;
+	for (size_t k = 0; k < sizes.size(); k++)
+	{
+		if (!(sizes[k] > 0.0f) || (k > 0 && !(sizes[k] < sizes[k - 1])))
+			return false;
+	}
+
+	thresholds = sizes;
+	return true;
+}
+
+/// <summary>
+/// Set the hysteresis margin.
+/// </summary>
+/// <param name="margin">Fraction of a threshold, clamped to [0, 0.5].</param>
+void LodSelector::SetHysteresis(float margin)
+{
+	hysteresis = (margin > 0.0f) ? ((margin < 0.5f) ? margin : 0.5f) : 0.0f;
+}
+
+/// <summary>
+/// Set the number of entries. Entries that already existed keep
+/// their level.
+/// </summary>
+/// <param name="newCount">Number of entities.</param>
+void LodSelector::Resize(size_t newCount)
+{
+	// Padding has no radius and a single level, so it always
+	// picks level 0 and never counts as a change.
+	size_t padded = (newCount + LANES - 1) / LANES * LANES;
+	centerX.resize(padded, 0.0f);
+	centerY.resize(padded, 0.0f);
+	centerZ.resize(padded, 0.0f);
+	radius.resize(padded, 0.0f);
+	coarsest.resize(padded, 0.0f);
+	levels.resize(padded, 0.0f);
+
+	for (size_t i = newCount; i < padded; i++)
+	{
+		radius[i] = 0.0f;
+		coarsest[i] = 0.0f;
+		levels[i] = 0.0f;
+	}
+	count = newCount;
+}
+
+/// <summary>
+/// Update an entry's bounding sphere and level count.
+/// </summary>
+/// <param name="index">Entry index (below GetCount()).</param>
+/// <param name="sphere">World space center (xyz) and radius (w).</param>
+/// <param name="levelCount">Detail levels the entity's mesh has.</param>
+void LodSelector::Set(size_t index, const XMFLOAT4& sphere, unsigned int levelCount)
+{
+	if (index >= count)
+		return;
+
+	if (levelCount == 0)
+		levelCount = 1;
+	if (levelCount > MAX_LEVELS)
+		levelCount = MAX_LEVELS;
+
+	centerX[index] = sphere.x;
+	centerY[index] = sphere.y;
+	centerZ[index] = sphere.z;
+	radius[index] = sphere.w;
+	coarsest[index] = (float)(levelCount - 1);
+}
+
+/// <summary>
+/// Pick every entry's level, four at a time. The size allows a
+/// range of levels: at least the number of thresholds it is
+/// clearly below, at most the number it isn't clearly above.
+/// The last level is kept if it's in that range, otherwise the
+/// nearest end of the range is taken.
+/// </summary>
+/// <param name="cameraPosition">World space camera position.</param>
+/// <param name="projectionScale">Projection matrix _22 (1 / tan(fov / 2)).</param>
+/// <returns>Returns the number of entries whose level changed.</returns>
+unsigned int LodSelector::Select(const XMFLOAT3& cameraPosition, float projectionScale)
+{
+	const __m128 cameraX = _mm_set1_ps(cameraPosition.x);
+	const __m128 cameraY = _mm_set1_ps(cameraPosition.y);
+	const __m128 cameraZ = _mm_set1_ps(cameraPosition.z);
+	const __m128 scale = _mm_set1_ps(projectionScale);
+	const __m128 minDistance = _mm_set1_ps(MIN_DISTANCE);
+	const __m128 one = _mm_set1_ps(1.0f);
+
+	// Comparing radius * scale against threshold * distance
+	// avoids a divide per entity.
+	__m128 lower[MAX_LEVELS - 1], upper[MAX_LEVELS - 1];
+	size_t thresholdCount = thresholds.size();
+	for (size_t k = 0; k < thresholdCount; k++)
+	{
+		lower[k] = _mm_set1_ps(thresholds[k] * (1.0f - hysteresis));
+		upper[k] = _mm_set1_ps(thresholds[k] * (1.0f + hysteresis));
+	}
+
+	unsigned int changed = 0;
+	size_t padded = levels.size();
+	for (size_t i = 0; i < padded; i += LANES)
+	{
+		__m128 dx = _mm_sub_ps(_mm_loadu_ps(&centerX[i]), cameraX);
+		__m128 dy = _mm_sub_ps(_mm_loadu_ps(&centerY[i]), cameraY);
+		__m128 dz = _mm_sub_ps(_mm_loadu_ps(&centerZ[i]), cameraZ);
+		__m128 distance = _mm_max_ps(_mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz))), minDistance);
+		__m128 size = _mm_mul_ps(_mm_loadu_ps(&radius[i]), scale);
+
+		// Count the thresholds the size is clearly below (the
+		// least level allowed) and those it isn't clearly above
+		// (the most).
+		__m128 least = _mm_setzero_ps();
+		__m128 most = _mm_setzero_ps();
+		for (size_t k = 0; k < thresholdCount; k++)
+		{
+			least = _mm_add_ps(least, _mm_and_ps(_mm_cmplt_ps(size, _mm_mul_ps(lower[k], distance)), one));
+			most = _mm_add_ps(most, _mm_and_ps(_mm_cmplt_ps(size, _mm_mul_ps(upper[k], distance)), one));
+		}
+
+		__m128 previous = _mm_loadu_ps(&levels[i]);
+		__m128 level = _mm_min_ps(_mm_max_ps(previous, least), most);
+		level = _mm_min_ps(level, _mm_loadu_ps(&coarsest[i]));
+		_mm_storeu_ps(&levels[i], level);
+
+		int mask = _mm_movemask_ps(_mm_cmpneq_ps(level, previous));
+		changed += (mask & 1) + ((mask >> 1) & 1) + ((mask >> 2) & 1) + ((mask >> 3) & 1);
+	}
+
+	changes = changed;
+	return changed;
+}
+
+/// <summary>
+/// Same selection as Select(), one entry at a time.
+/// </summary>
+/// <param name="cameraPosition">World space camera position.</param>
+/// <param name="projectionScale">Projection matrix _22 (1 / tan(fov / 2)).</param>
+/// <returns>Returns the number of entries whose level changed.</returns>
+unsigned int LodSelector::SelectScalar(const XMFLOAT3& cameraPosition, float projectionScale)
+{
+	unsigned int changed = 0;
+	for (size_t i = 0; i < count; i++)
+	{
+		float dx = centerX[i] - cameraPosition.x;
+		float dy = centerY[i] - cameraPosition.y;
+		float dz = centerZ[i] - cameraPosition.z;
+		float distance = fmaxf(sqrtf(dx * dx + dy * dy + dz * dz), MIN_DISTANCE);
+		float size = radius[i] * projectionScale;
+
+		float least = 0.0f, most = 0.0f;
+		for (float threshold : thresholds)
+		{
+			least += (size < threshold * (1.0f - hysteresis) * distance) ? 1.0f : 0.0f;
+			most += (size < threshold * (1.0f + hysteresis) * distance) ? 1.0f : 0.0f;
+		}
+
+		float level = fminf(fmaxf(levels[i], least), most);
+		level = fminf(level, coarsest[i]);
+		changed += (level != levels[i]) ? 1 : 0;
+		levels[i] = level;
+	}
+
+	changes = changed;
+	return changed;
+}
+
+/// <summary>
+/// Put every entry back to level 0, so the next Select() picks
+/// the most detailed level each size allows.
+/// </summary>
+void LodSelector::ResetLevels()
+{
+	for (float& level : levels)
+		level = 0.0f;
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+// -----------------------------------------------
+// Include statements.
+// -----------------------------------------------
+#include <DirectXMath.h>
+#include <cstddef>
+#include <vector>
+
+// -----------------------------------------------
+// LodSelector.h
+// ---
+// Picks a detail level for every entity from how
+// large its bounding sphere looks on screen: the
+// sphere's diameter as a fraction of the screen
+// height (radius * projection scale / distance).
+// Distance rather than view depth is used, so
+// turning the camera doesn't change any level.
+//
+// Level k is used while the size is below the
+// first k thresholds. A level only changes once
+// the size is past a threshold by the hysteresis
+// margin, so an entity sitting on a threshold
+// doesn't flip between two meshes every frame.
+//
+// Levels are kept per index between frames (that
+// is what the hysteresis compares against), and
+// four entities are done at a time with SSE, in
+// the same structure of arrays layout as the
+// FrustumCuller.
+// -----------------------------------------------
+
+class LodSelector
+{
+public:
+	// Entities per SIMD step.
+	static const unsigned int LANES = 4;
+
+	// Most detail levels a mesh can have.
+	static const unsigned int MAX_LEVELS = 8;
+
+	// -----------------------------------------------
+	// Constructors.
+	// -----------------------------------------------
+
+	LodSelector();	// Thresholds 0.2, 0.08 and 0.03 of the screen height, 15% hysteresis.
+
+	// -----------------------------------------------
+	// Static methods.
+	// -----------------------------------------------
+
+	static float GetScreenSize(const DirectX::XMFLOAT4& sphere, const DirectX::XMFLOAT3& cameraPosition, float projectionScale);
+
+	// -----------------------------------------------
+	// Accessors.
+	// -----------------------------------------------
+
+	size_t GetCount() const;
+	unsigned int GetLevel(size_t index) const;	// From the last Select().
+	unsigned int GetChangeCount() const;		// Levels the last Select() changed.
+	const std::vector<float>& GetThresholds() const;
+	float GetHysteresis() const;
+
+	// -----------------------------------------------
+	// Service methods.
+	// -----------------------------------------------
+
+	bool SetThresholds(const std::vector<float>& sizes);	// Descending, at most MAX_LEVELS - 1. False if not.
+	void SetHysteresis(float margin);	// Fraction of a threshold, e.g. 0.15.
+	void Resize(size_t count);	// Keeps the levels of existing entries; new ones start at level 0.
+	void Set(size_t index, const DirectX::XMFLOAT4& sphere, unsigned int levelCount);	// World space center (xyz) and radius (w).
+	unsigned int Select(const DirectX::XMFLOAT3& cameraPosition, float projectionScale);	// Returns the change count.
+	unsigned int SelectScalar(const DirectX::XMFLOAT3& cameraPosition, float projectionScale);	// One entity at a time, for comparison.
+	void ResetLevels();	// Forget the history (e.g. after a camera cut); back to level 0.
+
+private:
+
+	// -----------------------------------------------
+	// Data members.
+	// -----------------------------------------------
+
+	// One entry per entity, padded to a multiple of four.
+	std::vector<float> centerX;
+	std::vector<float> centerY;
+	std::vector<float> centerZ;
+	std::vector<float> radius;
+	std::vector<float> coarsest;	// Level count - 1.
+	std::vector<float> levels;		// Kept between frames.
+	size_t count;
+
+	std::vector<float> thresholds;	// Descending screen sizes.
+	float hysteresis;
+	unsigned int changes;
+};
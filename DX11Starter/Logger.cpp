@@ -0,0 +1,407 @@
+// -----------------------------------------------
+// Include statements.
+// -----------------------------------------------
+#include "Logger.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+// -----------------------------------------------
+// Constructors.
+// -----------------------------------------------
+
+/// <summary>
+/// The single logger instance.
+/// </summary>
+Logger& Logger::Get()
+{
+	static Logger instance;
+	return instance;
+}
+
+/// <summary>
+/// Allocates the ring buffer. Messages queue up
+/// until Start() is called.
+/// </summary>
+Logger::Logger()
+	: slots{ new Slot[RING_SIZE] }, enqueuePosition{ 0 }, dequeuePosition{ 0 }, dropped{ 0 },
+	running{ false }, startTime{ PlatformTimer::Now() }, consoleOutput{ true }, file{ nullptr }
+{
+	for (size_t i = 0; i < RING_SIZE; i++)
+		slots[i].sequence.store(i, std::memory_order_relaxed);
+}
+
+/// <summary>
+/// Flushes and closes everything.
+/// </summary>
+Logger::~Logger()
+{
+	this->Stop();
+	if (file)
+		fclose(file);
+}
+
+// -----------------------------------------------
+// Accessors.
+// -----------------------------------------------
+
+/// <summary>
+/// Short name of a level.
+/// </summary>
+const char* Logger::GetLevelName(LogLevel level)
+{
+	static const char* names[LL_COUNT] = { "TRACE", "DEBUG", "INFO", "WARN", "ERROR" };
+	return (level >= 0 && level < LL_COUNT) ? names[level] : "?";
+}
+
+/// <summary>
+/// Short name of a category.
+/// </summary>
+const char* Logger::GetCategoryName(LogCategory category)
+{
+	switch (category)
+	{
+	case LC_CORE: return "core";
+	case LC_INPUT: return "input";
+	case LC_CAMERA: return "camera";
+	case LC_RENDER: return "render";
+	case LC_ENTITY: return "entity";
+	default: return "?";
+	}
+}
+
+/// <summary>
+/// Messages dropped because the ring buffer was full.
+/// </summary>
+unsigned long long Logger::GetDroppedCount() const
+{
+	return dropped.load(std::memory_order_relaxed);
+}
+
+// -----------------------------------------------
+// Mutators.
+// -----------------------------------------------
+
+/// <summary>
+/// Write messages to stdout?
+/// </summary>
+void Logger::SetConsoleOutput(bool enabled)
+{
+	consoleOutput = enabled;
+}
+
+/// <summary>
+/// Also write messages to a file. Call before Start().
+/// </summary>
+/// <param name="filename">Log file path (overwritten).</param>
+/// <returns>Returns false if the file couldn't be opened.</returns>
+bool Logger::OpenFile(const std::string& filename)
+{
+	if (file)
+		fclose(file);
+
+	file = fopen(filename.c_str(), "w");
+	return file != nullptr;
+}
+
+// -----------------------------------------------
+// Service methods.
+// -----------------------------------------------
+
+/// <summary>
+/// Starts the background thread.
+/// </summary>
+void Logger::Start()
+{
+	if (running.exchange(true))
+		return;
+
+	worker = std::thread(&Logger::Run, this);
+}
+
+/// <summary>
+/// Writes anything still queued, then stops the thread.
+/// </summary>
+void Logger::Stop()
+{
+	if (running.exchange(false))
+		worker.join();
+
+	// Catch anything queued after the thread's last pass
+	// (or everything, if it was never started).
+	Drain();
+}
+
+// -----------------------------------------------
+// Helper methods.
+// -----------------------------------------------
+
+/// <summary>
+/// Reserve a ring buffer cell for writing.
+/// </summary>
+/// <param name="position">Receives the cell's sequence position.</param>
+/// <returns>Returns the record to fill, or null if the ring is full.</returns>
+Logger::Record* Logger::Claim(size_t& position)
+{
+	position = enqueuePosition.load(std::memory_order_relaxed);
+	for (;;)
+	{
+		Slot& slot = slots[position & (RING_SIZE - 1)];
+		size_t sequence = slot.sequence.load(std::memory_order_acquire);
+		intptr_t difference = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position);
+
+		if (difference == 0)
+		{
+			// Free: try to take it.
+			if (enqueuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+				return &slot.record;
+		}
+		else if (difference < 0)
+		{
+			// Full: the consumer hasn't caught up.
+			dropped.fetch_add(1, std::memory_order_relaxed);
+			return nullptr;
+		}
+		else
+		{
+			// Another producer got here first.
+			position = enqueuePosition.load(std::memory_order_relaxed);
+		}
+	}
+}
+
+/// <summary>
+/// Hand a filled cell over to the consumer.
+/// </summary>
+void Logger::Publish(size_t position)
+{
+	slots[position & (RING_SIZE - 1)].sequence.store(position + 1, std::memory_order_release);
+}
+
+/// <summary>
+/// Store a signed integer argument.
+/// </summary>
+void Logger::Encode(Record& record, long long value)
+{
+	Argument& argument = record.arguments[record.argumentCount++];
+	argument.type = AT_SIGNED;
+	argument.i = value;
+}
+
+/// <summary>
+/// Store an unsigned integer argument.
+/// </summary>
+void Logger::Encode(Record& record, unsigned long long value)
+{
+	Argument& argument = record.arguments[record.argumentCount++];
+	argument.type = AT_UNSIGNED;
+	argument.u = value;
+}
+
+/// <summary>
+/// Store a floating point argument.
+/// </summary>
+void Logger::Encode(Record& record, double value)
+{
+	Argument& argument = record.arguments[record.argumentCount++];
+	argument.type = AT_DOUBLE;
+	argument.d = value;
+}
+
+/// <summary>
+/// Store a pointer argument (printed with %p).
+/// </summary>
+void Logger::Encode(Record& record, const void* value)
+{
+	Argument& argument = record.arguments[record.argumentCount++];
+	argument.type = AT_POINTER;
+	argument.p = value;
+}
+
+/// <summary>
+/// Copy a string argument into the record, truncating
+/// it if the record's text space runs out.
+/// </summary>
+void Logger::Encode(Record& record, const char* value)
+{
+	Argument& argument = record.arguments[record.argumentCount++];
+	argument.type = AT_STRING;
+
+	// No room left: point at the last terminator, so the
+	// argument prints as an empty string.
+	if (record.textLength >= TEXT_CAPACITY)
+	{
+		argument.text = TEXT_CAPACITY - 1;
+		return;
+	}
+	argument.text = record.textLength;
+
+	if (!value)
+		value = "(null)";
+
+	unsigned int space = TEXT_CAPACITY - record.textLength - 1;	// Leaves room for the terminator.
+	unsigned int length = static_cast<unsigned int>(strnlen(value, space));
+	memcpy(record.text + record.textLength, value, length);
+	record.textLength += length;
+	record.text[record.textLength++] = '\0';
+}
+
+/// <summary>
+/// Background thread: drain the ring, sleep briefly when it's empty.
+/// </summary>
+void Logger::Run()
+{
+	while (running.load(std::memory_order_acquire))
+	{
+		if (!Drain())
+			std::this_thread::sleep_for(std::chrono::milliseconds(2));
+	}
+}
+
+/// <summary>
+/// Format and write every queued message.
+/// </summary>
+/// <returns>Returns true if anything was written.</returns>
+bool Logger::Drain()
+{
+	std::string output;
+	for (;;)
+	{
+		size_t position = dequeuePosition.load(std::memory_order_relaxed);
+		Slot& slot = slots[position & (RING_SIZE - 1)];
+		size_t sequence = slot.sequence.load(std::memory_order_acquire);
+		if (static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position + 1) < 0)
+			break; // Empty.
+
+		if (!dequeuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+			continue;
+
+		Format(slot.record, output);
+		slot.sequence.store(position + RING_SIZE, std::memory_order_release);
+	}
+
+	if (output.empty())
+		return false;
+
+	if (consoleOutput)
+	{
+		fwrite(output.data(), 1, output.size(), stdout);
+		fflush(stdout);
+	}
+	if (file)
+	{
+		fwrite(output.data(), 1, output.size(), file);
+		fflush(file);
+	}
+	return true;
+}
+
+/// <summary>
+/// Turn a record into one line of text.
+/// </summary>
+/// <param name="record">Unformatted message.</param>
+/// <param name="line">Text is appended here.</param>
+void Logger::Format(const Record& record, std::string& line) const
+{
+	char prefix[64];
+	snprintf(prefix, sizeof(prefix), "[%10.4f] %-5s %-6s : ",
+		PlatformTimer::SecondsBetween(startTime, record.time),
+		GetLevelName(record.level), GetCategoryName(record.category));
+	line += prefix;
+
+	// Walk the format string, substituting each conversion
+	// with the next stored argument.
+	unsigned int next = 0;
+	for (const char* c = record.format; *c; c++)
+	{
+		if (*c != '%')
+		{
+			line += *c;
+			continue;
+		}
+		if (c[1] == '%')
+		{
+			line += '%';
+			c++;
+			continue;
+		}
+
+		// Collect flags, width and precision; skip length
+		// modifiers (the stored type decides those).
+		std::string spec = "%";
+		const char* s = c + 1;
+		while (*s && strchr("-+ #0123456789.*", *s))
+			spec += *s++;
+		while (*s && strchr("hljztL", *s))
+			s++;
+		if (!*s)
+			break;
+
+		// "*" widths and precisions would make snprintf read an
+		// argument that was never stored; skip the arguments
+		// they were given instead.
+		if (spec.find('*') != std::string::npos)
+		{
+			next += static_cast<unsigned int>(std::count(spec.begin(), spec.end(), '*')) + 1;
+			line += "<unsupported>";
+			c = s;
+			continue;
+		}
+
+		if (next < record.argumentCount)
+			FormatArgument(record, record.arguments[next++], spec, *s, line);
+		else
+			line += "<missing>";
+		c = s;
+	}
+	line += '\n';
+}
+
+/// <summary>
+/// Format one argument with a printf conversion.
+/// </summary>
+void Logger::FormatArgument(const Record& record, const Argument& argument, const std::string& spec, char conversion, std::string& line)
+{
+	char buffer[256];
+	std::string f = spec;
+	bool integerConversion = strchr("diouxXc", conversion) != nullptr;
+	bool floatConversion = strchr("eEfFgGaA", conversion) != nullptr;
+
+	switch (argument.type)
+	{
+	case AT_SIGNED:
+	case AT_UNSIGNED:
+		if (floatConversion)
+		{
+			f += conversion;
+			double value = (argument.type == AT_SIGNED) ? (double)argument.i : (double)argument.u;
+			snprintf(buffer, sizeof(buffer), f.c_str(), value);
+		}
+		else if (conversion == 'c')
+		{
+			f += 'c';
+			snprintf(buffer, sizeof(buffer), f.c_str(), (int)argument.i);
+		}
+		else
+		{
+			f += "ll";
+			f += integerConversion ? conversion : (argument.type == AT_SIGNED ? 'd' : 'u');
+			snprintf(buffer, sizeof(buffer), f.c_str(), argument.u);
+		}
+		break;
+	case AT_DOUBLE:
+		f += floatConversion ? conversion : 'f';
+		snprintf(buffer, sizeof(buffer), f.c_str(), argument.d);
+		break;
+	case AT_POINTER:
+		f += 'p';
+		snprintf(buffer, sizeof(buffer), f.c_str(), argument.p);
+		break;
+	case AT_STRING:
+	default:
+		f += 's';
+		snprintf(buffer, sizeof(buffer), f.c_str(), record.text + argument.text);
+		break;
+	}
+	line += buffer;
+}
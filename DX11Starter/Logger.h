@@ -0,0 +1,291 @@
+#pragma once
+
+// -----------------------------------------------
+// Include statements.
+// -----------------------------------------------
+#include "PlatformTimer.h"
+#include <atomic>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <thread>
+
+// -----------------------------------------------
+// Logger.h
+// ---
+// Asynchronous logger. Callers copy the format
+// string pointer and raw argument values into a
+// lock-free ring buffer; a background thread does
+// the formatting and the console/file writes.
+//
+// Use the macros, which are compiled out entirely
+// when the level or category is filtered:
+//
+//   LOG_DEBUG(LC_INPUT, "Key %c down", key);
+//
+// Format strings must be string literals (only the
+// pointer is stored). String arguments are copied,
+// sharing TEXT_CAPACITY bytes per message; ones that
+// don't fit are cut short. "*" widths and precisions
+// aren't supported.
+// -----------------------------------------------
+
+class Logger
+{
+public:
+	// -----------------------------------------------
+	// Internal enum/structs.
+	// -----------------------------------------------
+
+	/// <summary>
+	/// LOG_LEVEL determines the severity of a message.
+	/// </summary>
+	typedef enum _LOG_LEVEL
+	{
+		LL_TRACE = 0,
+		LL_DEBUG = 1,
+		LL_INFO = 2,
+		LL_WARN = 3,
+		LL_ERROR = 4,
+		LL_COUNT = 5
+	} LOG_LEVEL;
+
+	/// <summary>
+	/// LOG_CATEGORY determines which system a message
+	/// comes from. Each is one bit of LOG_CATEGORY_MASK.
+	/// </summary>
+	typedef enum _LOG_CATEGORY
+	{
+		LC_CORE = 1 << 0,
+		LC_INPUT = 1 << 1,
+		LC_CAMERA = 1 << 2,
+		LC_RENDER = 1 << 3,
+		LC_ENTITY = 1 << 4
+	} LOG_CATEGORY;
+
+	/// <summary>
+	/// Wrapper for LOG_LEVEL enum.
+	/// </summary>
+	typedef LOG_LEVEL LogLevel;
+
+	/// <summary>
+	/// Wrapper for LOG_CATEGORY enum.
+	/// </summary>
+	typedef LOG_CATEGORY LogCategory;
+
+	// Capacity of the ring buffer (a power of two) and of each record.
+	static const unsigned int RING_SIZE = 4096;
+	static const unsigned int MAX_ARGUMENTS = 8;
+	static const unsigned int TEXT_CAPACITY = 128;
+
+	// -----------------------------------------------
+	// Constructors.
+	// -----------------------------------------------
+
+	static Logger& Get();
+	~Logger();
+
+	// -----------------------------------------------
+	// Accessors.
+	// -----------------------------------------------
+
+	static const char* GetLevelName(LogLevel level);
+	static const char* GetCategoryName(LogCategory category);
+	unsigned long long GetDroppedCount() const;
+
+	// -----------------------------------------------
+	// Mutators.
+	// -----------------------------------------------
+
+	void SetConsoleOutput(bool enabled);
+	bool OpenFile(const std::string& filename);
+
+	// -----------------------------------------------
+	// Service methods.
+	// -----------------------------------------------
+
+	void Start();	// Starts the background thread.
+	void Stop();	// Writes anything still queued, then stops the thread.
+
+	// Queue a message. Never blocks; drops the message if the ring is full.
+	template <typename... Args>
+	void Write(LogLevel level, LogCategory category, const char* format, const Args&... args);
+
+private:
+
+	// -----------------------------------------------
+	// Internal structs.
+	// -----------------------------------------------
+
+	/// <summary>
+	/// ARGUMENT_TYPE determines how an argument is stored.
+	/// </summary>
+	typedef enum _ARGUMENT_TYPE
+	{
+		AT_SIGNED = 0,
+		AT_UNSIGNED = 1,
+		AT_DOUBLE = 2,
+		AT_STRING = 3,	// Offset into the record's text.
+		AT_POINTER = 4
+	} ARGUMENT_TYPE;
+
+	/// <summary>
+	/// One raw argument value.
+	/// </summary>
+	struct Argument
+	{
+		ARGUMENT_TYPE type;
+		union
+		{
+			long long i;
+			unsigned long long u;
+			double d;
+			const void* p;
+			unsigned int text;
+		};
+	};
+
+	/// <summary>
+	/// One unformatted message.
+	/// </summary>
+	struct Record
+	{
+		LogLevel level;
+		LogCategory category;
+		PlatformTimer::Timestamp time;
+		const char* format;
+		unsigned int argumentCount;
+		Argument arguments[MAX_ARGUMENTS];
+		unsigned int textLength;
+		char text[TEXT_CAPACITY];
+	};
+
+	/// <summary>
+	/// Ring buffer cell. The sequence number says whether
+	/// the cell is free for a producer or ready for the consumer.
+	/// </summary>
+	struct Slot
+	{
+		std::atomic<size_t> sequence;
+		Record record;
+	};
+
+	// -----------------------------------------------
+	// Constructors.
+	// -----------------------------------------------
+
+	Logger();
+	Logger(const Logger&) = delete;
+	Logger& operator=(const Logger&) = delete;
+
+	// -----------------------------------------------
+	// Data members.
+	// -----------------------------------------------
+
+	std::unique_ptr<Slot[]> slots;
+	std::atomic<size_t> enqueuePosition;
+	std::atomic<size_t> dequeuePosition;
+	std::atomic<unsigned long long> dropped;
+
+	std::thread worker;
+	std::atomic<bool> running;
+	PlatformTimer::Timestamp startTime;
+
+	bool consoleOutput;
+	FILE* file;
+
+	// -----------------------------------------------
+	// Helper methods.
+	// -----------------------------------------------
+
+	// Producer side.
+	Record* Claim(size_t& position);
+	void Publish(size_t position);
+
+	static void Encode(Record& record, long long value);
+	static void Encode(Record& record, unsigned long long value);
+	static void Encode(Record& record, double value);
+	static void Encode(Record& record, const void* value);
+	static void Encode(Record& record, const char* value);
+	static void Encode(Record& record, const std::string& value) { Encode(record, value.c_str()); }
+	static void Encode(Record& record, char* value) { Encode(record, static_cast<const char*>(value)); }
+	static void Encode(Record& record, bool value) { Encode(record, static_cast<long long>(value)); }
+	static void Encode(Record& record, char value) { Encode(record, static_cast<long long>(value)); }
+	static void Encode(Record& record, int value) { Encode(record, static_cast<long long>(value)); }
+	static void Encode(Record& record, long value) { Encode(record, static_cast<long long>(value)); }
+	static void Encode(Record& record, unsigned char value) { Encode(record, static_cast<unsigned long long>(value)); }
+	static void Encode(Record& record, unsigned int value) { Encode(record, static_cast<unsigned long long>(value)); }
+	static void Encode(Record& record, unsigned long value) { Encode(record, static_cast<unsigned long long>(value)); }
+	static void Encode(Record& record, float value) { Encode(record, static_cast<double>(value)); }
+
+	// Consumer side.
+	void Run();
+	bool Drain();
+	void Format(const Record& record, std::string& line) const;
+	static void FormatArgument(const Record& record, const Argument& argument, const std::string& spec, char conversion, std::string& line);
+};
+
+// -----------------------------------------------
+// Template definitions.
+// -----------------------------------------------
+
+/// <summary>
+/// Queue a message for the background thread.
+/// </summary>
+/// <param name="level">Severity.</param>
+/// <param name="category">Originating system.</param>
+/// <param name="format">printf style format string literal.</param>
+/// <param name="args">Arguments, copied by value.</param>
+template <typename... Args>
+void Logger::Write(LogLevel level, LogCategory category, const char* format, const Args&... args)
+{
+	static_assert(sizeof...(Args) <= MAX_ARGUMENTS, "Too many arguments for one log message.");
+
+	size_t position;
+	Record* record = Claim(position);
+	if (!record)
+		return;
+
+	record->level = level;
+	record->category = category;
+	record->time = PlatformTimer::Now();
+	record->format = format;
+	record->argumentCount = 0;
+	record->textLength = 0;
+
+	int expand[] = { 0, (Encode(*record, args), 0)... };
+	(void)expand;
+
+	Publish(position);
+}
+
+// -----------------------------------------------
+// Compile-time filtering.
+// ---
+// Define LOG_MIN_LEVEL and/or LOG_CATEGORY_MASK
+// in the project settings to override.
+// -----------------------------------------------
+
+#ifndef LOG_MIN_LEVEL
+#if defined(DEBUG) || defined(_DEBUG)
+#define LOG_MIN_LEVEL 1	// Logger::LL_DEBUG
+#else
+#define LOG_MIN_LEVEL 2	// Logger::LL_INFO
+#endif
+#endif
+
+#ifndef LOG_CATEGORY_MASK
+#define LOG_CATEGORY_MASK 0xFFFFFFFFu
+#endif
+
+#define LOG_ENABLED(level, category) \
+	((int)(level) >= LOG_MIN_LEVEL && ((unsigned int)(category) & (LOG_CATEGORY_MASK)) != 0)
+
+#define LOG(level, category, ...) \
+	do { if (LOG_ENABLED(level, category)) { Logger::Get().Write(level, category, __VA_ARGS__); } } while (0)
+
+#define LOG_TRACE(category, ...) LOG(Logger::LL_TRACE, Logger::category, __VA_ARGS__)
+#define LOG_DEBUG(category, ...) LOG(Logger::LL_DEBUG, Logger::category, __VA_ARGS__)
+#define LOG_INFO(category, ...)  LOG(Logger::LL_INFO, Logger::category, __VA_ARGS__)
+#define LOG_WARN(category, ...)  LOG(Logger::LL_WARN, Logger::category, __VA_ARGS__)
+#define LOG_ERROR(category, ...) LOG(Logger::LL_ERROR, Logger::category, __VA_ARGS__)
@@ -1,6 +1,7 @@
 
 #include <Windows.h>
 #include "Game.h"
+#include "Benchmark.h"
 
 // --------------------------------------------------------
 // Entry point for a graphical (non-console) Windows application
@@ -44,9 +45,34 @@ int WINAPI WinMain(
 		}
 	}
 
-	// Create the Game object using
-	// the app handle we got from WinMain
-	Game dxGame(hInstance);
+	// Options given on the command line
+	//  - "--headless" runs without a window or GPU
+	//  - "--frames N" exits after N frames
+	//  - "--fps N" paces frames to N per second (0 is unlimited)
+	//  - "--seed N" fixes the random seed
+	//  - "--record F" / "--playback F" record or replay input
+	//  - "--log F" also writes log messages to F
+	//  - "--no-state-cache" sends redundant binds to the device
+	//  - "--benchmark NAME" runs a CPU benchmark instead of the game (exits with 1 if a check fails)
+	//  - "--no-instancing" draws each entity on its own
+	//  - "--entities N" sets how many entities the scene has
+	//  - "--no-culling" draws entities outside the view too
+	//  - "--no-occlusion" draws entities hidden behind others too
+	//  - "--snapshot F" renders the last frame in software to F
+	//  - "--no-lod" draws every mesh at full detail
+	//  - "--counters F" writes per-frame render counters to F
+	//  - "--budget NAME=N" fails the run if a frame counts more than N
+	//  - "--late-latch" applies the latest mouse input just before drawing
+	CommandLineOptions options = CommandLineOptions::Parse(lpCmdLine);
+
+	if (!options.benchmark.empty())
+	{
+		DXCore::AttachParentConsole();
+		return Benchmark::Run(options.benchmark) ? 0 : 1;
+	}
+
+	// Create the Game object using the app handle we got from WinMain
+	Game dxGame(hInstance, options);
 
 	// Result variable for function calls below
 	HRESULT hr = S_OK;
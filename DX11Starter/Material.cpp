@@ -4,6 +4,12 @@
 
 #include "Material.h"
 
+// -----------------------------------
+// Static members.
+// -----------------------------------
+
+unsigned int Material::nextID = 0;
+
 // -----------------------------------
 // Friend methods.
 // -----------------------------------
@@ -19,7 +25,11 @@ void swap(Material& lhs, Material& rhs)
 
 	// Swap member data.
 	swap(lhs.vertexShader, rhs.vertexShader);
-	swap(lhs.vertexShader, rhs.vertexShader);
+	swap(lhs.pixelShader, rhs.pixelShader);
+	swap(lhs.id, rhs.id);
+	swap(lhs.worldHandle, rhs.worldHandle);
+	swap(lhs.surfaceHandle, rhs.surfaceHandle);
+	swap(lhs.perObjectBufferIndex, rhs.perObjectBufferIndex);
 }
 
 // -----------------------------------
@@ -31,7 +41,7 @@ void swap(Material& lhs, Material& rhs)
 /// </summary>
 Material::Material()
 	: vertexShader{ nullptr },
-	pixelShader{ nullptr } {}
+	pixelShader{ nullptr }, id{ nextID++ }, perObjectBufferIndex{ -1 } {}
 
 /// <summary>
 /// Initializes a new instance of the <see cref="Material"/> class.
@@ -39,7 +49,10 @@ Material::Material()
 /// <param name="_vShd">The v SHD.</param>
 /// <param name="_pShd">The p SHD.</param>
 Material::Material(SimpleVertexShader& _vShd, SimplePixelShader& _pShd)
-	: vertexShader{ &_vShd }, pixelShader{ &_pShd } {}
+	: vertexShader{ &_vShd }, pixelShader{ &_pShd }, id{ nextID++ }, perObjectBufferIndex{ -1 }
+{
+	ResolveHandles();
+}
 
 /// <summary>
 /// Finalizes an instance of the <see cref="Material"/> class.
@@ -59,6 +72,10 @@ Material::Material(const Material& other)
 	// Copy data members.
 	vertexShader = other.vertexShader;
 	pixelShader = other.pixelShader;
+	id = other.id;
+	worldHandle = other.worldHandle;
+	surfaceHandle = other.surfaceHandle;
+	perObjectBufferIndex = other.perObjectBufferIndex;
 }
 
 /// <summary>
@@ -106,6 +123,42 @@ SimplePixelShader* Material::GetPixelShader() const
 	return this->pixelShader;
 }
 
+/// <summary>
+/// Gets the material's unique identifier.
+/// </summary>
+/// <returns>Returns material ID.</returns>
+unsigned int Material::GetID() const
+{
+	return this->id;
+}
+
+/// <summary>
+/// Gets the vertex shader's "world" matrix.
+/// </summary>
+/// <returns>Returns variable handle (invalid if the shader has none).</returns>
+const SimpleShaderVariableHandle& Material::GetWorldHandle() const
+{
+	return this->worldHandle;
+}
+
+/// <summary>
+/// Gets the vertex shader's "surface" color.
+/// </summary>
+/// <returns>Returns variable handle (invalid if the shader has none).</returns>
+const SimpleShaderVariableHandle& Material::GetSurfaceHandle() const
+{
+	return this->surfaceHandle;
+}
+
+/// <summary>
+/// Gets the index of the vertex shader's "perObject" buffer.
+/// </summary>
+/// <returns>Returns buffer index, or -1.</returns>
+int Material::GetPerObjectBufferIndex() const
+{
+	return this->perObjectBufferIndex;
+}
+
 // -----------------------------------
 // Mutators.
 // -----------------------------------
@@ -117,6 +170,7 @@ SimplePixelShader* Material::GetPixelShader() const
 void Material::SetVertexShader(SimpleVertexShader& _vShd)
 {
 	this->vertexShader = &_vShd;
+	ResolveHandles();
 }
 
 /// <summary>
@@ -126,4 +180,18 @@ void Material::SetVertexShader(SimpleVertexShader& _vShd)
 void Material::SetPixelShader(SimplePixelShader& _pShd)
 {
 	this->pixelShader = &_pShd;
+}
+
+// -----------------------------------
+// Helper methods.
+// -----------------------------------
+
+/// <summary>
+/// Looks up the vertex shader's per-object variables.
+/// </summary>
+void Material::ResolveHandles()
+{
+	this->worldHandle = this->vertexShader->GetVariableHandle("world");
+	this->surfaceHandle = this->vertexShader->GetVariableHandle("surface");
+	this->perObjectBufferIndex = this->vertexShader->GetBufferIndex("perObject");
 }
\ No newline at end of file
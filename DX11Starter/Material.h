@@ -33,6 +33,12 @@ public:
 
 	SimpleVertexShader* GetVertexShader() const;
 	SimplePixelShader* GetPixelShader() const;
+	unsigned int GetID() const; // Unique per material (copies share it), for sorting draws.
+
+	// Per-object variables of the vertex shader, looked up once so drawing needs no names.
+	const SimpleShaderVariableHandle& GetWorldHandle() const;
+	const SimpleShaderVariableHandle& GetSurfaceHandle() const;
+	int GetPerObjectBufferIndex() const; // -1 if the shader has no "perObject" buffer.
 
 	// -----------------------------------
 	// Mutators.
@@ -49,5 +55,17 @@ private:
 
 	SimpleVertexShader* vertexShader;
 	SimplePixelShader* pixelShader;
+	unsigned int id;
+	SimpleShaderVariableHandle worldHandle;
+	SimpleShaderVariableHandle surfaceHandle;
+	int perObjectBufferIndex;
+
+	static unsigned int nextID;
+
+	// -----------------------------------
+	// Helper methods.
+	// -----------------------------------
+
+	void ResolveHandles();
 
 };
\ No newline at end of file
@@ -11,6 +11,11 @@
 //-----------------------------
 using namespace DirectX;
 
+//-----------------------------
+// Static members.
+//-----------------------------
+unsigned int Mesh::nextID = 0;
+
 // Constructor.
 
 /// <summary>
@@ -32,11 +37,15 @@ Mesh::Mesh(
 	// Initialize fields.
 	vertexBuffer = 0;
 	indexBuffer = 0;
+	id = nextID++;
+	boundingSphere = XMFLOAT4(0.0f, 0.0f, 0.0f, 0.0f);
 
 	// Assign index count.
 	this->indexCount = indexCount;
 
 	// Assign values.
+	CalculateBounds(vertices, vertexCount);
+	CopyGeometry(vertices, vertexCount, indices, indexCount);
 	CreateVertexBuffer(vertices, vertexCount, device);
 	CreateIndexBuffer(indices, indexCount, device);
 }
@@ -52,6 +61,8 @@ Mesh::Mesh(char* filename,
 	// Initialize fields.
 	vertexBuffer = 0;
 	indexBuffer = 0;
+	id = nextID++;
+	boundingSphere = XMFLOAT4(0.0f, 0.0f, 0.0f, 0.0f);
 	
 	// File input object
 	std::ifstream obj(filename);
@@ -222,6 +233,8 @@ Mesh::Mesh(char* filename,
 	//    one, you'll need to write some extra code to handle cases when you don't.
 
 	// Call the helper methods.
+	CalculateBounds(&verts[0], vertCounter);
+	CopyGeometry(&verts[0], vertCounter, &indices[0], vertCounter);
 	CreateVertexBuffer(&verts[0], vertCounter, device);
 	CreateIndexBuffer(&indices[0], vertCounter, device);
 
@@ -274,6 +287,76 @@ unsigned int Mesh::GetIndexCount() const {
 	return indexCount;
 }
 
+/// <summary>
+/// Return this mesh's unique identifier.
+/// </summary>
+/// <returns>Return mesh ID.</returns>
+unsigned int Mesh::GetID() const {
+	return id;
+}
+
+/// <summary>
+/// Return the sphere enclosing the mesh, in local space.
+/// </summary>
+/// <returns>Return center (xyz) and radius (w).</returns>
+XMFLOAT4 Mesh::GetBoundingSphere() const {
+	return boundingSphere;
+}
+
+/// <summary>
+/// Return the CPU copy of the vertex positions.
+/// </summary>
+/// <returns>Return positions, in local space.</returns>
+const std::vector<XMFLOAT3>& Mesh::GetPositions() const {
+	return positions;
+}
+
+/// <summary>
+/// Return the CPU copy of the vertex normals.
+/// </summary>
+/// <returns>Return normals, in local space (same order as the positions).</returns>
+const std::vector<XMFLOAT3>& Mesh::GetNormals() const {
+	return normals;
+}
+
+/// <summary>
+/// Return the CPU copy of the indices.
+/// </summary>
+/// <returns>Return indices into the positions (three per triangle).</returns>
+const std::vector<unsigned int>& Mesh::GetIndices() const {
+	return indices;
+}
+
+// Detail levels.
+
+/// <summary>
+/// Add a coarser version of this mesh as the next detail level.
+/// </summary>
+/// <param name="level">Mesh with fewer triangles than the last level.</param>
+void Mesh::AddDetailLevel(const std::shared_ptr<Mesh>& level) {
+	if (level && level.get() != this)
+		detailLevels.push_back(level);
+}
+
+/// <summary>
+/// Return the number of detail levels, including this mesh.
+/// </summary>
+/// <returns>Return at least 1.</returns>
+unsigned int Mesh::GetDetailLevelCount() const {
+	return 1 + static_cast<unsigned int>(detailLevels.size());
+}
+
+/// <summary>
+/// Return a detail level of this mesh.
+/// </summary>
+/// <param name="level">0 for this mesh, higher for coarser ones.</param>
+/// <returns>Return the level, or the coarsest one if there are fewer levels.</returns>
+const Mesh* Mesh::GetDetailLevel(unsigned int level) const {
+	if (level == 0 || detailLevels.empty())
+		return this;
+	return (level <= detailLevels.size()) ? detailLevels[level - 1].get() : detailLevels.back().get();
+}
+
 // Helper functions.
 
 /// <summary>
@@ -331,4 +414,62 @@ void Mesh::CreateIndexBuffer(
 
 	// Create the actual buffer using the device. Pass items in by reference.
 	device->CreateBuffer(&desc, &initialData, &indexBuffer);
-}
\ No newline at end of file
+}
+
+/// <summary>
+/// Fits a sphere around the vertices: centered on their
+/// bounding box, with the radius of the farthest vertex.
+/// </summary>
+/// <param name="vertices">Vertex array.</param>
+/// <param name="count">Size of array.</param>
+void Mesh::CalculateBounds(
+	const Vertex* vertices,
+	unsigned int count) {
+
+	if (count == 0)
+		return;
+
+	XMVECTOR lower = XMLoadFloat3(&vertices[0].Position);
+	XMVECTOR upper = lower;
+	for (unsigned int i = 1; i < count; i++)
+	{
+		XMVECTOR position = XMLoadFloat3(&vertices[i].Position);
+		lower = XMVectorMin(lower, position);
+		upper = XMVectorMax(upper, position);
+	}
+
+	XMVECTOR center = XMVectorScale(XMVectorAdd(lower, upper), 0.5f);
+	XMVECTOR radiusSquared = XMVectorZero();
+	for (unsigned int i = 0; i < count; i++)
+	{
+		XMVECTOR offset = XMVectorSubtract(XMLoadFloat3(&vertices[i].Position), center);
+		radiusSquared = XMVectorMax(radiusSquared, XMVector3LengthSq(offset));
+	}
+
+	XMStoreFloat4(&boundingSphere, XMVectorSetW(center, XMVectorGetX(XMVectorSqrt(radiusSquared))));
+}
+
+/// <summary>
+/// Keeps the positions, normals and indices on the CPU, so the
+/// mesh can be rasterized as an occluder or drawn in software.
+/// </summary>
+/// <param name="vertices">Vertex array.</param>
+/// <param name="vertexCount">Size of vertex array.</param>
+/// <param name="indices">Index array.</param>
+/// <param name="indexCount">Size of index array.</param>
+void Mesh::CopyGeometry(
+	const Vertex* vertices,
+	unsigned int vertexCount,
+	const unsigned int* indices,
+	unsigned int indexCount) {
+
+	this->positions.resize(vertexCount);
+	this->normals.resize(vertexCount);
+	for (unsigned int i = 0; i < vertexCount; i++)
+	{
+		this->positions[i] = vertices[i].Position;
+		this->normals[i] = vertices[i].Normal;
+	}
+
+	this->indices.assign(indices, indices + indexCount);
+}
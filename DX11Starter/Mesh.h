@@ -2,6 +2,8 @@
 
 #include "Vertex.h"
 #include <d3d11.h>
+#include <memory>
+#include <vector>
 
 class Mesh
 {
@@ -20,17 +22,37 @@ public:
 	ID3D11Buffer* GetVertexBuffer() const;
 	ID3D11Buffer* GetIndexBuffer() const;
 	unsigned int GetIndexCount() const;
+	unsigned int GetID() const; // Unique per mesh, for sorting draws.
+	DirectX::XMFLOAT4 GetBoundingSphere() const; // Local space center (xyz) and radius (w), for culling.
+	const std::vector<DirectX::XMFLOAT3>& GetPositions() const; // CPU copy of the vertex positions, for occlusion culling.
+	const std::vector<DirectX::XMFLOAT3>& GetNormals() const; // CPU copy of the vertex normals, for software rendering.
+	const std::vector<unsigned int>& GetIndices() const; // CPU copy of the indices.
+
+	// Detail levels. Level 0 is this mesh; each added level is coarser than the last.
+	void AddDetailLevel(const std::shared_ptr<Mesh>& level);
+	unsigned int GetDetailLevelCount() const;
+	const Mesh* GetDetailLevel(unsigned int level) const; // Clamped to the coarsest level.
 
 private:
 
 	// Helper functions.
 	void CreateVertexBuffer(Vertex* vertices, unsigned int count, ID3D11Device* device);
 	void CreateIndexBuffer(unsigned int* indices, unsigned int count, ID3D11Device* device);
+	void CalculateBounds(const Vertex* vertices, unsigned int count);
+	void CopyGeometry(const Vertex* vertices, unsigned int vertexCount, const unsigned int* indices, unsigned int indexCount);
 
 	// Buffer pointers to hold geometry data.
 	ID3D11Buffer* vertexBuffer; // Stores vertices.
 	ID3D11Buffer* indexBuffer; // Stores winding order.
 	unsigned int indexCount; // Specifies amount of indices in the mesh's index buffer.
+	unsigned int id; // Unique identifier.
+	DirectX::XMFLOAT4 boundingSphere; // Encloses every vertex.
+	std::vector<DirectX::XMFLOAT3> positions; // Vertex positions kept on the CPU.
+	std::vector<DirectX::XMFLOAT3> normals; // Vertex normals kept on the CPU.
+	std::vector<unsigned int> indices; // Indices kept on the CPU.
+	std::vector<std::shared_ptr<Mesh>> detailLevels; // Coarser versions of this mesh (levels 1 and up).
+
+	static unsigned int nextID; // Identifier for the next mesh created.
 
 };
 
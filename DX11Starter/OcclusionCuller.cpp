@@ -0,0 +1,356 @@
+// -----------------------------------------------
+// Include statements.
+// -----------------------------------------------
+#include "OcclusionCuller.h"
+#include <algorithm>
+#include <cmath>
+#include <xmmintrin.h>
+
+// -----------------------------------------------
+// Namespace statements.
+// -----------------------------------------------
+using namespace DirectX;
+
+// -----------------------------------------------
+// Constants.
+// -----------------------------------------------
+
+// Clip space w below this is treated as crossing the near plane.
+static const float NEAR_W = 1e-4f;
+
+// Clamp a float to [low, high] before converting to int.
+static int ClampToInt(float value, int low, int high)
+{
+	if (!(value > (float)low)) return low; // Also catches NaN.
+	if (value > (float)high) return high;
+	return (int)value;
+}
+
+// -----------------------------------------------
+// Constructors.
+// -----------------------------------------------
+
+/// <summary>
+/// Allocate the buffers and start the worker threads.
+/// </summary>
+/// <param name="threadCount">Worker threads (see WorkerPool).</param>
+OcclusionCuller::OcclusionCuller(unsigned int threadCount)
+	: depth(WIDTH * HEIGHT, 1.0f), hierarchy(BLOCKS_X * BLOCKS_Y, 1.0f), stats{},
+	workers(threadCount)
+{
+	XMStoreFloat4x4(&viewProjection, XMMatrixIdentity());
+}
+
+/// <summary>
+/// Nothing to release; the worker pool joins its threads.
+/// </summary>
+OcclusionCuller::~OcclusionCuller() {}
+
+// -----------------------------------------------
+// Accessors.
+// -----------------------------------------------
+
+/// <summary>
+/// Occluders drawn and boxes tested since the last Begin().
+/// </summary>
+const OcclusionCuller::Statistics& OcclusionCuller::GetStatistics() const
+{
+	return stats;
+}
+
+/// <summary>
+/// The full resolution depth buffer (for debugging).
+/// </summary>
+const float* OcclusionCuller::GetDepthBuffer() const
+{
+	return depth.data();
+}
+
+/// <summary>
+/// Number of worker threads.
+/// </summary>
+unsigned int OcclusionCuller::GetThreadCount() const
+{
+	return workers.GetThreadCount();
+}
+
+// -----------------------------------------------
+// Service methods.
+// -----------------------------------------------
+
+/// <summary>
+/// Start a frame: clear the depth buffer and drop last frame's occluders.
+/// </summary>
+/// <param name="camera">View-projection matrix, as used with row vectors (not transposed).</param>
+void OcclusionCuller::Begin(const XMMATRIX& camera)
+{
+	XMStoreFloat4x4(&viewProjection, camera);
+
+	std::fill(depth.begin(), depth.end(), 1.0f);
+	std::fill(hierarchy.begin(), hierarchy.end(), 1.0f);
+	triangles.clear();
+	for (std::vector<unsigned int>& bin : bins)
+		bin.clear();
+	stats = {};
+}
+
+/// <summary>
+/// Transform an occluder's triangles to the screen and bin them.
+/// Nothing is drawn until Rasterize().
+/// </summary>
+/// <param name="positions">Vertex positions, in local space.</param>
+/// <param name="indices">Three indices per triangle.</param>
+/// <param name="indexCount">Number of indices.</param>
+/// <param name="world">World matrix (row vector, not transposed).</param>
+void OcclusionCuller::AddOccluder(const XMFLOAT3* positions, const unsigned int* indices, unsigned int indexCount, const XMMATRIX& world)
+{
+	XMMATRIX toClip = XMMatrixMultiply(world, XMLoadFloat4x4(&viewProjection));
+	stats.occluders++;
+
+	for (unsigned int i = 0; i + 2 < indexCount; i += 3)
+	{
+		XMFLOAT4 screen[3];
+		bool crossesNear = false;
+
+		for (unsigned int v = 0; v < 3; v++)
+		{
+			XMFLOAT4 clip;
+			XMStoreFloat4(&clip, XMVector3Transform(XMLoadFloat3(&positions[indices[i + v]]), toClip));
+			if (clip.w < NEAR_W)
+			{
+				crossesNear = true;
+				break;
+			}
+
+			// Normalized device coordinates to pixels (y down).
+			float inverseW = 1.0f / clip.w;
+			screen[v].x = (clip.x * inverseW * 0.5f + 0.5f) * WIDTH;
+			screen[v].y = (0.5f - clip.y * inverseW * 0.5f) * HEIGHT;
+			screen[v].z = clip.z * inverseW;
+			screen[v].w = 1.0f;
+		}
+
+		// Skipping (rather than clipping) only ever loses occlusion.
+		if (!crossesNear)
+			SetupTriangle(screen[0], screen[1], screen[2]);
+	}
+}
+
+/// <summary>
+/// Rasterize every binned triangle and build the Hi-Z, one
+/// task per tile.
+/// </summary>
+void OcclusionCuller::Rasterize()
+{
+	stats.triangles = (unsigned int)triangles.size();
+	workers.Run(TILE_COUNT, [this](unsigned int tile) { RasterizeTile(tile); });
+}
+
+/// <summary>
+/// Test a box against the Hi-Z. The box is hidden only if its
+/// nearest depth is behind the farthest depth of every block
+/// its screen rectangle touches.
+/// </summary>
+/// <param name="boxMin">Lower corner, in world space.</param>
+/// <param name="boxMax">Upper corner, in world space.</param>
+/// <returns>Returns false if the box is certainly hidden.</returns>
+bool OcclusionCuller::IsVisible(const XMFLOAT3& boxMin, const XMFLOAT3& boxMax)
+{
+	stats.tested++;
+	XMMATRIX toClip = XMLoadFloat4x4(&viewProjection);
+
+	float minX = (float)WIDTH, minY = (float)HEIGHT, minZ = 1.0f;
+	float maxX = 0.0f, maxY = 0.0f;
+
+	for (unsigned int corner = 0; corner < 8; corner++)
+	{
+		XMVECTOR position = XMVectorSet(
+			(corner & 1) ? boxMax.x : boxMin.x,
+			(corner & 2) ? boxMax.y : boxMin.y,
+			(corner & 4) ? boxMax.z : boxMin.z,
+			1.0f);
+
+		XMFLOAT4 clip;
+		XMStoreFloat4(&clip, XMVector4Transform(position, toClip));
+		if (clip.w < NEAR_W)
+			return true;
+
+		float inverseW = 1.0f / clip.w;
+		float x = (clip.x * inverseW * 0.5f + 0.5f) * WIDTH;
+		float y = (0.5f - clip.y * inverseW * 0.5f) * HEIGHT;
+		float z = clip.z * inverseW;
+
+		minX = fminf(minX, x); maxX = fmaxf(maxX, x);
+		minY = fminf(minY, y); maxY = fmaxf(maxY, y);
+		minZ = fminf(minZ, z);
+	}
+
+	// Off screen is the frustum culler's call, not ours.
+	if (maxX < 0.0f || maxY < 0.0f || minX >= (float)WIDTH || minY >= (float)HEIGHT)
+		return true;
+
+	int blockX0 = ClampToInt(minX, 0, WIDTH - 1) / BLOCK_SIZE;
+	int blockX1 = ClampToInt(maxX, 0, WIDTH - 1) / BLOCK_SIZE;
+	int blockY0 = ClampToInt(minY, 0, HEIGHT - 1) / BLOCK_SIZE;
+	int blockY1 = ClampToInt(maxY, 0, HEIGHT - 1) / BLOCK_SIZE;
+
+	for (int by = blockY0; by <= blockY1; by++)
+	{
+		const float* row = &hierarchy[by * BLOCKS_X];
+		for (int bx = blockX0; bx <= blockX1; bx++)
+		{
+			if (minZ <= row[bx])
+				return true;
+		}
+	}
+
+	stats.occluded++;
+	return false;
+}
+
+// -----------------------------------------------
+// Helper methods.
+// -----------------------------------------------
+
+/// <summary>
+/// Compute a triangle's edge functions, depth plane and pixel
+/// bounds, then bin it to every tile its bounds touch.
+/// </summary>
+/// <param name="a">First vertex, in pixels (xy) and depth (z).</param>
+/// <param name="b">Second vertex.</param>
+/// <param name="c">Third vertex.</param>
+void OcclusionCuller::SetupTriangle(const XMFLOAT4& a, const XMFLOAT4& b, const XMFLOAT4& c)
+{
+	// Occluders are drawn double sided, so make the
+	// winding consistent instead of culling back faces.
+	float area = (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x);
+	if (fabsf(area) < 1e-8f)
+		return;
+
+	const XMFLOAT4* v[3] = { &a, &b, &c };
+	if (area < 0.0f)
+	{
+		v[1] = &c;
+		v[2] = &b;
+		area = -area;
+	}
+
+	Triangle triangle;
+	for (int e = 0; e < 3; e++)
+	{
+		const XMFLOAT4& from = *v[e];
+		const XMFLOAT4& to = *v[(e + 1) % 3];
+		triangle.edgeA[e] = from.y - to.y;
+		triangle.edgeB[e] = to.x - from.x;
+		triangle.edgeC[e] = -(triangle.edgeA[e] * from.x + triangle.edgeB[e] * from.y);
+	}
+
+	// Depth is linear in screen space after the perspective divide.
+	float dx1 = v[1]->x - v[0]->x, dy1 = v[1]->y - v[0]->y, dz1 = v[1]->z - v[0]->z;
+	float dx2 = v[2]->x - v[0]->x, dy2 = v[2]->y - v[0]->y, dz2 = v[2]->z - v[0]->z;
+	triangle.depthX = (dz1 * dy2 - dz2 * dy1) / area;
+	triangle.depthY = (dz2 * dx1 - dz1 * dx2) / area;
+	triangle.depthC = v[0]->z - triangle.depthX * v[0]->x - triangle.depthY * v[0]->y;
+
+	float lowX = fminf(fminf(a.x, b.x), c.x), highX = fmaxf(fmaxf(a.x, b.x), c.x);
+	float lowY = fminf(fminf(a.y, b.y), c.y), highY = fmaxf(fmaxf(a.y, b.y), c.y);
+	if (highX < 0.0f || highY < 0.0f || lowX >= (float)WIDTH || lowY >= (float)HEIGHT)
+		return;
+
+	triangle.minX = ClampToInt(floorf(lowX), 0, WIDTH - 1);
+	triangle.maxX = ClampToInt(ceilf(highX), 0, WIDTH - 1);
+	triangle.minY = ClampToInt(floorf(lowY), 0, HEIGHT - 1);
+	triangle.maxY = ClampToInt(ceilf(highY), 0, HEIGHT - 1);
+
+	// Entirely behind the far plane - can't hide anything.
+	if (fminf(fminf(a.z, b.z), c.z) > 1.0f)
+		return;
+
+	unsigned int index = (unsigned int)triangles.size();
+	triangles.push_back(triangle);
+
+	for (int ty = triangle.minY / (int)TILE_HEIGHT; ty <= triangle.maxY / (int)TILE_HEIGHT; ty++)
+		for (int tx = triangle.minX / (int)TILE_WIDTH; tx <= triangle.maxX / (int)TILE_WIDTH; tx++)
+			bins[ty * TILES_X + tx].push_back(index);
+}
+
+/// <summary>
+/// Draw a tile's triangles, four pixels at a time, keeping
+/// the nearest depth. Then reduce the tile's blocks into
+/// the Hi-Z.
+/// </summary>
+/// <param name="tile">Tile index (row major).</param>
+void OcclusionCuller::RasterizeTile(unsigned int tile)
+{
+	const int tileX0 = (tile % TILES_X) * TILE_WIDTH;
+	const int tileY0 = (tile / TILES_X) * TILE_HEIGHT;
+	const int tileX1 = tileX0 + TILE_WIDTH - 1;
+	const int tileY1 = tileY0 + TILE_HEIGHT - 1;
+
+	const __m128 laneOffsets = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+	const __m128 zero = _mm_setzero_ps();
+
+	for (unsigned int index : bins[tile])
+	{
+		const Triangle& triangle = triangles[index];
+
+		// Start on a multiple of four; tiles are too, so
+		// every group of four stays inside the tile.
+		int x0 = (triangle.minX > tileX0 ? triangle.minX : tileX0) & ~3;
+		int x1 = triangle.maxX < tileX1 ? triangle.maxX : tileX1;
+		int y0 = triangle.minY > tileY0 ? triangle.minY : tileY0;
+		int y1 = triangle.maxY < tileY1 ? triangle.maxY : tileY1;
+
+		__m128 edgeA[3];
+		for (int e = 0; e < 3; e++)
+			edgeA[e] = _mm_set1_ps(triangle.edgeA[e]);
+		__m128 depthX = _mm_set1_ps(triangle.depthX);
+
+		for (int y = y0; y <= y1; y++)
+		{
+			float pixelY = (float)y + 0.5f;
+			__m128 edgeRow[3];
+			for (int e = 0; e < 3; e++)
+				edgeRow[e] = _mm_set1_ps(triangle.edgeB[e] * pixelY + triangle.edgeC[e]);
+			__m128 depthRow = _mm_set1_ps(triangle.depthY * pixelY + triangle.depthC);
+
+			float* row = &depth[y * WIDTH];
+			for (int x = x0; x <= x1; x += 4)
+			{
+				__m128 pixelX = _mm_add_ps(_mm_set1_ps((float)x), laneOffsets);
+
+				__m128 inside = _mm_and_ps(
+					_mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(edgeA[0], pixelX), edgeRow[0]), zero),
+					_mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(edgeA[1], pixelX), edgeRow[1]), zero));
+				inside = _mm_and_ps(inside,
+					_mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(edgeA[2], pixelX), edgeRow[2]), zero));
+				if (_mm_movemask_ps(inside) == 0)
+					continue;
+
+				__m128 pixelDepth = _mm_add_ps(_mm_mul_ps(depthX, pixelX), depthRow);
+				__m128 current = _mm_loadu_ps(row + x);
+				__m128 nearest = _mm_min_ps(current, pixelDepth);
+				_mm_storeu_ps(row + x, _mm_or_ps(_mm_and_ps(inside, nearest), _mm_andnot_ps(inside, current)));
+			}
+		}
+	}
+
+	// Hi-Z: the farthest depth in each block of this tile.
+	for (int by = tileY0 / (int)BLOCK_SIZE; by <= tileY1 / (int)BLOCK_SIZE; by++)
+	{
+		for (int bx = tileX0 / (int)BLOCK_SIZE; bx <= tileX1 / (int)BLOCK_SIZE; bx++)
+		{
+			__m128 farthest = zero;
+			for (unsigned int y = 0; y < BLOCK_SIZE; y++)
+			{
+				const float* row = &depth[(by * BLOCK_SIZE + y) * WIDTH + bx * BLOCK_SIZE];
+				for (unsigned int x = 0; x < BLOCK_SIZE; x += 4)
+					farthest = _mm_max_ps(farthest, _mm_loadu_ps(row + x));
+			}
+
+			float lanes[4];
+			_mm_storeu_ps(lanes, farthest);
+			hierarchy[by * BLOCKS_X + bx] = fmaxf(fmaxf(lanes[0], lanes[1]), fmaxf(lanes[2], lanes[3]));
+		}
+	}
+}
@@ -0,0 +1,126 @@
+#pragma once
+
+// -----------------------------------------------
+// Include statements.
+// -----------------------------------------------
+#include "WorkerPool.h"
+#include <DirectXMath.h>
+#include <vector>
+
+// -----------------------------------------------
+// OcclusionCuller.h
+// ---
+// Software occlusion culling. A few large meshes
+// (occluders) are rasterized on the CPU into a
+// small depth buffer, then bounding boxes are
+// tested against a coarse max-depth copy of it
+// (the hierarchical depth, or "Hi-Z"). A box
+// whose nearest point is behind everything drawn
+// over its screen rectangle can't be seen.
+//
+// The screen is split into tiles. Triangles are
+// binned to the tiles they touch, then the tiles
+// are rasterized in parallel (4 pixels at a time
+// with SSE) on a WorkerPool.
+// Each tile only writes its own pixels, so the
+// workers never need to lock.
+//
+// Everything errs towards "visible": triangles
+// crossing the near plane are skipped rather than
+// clipped, and boxes crossing it always pass.
+// -----------------------------------------------
+
+class OcclusionCuller
+{
+public:
+	// -----------------------------------------------
+	// Internal structs.
+	// -----------------------------------------------
+
+	/// <summary>
+	/// Counts from the last frame.
+	/// </summary>
+	struct Statistics
+	{
+		unsigned int occluders;
+		unsigned int triangles;		// Triangles that reached the tiles.
+		unsigned int tested;
+		unsigned int occluded;
+	};
+
+	// Depth buffer size, in pixels.
+	static const unsigned int WIDTH = 256;
+	static const unsigned int HEIGHT = 128;
+
+	// Tiles are rasterized independently.
+	static const unsigned int TILE_WIDTH = 32;
+	static const unsigned int TILE_HEIGHT = 32;
+	static const unsigned int TILES_X = WIDTH / TILE_WIDTH;
+	static const unsigned int TILES_Y = HEIGHT / TILE_HEIGHT;
+	static const unsigned int TILE_COUNT = TILES_X * TILES_Y;
+
+	// Each Hi-Z texel holds the farthest depth of a block of pixels.
+	static const unsigned int BLOCK_SIZE = 8;
+	static const unsigned int BLOCKS_X = WIDTH / BLOCK_SIZE;
+	static const unsigned int BLOCKS_Y = HEIGHT / BLOCK_SIZE;
+
+	// -----------------------------------------------
+	// Constructors.
+	// -----------------------------------------------
+
+	OcclusionCuller(unsigned int threadCount = WorkerPool::DEFAULT_THREADS);	// 0 rasterizes on the calling thread only.
+	~OcclusionCuller();
+
+	// -----------------------------------------------
+	// Accessors.
+	// -----------------------------------------------
+
+	const Statistics& GetStatistics() const;
+	const float* GetDepthBuffer() const;	// WIDTH x HEIGHT, row major. 1 is the far plane.
+	unsigned int GetThreadCount() const;	// Worker threads, not counting the caller.
+
+	// -----------------------------------------------
+	// Service methods.
+	// -----------------------------------------------
+
+	void Begin(const DirectX::XMMATRIX& viewProjection);	// Clear, and set the camera (row vector, not transposed).
+	void AddOccluder(const DirectX::XMFLOAT3* positions, const unsigned int* indices, unsigned int indexCount, const DirectX::XMMATRIX& world);
+	void Rasterize();	// Draw every added occluder and build the Hi-Z.
+	bool IsVisible(const DirectX::XMFLOAT3& boxMin, const DirectX::XMFLOAT3& boxMax);	// World space box.
+
+private:
+
+	// -----------------------------------------------
+	// Internal structs.
+	// -----------------------------------------------
+
+	/// <summary>
+	/// A screen space triangle, set up for rasterizing.
+	/// </summary>
+	struct Triangle
+	{
+		float edgeA[3], edgeB[3], edgeC[3];	// Edge functions: A*x + B*y + C >= 0 inside.
+		float depthX, depthY, depthC;		// Depth plane: z = depthX*x + depthY*y + depthC.
+		int minX, minY, maxX, maxY;			// Pixel bounds, clamped to the screen.
+	};
+
+	// -----------------------------------------------
+	// Data members.
+	// -----------------------------------------------
+
+	DirectX::XMFLOAT4X4 viewProjection;
+	std::vector<float> depth;		// WIDTH x HEIGHT.
+	std::vector<float> hierarchy;	// BLOCKS_X x BLOCKS_Y, farthest depth per block.
+	std::vector<Triangle> triangles;
+	std::vector<unsigned int> bins[TILE_COUNT];	// Triangles touching each tile.
+	Statistics stats;
+
+	WorkerPool workers;
+
+	// -----------------------------------------------
+	// Helper methods.
+	// -----------------------------------------------
+
+	void SetupTriangle(const DirectX::XMFLOAT4& a, const DirectX::XMFLOAT4& b, const DirectX::XMFLOAT4& c);
+	void RasterizeTile(unsigned int tile);
+};
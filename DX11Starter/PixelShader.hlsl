@@ -13,6 +13,7 @@ struct VertexToPixel
 	//  v    v                v
 	float4 position		: SV_POSITION;
 	float3 normal		: NORMAL;
+	float4 surface		: COLOR;
 };
 
 struct DirectionalLight
@@ -32,12 +33,15 @@ struct DirectionalLight
 //    which will (eventually) hold data from our C++ code
 // - All non-pipeline variables that get their values from 
 //    our C++ code must be defined inside a Constant Buffer
-// - The name of the cbuffer itself is unimportant
-cbuffer externalData : register(b0)
+// - Buffers are split by how often their data changes, so
+//    each one is only copied to the GPU when it has to be
+//    (the C++ code refers to them by these names)
+//  - The surface color comes from the vertex shader, so this
+//    shader works for both per-object and instanced draws
+cbuffer perFrame : register(b0)
 {
 	DirectionalLight light1;
 	DirectionalLight light2;
-	float4 surface;
 };
 
 float4 calculateLight(DirectionalLight light, float3 norm) 
@@ -67,7 +71,7 @@ float4 main(VertexToPixel input) : SV_TARGET
 	float4 firstLight = calculateLight(light1, input.normal);
 	float4 secondLight = calculateLight(light2, input.normal);
 	float4 finalColor = firstLight + secondLight;
-	float4 surfaceColor = normalize(finalColor) * normalize(surface);
+	float4 surfaceColor = normalize(finalColor) * normalize(input.surface);
 	
 	// Just return the input color
 	// - This color (like most values passing through the rasterizer) is 
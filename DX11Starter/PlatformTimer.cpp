@@ -0,0 +1,178 @@
+// -----------------------------------------------
+// Include statements.
+// -----------------------------------------------
+#include "PlatformTimer.h"
+#include <algorithm>
+#include <chrono>
+
+// -----------------------------------------------
+// Constructors.
+// -----------------------------------------------
+
+/// <summary>
+/// Initializes a real time timer.
+/// </summary>
+PlatformTimer::PlatformTimer()
+	: fixedStep{ 0.0f }, fixedFrames{ 0 },
+	deltaTime{ 0.0f }, totalTime{ 0.0f }
+{
+	this->Start();
+}
+
+// -----------------------------------------------
+// Static methods.
+// -----------------------------------------------
+
+/// <summary>
+/// Current time of the steady clock.
+/// </summary>
+/// <returns>Returns raw timestamp.</returns>
+PlatformTimer::Timestamp PlatformTimer::Now()
+{
+	return static_cast<Timestamp>(std::chrono::steady_clock::now().time_since_epoch().count());
+}
+
+/// <summary>
+/// Convert the difference between two timestamps to seconds.
+/// </summary>
+/// <param name="start">Earlier timestamp.</param>
+/// <param name="end">Later timestamp.</param>
+/// <returns>Returns seconds.</returns>
+double PlatformTimer::SecondsBetween(Timestamp start, Timestamp end)
+{
+	typedef std::chrono::steady_clock::period Period;
+	return static_cast<double>(end - start) * Period::num / Period::den;
+}
+
+/// <summary>
+/// Convert a duration in seconds to clock ticks.
+/// </summary>
+/// <param name="seconds">Duration.</param>
+/// <returns>Returns duration in ticks.</returns>
+PlatformTimer::Timestamp PlatformTimer::TicksFromSeconds(double seconds)
+{
+	typedef std::chrono::steady_clock::period Period;
+	return static_cast<Timestamp>(seconds * Period::den / Period::num);
+}
+
+/// <summary>
+/// Milliseconds elapsed between a timestamp and now.
+/// </summary>
+/// <param name="start">Earlier timestamp.</param>
+/// <returns>Returns milliseconds.</returns>
+float PlatformTimer::MillisecondsSince(Timestamp start)
+{
+	return static_cast<float>(SecondsBetween(start, Now()) * 1000.0);
+}
+
+// -----------------------------------------------
+// Accessors.
+// -----------------------------------------------
+
+/// <summary>
+/// Duration of the last frame, in seconds.
+/// </summary>
+float PlatformTimer::GetDeltaTime() const
+{
+	return deltaTime;
+}
+
+/// <summary>
+/// Wall clock duration of the last frame, in seconds.
+/// Differs from GetDeltaTime() only on a fixed step.
+/// </summary>
+float PlatformTimer::GetRealDeltaTime() const
+{
+	return realDeltaTime;
+}
+
+/// <summary>
+/// Time since Start(), in seconds.
+/// </summary>
+float PlatformTimer::GetTotalTime() const
+{
+	return totalTime;
+}
+
+/// <summary>
+/// Wall clock timestamp of the last Tick().
+/// </summary>
+PlatformTimer::Timestamp PlatformTimer::GetFrameTimestamp() const
+{
+	return currentTime;
+}
+
+/// <summary>
+/// Is the timer advancing in fixed steps?
+/// </summary>
+bool PlatformTimer::IsFixedStep() const
+{
+	return fixedStep > 0.0f;
+}
+
+// -----------------------------------------------
+// Mutators.
+// -----------------------------------------------
+
+/// <summary>
+/// Advance by a constant step every Tick() instead of by wall clock time.
+/// </summary>
+/// <param name="seconds">Step length, or zero for real time.</param>
+void PlatformTimer::SetFixedStep(float seconds)
+{
+	fixedStep = std::max(seconds, 0.0f);
+}
+
+// -----------------------------------------------
+// Service methods.
+// -----------------------------------------------
+
+/// <summary>
+/// Starts the clock from zero.
+/// </summary>
+void PlatformTimer::Start()
+{
+	startTime = Now();
+	previousTime = startTime;
+	currentTime = startTime;
+	fixedFrames = 0;
+	deltaTime = 0.0f;
+	realDeltaTime = 0.0f;
+	totalTime = 0.0f;
+}
+
+/// <summary>
+/// Forget the time elapsed since the last Tick(), so
+/// long loads don't show up as one enormous frame.
+/// </summary>
+void PlatformTimer::Restart()
+{
+	previousTime = Now();
+}
+
+/// <summary>
+/// Advance the timer one frame.
+/// </summary>
+void PlatformTimer::Tick()
+{
+	currentTime = Now();
+
+	// Clamp to zero - could go negative if CPU goes into power
+	// save mode or the process itself gets moved to another core.
+	realDeltaTime = std::max(static_cast<float>(SecondsBetween(previousTime, currentTime)), 0.0f);
+
+	if (IsFixedStep())
+	{
+		// Deterministic: identical times on every run.
+		fixedFrames++;
+		deltaTime = fixedStep;
+		totalTime = static_cast<float>(fixedFrames * static_cast<double>(fixedStep));
+	}
+	else
+	{
+		deltaTime = realDeltaTime;
+		totalTime = static_cast<float>(SecondsBetween(startTime, currentTime));
+	}
+
+	previousTime = currentTime;
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+// -----------------------------------------------
+// PlatformTimer.h
+// ---
+// High resolution game loop timer. Uses the
+// standard steady clock so it has no OS-specific
+// dependencies, and can run on a fixed step so
+// headless runs are deterministic.
+// -----------------------------------------------
+
+class PlatformTimer
+{
+public:
+
+	// -----------------------------------------------
+	// Internal typedef statements.
+	// -----------------------------------------------
+
+	/// <summary>
+	/// Raw timestamp, in clock ticks.
+	/// </summary>
+	typedef long long Timestamp;
+
+	// -----------------------------------------------
+	// Constructors.
+	// -----------------------------------------------
+
+	PlatformTimer();
+
+	// -----------------------------------------------
+	// Static methods.
+	// -----------------------------------------------
+
+	static Timestamp Now();
+	static double SecondsBetween(Timestamp start, Timestamp end);
+	static Timestamp TicksFromSeconds(double seconds);
+	static float MillisecondsSince(Timestamp start);
+
+	// -----------------------------------------------
+	// Accessors.
+	// -----------------------------------------------
+
+	float GetDeltaTime() const;
+	float GetRealDeltaTime() const; // Wall clock, even on a fixed step.
+	float GetTotalTime() const;
+	Timestamp GetFrameTimestamp() const;
+	bool IsFixedStep() const;
+
+	// -----------------------------------------------
+	// Mutators.
+	// -----------------------------------------------
+
+	void SetFixedStep(float seconds); // Zero returns to real time.
+
+	// -----------------------------------------------
+	// Service methods.
+	// -----------------------------------------------
+
+	void Start();		// Starts the clock from zero.
+	void Restart();		// Forgets the time since the last Tick() (e.g. after loading).
+	void Tick();		// Advances one frame.
+
+private:
+
+	// -----------------------------------------------
+	// Data members.
+	// -----------------------------------------------
+
+	Timestamp startTime;
+	Timestamp previousTime;
+	Timestamp currentTime;
+
+	float fixedStep;
+	unsigned long long fixedFrames;
+
+	float deltaTime;
+	float realDeltaTime;
+	float totalTime;
+};
@@ -0,0 +1,701 @@
+#include "RenderBackend.h"
+#include "RenderCounters.h"
+#include "SimpleShader.h"
+#include <d3d11_1.h>
+#include <cstring>
+
+///////////////////////////////////////////////////////////////////////////////
+// ------ BASE RENDER BACKEND -------------------------------------------------
+///////////////////////////////////////////////////////////////////////////////
+
+// --------------------------------------------------------
+// Constructor - start with empty statistics
+// --------------------------------------------------------
+IRenderBackend::IRenderBackend()
+{
+	occluded = false;
+	ResetStatistics();
+}
+
+// --------------------------------------------------------
+// Destructor
+// --------------------------------------------------------
+IRenderBackend::~IRenderBackend() { }
+
+// --------------------------------------------------------
+// Zeroes the running totals
+// --------------------------------------------------------
+void IRenderBackend::ResetStatistics()
+{
+	stats = {};
+}
+
+// --------------------------------------------------------
+// Copies the changed part of a constant buffer's data to
+// the GPU.  Backends that can't update part of a buffer
+// copy all of it, which is what this default does
+//
+// data  - The whole buffer's data
+// size  - The size of the whole buffer
+// begin - First changed byte (a multiple of 16)
+// end   - One past the last changed byte
+//
+// Returns the bytes copied
+// --------------------------------------------------------
+unsigned int IRenderBackend::UpdateConstantRange(ID3D11Buffer* buffer, const void* data, unsigned int size, unsigned int begin, unsigned int end)
+{
+	UpdateConstantBuffer(buffer, data, size);
+	return size;
+}
+
+// --------------------------------------------------------
+// Copies a shader's constant buffer to the GPU, but only
+// if its local data changed since the last copy - and then
+// only the bytes that changed, where the backend can
+//
+// Returns true if the buffer was copied
+// --------------------------------------------------------
+bool IRenderBackend::UploadConstants(ISimpleShader* shader, const std::string& bufferName)
+{
+	if (!shader)
+		return false;
+
+	int index = shader->GetBufferIndex(bufferName);
+	return index >= 0 && UploadConstants(shader, (unsigned int)index);
+}
+
+// --------------------------------------------------------
+// Same as above, with the buffer given by its index (see
+// ISimpleShader::GetBufferIndex), so no name is looked up
+// --------------------------------------------------------
+bool IRenderBackend::UploadConstants(ISimpleShader* shader, unsigned int bufferIndex)
+{
+	if (!shader || !shader->IsBufferDirty(bufferIndex))
+		return false;
+
+	// Count what the backend copied, which is the whole buffer
+	// unless it does partial updates
+	const SimpleConstantBuffer* cb = shader->GetBufferInfo(bufferIndex);
+	unsigned int bytes = UpdateConstantRange(cb->ConstantBuffer, cb->LocalDataBuffer, cb->Size, cb->DirtyBegin, cb->DirtyEnd);
+	RenderCounters::Add(RenderCounters::RC_CONSTANT_BYTES, bytes);
+	shader->MarkBufferClean(bufferIndex);
+	return true;
+}
+
+// --------------------------------------------------------
+// Writes a vertex shader's per-draw constants and binds
+// them to the buffer's slot.  Unlike UploadConstants() this
+// always writes, since backends with a constant ring bind a
+// new slice of it each time - so bind the shader first
+//
+// Returns false if the shader has no such buffer
+// --------------------------------------------------------
+bool IRenderBackend::WriteConstants(SimpleVertexShader* shader, const std::string& bufferName)
+{
+	if (!shader)
+		return false;
+
+	int index = shader->GetBufferIndex(bufferName);
+	return index >= 0 && WriteConstants(shader, (unsigned int)index);
+}
+
+// --------------------------------------------------------
+// Same as above, with the buffer given by its index (see
+// ISimpleShader::GetBufferIndex) - the per-draw path, so
+// no name is looked up
+// --------------------------------------------------------
+bool IRenderBackend::WriteConstants(SimpleVertexShader* shader, unsigned int bufferIndex)
+{
+	if (!shader)
+		return false;
+
+	const SimpleConstantBuffer* cb = shader->GetBufferInfo(bufferIndex);
+	if (!cb)
+		return false;
+
+	WriteVSConstants(cb->BindIndex, cb->ConstantBuffer, cb->LocalDataBuffer, cb->Size);
+	RenderCounters::Add(RenderCounters::RC_CONSTANT_BYTES, cb->Size);
+	shader->MarkBufferClean(bufferIndex);
+	return true;
+}
+
+// --------------------------------------------------------
+// Binds a vertex shader, its input layout and its constant
+// buffers - what SimpleVertexShader::SetShader() does, but
+// through the backend so the calls are counted (and can
+// be filtered)
+// --------------------------------------------------------
+void IRenderBackend::BindShader(SimpleVertexShader* shader)
+{
+	if (!shader || !shader->IsShaderValid())
+		return;
+
+	SetInputLayout(shader->GetInputLayout());
+	SetVertexShader(shader->GetDirectXShader());
+
+	for (unsigned int i = 0; i < shader->GetBufferCount(); i++)
+	{
+		// Skip "buffers" that aren't true constant buffers
+		const SimpleConstantBuffer* cb = shader->GetBufferInfo(i);
+		if (cb->Type == D3D11_CT_CBUFFER)
+			SetVSConstantBuffer(cb->BindIndex, cb->ConstantBuffer);
+	}
+}
+
+// --------------------------------------------------------
+// Binds a pixel shader and its constant buffers
+// --------------------------------------------------------
+void IRenderBackend::BindShader(SimplePixelShader* shader)
+{
+	if (!shader || !shader->IsShaderValid())
+		return;
+
+	SetPixelShader(shader->GetDirectXShader());
+
+	for (unsigned int i = 0; i < shader->GetBufferCount(); i++)
+	{
+		const SimpleConstantBuffer* cb = shader->GetBufferInfo(i);
+		if (cb->Type == D3D11_CT_CBUFFER)
+			SetPSConstantBuffer(cb->BindIndex, cb->ConstantBuffer);
+	}
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// ------ D3D11 RENDER BACKEND ------------------------------------------------
+///////////////////////////////////////////////////////////////////////////////
+
+// --------------------------------------------------------
+// Constructor - the backend does not own the context or
+// swap chain, DXCore releases them
+// --------------------------------------------------------
+D3D11RenderBackend::D3D11RenderBackend(ID3D11DeviceContext* context, IDXGISwapChain* swapChain)
+	: IRenderBackend()
+{
+	this->context = context;
+	this->swapChain = swapChain;
+
+	device = 0;
+	context1 = 0;
+	partialConstantUpdates = false;
+	constantRing = 0;
+	frameFence = 0;
+	CreateConstantRing();
+}
+
+// --------------------------------------------------------
+// Destructor - releases the constant ring and its queries
+// --------------------------------------------------------
+D3D11RenderBackend::~D3D11RenderBackend()
+{
+	for (auto& fence : fences)
+		fence.second->Release();
+	for (ID3D11Query* query : freeFences)
+		query->Release();
+	fences.clear();
+	freeFences.clear();
+
+	if (constantRing) { constantRing->Release(); constantRing = 0; }
+	if (context1) { context1->Release(); context1 = 0; }
+	if (device) { device->Release(); device = 0; }
+
+	context = 0;
+	swapChain = 0;
+}
+
+// --------------------------------------------------------
+// Clears the render target and depth buffer
+// --------------------------------------------------------
+void D3D11RenderBackend::Clear(ID3D11RenderTargetView* renderTarget, ID3D11DepthStencilView* depthStencil, const float color[4])
+{
+	stats.clears++;
+	if (renderTarget)
+		context->ClearRenderTargetView(renderTarget, color);
+	if (depthStencil)
+		context->ClearDepthStencilView(depthStencil, D3D11_CLEAR_DEPTH | D3D11_CLEAR_STENCIL, 1.0f, 0);
+}
+
+// --------------------------------------------------------
+// Sets the input assembler's primitive topology
+// --------------------------------------------------------
+void D3D11RenderBackend::SetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY topology)
+{
+	stats.topologyChanges++;
+	RenderCounters::Add(RenderCounters::RC_STATE_CHANGES);
+	context->IASetPrimitiveTopology(topology);
+}
+
+// --------------------------------------------------------
+// Binds the input layout
+// --------------------------------------------------------
+void D3D11RenderBackend::SetInputLayout(ID3D11InputLayout* layout)
+{
+	stats.inputLayoutBinds++;
+	RenderCounters::Add(RenderCounters::RC_STATE_CHANGES);
+	context->IASetInputLayout(layout);
+}
+
+// --------------------------------------------------------
+// Binds the vertex shader
+// --------------------------------------------------------
+void D3D11RenderBackend::SetVertexShader(ID3D11VertexShader* shader)
+{
+	stats.shaderBinds++;
+	RenderCounters::Add(RenderCounters::RC_STATE_CHANGES);
+	context->VSSetShader(shader, 0, 0);
+}
+
+// --------------------------------------------------------
+// Binds the pixel shader
+// --------------------------------------------------------
+void D3D11RenderBackend::SetPixelShader(ID3D11PixelShader* shader)
+{
+	stats.shaderBinds++;
+	RenderCounters::Add(RenderCounters::RC_STATE_CHANGES);
+	context->PSSetShader(shader, 0, 0);
+}
+
+// --------------------------------------------------------
+// Binds a constant buffer to a vertex shader slot
+// --------------------------------------------------------
+void D3D11RenderBackend::SetVSConstantBuffer(unsigned int slot, ID3D11Buffer* buffer)
+{
+	stats.constantBufferBinds++;
+	RenderCounters::Add(RenderCounters::RC_STATE_CHANGES);
+	context->VSSetConstantBuffers(slot, 1, &buffer);
+}
+
+// --------------------------------------------------------
+// Binds a constant buffer to a pixel shader slot
+// --------------------------------------------------------
+void D3D11RenderBackend::SetPSConstantBuffer(unsigned int slot, ID3D11Buffer* buffer)
+{
+	stats.constantBufferBinds++;
+	RenderCounters::Add(RenderCounters::RC_STATE_CHANGES);
+	context->PSSetConstantBuffers(slot, 1, &buffer);
+}
+
+// --------------------------------------------------------
+// Binds a single vertex buffer to slot 0
+// --------------------------------------------------------
+void D3D11RenderBackend::SetVertexBuffer(ID3D11Buffer* buffer, unsigned int stride, unsigned int offset)
+{
+	stats.vertexBufferBinds++;
+	RenderCounters::Add(RenderCounters::RC_STATE_CHANGES);
+	context->IASetVertexBuffers(0, 1, &buffer, &stride, &offset);
+}
+
+// --------------------------------------------------------
+// Binds the index buffer
+// --------------------------------------------------------
+void D3D11RenderBackend::SetIndexBuffer(ID3D11Buffer* buffer, DXGI_FORMAT format, unsigned int offset)
+{
+	stats.indexBufferBinds++;
+	RenderCounters::Add(RenderCounters::RC_STATE_CHANGES);
+	context->IASetIndexBuffer(buffer, format, offset);
+}
+
+// --------------------------------------------------------
+// Issues an indexed draw
+// --------------------------------------------------------
+void D3D11RenderBackend::DrawIndexed(unsigned int indexCount, unsigned int startIndex, int baseVertex)
+{
+	stats.draws++;
+	stats.indices += indexCount;
+	context->DrawIndexed(indexCount, startIndex, baseVertex);
+}
+
+// --------------------------------------------------------
+// Binds the per-instance vertex buffer to slot 1
+// --------------------------------------------------------
+void D3D11RenderBackend::SetInstanceBuffer(ID3D11Buffer* buffer, unsigned int stride, unsigned int offset)
+{
+	stats.instanceBufferBinds++;
+	RenderCounters::Add(RenderCounters::RC_STATE_CHANGES);
+	context->IASetVertexBuffers(1, 1, &buffer, &stride, &offset);
+}
+
+// --------------------------------------------------------
+// Issues an instanced indexed draw
+// --------------------------------------------------------
+void D3D11RenderBackend::DrawIndexedInstanced(unsigned int indexCount, unsigned int instanceCount, unsigned int startIndex, int baseVertex, unsigned int startInstance)
+{
+	stats.draws++;
+	stats.instancedDraws++;
+	stats.instances += instanceCount;
+	stats.indices += (unsigned long long)indexCount * instanceCount;
+	context->DrawIndexedInstanced(indexCount, instanceCount, startIndex, baseVertex, startInstance);
+}
+
+// --------------------------------------------------------
+// Replaces the contents of a dynamic buffer
+//  - WRITE_DISCARD hands back fresh memory, so the GPU can
+//    keep reading the old contents without a stall
+// --------------------------------------------------------
+void D3D11RenderBackend::UpdateDynamicBuffer(ID3D11Buffer* buffer, const void* data, unsigned int size)
+{
+	D3D11_MAPPED_SUBRESOURCE mapped = {};
+	if (FAILED(context->Map(buffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped)))
+		return;
+
+	stats.dynamicBufferUpdates++;
+	stats.dynamicBytes += size;
+	memcpy(mapped.pData, data, size);
+	context->Unmap(buffer, 0);
+}
+
+// --------------------------------------------------------
+// Copies a whole constant buffer's data to the GPU
+// --------------------------------------------------------
+void D3D11RenderBackend::UpdateConstantBuffer(ID3D11Buffer* buffer, const void* data, unsigned int size)
+{
+	stats.constantBufferUpdates++;
+	stats.constantBytes += size;
+	context->UpdateSubresource(buffer, 0, 0, data, 0, 0);
+}
+
+// --------------------------------------------------------
+// Copies only the changed bytes of a constant buffer, if
+// the driver supports partial constant buffer updates
+// (Direct3D 11.1) - otherwise the whole buffer
+//
+// Returns the bytes copied
+// --------------------------------------------------------
+unsigned int D3D11RenderBackend::UpdateConstantRange(ID3D11Buffer* buffer, const void* data, unsigned int size, unsigned int begin, unsigned int end)
+{
+	if (!partialConstantUpdates || (begin == 0 && end >= size))
+	{
+		UpdateConstantBuffer(buffer, data, size);
+		return size;
+	}
+
+	// The source pointer is where the box starts
+	D3D11_BOX box = {};
+	box.left = begin;
+	box.right = end;
+	box.bottom = 1;
+	box.back = 1;
+
+	stats.constantBufferUpdates++;
+	stats.constantBytes += end - begin;
+	context1->UpdateSubresource1(buffer, 0, &box, (const unsigned char*)data + begin, 0, 0, 0);
+	return end - begin;
+}
+
+// --------------------------------------------------------
+// Writes per-draw constants to the next slice of the
+// constant ring and binds that slice to the slot
+//  - NO_OVERWRITE appends without the driver copying or
+//    versioning anything; the ring asks for DISCARD only
+//    on its first write or when it runs into data the GPU
+//    may still be reading
+//  - Without a ring (no 11.1 offsets), falls back to
+//    copying into the shader's own buffer
+// --------------------------------------------------------
+void D3D11RenderBackend::WriteVSConstants(unsigned int slot, ID3D11Buffer* buffer, const void* data, unsigned int size)
+{
+	unsigned int offset = 0;
+	RingAllocator::RingMap map;
+	if (constantRing && ring.Allocate(size, &offset, &map))
+	{
+		D3D11_MAP mapType = (map == RingAllocator::RM_DISCARD) ? D3D11_MAP_WRITE_DISCARD : D3D11_MAP_WRITE_NO_OVERWRITE;
+		D3D11_MAPPED_SUBRESOURCE mapped = {};
+		if (SUCCEEDED(context->Map(constantRing, 0, mapType, 0, &mapped)))
+		{
+			memcpy((unsigned char*)mapped.pData + offset, data, size);
+			context->Unmap(constantRing, 0);
+
+			// Offsets and sizes are in 16 byte constants, and the
+			// ring keeps both on 256 byte (16 constant) boundaries.
+			// Some runtimes ignore a rebind of the same buffer at a
+			// new offset, so the slot is cleared first.
+			UINT firstConstant = offset / 16;
+			UINT constantCount = ((size + 255) & ~255u) / 16;
+			ID3D11Buffer* none = 0;
+			context1->VSSetConstantBuffers(slot, 1, &none);
+			context1->VSSetConstantBuffers1(slot, 1, &constantRing, &firstConstant, &constantCount);
+
+			stats.ringConstantWrites++;
+			stats.ringConstantBytes += size;
+			stats.constantBufferBinds++;
+			RenderCounters::Add(RenderCounters::RC_STATE_CHANGES);
+			return;
+		}
+	}
+
+	UpdateConstantBuffer(buffer, data, size);
+	SetVSConstantBuffer(slot, buffer);
+}
+
+// --------------------------------------------------------
+// Presents the back buffer, noting whether the window was
+// occluded.  DXGI_PRESENT_TEST only checks for occlusion
+// and isn't counted as a frame.
+// --------------------------------------------------------
+HRESULT D3D11RenderBackend::Present(unsigned int syncInterval, unsigned int flags)
+{
+	if (!(flags & DXGI_PRESENT_TEST))
+	{
+		stats.frames++;
+		EndFrame();
+	}
+
+	HRESULT hr = swapChain->Present(syncInterval, flags);
+	occluded = (hr == DXGI_STATUS_OCCLUDED);
+	return hr;
+}
+
+// --------------------------------------------------------
+// Creates the constant ring, if the device can bind
+// constant buffers at an offset and map them with
+// NO_OVERWRITE (Direct3D 11.1 runtime and driver)
+// --------------------------------------------------------
+void D3D11RenderBackend::CreateConstantRing()
+{
+	context->GetDevice(&device);
+	if (FAILED(context->QueryInterface(__uuidof(ID3D11DeviceContext1), (void**)&context1)))
+		return;
+
+	D3D11_FEATURE_DATA_D3D11_OPTIONS options = {};
+	if (FAILED(device->CheckFeatureSupport(D3D11_FEATURE_D3D11_OPTIONS, &options, sizeof(options))))
+		return;
+
+	partialConstantUpdates = options.ConstantBufferPartialUpdate != FALSE;
+	if (!options.ConstantBufferOffsetting || !options.MapNoOverwriteOnDynamicConstantBuffer)
+		return;
+
+	D3D11_BUFFER_DESC desc = {};
+	desc.ByteWidth = CONSTANT_RING_SIZE;
+	desc.Usage = D3D11_USAGE_DYNAMIC;
+	desc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+	desc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+	if (FAILED(device->CreateBuffer(&desc, 0, &constantRing)))
+	{
+		constantRing = 0;
+		return;
+	}
+
+	// 256 bytes = 16 constants, the offset granularity.
+	ring.Reset(CONSTANT_RING_SIZE, 256);
+}
+
+// --------------------------------------------------------
+// Frees the ring space of every frame the GPU has finished,
+// oldest first, without waiting on ones it hasn't
+// --------------------------------------------------------
+void D3D11RenderBackend::RetireFrames()
+{
+	while (!fences.empty())
+	{
+		ID3D11Query* query = fences.front().second;
+		if (context->GetData(query, 0, 0, D3D11_ASYNC_GETDATA_DONOTFLUSH) != S_OK)
+			break;
+
+		ring.Retire(fences.front().first);
+		freeFences.push_back(query);
+		fences.pop_front();
+	}
+}
+
+// --------------------------------------------------------
+// Closes the frame's part of the constant ring and fences
+// it with an event query the GPU signals when done
+// --------------------------------------------------------
+void D3D11RenderBackend::EndFrame()
+{
+	if (!constantRing)
+		return;
+
+	RetireFrames();
+
+	ID3D11Query* query = 0;
+	if (!freeFences.empty())
+	{
+		query = freeFences.back();
+		freeFences.pop_back();
+	}
+	else
+	{
+		D3D11_QUERY_DESC desc = { D3D11_QUERY_EVENT, 0 };
+		if (FAILED(device->CreateQuery(&desc, &query)))
+			return;
+	}
+
+	ring.EndFrame(++frameFence);
+	context->End(query);
+	fences.push_back(std::make_pair(frameFence, query));
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// ------ NULL RENDER BACKEND -------------------------------------------------
+///////////////////////////////////////////////////////////////////////////////
+
+// --------------------------------------------------------
+// Constructor
+// --------------------------------------------------------
+NullRenderBackend::NullRenderBackend()
+	: IRenderBackend() { }
+
+// --------------------------------------------------------
+// Destructor
+// --------------------------------------------------------
+NullRenderBackend::~NullRenderBackend() { }
+
+// --------------------------------------------------------
+// Counts the clear
+// --------------------------------------------------------
+void NullRenderBackend::Clear(ID3D11RenderTargetView* renderTarget, ID3D11DepthStencilView* depthStencil, const float color[4])
+{
+	stats.clears++;
+}
+
+// --------------------------------------------------------
+// Counts the topology change
+// --------------------------------------------------------
+void NullRenderBackend::SetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY topology)
+{
+	stats.topologyChanges++;
+	RenderCounters::Add(RenderCounters::RC_STATE_CHANGES);
+}
+
+// --------------------------------------------------------
+// Counts the input layout bind
+// --------------------------------------------------------
+void NullRenderBackend::SetInputLayout(ID3D11InputLayout* layout)
+{
+	stats.inputLayoutBinds++;
+	RenderCounters::Add(RenderCounters::RC_STATE_CHANGES);
+}
+
+// --------------------------------------------------------
+// Counts the vertex shader bind
+// --------------------------------------------------------
+void NullRenderBackend::SetVertexShader(ID3D11VertexShader* shader)
+{
+	stats.shaderBinds++;
+	RenderCounters::Add(RenderCounters::RC_STATE_CHANGES);
+}
+
+// --------------------------------------------------------
+// Counts the pixel shader bind
+// --------------------------------------------------------
+void NullRenderBackend::SetPixelShader(ID3D11PixelShader* shader)
+{
+	stats.shaderBinds++;
+	RenderCounters::Add(RenderCounters::RC_STATE_CHANGES);
+}
+
+// --------------------------------------------------------
+// Counts the vertex shader constant buffer bind
+// --------------------------------------------------------
+void NullRenderBackend::SetVSConstantBuffer(unsigned int slot, ID3D11Buffer* buffer)
+{
+	stats.constantBufferBinds++;
+	RenderCounters::Add(RenderCounters::RC_STATE_CHANGES);
+}
+
+// --------------------------------------------------------
+// Counts the pixel shader constant buffer bind
+// --------------------------------------------------------
+void NullRenderBackend::SetPSConstantBuffer(unsigned int slot, ID3D11Buffer* buffer)
+{
+	stats.constantBufferBinds++;
+	RenderCounters::Add(RenderCounters::RC_STATE_CHANGES);
+}
+
+// --------------------------------------------------------
+// Counts the vertex buffer bind
+// --------------------------------------------------------
+void NullRenderBackend::SetVertexBuffer(ID3D11Buffer* buffer, unsigned int stride, unsigned int offset)
+{
+	stats.vertexBufferBinds++;
+	RenderCounters::Add(RenderCounters::RC_STATE_CHANGES);
+}
+
+// --------------------------------------------------------
+// Counts the index buffer bind
+// --------------------------------------------------------
+void NullRenderBackend::SetIndexBuffer(ID3D11Buffer* buffer, DXGI_FORMAT format, unsigned int offset)
+{
+	stats.indexBufferBinds++;
+	RenderCounters::Add(RenderCounters::RC_STATE_CHANGES);
+}
+
+// --------------------------------------------------------
+// Counts the draw and its indices
+// --------------------------------------------------------
+void NullRenderBackend::DrawIndexed(unsigned int indexCount, unsigned int startIndex, int baseVertex)
+{
+	stats.draws++;
+	stats.indices += indexCount;
+}
+
+// --------------------------------------------------------
+// Counts the instance buffer bind
+// --------------------------------------------------------
+void NullRenderBackend::SetInstanceBuffer(ID3D11Buffer* buffer, unsigned int stride, unsigned int offset)
+{
+	stats.instanceBufferBinds++;
+	RenderCounters::Add(RenderCounters::RC_STATE_CHANGES);
+}
+
+// --------------------------------------------------------
+// Counts the instanced draw, its instances and indices
+// --------------------------------------------------------
+void NullRenderBackend::DrawIndexedInstanced(unsigned int indexCount, unsigned int instanceCount, unsigned int startIndex, int baseVertex, unsigned int startInstance)
+{
+	stats.draws++;
+	stats.instancedDraws++;
+	stats.instances += instanceCount;
+	stats.indices += (unsigned long long)indexCount * instanceCount;
+}
+
+// --------------------------------------------------------
+// Counts the dynamic buffer update and its size
+// --------------------------------------------------------
+void NullRenderBackend::UpdateDynamicBuffer(ID3D11Buffer* buffer, const void* data, unsigned int size)
+{
+	stats.dynamicBufferUpdates++;
+	stats.dynamicBytes += size;
+}
+
+// --------------------------------------------------------
+// Counts the constant buffer update and its size
+// --------------------------------------------------------
+void NullRenderBackend::UpdateConstantBuffer(ID3D11Buffer* buffer, const void* data, unsigned int size)
+{
+	stats.constantBufferUpdates++;
+	stats.constantBytes += size;
+}
+
+// --------------------------------------------------------
+// Counts the update and the changed bytes, as a driver with
+// partial constant buffer updates would copy them
+// --------------------------------------------------------
+unsigned int NullRenderBackend::UpdateConstantRange(ID3D11Buffer* buffer, const void* data, unsigned int size, unsigned int begin, unsigned int end)
+{
+	stats.constantBufferUpdates++;
+	stats.constantBytes += end - begin;
+	return end - begin;
+}
+
+// --------------------------------------------------------
+// Counts the per-draw constants as an update and a bind
+// --------------------------------------------------------
+void NullRenderBackend::WriteVSConstants(unsigned int slot, ID3D11Buffer* buffer, const void* data, unsigned int size)
+{
+	stats.constantBufferUpdates++;
+	stats.constantBytes += size;
+	stats.constantBufferBinds++;
+	RenderCounters::Add(RenderCounters::RC_STATE_CHANGES);
+}
+
+// --------------------------------------------------------
+// Counts the frame
+// --------------------------------------------------------
+HRESULT NullRenderBackend::Present(unsigned int syncInterval, unsigned int flags)
+{
+	stats.frames++;
+	return S_OK;
+}
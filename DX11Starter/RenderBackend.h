@@ -0,0 +1,188 @@
+#pragma once
+
+// -----------------------------------------------
+// Include statements.
+// -----------------------------------------------
+#include "RingAllocator.h"
+#include <d3d11.h>
+#include <deque>
+#include <string>
+#include <vector>
+
+class ISimpleShader;
+class SimpleVertexShader;
+struct ID3D11DeviceContext1;
+class SimplePixelShader;
+
+// -----------------------------------------------
+// RenderBackend.h
+// ---
+// The calls Game::Draw() makes to submit a frame.
+// The D3D11 backend forwards them to the device
+// context and swap chain; the null backend only
+// counts them, for headless runs with no GPU.
+// -----------------------------------------------
+
+/// <summary>
+/// Running totals of the work submitted to a backend.
+/// </summary>
+struct RenderBackendStatistics
+{
+	unsigned long long frames;
+	unsigned long long clears;
+	unsigned long long vertexBufferBinds;
+	unsigned long long indexBufferBinds;
+	unsigned long long topologyChanges;
+	unsigned long long inputLayoutBinds;
+	unsigned long long shaderBinds;
+	unsigned long long constantBufferBinds;
+	unsigned long long draws;
+	unsigned long long instancedDraws;
+	unsigned long long instances;
+	unsigned long long indices;
+	unsigned long long constantBufferUpdates;
+	unsigned long long constantBytes;
+	unsigned long long dynamicBufferUpdates;
+	unsigned long long dynamicBytes;
+	unsigned long long instanceBufferBinds;
+	unsigned long long ringConstantWrites;	// Per-draw constants written to the constant ring.
+	unsigned long long ringConstantBytes;
+};
+
+/// <summary>
+/// Abstract frame submission interface.
+/// </summary>
+class IRenderBackend
+{
+public:
+	IRenderBackend();
+	virtual ~IRenderBackend();
+
+	// Frame setup
+	virtual void Clear(ID3D11RenderTargetView* renderTarget, ID3D11DepthStencilView* depthStencil, const float color[4]) = 0;
+	virtual void SetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY topology) = 0;
+
+	// Shaders
+	virtual void SetInputLayout(ID3D11InputLayout* layout) = 0;
+	virtual void SetVertexShader(ID3D11VertexShader* shader) = 0;
+	virtual void SetPixelShader(ID3D11PixelShader* shader) = 0;
+	virtual void SetVSConstantBuffer(unsigned int slot, ID3D11Buffer* buffer) = 0;
+	virtual void SetPSConstantBuffer(unsigned int slot, ID3D11Buffer* buffer) = 0;
+	void BindShader(SimpleVertexShader* shader);	// Shader, input layout and constant buffers
+	void BindShader(SimplePixelShader* shader);		// Shader and constant buffers
+
+	// Geometry
+	virtual void SetVertexBuffer(ID3D11Buffer* buffer, unsigned int stride, unsigned int offset) = 0;
+	virtual void SetIndexBuffer(ID3D11Buffer* buffer, DXGI_FORMAT format, unsigned int offset) = 0;
+	virtual void DrawIndexed(unsigned int indexCount, unsigned int startIndex, int baseVertex) = 0;
+
+	// Instancing - per-instance data comes from vertex buffer slot 1
+	virtual void SetInstanceBuffer(ID3D11Buffer* buffer, unsigned int stride, unsigned int offset) = 0;
+	virtual void DrawIndexedInstanced(unsigned int indexCount, unsigned int instanceCount, unsigned int startIndex, int baseVertex, unsigned int startInstance) = 0;
+	virtual void UpdateDynamicBuffer(ID3D11Buffer* buffer, const void* data, unsigned int size) = 0;	// Replaces the contents (write-discard)
+
+	// Shader constants
+	virtual void UpdateConstantBuffer(ID3D11Buffer* buffer, const void* data, unsigned int size) = 0;
+	virtual unsigned int UpdateConstantRange(ID3D11Buffer* buffer, const void* data, unsigned int size, unsigned int begin, unsigned int end);	// data is the whole buffer; only [begin, end) changed. Returns the bytes copied
+	virtual void WriteVSConstants(unsigned int slot, ID3D11Buffer* buffer, const void* data, unsigned int size) = 0;	// Per draw: contents of buffer, bound to slot
+	bool UploadConstants(ISimpleShader* shader, const std::string& bufferName);	// Only if changed
+	bool UploadConstants(ISimpleShader* shader, unsigned int bufferIndex);		// Same, by ISimpleShader::GetBufferIndex()
+	bool WriteConstants(SimpleVertexShader* shader, const std::string& bufferName);	// Always - call after BindShader()
+	bool WriteConstants(SimpleVertexShader* shader, unsigned int bufferIndex);		// Same, with no name lookups (per draw)
+
+	// Ends the frame
+	virtual HRESULT Present(unsigned int syncInterval, unsigned int flags) = 0;
+
+	// Simple helpers
+	virtual bool IsNull() const = 0;
+	virtual bool IsOccluded() const { return occluded; }	// Last Present() found nothing visible
+	virtual const RenderBackendStatistics& GetStatistics() const { return stats; }
+	virtual void ResetStatistics();
+
+protected:
+	RenderBackendStatistics stats;
+	bool occluded;
+};
+
+/// <summary>
+/// Forwards submission to Direct3D 11.
+/// </summary>
+class D3D11RenderBackend : public IRenderBackend
+{
+public:
+	D3D11RenderBackend(ID3D11DeviceContext* context, IDXGISwapChain* swapChain);
+	~D3D11RenderBackend();
+
+	void Clear(ID3D11RenderTargetView* renderTarget, ID3D11DepthStencilView* depthStencil, const float color[4]);
+	void SetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY topology);
+	void SetInputLayout(ID3D11InputLayout* layout);
+	void SetVertexShader(ID3D11VertexShader* shader);
+	void SetPixelShader(ID3D11PixelShader* shader);
+	void SetVSConstantBuffer(unsigned int slot, ID3D11Buffer* buffer);
+	void SetPSConstantBuffer(unsigned int slot, ID3D11Buffer* buffer);
+	void SetVertexBuffer(ID3D11Buffer* buffer, unsigned int stride, unsigned int offset);
+	void SetIndexBuffer(ID3D11Buffer* buffer, DXGI_FORMAT format, unsigned int offset);
+	void DrawIndexed(unsigned int indexCount, unsigned int startIndex, int baseVertex);
+	void SetInstanceBuffer(ID3D11Buffer* buffer, unsigned int stride, unsigned int offset);
+	void DrawIndexedInstanced(unsigned int indexCount, unsigned int instanceCount, unsigned int startIndex, int baseVertex, unsigned int startInstance);
+	void UpdateDynamicBuffer(ID3D11Buffer* buffer, const void* data, unsigned int size);
+	void UpdateConstantBuffer(ID3D11Buffer* buffer, const void* data, unsigned int size);
+	unsigned int UpdateConstantRange(ID3D11Buffer* buffer, const void* data, unsigned int size, unsigned int begin, unsigned int end);
+	void WriteVSConstants(unsigned int slot, ID3D11Buffer* buffer, const void* data, unsigned int size);
+	HRESULT Present(unsigned int syncInterval, unsigned int flags);
+	bool IsNull() const { return false; }
+
+	// Per-draw constants share one large dynamic buffer, bound
+	// at an offset (needs Direct3D 11.1 constant buffer offsets)
+	static const unsigned int CONSTANT_RING_SIZE = 4 * 1024 * 1024;
+	bool HasConstantRing() const { return constantRing != 0; }
+	const RingAllocator& GetConstantRing() const { return ring; }
+
+private:
+	ID3D11DeviceContext* context;
+	IDXGISwapChain* swapChain;
+
+	// Constant ring, and a query per frame in flight to tell
+	// when the GPU is done with that frame's part of it
+	ID3D11Device* device;
+	ID3D11DeviceContext1* context1;
+	bool partialConstantUpdates;	// Driver can update part of a constant buffer
+	ID3D11Buffer* constantRing;
+	RingAllocator ring;
+	unsigned long long frameFence;
+	std::deque<std::pair<unsigned long long, ID3D11Query*>> fences;
+	std::vector<ID3D11Query*> freeFences;
+
+	void CreateConstantRing();
+	void RetireFrames();
+	void EndFrame();
+};
+
+/// <summary>
+/// Accepts and counts submission without rendering anything.
+/// </summary>
+class NullRenderBackend : public IRenderBackend
+{
+public:
+	NullRenderBackend();
+	~NullRenderBackend();
+
+	void Clear(ID3D11RenderTargetView* renderTarget, ID3D11DepthStencilView* depthStencil, const float color[4]);
+	void SetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY topology);
+	void SetInputLayout(ID3D11InputLayout* layout);
+	void SetVertexShader(ID3D11VertexShader* shader);
+	void SetPixelShader(ID3D11PixelShader* shader);
+	void SetVSConstantBuffer(unsigned int slot, ID3D11Buffer* buffer);
+	void SetPSConstantBuffer(unsigned int slot, ID3D11Buffer* buffer);
+	void SetVertexBuffer(ID3D11Buffer* buffer, unsigned int stride, unsigned int offset);
+	void SetIndexBuffer(ID3D11Buffer* buffer, DXGI_FORMAT format, unsigned int offset);
+	void DrawIndexed(unsigned int indexCount, unsigned int startIndex, int baseVertex);
+	void SetInstanceBuffer(ID3D11Buffer* buffer, unsigned int stride, unsigned int offset);
+	void DrawIndexedInstanced(unsigned int indexCount, unsigned int instanceCount, unsigned int startIndex, int baseVertex, unsigned int startInstance);
+	void UpdateDynamicBuffer(ID3D11Buffer* buffer, const void* data, unsigned int size);
+	void UpdateConstantBuffer(ID3D11Buffer* buffer, const void* data, unsigned int size);
+	unsigned int UpdateConstantRange(ID3D11Buffer* buffer, const void* data, unsigned int size, unsigned int begin, unsigned int end);
+	void WriteVSConstants(unsigned int slot, ID3D11Buffer* buffer, const void* data, unsigned int size);
+	HRESULT Present(unsigned int syncInterval, unsigned int flags);
+	bool IsNull() const { return true; }
+};
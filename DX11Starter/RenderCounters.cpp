@@ -0,0 +1,324 @@
+// -----------------------------------------------
+// Include statements.
+// -----------------------------------------------
+#include "RenderCounters.h"
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+
+// -----------------------------------------------
+// Constructors.
+// -----------------------------------------------
+
+/// <summary>
+/// The single set of counters.
+/// </summary>
+RenderCounters& RenderCounters::Get()
+{
+	static RenderCounters instance;
+	return instance;
+}
+
+/// <summary>
+/// Starts every counter (and the frame window) at zero,
+/// with no budgets.
+/// </summary>
+RenderCounters::RenderCounters()
+	: retired{}, baseline{}, frameStart{}, lastFrame{}, peak{}, window{}, frameCount{ 0 },
+	budgets{}, budgeted{}
+{}
+
+/// <summary>
+/// Threads still running keep their blocks; nothing to free.
+/// </summary>
+RenderCounters::~RenderCounters()
+{}
+
+/// <summary>
+/// Registers the calling thread's block.
+/// </summary>
+RenderCounters::ThreadBlock::ThreadBlock()
+{
+	for (unsigned int c = 0; c < RC_COUNT; c++)
+		block.counts[c].store(0, std::memory_order_relaxed);
+	RenderCounters::Get().Register(&block);
+}
+
+/// <summary>
+/// Keeps the exiting thread's counts in the totals.
+/// </summary>
+RenderCounters::ThreadBlock::~ThreadBlock()
+{
+	RenderCounters::Get().Retire(&block);
+}
+
+// -----------------------------------------------
+// Static methods.
+// -----------------------------------------------
+
+/// <summary>
+/// Returns the name of a counter.
+/// </summary>
+const char* RenderCounters::GetName(Counter counter)
+{
+	static const char* names[RC_COUNT] = {
+		"draws", "triangles", "constant_bytes", "state_changes", "state_changes_skipped",
+		"entities_updated", "entities_culled", "entities_visible", "transform_commands" };
+	return (counter >= 0 && counter < RC_COUNT) ? names[counter] : "unknown";
+}
+
+/// <summary>
+/// Look a counter up by name.
+/// </summary>
+/// <param name="name">Counter name (see GetName()).</param>
+/// <param name="counter">Receives the counter.</param>
+/// <returns>Returns false if no counter has that name.</returns>
+bool RenderCounters::FindCounter(const std::string& name, Counter* counter)
+{
+	for (unsigned int c = 0; c < RC_COUNT; c++)
+	{
+		if (name == GetName((Counter)c))
+		{
+			*counter = (Counter)c;
+			return true;
+		}
+	}
+	return false;
+}
+
+/// <summary>
+/// Count something. Only the calling thread writes its
+/// block, so this is a plain load and store rather than
+/// a locked add.
+/// </summary>
+/// <param name="counter">What to count.</param>
+/// <param name="amount">How many.</param>
+void RenderCounters::Add(Counter counter, unsigned long long amount)
+{
+	static thread_local ThreadBlock local;
+
+	std::atomic<unsigned long long>& count = local.block.counts[counter];
+	count.store(count.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+}
+
+// -----------------------------------------------
+// Accessors.
+// -----------------------------------------------
+
+/// <summary>
+/// Everything counted since the last Reset(), on every thread.
+/// </summary>
+RenderCounters::Values RenderCounters::GetTotals() const
+{
+	Values totals = Sum();
+	for (unsigned int c = 0; c < RC_COUNT; c++)
+		totals.counts[c] -= baseline.counts[c];
+	return totals;
+}
+
+/// <summary>
+/// Counts of the last finished frame.
+/// </summary>
+const RenderCounters::Values& RenderCounters::GetLastFrame() const
+{
+	return lastFrame;
+}
+
+/// <summary>
+/// Largest count each counter reached in a single frame.
+/// </summary>
+const RenderCounters::Values& RenderCounters::GetPeak() const
+{
+	return peak;
+}
+
+/// <summary>
+/// Frames finished since the last Reset().
+/// </summary>
+unsigned long long RenderCounters::GetFrameCount() const
+{
+	return frameCount;
+}
+
+/// <summary>
+/// Does the counter have a budget?
+/// </summary>
+bool RenderCounters::HasBudget(Counter counter) const
+{
+	return budgeted[counter];
+}
+
+/// <summary>
+/// Most a frame may count, if the counter has a budget.
+/// </summary>
+unsigned long long RenderCounters::GetBudget(Counter counter) const
+{
+	return budgets.counts[counter];
+}
+
+/// <summary>
+/// Did any frame count more than the counter's budget?
+/// </summary>
+bool RenderCounters::IsOverBudget(Counter counter) const
+{
+	return budgeted[counter] && peak.counts[counter] > budgets.counts[counter];
+}
+
+// -----------------------------------------------
+// Mutators.
+// -----------------------------------------------
+
+/// <summary>
+/// Set the most a frame may count.
+/// </summary>
+/// <param name="budget">"name=N", e.g. "draws=500".</param>
+/// <returns>Returns false if the text isn't a known counter and a number.</returns>
+bool RenderCounters::SetBudget(const std::string& budget)
+{
+	size_t equals = budget.find('=');
+	if (equals == std::string::npos || equals + 1 == budget.size())
+		return false;
+
+	Counter counter;
+	if (!FindCounter(budget.substr(0, equals), &counter))
+		return false;
+
+	const char* text = budget.c_str() + equals + 1;
+	char* end = nullptr;
+	unsigned long long value = std::strtoull(text, &end, 10);
+	if (*end != '\0')
+		return false;
+
+	budgets.counts[counter] = value;
+	budgeted[counter] = true;
+	return true;
+}
+
+/// <summary>
+/// Remove every budget.
+/// </summary>
+void RenderCounters::ClearBudgets()
+{
+	budgets = {};
+	for (bool& b : budgeted)
+		b = false;
+}
+
+// -----------------------------------------------
+// Service methods.
+// -----------------------------------------------
+
+/// <summary>
+/// Close the frame: what was counted since the last call
+/// becomes the frame's counts. Counts added by other
+/// threads while this runs land in one frame or the next,
+/// never both.
+/// </summary>
+void RenderCounters::EndFrame()
+{
+	Values now = Sum();
+	for (unsigned int c = 0; c < RC_COUNT; c++)
+	{
+		lastFrame.counts[c] = now.counts[c] - frameStart.counts[c];
+		peak.counts[c] = std::max(peak.counts[c], lastFrame.counts[c]);
+	}
+	frameStart = now;
+
+	window[frameCount % WINDOW_SIZE] = lastFrame;
+	frameCount++;
+}
+
+/// <summary>
+/// Write the rolling window to a CSV file, oldest frame first,
+/// followed by the peaks and budgets.
+/// </summary>
+/// <param name="filename">Path of the file to (over)write.</param>
+/// <returns>Returns false if the file couldn't be opened.</returns>
+bool RenderCounters::DumpCSV(const std::string& filename) const
+{
+	std::ofstream csv(filename);
+	if (!csv.is_open())
+		return false;
+
+	csv << "frame";
+	for (unsigned int c = 0; c < RC_COUNT; c++)
+		csv << ',' << GetName((Counter)c);
+	csv << '\n';
+
+	unsigned long long first = (frameCount > WINDOW_SIZE) ? frameCount - WINDOW_SIZE : 0;
+	for (unsigned long long frame = first; frame < frameCount; frame++)
+	{
+		const Values& values = window[frame % WINDOW_SIZE];
+		csv << frame;
+		for (unsigned int c = 0; c < RC_COUNT; c++)
+			csv << ',' << values.counts[c];
+		csv << '\n';
+	}
+
+	// Peaks cover every frame, not just the window.
+	csv << "\npeak";
+	for (unsigned int c = 0; c < RC_COUNT; c++)
+		csv << ',' << peak.counts[c];
+	csv << "\nbudget";
+	for (unsigned int c = 0; c < RC_COUNT; c++)
+	{
+		csv << ',';
+		if (budgeted[c])
+			csv << budgets.counts[c];
+	}
+	csv << '\n';
+
+	return true;
+}
+
+/// <summary>
+/// Start counting from zero again.
+/// </summary>
+void RenderCounters::Reset()
+{
+	baseline = Sum();
+	frameStart = baseline;
+	lastFrame = {};
+	peak = {};
+	frameCount = 0;
+}
+
+// -----------------------------------------------
+// Helper methods.
+// -----------------------------------------------
+
+/// <summary>
+/// Sum of every thread's counts, since the program started.
+/// </summary>
+RenderCounters::Values RenderCounters::Sum() const
+{
+	std::lock_guard<std::mutex> lock(mutex);
+
+	Values sum = retired;
+	for (const Block* block : blocks)
+	{
+		for (unsigned int c = 0; c < RC_COUNT; c++)
+			sum.counts[c] += block->counts[c].load(std::memory_order_relaxed);
+	}
+	return sum;
+}
+
+/// <summary>
+/// Start reading a thread's block.
+/// </summary>
+void RenderCounters::Register(Block* block)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	blocks.push_back(block);
+}
+
+/// <summary>
+/// Stop reading a thread's block, keeping its counts.
+/// </summary>
+void RenderCounters::Retire(Block* block)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	for (unsigned int c = 0; c < RC_COUNT; c++)
+		retired.counts[c] += block->counts[c].load(std::memory_order_relaxed);
+	blocks.erase(std::remove(blocks.begin(), blocks.end(), block), blocks.end());
+}
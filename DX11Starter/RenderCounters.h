@@ -0,0 +1,177 @@
+#pragma once
+
+// -----------------------------------------------
+// Include statements.
+// -----------------------------------------------
+#include <array>
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// -----------------------------------------------
+// RenderCounters.h
+// ---
+// Counts what the renderer did each frame: draws,
+// triangles, constant bytes, state changes and
+// what happened to the entities.
+//
+// Any thread can Add(). Each thread counts into
+// its own block (a plain load and store, no lock
+// and no shared cache line); reading sums the
+// blocks. EndFrame() turns the running totals
+// into the frame's counts, which are kept in a
+// rolling window for dumping, along with the
+// largest count each counter reached in a frame.
+//
+// Counters are set where the work is asked for,
+// not by the backend, so they read the same with
+// the null backend. Budgets ("--budget draws=500")
+// are checked against the largest frame, which
+// lets a headless run fail when one is exceeded.
+// -----------------------------------------------
+
+class RenderCounters
+{
+public:
+	// -----------------------------------------------
+	// Internal enum/structs.
+	// -----------------------------------------------
+
+	/// <summary>
+	/// COUNTER determines what is being counted.
+	/// </summary>
+	typedef enum _COUNTER
+	{
+		RC_DRAWS = 0,					// Draw calls recorded (instanced draws count once).
+		RC_TRIANGLES = 1,				// Triangles those draws submit, over every instance.
+		RC_CONSTANT_BYTES = 2,			// Bytes copied into constant buffers.
+		RC_STATE_CHANGES = 3,			// Binds that reached the device (or null backend).
+		RC_STATE_CHANGES_SKIPPED = 4,	// Binds the state cache dropped as redundant.
+		RC_ENTITIES_UPDATED = 5,		// Entities that applied at least one transform command.
+		RC_ENTITIES_CULLED = 6,			// Entities left out of the frame by culling.
+		RC_ENTITIES_VISIBLE = 7,		// Entities queued for drawing.
+		RC_TRANSFORM_COMMANDS = 8,		// Transform commands taken off entities' buffers.
+		RC_COUNT = 9
+	} COUNTER;
+
+	/// <summary>
+	/// Wrapper for COUNTER enum.
+	/// </summary>
+	typedef COUNTER Counter;
+
+	/// <summary>
+	/// One value per counter.
+	/// </summary>
+	struct Values
+	{
+		unsigned long long counts[RC_COUNT];
+	};
+
+	// Number of frames kept in the rolling window.
+	static const unsigned int WINDOW_SIZE = 1024;
+
+	// -----------------------------------------------
+	// Constructors.
+	// -----------------------------------------------
+
+	static RenderCounters& Get();
+	~RenderCounters();
+
+	// -----------------------------------------------
+	// Static methods.
+	// -----------------------------------------------
+
+	static const char* GetName(Counter counter);	// e.g. "draws", as used by budgets and the CSV.
+	static bool FindCounter(const std::string& name, Counter* counter);
+	static void Add(Counter counter, unsigned long long amount = 1);	// Any thread.
+
+	// -----------------------------------------------
+	// Accessors.
+	// -----------------------------------------------
+
+	Values GetTotals() const;			// Everything counted since the last Reset(), including the current frame.
+	const Values& GetLastFrame() const;	// Counts of the frame the last EndFrame() closed.
+	const Values& GetPeak() const;		// Largest count of each counter in any frame.
+	unsigned long long GetFrameCount() const;
+	bool HasBudget(Counter counter) const;
+	unsigned long long GetBudget(Counter counter) const;
+	bool IsOverBudget(Counter counter) const;	// Peak frame above the budget.
+
+	// -----------------------------------------------
+	// Mutators.
+	// -----------------------------------------------
+
+	bool SetBudget(const std::string& budget);	// "name=N". False if the counter is unknown.
+	void ClearBudgets();
+
+	// -----------------------------------------------
+	// Service methods.
+	// -----------------------------------------------
+
+	void EndFrame();	// Once per frame, after Draw().
+	bool DumpCSV(const std::string& filename) const;	// One row per frame in the window.
+	void Reset();		// Starts counting again from zero. Budgets are kept.
+
+private:
+
+	// -----------------------------------------------
+	// Internal structs.
+	// -----------------------------------------------
+
+	/// <summary>
+	/// One thread's counts. Only the owning thread writes
+	/// them; other threads only read.
+	/// </summary>
+	struct Block
+	{
+		std::atomic<unsigned long long> counts[RC_COUNT];
+	};
+
+	/// <summary>
+	/// A thread's block, registered while the thread lives.
+	/// </summary>
+	struct ThreadBlock
+	{
+		ThreadBlock();
+		~ThreadBlock();	// Folds its counts into the retired totals.
+
+		Block block;
+	};
+
+	// -----------------------------------------------
+	// Constructors.
+	// -----------------------------------------------
+
+	RenderCounters();
+	RenderCounters(const RenderCounters&) = delete;
+	RenderCounters& operator=(const RenderCounters&) = delete;
+
+	// -----------------------------------------------
+	// Data members.
+	// -----------------------------------------------
+
+	// Every live thread's block, and the counts of threads
+	// that have exited. Guarded by the mutex.
+	mutable std::mutex mutex;
+	std::vector<Block*> blocks;
+	Values retired;
+
+	Values baseline;	// Sum at the last Reset().
+	Values frameStart;	// Sum at the last EndFrame().
+	Values lastFrame;
+	Values peak;
+	std::array<Values, WINDOW_SIZE> window;
+	unsigned long long frameCount;
+
+	Values budgets;
+	bool budgeted[RC_COUNT];
+
+	// -----------------------------------------------
+	// Helper methods.
+	// -----------------------------------------------
+
+	Values Sum() const;
+	void Register(Block* block);
+	void Retire(Block* block);
+};
@@ -0,0 +1,228 @@
+// -----------------------------------------------
+// Include statements.
+// -----------------------------------------------
+#include "RenderQueue.h"
+#include <cstring>
+
+// -----------------------------------------------
+// Static methods.
+// -----------------------------------------------
+
+/// <summary>
+/// Pack a draw into a sort key. IDs and depth wider
+/// than their fields are truncated.
+/// </summary>
+/// <param name="pass">Render pass.</param>
+/// <param name="material">Material ID.</param>
+/// <param name="mesh">Mesh ID.</param>
+/// <param name="depth">Quantized depth (see QuantizeDepth).</param>
+/// <returns>Returns the key.</returns>
+RenderQueue::SortKey RenderQueue::MakeKey(RenderPass pass, unsigned int material, unsigned int mesh, unsigned int depth)
+{
+	const SortKey depthMask = (1ULL << DEPTH_BITS) - 1;
+	const SortKey materialMask = (1ULL << MATERIAL_BITS) - 1;
+	const SortKey meshMask = (1ULL << MESH_BITS) - 1;
+
+	SortKey key = static_cast<SortKey>(pass) << (64 - PASS_BITS);
+
+	if (pass == RP_TRANSPARENT)
+	{
+		// Back to front: invert depth so far draws sort first.
+		key |= (depthMask - (depth & depthMask)) << (MATERIAL_BITS + MESH_BITS);
+		key |= (material & materialMask) << MESH_BITS;
+		key |= (mesh & meshMask);
+	}
+	else
+	{
+		key |= (material & materialMask) << (MESH_BITS + DEPTH_BITS);
+		key |= (mesh & meshMask) << DEPTH_BITS;
+		key |= (depth & depthMask);
+	}
+
+	return key;
+}
+
+/// <summary>
+/// Map a view space depth onto the key's depth field,
+/// linearly between the clipping planes.
+/// </summary>
+/// <param name="viewDepth">Distance along the view direction.</param>
+/// <param name="nearPlane">Near clipping plane.</param>
+/// <param name="farPlane">Far clipping plane.</param>
+/// <returns>Returns depth in [0, 2^DEPTH_BITS).</returns>
+unsigned int RenderQueue::QuantizeDepth(float viewDepth, float nearPlane, float farPlane)
+{
+	const unsigned int maxDepth = (1u << DEPTH_BITS) - 1;
+
+	float range = farPlane - nearPlane;
+	float t = (range > 0.0f) ? (viewDepth - nearPlane) / range : 0.0f;
+	if (!(t > 0.0f)) return 0; // Also catches NaN.
+	if (t >= 1.0f) return maxDepth;
+
+	return static_cast<unsigned int>(t * static_cast<float>(maxDepth));
+}
+
+/// <summary>
+/// Pass a key belongs to.
+/// </summary>
+RenderQueue::RenderPass RenderQueue::GetPass(SortKey key)
+{
+	return static_cast<RenderPass>(key >> (64 - PASS_BITS));
+}
+
+/// <summary>
+/// Part of a key that decides whether draws can be batched:
+/// pass, material and mesh for opaque draws. Transparent
+/// draws keep their depth, so only neighbours at the same
+/// depth share a batch and blending order is preserved.
+/// </summary>
+/// <param name="key">Sort key.</param>
+/// <returns>Returns equal values for draws that can be instanced together.</returns>
+RenderQueue::SortKey RenderQueue::GetBatchKey(SortKey key)
+{
+	if (GetPass(key) == RP_TRANSPARENT)
+		return key;
+	return key >> DEPTH_BITS;
+}
+
+// -----------------------------------------------
+// Constructors.
+// -----------------------------------------------
+
+/// <summary>
+/// Initializes an empty queue.
+/// </summary>
+RenderQueue::RenderQueue() {}
+
+// -----------------------------------------------
+// Accessors.
+// -----------------------------------------------
+
+/// <summary>
+/// Number of queued draws.
+/// </summary>
+size_t RenderQueue::GetCount() const
+{
+	return items.size();
+}
+
+/// <summary>
+/// Queued draw, in sorted order after Sort().
+/// </summary>
+const RenderQueue::Item& RenderQueue::operator[](size_t i) const
+{
+	return items[i];
+}
+
+/// <summary>
+/// First queued draw.
+/// </summary>
+const RenderQueue::Item* RenderQueue::begin() const
+{
+	return items.data();
+}
+
+/// <summary>
+/// One past the last queued draw.
+/// </summary>
+const RenderQueue::Item* RenderQueue::end() const
+{
+	return items.data() + items.size();
+}
+
+// -----------------------------------------------
+// Service methods.
+// -----------------------------------------------
+
+/// <summary>
+/// Make room for a number of draws up front.
+/// </summary>
+void RenderQueue::Reserve(size_t count)
+{
+	items.reserve(count);
+	scratch.reserve(count);
+}
+
+/// <summary>
+/// Remove all draws, keeping the memory for the next frame.
+/// </summary>
+void RenderQueue::Clear()
+{
+	items.clear();
+}
+
+/// <summary>
+/// Queue a draw.
+/// </summary>
+/// <param name="key">Sort key (see MakeKey).</param>
+/// <param name="index">Caller's index for the draw.</param>
+void RenderQueue::Submit(SortKey key, unsigned int index)
+{
+	Item item;
+	item.key = key;
+	item.index = index;
+	items.push_back(item);
+}
+
+/// <summary>
+/// Least significant digit radix sort, one byte per pass.
+/// Passes where every key has the same byte are skipped,
+/// so unused fields (e.g. a single pass) cost nothing.
+/// </summary>
+void RenderQueue::Sort()
+{
+	const size_t count = items.size();
+	if (count < 2)
+		return;
+
+	scratch.resize(count);
+
+	// Count every byte of every key in one sweep.
+	static const unsigned int PASSES = sizeof(SortKey);
+	size_t histograms[PASSES][256];
+	memset(histograms, 0, sizeof(histograms));
+
+	for (size_t i = 0; i < count; i++)
+	{
+		SortKey key = items[i].key;
+		for (unsigned int p = 0; p < PASSES; p++)
+			histograms[p][(key >> (p * 8)) & 0xFF]++;
+	}
+
+	Item* source = items.data();
+	Item* destination = scratch.data();
+
+	for (unsigned int p = 0; p < PASSES; p++)
+	{
+		size_t* histogram = histograms[p];
+
+		// Skip the pass if all keys share this byte.
+		unsigned int firstByte = static_cast<unsigned int>((source[0].key >> (p * 8)) & 0xFF);
+		if (histogram[firstByte] == count)
+			continue;
+
+		// Prefix sum into starting offsets.
+		size_t offset = 0;
+		for (unsigned int b = 0; b < 256; b++)
+		{
+			size_t n = histogram[b];
+			histogram[b] = offset;
+			offset += n;
+		}
+
+		// Scatter (stable).
+		for (size_t i = 0; i < count; i++)
+		{
+			unsigned int b = static_cast<unsigned int>((source[i].key >> (p * 8)) & 0xFF);
+			destination[histogram[b]++] = source[i];
+		}
+
+		Item* swap = source;
+		source = destination;
+		destination = swap;
+	}
+
+	// An odd number of passes leaves the result in the scratch buffer.
+	if (source != items.data())
+		items.swap(scratch);
+}
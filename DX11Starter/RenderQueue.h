@@ -0,0 +1,111 @@
+#pragma once
+
+// -----------------------------------------------
+// Include statements.
+// -----------------------------------------------
+#include <cstddef>
+#include <vector>
+
+// -----------------------------------------------
+// RenderQueue.h
+// ---
+// Collects a frame's draws as 64-bit sort keys,
+// radix sorts them and hands them back in order.
+//
+// Key layout (most significant bits first):
+//
+//   opaque:       pass:4 | material:16 | mesh:16 | depth:28
+//   transparent:  pass:4 | depth:28 (far first) | material:16 | mesh:16
+//
+// Opaque draws are grouped by material, then mesh,
+// so state changes are minimized, and go front to
+// back within a group for early-Z. Transparent
+// draws go back to front for correct blending.
+// -----------------------------------------------
+
+class RenderQueue
+{
+public:
+	// -----------------------------------------------
+	// Internal enum/structs.
+	// -----------------------------------------------
+
+	/// <summary>
+	/// RENDER_PASS determines the order groups of draws are submitted in.
+	/// </summary>
+	typedef enum _RENDER_PASS
+	{
+		RP_OPAQUE = 0,
+		RP_TRANSPARENT = 1,
+		RP_COUNT = 2
+	} RENDER_PASS;
+
+	/// <summary>
+	/// Wrapper for RENDER_PASS enum.
+	/// </summary>
+	typedef RENDER_PASS RenderPass;
+
+	/// <summary>
+	/// Packed sort key.
+	/// </summary>
+	typedef unsigned long long SortKey;
+
+	/// <summary>
+	/// A queued draw: its key, and the index of whatever
+	/// the caller is drawing (e.g. an entity).
+	/// </summary>
+	struct Item
+	{
+		SortKey key;
+		unsigned int index;
+	};
+
+	// Field widths.
+	static const unsigned int PASS_BITS = 4;
+	static const unsigned int MATERIAL_BITS = 16;
+	static const unsigned int MESH_BITS = 16;
+	static const unsigned int DEPTH_BITS = 28;
+
+	// -----------------------------------------------
+	// Static methods.
+	// -----------------------------------------------
+
+	static SortKey MakeKey(RenderPass pass, unsigned int material, unsigned int mesh, unsigned int depth);
+	static unsigned int QuantizeDepth(float viewDepth, float nearPlane, float farPlane);
+	static RenderPass GetPass(SortKey key);
+	static SortKey GetBatchKey(SortKey key);	// Equal for draws that can share an instanced draw.
+
+	// -----------------------------------------------
+	// Constructors.
+	// -----------------------------------------------
+
+	RenderQueue();
+
+	// -----------------------------------------------
+	// Accessors.
+	// -----------------------------------------------
+
+	size_t GetCount() const;
+	const Item& operator[](size_t i) const;
+	const Item* begin() const;
+	const Item* end() const;
+
+	// -----------------------------------------------
+	// Service methods.
+	// -----------------------------------------------
+
+	void Reserve(size_t count);
+	void Clear();		// Call at the start of each frame. Keeps the memory.
+	void Submit(SortKey key, unsigned int index);
+	void Sort();		// Stable, ascending by key.
+
+private:
+
+	// -----------------------------------------------
+	// Data members.
+	// -----------------------------------------------
+
+	std::vector<Item> items;
+	std::vector<Item> scratch;	// Radix sort ping-pong buffer.
+
+};
@@ -0,0 +1,263 @@
+// -----------------------------------------------
+// Include statements.
+// -----------------------------------------------
+#include "RenderStateCache.h"
+
+// -----------------------------------------------
+// Constants.
+// -----------------------------------------------
+
+// The tracker's slot count must cover every slot Direct3D has.
+static_assert(RenderStateTracker::CONSTANT_BUFFER_SLOTS == D3D11_COMMONSHADER_CONSTANT_BUFFER_API_SLOT_COUNT,
+	"RenderStateTracker tracks the wrong number of constant buffer slots");
+
+// -----------------------------------------------
+// Constructors.
+// -----------------------------------------------
+
+/// <summary>
+/// Wraps a backend, starting with nothing known to be bound.
+/// </summary>
+/// <param name="backend">Backend to forward to (deleted with the cache).</param>
+RenderStateCache::RenderStateCache(IRenderBackend* backend)
+	: IRenderBackend(), backend{ backend }
+{}
+
+/// <summary>
+/// Deletes the wrapped backend.
+/// </summary>
+RenderStateCache::~RenderStateCache()
+{
+	delete backend;
+	backend = nullptr;
+}
+
+// -----------------------------------------------
+// Accessors.
+// -----------------------------------------------
+
+/// <summary>
+/// Issued and skipped call counts.
+/// </summary>
+const RenderStateTracker::Counters& RenderStateCache::GetCounters() const
+{
+	return tracker.GetCounters();
+}
+
+/// <summary>
+/// The wrapped backend.
+/// </summary>
+IRenderBackend* RenderStateCache::GetBackend() const
+{
+	return backend;
+}
+
+// -----------------------------------------------
+// Service methods.
+// -----------------------------------------------
+
+/// <summary>
+/// Forget all bound state, so every next call goes through.
+/// Needed whenever something binds state behind the cache's back.
+/// </summary>
+void RenderStateCache::Invalidate()
+{
+	tracker.Invalidate();
+}
+
+/// <summary>
+/// Zero the issued/skipped counters.
+/// </summary>
+void RenderStateCache::ResetCounters()
+{
+	tracker.ResetCounters();
+}
+
+// -----------------------------------------------
+// IRenderBackend.
+// -----------------------------------------------
+
+/// <summary>
+/// Always forwarded.
+/// </summary>
+void RenderStateCache::Clear(ID3D11RenderTargetView* renderTarget, ID3D11DepthStencilView* depthStencil, const float color[4])
+{
+	backend->Clear(renderTarget, depthStencil, color);
+}
+
+/// <summary>
+/// Forwarded if the topology changed.
+/// </summary>
+void RenderStateCache::SetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY topology)
+{
+	if (tracker.SetTopology((unsigned int)topology))
+		backend->SetPrimitiveTopology(topology);
+}
+
+/// <summary>
+/// Forwarded if the input layout changed.
+/// </summary>
+void RenderStateCache::SetInputLayout(ID3D11InputLayout* layout)
+{
+	if (tracker.SetInputLayout(layout))
+		backend->SetInputLayout(layout);
+}
+
+/// <summary>
+/// Forwarded if the vertex shader changed.
+/// </summary>
+void RenderStateCache::SetVertexShader(ID3D11VertexShader* shader)
+{
+	if (tracker.SetVertexShader(shader))
+		backend->SetVertexShader(shader);
+}
+
+/// <summary>
+/// Forwarded if the pixel shader changed.
+/// </summary>
+void RenderStateCache::SetPixelShader(ID3D11PixelShader* shader)
+{
+	if (tracker.SetPixelShader(shader))
+		backend->SetPixelShader(shader);
+}
+
+/// <summary>
+/// Forwarded if the slot's buffer changed. Slots past
+/// the tracked range are always forwarded.
+/// </summary>
+void RenderStateCache::SetVSConstantBuffer(unsigned int slot, ID3D11Buffer* buffer)
+{
+	if (tracker.SetVSConstantBuffer(slot, buffer))
+		backend->SetVSConstantBuffer(slot, buffer);
+}
+
+/// <summary>
+/// Forwarded if the slot's buffer changed.
+/// </summary>
+void RenderStateCache::SetPSConstantBuffer(unsigned int slot, ID3D11Buffer* buffer)
+{
+	if (tracker.SetPSConstantBuffer(slot, buffer))
+		backend->SetPSConstantBuffer(slot, buffer);
+}
+
+/// <summary>
+/// Forwarded if the buffer, stride or offset changed.
+/// </summary>
+void RenderStateCache::SetVertexBuffer(ID3D11Buffer* buffer, unsigned int stride, unsigned int offset)
+{
+	if (tracker.SetVertexBuffer(buffer, stride, offset))
+		backend->SetVertexBuffer(buffer, stride, offset);
+}
+
+/// <summary>
+/// Forwarded if the buffer, format or offset changed.
+/// </summary>
+void RenderStateCache::SetIndexBuffer(ID3D11Buffer* buffer, DXGI_FORMAT format, unsigned int offset)
+{
+	if (tracker.SetIndexBuffer(buffer, (unsigned int)format, offset))
+		backend->SetIndexBuffer(buffer, format, offset);
+}
+
+/// <summary>
+/// Always forwarded.
+/// </summary>
+void RenderStateCache::DrawIndexed(unsigned int indexCount, unsigned int startIndex, int baseVertex)
+{
+	backend->DrawIndexed(indexCount, startIndex, baseVertex);
+}
+
+/// <summary>
+/// Forwarded if the buffer, stride or offset changed.
+/// </summary>
+void RenderStateCache::SetInstanceBuffer(ID3D11Buffer* buffer, unsigned int stride, unsigned int offset)
+{
+	if (tracker.SetInstanceBuffer(buffer, stride, offset))
+		backend->SetInstanceBuffer(buffer, stride, offset);
+}
+
+/// <summary>
+/// Always forwarded.
+/// </summary>
+void RenderStateCache::DrawIndexedInstanced(unsigned int indexCount, unsigned int instanceCount, unsigned int startIndex, int baseVertex, unsigned int startInstance)
+{
+	backend->DrawIndexedInstanced(indexCount, instanceCount, startIndex, baseVertex, startInstance);
+}
+
+/// <summary>
+/// Always forwarded.
+/// </summary>
+void RenderStateCache::UpdateDynamicBuffer(ID3D11Buffer* buffer, const void* data, unsigned int size)
+{
+	backend->UpdateDynamicBuffer(buffer, data, size);
+}
+
+/// <summary>
+/// Always forwarded (the data may differ even if the buffer doesn't).
+/// </summary>
+void RenderStateCache::UpdateConstantBuffer(ID3D11Buffer* buffer, const void* data, unsigned int size)
+{
+	backend->UpdateConstantBuffer(buffer, data, size);
+}
+
+/// <summary>
+/// Always forwarded.
+/// </summary>
+/// <returns>Returns the bytes the backend copied.</returns>
+unsigned int RenderStateCache::UpdateConstantRange(ID3D11Buffer* buffer, const void* data, unsigned int size, unsigned int begin, unsigned int end)
+{
+	return backend->UpdateConstantRange(buffer, data, size, begin, end);
+}
+
+/// <summary>
+/// Always forwarded. The slot's binding is then unknown: the
+/// backend may have bound a slice of its constant ring there
+/// instead of the buffer, so a later bind of the buffer must
+/// not be skipped.
+/// </summary>
+void RenderStateCache::WriteVSConstants(unsigned int slot, ID3D11Buffer* buffer, const void* data, unsigned int size)
+{
+	tracker.ForgetVSConstantBuffer(slot);
+	backend->WriteVSConstants(slot, buffer, data, size);
+}
+
+/// <summary>
+/// Always forwarded. Bound state survives Present().
+/// </summary>
+HRESULT RenderStateCache::Present(unsigned int syncInterval, unsigned int flags)
+{
+	return backend->Present(syncInterval, flags);
+}
+
+/// <summary>
+/// Is the wrapped backend the null backend?
+/// </summary>
+bool RenderStateCache::IsNull() const
+{
+	return backend->IsNull();
+}
+
+/// <summary>
+/// Did the wrapped backend's last Present() find nothing visible?
+/// </summary>
+bool RenderStateCache::IsOccluded() const
+{
+	return backend->IsOccluded();
+}
+
+/// <summary>
+/// Statistics of the wrapped backend - the calls that got through.
+/// </summary>
+const RenderBackendStatistics& RenderStateCache::GetStatistics() const
+{
+	return backend->GetStatistics();
+}
+
+/// <summary>
+/// Zero the wrapped backend's statistics and the cache's counters.
+/// </summary>
+void RenderStateCache::ResetStatistics()
+{
+	if (backend)
+		backend->ResetStatistics();
+	this->ResetCounters();
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+// -----------------------------------------------
+// Include statements.
+// -----------------------------------------------
+#include "RenderBackend.h"
+#include "RenderStateTracker.h"
+
+// -----------------------------------------------
+// RenderStateCache.h
+// ---
+// Sits in front of another backend, remembers
+// what's bound and drops calls that would bind
+// the same thing again. Draws, clears, uploads
+// and presents always pass through.
+//
+// The cache only talks to the IRenderBackend
+// interface, so any backend (including the null
+// one, which just counts) can stand behind it.
+// The bookkeeping itself is RenderStateTracker,
+// which has no Direct3D in it; this class only
+// adapts the backend calls to it.
+// -----------------------------------------------
+
+class RenderStateCache : public IRenderBackend
+{
+public:
+	// -----------------------------------------------
+	// Constructors.
+	// -----------------------------------------------
+
+	RenderStateCache(IRenderBackend* backend);	// Takes ownership of the backend.
+	~RenderStateCache();
+
+	// -----------------------------------------------
+	// Accessors.
+	// -----------------------------------------------
+
+	const RenderStateTracker::Counters& GetCounters() const;
+	IRenderBackend* GetBackend() const;
+
+	// -----------------------------------------------
+	// Service methods.
+	// -----------------------------------------------
+
+	void Invalidate();	// Forget all bound state (e.g. after ClearState() or outside binds).
+	void ResetCounters();
+
+	// -----------------------------------------------
+	// IRenderBackend.
+	// -----------------------------------------------
+
+	void Clear(ID3D11RenderTargetView* renderTarget, ID3D11DepthStencilView* depthStencil, const float color[4]);
+	void SetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY topology);
+	void SetInputLayout(ID3D11InputLayout* layout);
+	void SetVertexShader(ID3D11VertexShader* shader);
+	void SetPixelShader(ID3D11PixelShader* shader);
+	void SetVSConstantBuffer(unsigned int slot, ID3D11Buffer* buffer);
+	void SetPSConstantBuffer(unsigned int slot, ID3D11Buffer* buffer);
+	void SetVertexBuffer(ID3D11Buffer* buffer, unsigned int stride, unsigned int offset);
+	void SetIndexBuffer(ID3D11Buffer* buffer, DXGI_FORMAT format, unsigned int offset);
+	void DrawIndexed(unsigned int indexCount, unsigned int startIndex, int baseVertex);
+	void SetInstanceBuffer(ID3D11Buffer* buffer, unsigned int stride, unsigned int offset);
+	void DrawIndexedInstanced(unsigned int indexCount, unsigned int instanceCount, unsigned int startIndex, int baseVertex, unsigned int startInstance);
+	void UpdateDynamicBuffer(ID3D11Buffer* buffer, const void* data, unsigned int size);
+	void UpdateConstantBuffer(ID3D11Buffer* buffer, const void* data, unsigned int size);
+	unsigned int UpdateConstantRange(ID3D11Buffer* buffer, const void* data, unsigned int size, unsigned int begin, unsigned int end);
+	void WriteVSConstants(unsigned int slot, ID3D11Buffer* buffer, const void* data, unsigned int size);
+	HRESULT Present(unsigned int syncInterval, unsigned int flags);
+	bool IsNull() const;
+	bool IsOccluded() const;
+	const RenderBackendStatistics& GetStatistics() const;	// What reached the backend.
+	void ResetStatistics();
+
+private:
+
+	// -----------------------------------------------
+	// Data members.
+	// -----------------------------------------------
+
+	IRenderBackend* backend;
+	RenderStateTracker tracker;
+};
\ No newline at end of file
@@ -0,0 +1,241 @@
+// -----------------------------------------------
+// Include statements.
+// -----------------------------------------------
+#include "RenderStateTracker.h"
+#include "RenderCounters.h"
+
+// -----------------------------------------------
+// Constructors.
+// -----------------------------------------------
+
+/// <summary>
+/// Start with nothing known to be bound.
+/// </summary>
+RenderStateTracker::RenderStateTracker()
+{
+	this->Invalidate();
+	this->ResetCounters();
+}
+
+// -----------------------------------------------
+// Static methods.
+// -----------------------------------------------
+
+/// <summary>
+/// Short name of a kind of call.
+/// </summary>
+const char* RenderStateTracker::GetCallName(StateCall call)
+{
+	static const char* names[SC_COUNT] = {
+		"topology", "input layout", "vertex shader", "pixel shader",
+		"VS constants", "PS constants", "vertex buffer", "index buffer",
+		"instance buffer"
+	};
+	return (call >= 0 && call < SC_COUNT) ? names[call] : "?";
+}
+
+// -----------------------------------------------
+// Accessors.
+// -----------------------------------------------
+
+/// <summary>
+/// Issued and skipped call counts.
+/// </summary>
+const RenderStateTracker::Counters& RenderStateTracker::GetCounters() const
+{
+	return counters;
+}
+
+// -----------------------------------------------
+// Service methods.
+// -----------------------------------------------
+
+/// <summary>
+/// Forget all bound state, so every next call goes through.
+/// Needed whenever something binds state behind the tracker's back.
+/// </summary>
+void RenderStateTracker::Invalidate()
+{
+	bound = {};
+}
+
+/// <summary>
+/// Zero the issued/skipped counters.
+/// </summary>
+void RenderStateTracker::ResetCounters()
+{
+	counters = {};
+}
+
+/// <summary>
+/// Issue if the topology changed.
+/// </summary>
+bool RenderStateTracker::SetTopology(unsigned int topology)
+{
+	if (!Filter(SC_TOPOLOGY, bound.topology == topology))
+		return false;
+
+	bound.topology = topology;
+	return true;
+}
+
+/// <summary>
+/// Issue if the input layout changed.
+/// </summary>
+bool RenderStateTracker::SetInputLayout(const void* layout)
+{
+	if (!Filter(SC_INPUT_LAYOUT, bound.inputLayout == layout))
+		return false;
+
+	bound.inputLayout = layout;
+	return true;
+}
+
+/// <summary>
+/// Issue if the vertex shader changed.
+/// </summary>
+bool RenderStateTracker::SetVertexShader(const void* shader)
+{
+	if (!Filter(SC_VERTEX_SHADER, bound.vertexShader == shader))
+		return false;
+
+	bound.vertexShader = shader;
+	return true;
+}
+
+/// <summary>
+/// Issue if the pixel shader changed.
+/// </summary>
+bool RenderStateTracker::SetPixelShader(const void* shader)
+{
+	if (!Filter(SC_PIXEL_SHADER, bound.pixelShader == shader))
+		return false;
+
+	bound.pixelShader = shader;
+	return true;
+}
+
+/// <summary>
+/// Issue if the slot's buffer changed. Slots past the
+/// tracked range are always issued.
+/// </summary>
+bool RenderStateTracker::SetVSConstantBuffer(unsigned int slot, const void* buffer)
+{
+	return FilterSlot(SC_VS_CONSTANT_BUFFER, slot, buffer, bound.vsConstantBuffers, &bound.vsConstantBufferMask);
+}
+
+/// <summary>
+/// Issue if the slot's buffer changed.
+/// </summary>
+bool RenderStateTracker::SetPSConstantBuffer(unsigned int slot, const void* buffer)
+{
+	return FilterSlot(SC_PS_CONSTANT_BUFFER, slot, buffer, bound.psConstantBuffers, &bound.psConstantBufferMask);
+}
+
+/// <summary>
+/// Issue if the buffer, stride or offset changed.
+/// </summary>
+bool RenderStateTracker::SetVertexBuffer(const void* buffer, unsigned int stride, unsigned int offset)
+{
+	bool unchanged = bound.vertexBuffer == buffer && bound.vertexStride == stride && bound.vertexOffset == offset;
+	if (!Filter(SC_VERTEX_BUFFER, unchanged))
+		return false;
+
+	bound.vertexBuffer = buffer;
+	bound.vertexStride = stride;
+	bound.vertexOffset = offset;
+	return true;
+}
+
+/// <summary>
+/// Issue if the buffer, format or offset changed.
+/// </summary>
+bool RenderStateTracker::SetIndexBuffer(const void* buffer, unsigned int format, unsigned int offset)
+{
+	bool unchanged = bound.indexBuffer == buffer && bound.indexFormat == format && bound.indexOffset == offset;
+	if (!Filter(SC_INDEX_BUFFER, unchanged))
+		return false;
+
+	bound.indexBuffer = buffer;
+	bound.indexFormat = format;
+	bound.indexOffset = offset;
+	return true;
+}
+
+/// <summary>
+/// Issue if the buffer, stride or offset changed.
+/// </summary>
+bool RenderStateTracker::SetInstanceBuffer(const void* buffer, unsigned int stride, unsigned int offset)
+{
+	bool unchanged = bound.instanceBuffer == buffer && bound.instanceStride == stride && bound.instanceOffset == offset;
+	if (!Filter(SC_INSTANCE_BUFFER, unchanged))
+		return false;
+
+	bound.instanceBuffer = buffer;
+	bound.instanceStride = stride;
+	bound.instanceOffset = offset;
+	return true;
+}
+
+/// <summary>
+/// Mark a VS constant buffer slot unknown after something was
+/// bound to it without going through SetVSConstantBuffer()
+/// (e.g. a ring slice for per-draw constants), so the next
+/// bind to it is issued.
+/// </summary>
+void RenderStateTracker::ForgetVSConstantBuffer(unsigned int slot)
+{
+	if (slot >= CONSTANT_BUFFER_SLOTS)
+		return;
+
+	bound.vsConstantBufferMask &= ~(1u << slot);
+}
+
+// -----------------------------------------------
+// Helper methods.
+// -----------------------------------------------
+
+/// <summary>
+/// Count a call as issued or skipped.
+/// </summary>
+/// <param name="call">Kind of call.</param>
+/// <param name="unchanged">Does it match what's bound?</param>
+/// <returns>Returns true if the call should be issued.</returns>
+bool RenderStateTracker::Filter(StateCall call, bool unchanged)
+{
+	if (unchanged && bound.valid[call])
+	{
+		counters.skipped[call]++;
+		RenderCounters::Add(RenderCounters::RC_STATE_CHANGES_SKIPPED);
+		return false;
+	}
+
+	bound.valid[call] = true;
+	counters.issued[call]++;
+	return true;
+}
+
+/// <summary>
+/// Filter a constant buffer bind, tracking each slot on its own.
+/// </summary>
+/// <param name="buffers">The stage's bound buffers.</param>
+/// <param name="mask">The stage's slots with a known binding.</param>
+/// <returns>Returns true if the call should be issued.</returns>
+bool RenderStateTracker::FilterSlot(StateCall call, unsigned int slot, const void* buffer, const void** buffers, unsigned int* mask)
+{
+	if (slot < CONSTANT_BUFFER_SLOTS)
+	{
+		unsigned int bit = 1u << slot;
+		if ((*mask & bit) && buffers[slot] == buffer)
+		{
+			counters.skipped[call]++;
+			RenderCounters::Add(RenderCounters::RC_STATE_CHANGES_SKIPPED);
+			return false;
+		}
+		buffers[slot] = buffer;
+		*mask |= bit;
+	}
+
+	counters.issued[call]++;
+	return true;
+}
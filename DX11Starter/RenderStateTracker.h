@@ -0,0 +1,141 @@
+#pragma once
+
+// -----------------------------------------------
+// RenderStateTracker.h
+// ---
+// Remembers what's bound to the pipeline and
+// says whether a bind would change anything.
+// This is the bookkeeping behind RenderStateCache,
+// kept apart from Direct3D: objects are only
+// compared, so they're held as opaque pointers,
+// and enums (topology, index format) as numbers.
+// That lets it build and be checked anywhere.
+//
+// Each Set method returns true if the call should
+// be issued, and counts it as issued or skipped.
+// -----------------------------------------------
+
+class RenderStateTracker
+{
+public:
+	// -----------------------------------------------
+	// Internal enum/structs.
+	// -----------------------------------------------
+
+	/// <summary>
+	/// STATE_CALL determines which kind of binding a counter tracks.
+	/// </summary>
+	typedef enum _STATE_CALL
+	{
+		SC_TOPOLOGY = 0,
+		SC_INPUT_LAYOUT = 1,
+		SC_VERTEX_SHADER = 2,
+		SC_PIXEL_SHADER = 3,
+		SC_VS_CONSTANT_BUFFER = 4,
+		SC_PS_CONSTANT_BUFFER = 5,
+		SC_VERTEX_BUFFER = 6,
+		SC_INDEX_BUFFER = 7,
+		SC_INSTANCE_BUFFER = 8,
+		SC_COUNT = 9
+	} STATE_CALL;
+
+	/// <summary>
+	/// Wrapper for STATE_CALL enum.
+	/// </summary>
+	typedef STATE_CALL StateCall;
+
+	/// <summary>
+	/// Calls passed on to the backend, and calls dropped.
+	/// </summary>
+	struct Counters
+	{
+		unsigned long long issued[SC_COUNT];
+		unsigned long long skipped[SC_COUNT];
+	};
+
+	// Constant buffer slots tracked per stage
+	// (D3D11_COMMONSHADER_CONSTANT_BUFFER_API_SLOT_COUNT).
+	static const unsigned int CONSTANT_BUFFER_SLOTS = 14;
+
+	// -----------------------------------------------
+	// Constructors.
+	// -----------------------------------------------
+
+	RenderStateTracker();
+
+	// -----------------------------------------------
+	// Static methods.
+	// -----------------------------------------------
+
+	static const char* GetCallName(StateCall call);
+
+	// -----------------------------------------------
+	// Accessors.
+	// -----------------------------------------------
+
+	const Counters& GetCounters() const;
+
+	// -----------------------------------------------
+	// Service methods.
+	// -----------------------------------------------
+
+	void Invalidate();	// Forget all bound state; every next call is issued.
+	void ResetCounters();
+
+	bool SetTopology(unsigned int topology);
+	bool SetInputLayout(const void* layout);
+	bool SetVertexShader(const void* shader);
+	bool SetPixelShader(const void* shader);
+	bool SetVSConstantBuffer(unsigned int slot, const void* buffer);	// Slots past the tracked range are always issued.
+	bool SetPSConstantBuffer(unsigned int slot, const void* buffer);
+	bool SetVertexBuffer(const void* buffer, unsigned int stride, unsigned int offset);
+	bool SetIndexBuffer(const void* buffer, unsigned int format, unsigned int offset);
+	bool SetInstanceBuffer(const void* buffer, unsigned int stride, unsigned int offset);
+	void ForgetVSConstantBuffer(unsigned int slot);	// Bound some other way; the next bind is issued.
+
+private:
+
+	// -----------------------------------------------
+	// Internal structs.
+	// -----------------------------------------------
+
+	/// <summary>
+	/// Everything the tracker knows is bound. Invalid
+	/// entries force the next call through.
+	/// </summary>
+	struct BoundState
+	{
+		bool valid[SC_COUNT];
+		unsigned int topology;
+		const void* inputLayout;
+		const void* vertexShader;
+		const void* pixelShader;
+		const void* vsConstantBuffers[CONSTANT_BUFFER_SLOTS];
+		const void* psConstantBuffers[CONSTANT_BUFFER_SLOTS];
+		unsigned int vsConstantBufferMask;	// Slots with a known binding.
+		unsigned int psConstantBufferMask;
+		const void* vertexBuffer;
+		unsigned int vertexStride;
+		unsigned int vertexOffset;
+		const void* indexBuffer;
+		unsigned int indexFormat;
+		unsigned int indexOffset;
+		const void* instanceBuffer;
+		unsigned int instanceStride;
+		unsigned int instanceOffset;
+	};
+
+	// -----------------------------------------------
+	// Data members.
+	// -----------------------------------------------
+
+	BoundState bound;
+	Counters counters;
+
+	// -----------------------------------------------
+	// Helper methods.
+	// -----------------------------------------------
+
+	bool Filter(StateCall call, bool unchanged);	// Returns true if the call should be issued.
+	bool FilterSlot(StateCall call, unsigned int slot, const void* buffer, const void** buffers, unsigned int* mask);
+};
@@ -0,0 +1,179 @@
+// -----------------------------------------------
+// Include statements.
+// -----------------------------------------------
+#include "RingAllocator.h"
+
+// -----------------------------------------------
+// Constructors.
+// -----------------------------------------------
+
+/// <summary>
+/// Create an empty ring.
+/// </summary>
+/// <param name="capacity">Size of the buffer, in bytes.</param>
+/// <param name="alignment">Every allocation starts on a multiple of this (a power of two).</param>
+RingAllocator::RingAllocator(unsigned int capacity, unsigned int alignment)
+	: stats{}
+{
+	this->Reset(capacity, alignment);
+}
+
+// -----------------------------------------------
+// Accessors.
+// -----------------------------------------------
+
+/// <summary>
+/// Size of the buffer, in bytes.
+/// </summary>
+unsigned int RingAllocator::GetCapacity() const
+{
+	return capacity;
+}
+
+/// <summary>
+/// Alignment of every allocation, in bytes.
+/// </summary>
+unsigned int RingAllocator::GetAlignment() const
+{
+	return alignment;
+}
+
+/// <summary>
+/// Bytes that can't be handed out yet.
+/// </summary>
+unsigned int RingAllocator::GetUsed() const
+{
+	return used;
+}
+
+/// <summary>
+/// Frames ended but not yet retired.
+/// </summary>
+size_t RingAllocator::GetFramesInFlight() const
+{
+	return frames.size();
+}
+
+/// <summary>
+/// Running totals since the last ResetStatistics().
+/// </summary>
+const RingAllocator::Statistics& RingAllocator::GetStatistics() const
+{
+	return stats;
+}
+
+// -----------------------------------------------
+// Service methods.
+// -----------------------------------------------
+
+/// <summary>
+/// Start over with an empty ring. The next allocation
+/// asks for a discard.
+/// </summary>
+/// <param name="capacity">Size of the buffer, in bytes.</param>
+/// <param name="alignment">Allocation alignment (a power of two).</param>
+void RingAllocator::Reset(unsigned int capacity, unsigned int alignment)
+{
+	this->capacity = capacity;
+	this->alignment = (alignment > 0) ? alignment : 1;
+	head = 0;
+	used = 0;
+	frameBytes = 0;
+	written = false;
+	frames.clear();
+}
+
+/// <summary>
+/// Reserve room for size bytes. Goes back to the start
+/// of the buffer if the end is too short, and asks for
+/// a discard if the room is still held by frames in flight.
+/// </summary>
+/// <param name="size">Bytes needed.</param>
+/// <param name="offset">Receives the offset of the allocation.</param>
+/// <param name="map">Receives how the buffer must be mapped to write it.</param>
+/// <returns>Returns false if size is 0 or larger than the ring.</returns>
+bool RingAllocator::Allocate(unsigned int size, unsigned int* offset, RingMap* map)
+{
+	unsigned int aligned = (size + alignment - 1) & ~(alignment - 1);
+	if (size == 0 || aligned < size || aligned > capacity)
+	{
+		stats.failures++;
+		return false;
+	}
+
+	// Skip the end of the buffer if it's too short.
+	unsigned int start = head;
+	unsigned int skipped = 0;
+	if (aligned > capacity - start)
+	{
+		skipped = capacity - start;
+		start = 0;
+	}
+
+	if (!written || aligned + skipped > capacity - used)
+	{
+		// Everything ahead may still be read by the GPU. A discard
+		// gives the buffer new memory, leaving the old copy to the
+		// frames still using it, so the whole ring is free again.
+		if (written)
+			stats.discards++;
+
+		frames.clear();
+		used = 0;
+		frameBytes = 0;
+		start = 0;
+		skipped = 0;
+		written = true;
+		*map = RM_DISCARD;
+	}
+	else
+	{
+		if (skipped > 0)
+			stats.wraps++;
+		*map = RM_NO_OVERWRITE;
+	}
+
+	used += skipped + aligned;
+	frameBytes += skipped + aligned;
+	head = start + aligned;
+	*offset = start;
+
+	stats.allocations++;
+	stats.bytes += size;
+	return true;
+}
+
+/// <summary>
+/// Close the current frame. Its bytes are held until a
+/// Retire() with this fence value or a later one.
+/// </summary>
+/// <param name="fence">Value the GPU will signal when the frame is done.</param>
+void RingAllocator::EndFrame(unsigned long long fence)
+{
+	if (frameBytes == 0)
+		return;
+
+	frames.push_back(Frame{ fence, frameBytes });
+	frameBytes = 0;
+}
+
+/// <summary>
+/// Free the bytes of every frame the GPU has finished.
+/// </summary>
+/// <param name="completedFence">Last fence value the GPU signaled.</param>
+void RingAllocator::Retire(unsigned long long completedFence)
+{
+	while (!frames.empty() && frames.front().fence <= completedFence)
+	{
+		used -= frames.front().bytes;
+		frames.pop_front();
+	}
+}
+
+/// <summary>
+/// Zero the running totals.
+/// </summary>
+void RingAllocator::ResetStatistics()
+{
+	stats = {};
+}
@@ -0,0 +1,113 @@
+#pragma once
+
+// -----------------------------------------------
+// Include statements.
+// -----------------------------------------------
+#include <cstddef>
+#include <deque>
+
+// -----------------------------------------------
+// RingAllocator.h
+// ---
+// Offset bookkeeping for one large GPU buffer
+// that is filled front to back every frame and
+// wraps around to the start when it reaches the
+// end. It never touches the device, so the same
+// logic serves any buffer (and runs anywhere).
+//
+// Each frame's bytes stay reserved until the
+// caller reports that the GPU finished that frame
+// (Retire(), with the fence value the frame was
+// ended with). An allocation that would overwrite
+// data still in flight asks for a discard instead:
+// the driver gives the buffer new memory and the
+// whole ring becomes free again.
+// -----------------------------------------------
+
+class RingAllocator
+{
+public:
+	// -----------------------------------------------
+	// Internal enum/structs.
+	// -----------------------------------------------
+
+	/// <summary>
+	/// RING_MAP determines how the buffer must be mapped to write an allocation.
+	/// </summary>
+	typedef enum _RING_MAP
+	{
+		RM_NO_OVERWRITE = 0,	// Nothing in flight is touched.
+		RM_DISCARD = 1			// First write, or the ring was full.
+	} RING_MAP;
+
+	/// <summary>
+	/// Wrapper for RING_MAP enum.
+	/// </summary>
+	typedef RING_MAP RingMap;
+
+	/// <summary>
+	/// Running totals.
+	/// </summary>
+	struct Statistics
+	{
+		unsigned long long allocations;
+		unsigned long long bytes;		// Requested, before alignment.
+		unsigned long long wraps;		// Went back to the start of the buffer.
+		unsigned long long discards;	// Ran into data still in flight.
+		unsigned long long failures;	// Larger than the whole ring.
+	};
+
+	// -----------------------------------------------
+	// Constructors.
+	// -----------------------------------------------
+
+	RingAllocator(unsigned int capacity = 0, unsigned int alignment = 256);
+
+	// -----------------------------------------------
+	// Accessors.
+	// -----------------------------------------------
+
+	unsigned int GetCapacity() const;
+	unsigned int GetAlignment() const;
+	unsigned int GetUsed() const;	// Bytes reserved by frames in flight and the current frame.
+	size_t GetFramesInFlight() const;
+	const Statistics& GetStatistics() const;
+
+	// -----------------------------------------------
+	// Service methods.
+	// -----------------------------------------------
+
+	void Reset(unsigned int capacity, unsigned int alignment);	// Forget everything (e.g. new buffer).
+	bool Allocate(unsigned int size, unsigned int* offset, RingMap* map);	// Returns false if size is 0 or too large.
+	void EndFrame(unsigned long long fence);	// Fence values must increase.
+	void Retire(unsigned long long completedFence);	// Frees every frame ended with a fence <= completedFence.
+	void ResetStatistics();
+
+private:
+
+	// -----------------------------------------------
+	// Internal structs.
+	// -----------------------------------------------
+
+	/// <summary>
+	/// A frame the GPU may still be reading.
+	/// </summary>
+	struct Frame
+	{
+		unsigned long long fence;
+		unsigned int bytes;		// Including any end of buffer skipped by a wrap.
+	};
+
+	// -----------------------------------------------
+	// Data members.
+	// -----------------------------------------------
+
+	unsigned int capacity;
+	unsigned int alignment;		// Power of two.
+	unsigned int head;			// Next free byte.
+	unsigned int used;
+	unsigned int frameBytes;	// Reserved by the current frame so far.
+	bool written;				// Has the buffer been mapped since Reset()?
+	std::deque<Frame> frames;
+	Statistics stats;
+};
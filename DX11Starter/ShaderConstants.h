@@ -0,0 +1,95 @@
+#pragma once
+
+// -----------------------------------------------
+// ShaderConstants.h
+// ---
+// Generated by CBufferGen from:
+//  - VertexShader.hlsl
+//  - PixelShader.hlsl
+//  - InstancedVertexShader.hlsl
+// Edit the shaders and rebuild rather than
+// editing this file.
+//
+// One struct per cbuffer, with every member
+// where HLSL packs it (checked below), so a
+// whole buffer can be filled and handed to
+// ISimpleShader::SetBufferData() at once.
+// Padding is spelled out as members: create the
+// structs with "= {}" so it's zero, and an
+// unchanged buffer compares equal.
+// -----------------------------------------------
+#include <DirectXMath.h>
+#include <cstddef>
+
+namespace ShaderConstants
+{
+	namespace VertexShader
+	{
+		struct alignas(16) perFrame
+		{
+			static const char* Name() { return "perFrame"; }
+			static const int Register = 0;
+
+			DirectX::XMFLOAT4X4 view;
+			DirectX::XMFLOAT4X4 projection;
+		};
+		static_assert(offsetof(perFrame, view) == 0, "perFrame.view isn't where HLSL packs it");
+		static_assert(offsetof(perFrame, projection) == 64, "perFrame.projection isn't where HLSL packs it");
+		static_assert(sizeof(perFrame) == 128, "perFrame isn't the size of the HLSL cbuffer");
+
+		struct alignas(16) perObject
+		{
+			static const char* Name() { return "perObject"; }
+			static const int Register = 1;
+
+			DirectX::XMFLOAT4X4 world;
+			DirectX::XMFLOAT4 surface;
+		};
+		static_assert(offsetof(perObject, world) == 0, "perObject.world isn't where HLSL packs it");
+		static_assert(offsetof(perObject, surface) == 64, "perObject.surface isn't where HLSL packs it");
+		static_assert(sizeof(perObject) == 80, "perObject isn't the size of the HLSL cbuffer");
+	}
+
+	namespace PixelShader
+	{
+		struct DirectionalLight
+		{
+			DirectX::XMFLOAT4 AmbientColor;
+			DirectX::XMFLOAT4 DiffuseColor;
+			DirectX::XMFLOAT3 Direction;
+		};
+		static_assert(offsetof(DirectionalLight, AmbientColor) == 0, "DirectionalLight.AmbientColor isn't where HLSL packs it");
+		static_assert(offsetof(DirectionalLight, DiffuseColor) == 16, "DirectionalLight.DiffuseColor isn't where HLSL packs it");
+		static_assert(offsetof(DirectionalLight, Direction) == 32, "DirectionalLight.Direction isn't where HLSL packs it");
+		static_assert(sizeof(DirectionalLight) == 44, "DirectionalLight isn't the size HLSL gives it");
+
+		struct alignas(16) perFrame
+		{
+			static const char* Name() { return "perFrame"; }
+			static const int Register = 0;
+
+			DirectionalLight light1;
+			unsigned int padding0[1];
+			DirectionalLight light2;
+			unsigned int padding1[1];
+		};
+		static_assert(offsetof(perFrame, light1) == 0, "perFrame.light1 isn't where HLSL packs it");
+		static_assert(offsetof(perFrame, light2) == 48, "perFrame.light2 isn't where HLSL packs it");
+		static_assert(sizeof(perFrame) == 96, "perFrame isn't the size of the HLSL cbuffer");
+	}
+
+	namespace InstancedVertexShader
+	{
+		struct alignas(16) perFrame
+		{
+			static const char* Name() { return "perFrame"; }
+			static const int Register = 0;
+
+			DirectX::XMFLOAT4X4 view;
+			DirectX::XMFLOAT4X4 projection;
+		};
+		static_assert(offsetof(perFrame, view) == 0, "perFrame.view isn't where HLSL packs it");
+		static_assert(offsetof(perFrame, projection) == 64, "perFrame.projection isn't where HLSL packs it");
+		static_assert(sizeof(perFrame) == 128, "perFrame isn't the size of the HLSL cbuffer");
+	}
+}
@@ -0,0 +1,299 @@
+// -----------------------------------------------
+// Include statements.
+// -----------------------------------------------
+#include "ShaderReflectionCache.h"
+#include <cstring>
+#include <utility>
+
+// -----------------------------------------------
+// Constants.
+// -----------------------------------------------
+
+// First four bytes of every sidecar.
+static const unsigned char MAGIC[4] = { 'S', 'R', 'F', 'L' };
+
+// Smallest each entry can be: its numbers and an empty
+// name's length. Counts that couldn't fit in what's left
+// of the file are rejected before anything is allocated.
+static const size_t MIN_RESOURCE_BYTES = 3 * sizeof(unsigned int);
+static const size_t MIN_BUFFER_BYTES = 5 * sizeof(unsigned int);
+static const size_t MIN_VARIABLE_BYTES = 3 * sizeof(unsigned int);
+static const size_t MIN_INPUT_BYTES = 5 * sizeof(unsigned int);
+
+// Largest D3D_REGISTER_COMPONENT_TYPE (D3D_REGISTER_COMPONENT_FLOAT32).
+static const unsigned int MAX_COMPONENT_TYPE = 3;
+
+// Largest constant buffer Direct3D 11 allows: 4096 constants
+// of 16 bytes (D3D11_REQ_CONSTANT_BUFFER_ELEMENT_COUNT).
+static const unsigned int MAX_BUFFER_BYTES = 4096 * 16;
+
+// Append a number.
+template <typename T>
+static void Write(std::vector<unsigned char>* bytes, T value)
+{
+	const unsigned char* raw = (const unsigned char*)&value;
+	bytes->insert(bytes->end(), raw, raw + sizeof(T));
+}
+
+// Append a string, as its length and then its characters.
+static void WriteString(std::vector<unsigned char>* bytes, const std::string& text)
+{
+	Write(bytes, (unsigned int)text.size());
+	bytes->insert(bytes->end(), text.begin(), text.end());
+}
+
+// Read a number, moving the cursor past it. False if the
+// bytes run out first.
+template <typename T>
+static bool Read(const unsigned char*& cursor, const unsigned char* end, T* value)
+{
+	if ((size_t)(end - cursor) < sizeof(T))
+		return false;
+	memcpy(value, cursor, sizeof(T));
+	cursor += sizeof(T);
+	return true;
+}
+
+// Read a string written by WriteString().
+static bool ReadString(const unsigned char*& cursor, const unsigned char* end, std::string* text)
+{
+	unsigned int length = 0;
+	if (!Read(cursor, end, &length) || (size_t)(end - cursor) < length)
+		return false;
+	text->assign((const char*)cursor, length);
+	cursor += length;
+	return true;
+}
+
+// Read a count of entries, each at least minBytes long. False
+// if that many couldn't fit in the bytes left.
+static bool ReadCount(const unsigned char*& cursor, const unsigned char* end, size_t minBytes, unsigned int* count)
+{
+	return Read(cursor, end, count) && *count <= (size_t)(end - cursor) / minBytes;
+}
+
+// -----------------------------------------------
+// Static methods.
+// -----------------------------------------------
+
+/// <summary>
+/// 64 bit FNV-1a hash of some bytes.
+/// </summary>
+/// <param name="data">Bytes to hash (e.g. a compiled shader).</param>
+/// <param name="size">Number of bytes.</param>
+unsigned long long ShaderReflectionCache::Hash(const void* data, size_t size)
+{
+	const unsigned char* bytes = (const unsigned char*)data;
+	unsigned long long hash = 14695981039346656037ull;
+	for (size_t i = 0; i < size; i++)
+	{
+		hash ^= bytes[i];
+		hash *= 1099511628211ull;
+	}
+	return hash;
+}
+
+/// <summary>
+/// Where a compiled shader's sidecar lives: next to it, with
+/// ".refl" added to the name.
+/// </summary>
+std::string ShaderReflectionCache::GetSidecarPath(const std::string& shaderPath)
+{
+	return shaderPath + ".refl";
+}
+
+/// <summary>
+/// Same as above, for wide paths (what SimpleShader loads from).
+/// </summary>
+std::wstring ShaderReflectionCache::GetSidecarPath(const std::wstring& shaderPath)
+{
+	return shaderPath + L".refl";
+}
+
+/// <summary>
+/// Which vertex buffer slot an input reads from. Semantics
+/// ending in "_PER_INSTANCE" come from INSTANCE_SLOT, a step
+/// per instance, and everything else from slot 0.
+/// </summary>
+/// <param name="semanticName">The input's semantic, without its index.</param>
+unsigned int ShaderReflectionCache::GetInputSlot(const std::string& semanticName)
+{
+	static const std::string suffix = "_PER_INSTANCE";
+	bool perInstance = semanticName.size() >= suffix.size() &&
+		semanticName.compare(semanticName.size() - suffix.size(), suffix.size(), suffix) == 0;
+	return perInstance ? INSTANCE_SLOT : 0;
+}
+
+/// <summary>
+/// The DXGI_FORMAT for an input with this many 32 bit
+/// components (the highest bit of its mask) of this type.
+/// </summary>
+/// <param name="componentType">D3D_REGISTER_COMPONENT_TYPE of the input.</param>
+/// <param name="mask">The input's component mask.</param>
+/// <returns>Returns 0 (DXGI_FORMAT_UNKNOWN) for an unknown type or an empty mask.</returns>
+unsigned int ShaderReflectionCache::GetInputFormat(unsigned int componentType, unsigned int mask)
+{
+	// One row per component count, in the order
+	// UINT32, SINT32, FLOAT32 (component types 1 to 3).
+	static const unsigned int formats[4][3] =
+	{
+		{ 42, 43, 41 },	// R32_UINT, R32_SINT, R32_FLOAT
+		{ 17, 18, 16 },	// R32G32_UINT, R32G32_SINT, R32G32_FLOAT
+		{ 7, 8, 6 },	// R32G32B32_UINT, R32G32B32_SINT, R32G32B32_FLOAT
+		{ 3, 4, 2 }		// R32G32B32A32_UINT, R32G32B32A32_SINT, R32G32B32A32_FLOAT
+	};
+
+	if (componentType < 1 || componentType > MAX_COMPONENT_TYPE || mask == 0 || mask > 15)
+		return 0;
+	unsigned int components = (mask >= 8) ? 4 : (mask >= 4) ? 3 : (mask >= 2) ? 2 : 1;
+	return formats[components - 1][componentType - 1];
+}
+
+/// <summary>
+/// Write a reflection to bytes, ready to be saved as a sidecar.
+/// </summary>
+/// <param name="reflection">What was reflected.</param>
+/// <param name="shaderHash">Hash() of the compiled shader it came from.</param>
+/// <param name="bytes">Replaced with the sidecar's contents.</param>
+void ShaderReflectionCache::Serialize(const Reflection& reflection, unsigned long long shaderHash, std::vector<unsigned char>* bytes)
+{
+	bytes->clear();
+	bytes->insert(bytes->end(), MAGIC, MAGIC + sizeof(MAGIC));
+	Write(bytes, VERSION);
+	Write(bytes, shaderHash);
+
+	Write(bytes, (unsigned int)reflection.resources.size());
+	for (const Resource& resource : reflection.resources)
+	{
+		Write(bytes, (unsigned int)resource.kind);
+		Write(bytes, resource.bindIndex);
+		WriteString(bytes, resource.name);
+	}
+
+	Write(bytes, (unsigned int)reflection.buffers.size());
+	for (const Buffer& buffer : reflection.buffers)
+	{
+		Write(bytes, buffer.type);
+		Write(bytes, buffer.size);
+		Write(bytes, buffer.bindIndex);
+		WriteString(bytes, buffer.name);
+
+		Write(bytes, (unsigned int)buffer.variables.size());
+		for (const Variable& variable : buffer.variables)
+		{
+			Write(bytes, variable.offset);
+			Write(bytes, variable.size);
+			WriteString(bytes, variable.name);
+		}
+	}
+
+	Write(bytes, (unsigned int)reflection.inputs.size());
+	for (const Input& input : reflection.inputs)
+	{
+		Write(bytes, input.semanticIndex);
+		Write(bytes, input.componentType);
+		Write(bytes, input.mask);
+		Write(bytes, input.inputSlot);
+		WriteString(bytes, input.semanticName);
+	}
+}
+
+/// <summary>
+/// Read a sidecar written by Serialize().
+/// </summary>
+/// <param name="bytes">The sidecar's contents.</param>
+/// <param name="size">Number of bytes.</param>
+/// <param name="shaderHash">Hash() of the compiled shader being loaded.</param>
+/// <param name="reflection">Receives the reflection. Left empty on failure.</param>
+/// <returns>Returns false if the sidecar is for a different shader or version, or is malformed.</returns>
+bool ShaderReflectionCache::Deserialize(const unsigned char* bytes, size_t size, unsigned long long shaderHash, Reflection* reflection)
+{
+	reflection->resources.clear();
+	reflection->buffers.clear();
+	reflection->inputs.clear();
+
+	// Read into a copy, so nothing half read is left behind
+	// to be mixed with a fresh reflection.
+	Reflection parsed;
+	const unsigned char* cursor = bytes;
+	const unsigned char* end = bytes + size;
+
+	unsigned int version = 0;
+	unsigned long long hash = 0;
+	if (size < sizeof(MAGIC) || memcmp(bytes, MAGIC, sizeof(MAGIC)) != 0)
+		return false;
+	cursor += sizeof(MAGIC);
+	if (!Read(cursor, end, &version) || version != VERSION ||
+		!Read(cursor, end, &hash) || hash != shaderHash)
+		return false;
+
+	unsigned int resourceCount = 0;
+	if (!ReadCount(cursor, end, MIN_RESOURCE_BYTES, &resourceCount))
+		return false;
+	parsed.resources.resize(resourceCount);
+	for (Resource& resource : parsed.resources)
+	{
+		unsigned int kind = 0;
+		if (!Read(cursor, end, &kind) || kind > RK_SAMPLER ||
+			!Read(cursor, end, &resource.bindIndex) ||
+			!ReadString(cursor, end, &resource.name))
+			return false;
+		resource.kind = (ResourceKind)kind;
+	}
+
+	unsigned int bufferCount = 0;
+	if (!ReadCount(cursor, end, MIN_BUFFER_BYTES, &bufferCount))
+		return false;
+	parsed.buffers.resize(bufferCount);
+	for (Buffer& buffer : parsed.buffers)
+	{
+		unsigned int variableCount = 0;
+		if (!Read(cursor, end, &buffer.type) ||
+			!Read(cursor, end, &buffer.size) ||
+			!Read(cursor, end, &buffer.bindIndex) ||
+			!ReadString(cursor, end, &buffer.name) ||
+			!ReadCount(cursor, end, MIN_VARIABLE_BYTES, &variableCount))
+			return false;
+
+		// The buffer's local copy is allocated at this size.
+		if (buffer.size > MAX_BUFFER_BYTES || buffer.size % 16 != 0)
+			return false;
+
+		// Variables are written to without bounds checks later,
+		// so every one must lie inside its buffer.
+		buffer.variables.resize(variableCount);
+		for (Variable& variable : buffer.variables)
+		{
+			if (!Read(cursor, end, &variable.offset) ||
+				!Read(cursor, end, &variable.size) ||
+				!ReadString(cursor, end, &variable.name) ||
+				(unsigned long long)variable.offset + variable.size > buffer.size)
+				return false;
+		}
+	}
+
+	// The input layout is built straight from these, so
+	// only what reflection could have given is accepted.
+	unsigned int inputCount = 0;
+	if (!ReadCount(cursor, end, MIN_INPUT_BYTES, &inputCount))
+		return false;
+	parsed.inputs.resize(inputCount);
+	for (Input& input : parsed.inputs)
+	{
+		if (!Read(cursor, end, &input.semanticIndex) ||
+			!Read(cursor, end, &input.componentType) ||
+			!Read(cursor, end, &input.mask) ||
+			!Read(cursor, end, &input.inputSlot) ||
+			!ReadString(cursor, end, &input.semanticName) ||
+			input.componentType > MAX_COMPONENT_TYPE || input.mask > 15 ||
+			input.inputSlot != GetInputSlot(input.semanticName))
+			return false;
+	}
+
+	// Trailing bytes mean it wasn't written by this version.
+	if (cursor != end)
+		return false;
+
+	*reflection = std::move(parsed);
+	return true;
+}
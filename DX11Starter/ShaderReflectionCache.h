@@ -0,0 +1,135 @@
+#pragma once
+
+// -----------------------------------------------
+// Include statements.
+// -----------------------------------------------
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// -----------------------------------------------
+// ShaderReflectionCache.h
+// ---
+// What SimpleShader learns from reflecting a
+// compiled shader (its constant buffers, their
+// variables, its textures and samplers, and the
+// inputs a vertex shader's layout is built from),
+// in a form that can be written to a small
+// sidecar file next to the .cso and read back
+// with one read on the next run, instead of
+// reflecting again.
+//
+// The sidecar is keyed by a hash (64 bit FNV-1a)
+// of the compiled shader, so recompiling makes
+// the old one stale and it is simply rebuilt.
+// Numbers are stored in the machine's own byte
+// order: the cache is local, not something to
+// ship. Anything that doesn't parse (wrong key,
+// version, truncated, offsets past the end of a
+// buffer) is rejected rather than trusted.
+//
+// Nothing here touches Direct3D, so it builds
+// and runs anywhere.
+// -----------------------------------------------
+
+class ShaderReflectionCache
+{
+public:
+	// -----------------------------------------------
+	// Internal enum/structs.
+	// -----------------------------------------------
+
+	/// <summary>
+	/// RESOURCE_KIND determines what a bound resource is.
+	/// </summary>
+	typedef enum _RESOURCE_KIND
+	{
+		RK_TEXTURE = 0,
+		RK_SAMPLER = 1
+	} RESOURCE_KIND;
+
+	/// <summary>
+	/// Wrapper for RESOURCE_KIND enum.
+	/// </summary>
+	typedef RESOURCE_KIND ResourceKind;
+
+	/// <summary>
+	/// A texture or sampler and the register it's bound to.
+	/// </summary>
+	struct Resource
+	{
+		std::string name;
+		ResourceKind kind;
+		unsigned int bindIndex;
+	};
+
+	/// <summary>
+	/// A variable in a constant buffer.
+	/// </summary>
+	struct Variable
+	{
+		std::string name;
+		unsigned int offset;	// Bytes from the start of the buffer.
+		unsigned int size;
+	};
+
+	/// <summary>
+	/// A constant buffer and its variables.
+	/// </summary>
+	struct Buffer
+	{
+		std::string name;
+		unsigned int type;		// D3D_CBUFFER_TYPE.
+		unsigned int size;
+		unsigned int bindIndex;
+		std::vector<Variable> variables;
+	};
+
+	/// <summary>
+	/// An element of the shader's input signature.
+	/// </summary>
+	struct Input
+	{
+		std::string semanticName;
+		unsigned int semanticIndex;
+		unsigned int componentType;	// D3D_REGISTER_COMPONENT_TYPE.
+		unsigned int mask;			// Components used, one bit each.
+		unsigned int inputSlot;		// GetInputSlot() of the semantic.
+	};
+
+	/// <summary>
+	/// Everything cached for one shader, in reflection order.
+	/// </summary>
+	struct Reflection
+	{
+		std::vector<Resource> resources;
+		std::vector<Buffer> buffers;
+		std::vector<Input> inputs;
+	};
+
+	// Bumped whenever the file layout changes.
+	static const unsigned int VERSION = 2;
+
+	// Vertex buffer slot for per instance inputs.
+	static const unsigned int INSTANCE_SLOT = 1;
+
+	// -----------------------------------------------
+	// Static methods.
+	// -----------------------------------------------
+
+	static unsigned long long Hash(const void* data, size_t size);	// 64 bit FNV-1a.
+	static std::string GetSidecarPath(const std::string& shaderPath);	// "Shader.cso" -> "Shader.cso.refl".
+	static std::wstring GetSidecarPath(const std::wstring& shaderPath);
+	static unsigned int GetInputSlot(const std::string& semanticName);	// INSTANCE_SLOT for "..._PER_INSTANCE", otherwise 0.
+	static unsigned int GetInputFormat(unsigned int componentType, unsigned int mask);	// DXGI_FORMAT, 0 (unknown) if there's none.
+	static void Serialize(const Reflection& reflection, unsigned long long shaderHash, std::vector<unsigned char>* bytes);
+	static bool Deserialize(const unsigned char* bytes, size_t size, unsigned long long shaderHash, Reflection* reflection);	// False if stale or malformed.
+
+private:
+
+	// -----------------------------------------------
+	// Constructors.
+	// -----------------------------------------------
+
+	ShaderReflectionCache() = delete;
+};
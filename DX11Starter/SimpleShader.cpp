@@ -1,4 +1,6 @@
 #include "SimpleShader.h"
+#include "RenderCounters.h"
+#include <fstream>
 
 #pragma warning( push )
 // #pragma warning( disable : 26495 )
@@ -7,6 +9,10 @@
 // ------ BASE SIMPLE SHADER --------------------------------------------------
 ///////////////////////////////////////////////////////////////////////////////
 
+ID3D11DeviceContext* ISimpleShader::probedContext = 0;
+ID3D11DeviceContext1* ISimpleShader::probedContext1 = 0;
+unsigned int ISimpleShader::probeUsers = 0;
+
 // --------------------------------------------------------
 // Constructor accepts DirectX device & context
 // --------------------------------------------------------
@@ -20,6 +26,11 @@ ISimpleShader::ISimpleShader(ID3D11Device* device, ID3D11DeviceContext* context)
 	constantBufferCount = 0;
 	constantBuffers = 0;
 	shaderBlob = 0;
+
+	// Partial constant buffer updates need the 11.1 context
+	// and a driver that supports them - otherwise every copy
+	// is of the whole buffer
+	deviceContext1 = AcquireContext1(device, context, &sharesProbe);
 }
 
 // --------------------------------------------------------
@@ -30,6 +41,58 @@ ISimpleShader::~ISimpleShader()
 	// Derived class destructors will call this class's CleanUp method
 	if (shaderBlob)
 		shaderBlob->Release();
+	if (sharesProbe)
+		ReleaseContext1();
+}
+
+// --------------------------------------------------------
+// Gets the 11.1 context for partial constant buffer updates,
+// probing the device only for the first shader made with
+// this context.  Shaders made with a different context
+// while the first one's are alive copy whole buffers
+//
+// shared - Set to whether the caller must ReleaseContext1()
+//
+// Returns null if partial updates aren't available
+// --------------------------------------------------------
+ID3D11DeviceContext1* ISimpleShader::AcquireContext1(ID3D11Device* device, ID3D11DeviceContext* context, bool* shared)
+{
+	*shared = false;
+	if (probeUsers > 0 && probedContext != context)
+		return 0;
+
+	if (probeUsers == 0)
+	{
+		probedContext = context;
+		probedContext1 = 0;
+		D3D11_FEATURE_DATA_D3D11_OPTIONS options = {};
+		if (SUCCEEDED(device->CheckFeatureSupport(D3D11_FEATURE_D3D11_OPTIONS, &options, sizeof(options))) &&
+			options.ConstantBufferPartialUpdate &&
+			FAILED(context->QueryInterface(__uuidof(ID3D11DeviceContext1), (void**)&probedContext1)))
+		{
+			probedContext1 = 0;
+		}
+	}
+
+	probeUsers++;
+	*shared = true;
+	return probedContext1;
+}
+
+// --------------------------------------------------------
+// Lets go of the shared 11.1 context once the last shader
+// using it is gone, so the next one probes again (the
+// device may be new)
+// --------------------------------------------------------
+void ISimpleShader::ReleaseContext1()
+{
+	if (--probeUsers > 0)
+		return;
+
+	if (probedContext1)
+		probedContext1->Release();
+	probedContext = 0;
+	probedContext1 = 0;
 }
 
 // --------------------------------------------------------
@@ -69,6 +132,10 @@ void ISimpleShader::CleanUp()
 // reflection.  This must be a separate step from the constructor since
 // we can't invoke derived class overrides in the base class constructor.
 //
+// The reflection is cached in a sidecar file next to the shader
+// (see ShaderReflectionCache), so later runs read that instead of
+// reflecting again - as long as the shader hasn't changed since
+//
 // shaderFile - A "wide string" specifying the compiled shader to load
 //
 // Returns true if shader is loaded properly, false otherwise
@@ -82,31 +149,64 @@ bool ISimpleShader::LoadShaderFile(LPCWSTR shaderFile)
 		return false;
 	}
 
+	// Use the cached reflection if it's for this exact blob,
+	// otherwise reflect and cache the result for next time
+	ShaderReflectionCache::Reflection reflection;
+	unsigned long long hash = ShaderReflectionCache::Hash(
+		shaderBlob->GetBufferPointer(),
+		shaderBlob->GetBufferSize());
+	std::wstring sidecar = ShaderReflectionCache::GetSidecarPath(shaderFile);
+	if (!ReadReflectionCache(sidecar, hash, &reflection))
+	{
+		// Start from nothing, whatever a bad sidecar left behind
+		reflection = ShaderReflectionCache::Reflection();
+		if (!ReflectShader(&reflection))
+		{
+			shaderValid = false;
+			return false;
+		}
+		WriteReflectionCache(sidecar, hash, reflection);
+	}
+
 	// Create the shader - Calls an overloaded version of this abstract
 	// method in the appropriate child class
-	shaderValid = CreateShader(shaderBlob);
+	shaderValid = CreateShader(shaderBlob, reflection);
 	if (!shaderValid)
 	{
 		return false;
 	}
 
+	// Set up the buffers and tables from it
+	BuildTables(reflection);
+	return true;
+}
+
+// --------------------------------------------------------
+// Uses shader reflection to find the shader's textures,
+// samplers, constant buffers and their variables, and
+// its input signature
+//
+// reflection - Receives what was found
+//
+// Returns false if the blob couldn't be reflected
+// --------------------------------------------------------
+bool ISimpleShader::ReflectShader(ShaderReflectionCache::Reflection* reflection)
+{
 	// Set up shader reflection to get information about
 	// this shader and its variables,  buffers, etc.
 	ID3D11ShaderReflection* refl;
-	D3DReflect(
+	HRESULT hr = D3DReflect(
 		shaderBlob->GetBufferPointer(),
 		shaderBlob->GetBufferSize(),
 		IID_ID3D11ShaderReflection,
 		(void**)&refl);
+	if (FAILED(hr))
+		return false;
 
 	// Get the description of the shader
 	D3D11_SHADER_DESC shaderDesc;
 	refl->GetDesc(&shaderDesc);
 
-	// Get the number of buffers and make the resource array
-	constantBufferCount = shaderDesc.ConstantBuffers;
-	constantBuffers = new SimpleConstantBuffer[constantBufferCount];
-
 	// Handle bound resources (like shaders and samplers)
 	unsigned int resourceCount = shaderDesc.BoundResources;
 	for (unsigned int r = 0; r < resourceCount; r++)
@@ -115,103 +215,218 @@ bool ISimpleShader::LoadShaderFile(LPCWSTR shaderFile)
 		D3D11_SHADER_INPUT_BIND_DESC resourceDesc;
 		refl->GetResourceBindingDesc(r, &resourceDesc);
 
-		// Check the type
-		switch (resourceDesc.Type)
+		// Only textures and samplers are tracked
+		ShaderReflectionCache::Resource resource;
+		if (resourceDesc.Type == D3D_SIT_TEXTURE)
+			resource.kind = ShaderReflectionCache::RK_TEXTURE;
+		else if (resourceDesc.Type == D3D_SIT_SAMPLER)
+			resource.kind = ShaderReflectionCache::RK_SAMPLER;
+		else
+			continue;
+
+		resource.name = resourceDesc.Name;
+		resource.bindIndex = resourceDesc.BindPoint;
+		reflection->resources.push_back(resource);
+	}
+
+	// Loop through all constant buffers
+	reflection->buffers.resize(shaderDesc.ConstantBuffers);
+	for (unsigned int b = 0; b < shaderDesc.ConstantBuffers; b++)
+	{
+		// Get this buffer
+		ID3D11ShaderReflectionConstantBuffer* cb =
+			refl->GetConstantBufferByIndex(b);
+
+		// Get the description of this buffer
+		D3D11_SHADER_BUFFER_DESC bufferDesc;
+		cb->GetDesc(&bufferDesc);
+
+		// Get the description of the resource binding, so
+		// we know exactly how it's bound in the shader
+		D3D11_SHADER_INPUT_BIND_DESC bindDesc;
+		refl->GetResourceBindingDescByName(bufferDesc.Name, &bindDesc);
+
+		ShaderReflectionCache::Buffer& buffer = reflection->buffers[b];
+		buffer.name = bufferDesc.Name;
+		buffer.type = bufferDesc.Type;
+		buffer.size = bufferDesc.Size;
+		buffer.bindIndex = bindDesc.BindPoint;
+
+		// Loop through all variables in this buffer
+		buffer.variables.resize(bufferDesc.Variables);
+		for (unsigned int v = 0; v < bufferDesc.Variables; v++)
 		{
-		case D3D_SIT_TEXTURE: // A texture resource
+			// Get this variable and its description
+			ID3D11ShaderReflectionVariable* var =
+				cb->GetVariableByIndex(v);
+			D3D11_SHADER_VARIABLE_DESC varDesc;
+			var->GetDesc(&varDesc);
+
+			buffer.variables[v].name = varDesc.Name;
+			buffer.variables[v].offset = varDesc.StartOffset;
+			buffer.variables[v].size = varDesc.Size;
+		}
+	}
+
+	// Read the input signature, which a vertex shader's
+	// input layout is built from
+	reflection->inputs.resize(shaderDesc.InputParameters);
+	for (unsigned int i = 0; i < shaderDesc.InputParameters; i++)
+	{
+		D3D11_SIGNATURE_PARAMETER_DESC paramDesc;
+		refl->GetInputParameterDesc(i, &paramDesc);
+
+		ShaderReflectionCache::Input& input = reflection->inputs[i];
+		input.semanticName = paramDesc.SemanticName;
+		input.semanticIndex = paramDesc.SemanticIndex;
+		input.componentType = paramDesc.ComponentType;
+		input.mask = paramDesc.Mask;
+		input.inputSlot = ShaderReflectionCache::GetInputSlot(input.semanticName);
+	}
+
+	// All set
+	refl->Release();
+	return true;
+}
+
+// --------------------------------------------------------
+// Creates the constant buffers and fills in the variable,
+// buffer and resource tables from a reflection
+//
+// reflection - What ReflectShader() (or the cache) found
+// --------------------------------------------------------
+void ISimpleShader::BuildTables(const ShaderReflectionCache::Reflection& reflection)
+{
+	// Size the tables up front, so filling them doesn't rehash
+	size_t variableCount = 0;
+	for (const ShaderReflectionCache::Buffer& buffer : reflection.buffers)
+		variableCount += buffer.variables.size();
+	varTable.reserve(variableCount);
+	cbTable.reserve(reflection.buffers.size());
+
+	// Handle bound resources (like shaders and samplers)
+	for (const ShaderReflectionCache::Resource& resource : reflection.resources)
+	{
+		if (resource.kind == ShaderReflectionCache::RK_TEXTURE)
 		{
 			// Create the SRV wrapper
 			SimpleSRV* srv = new SimpleSRV();
-			srv->BindIndex = resourceDesc.BindPoint;				// Shader bind point
+			srv->BindIndex = resource.bindIndex;					// Shader bind point
 			srv->Index = (unsigned int)shaderResourceViews.size();	// Raw index
 
-			textureTable.insert(std::pair<std::string, SimpleSRV*>(resourceDesc.Name, srv));
+			textureTable.insert(std::pair<std::string, SimpleSRV*>(resource.name, srv));
 			shaderResourceViews.push_back(srv);
 		}
-		break;
-
-		case D3D_SIT_SAMPLER: // A sampler resource
+		else
 		{
 			// Create the sampler wrapper
 			SimpleSampler* samp = new SimpleSampler();
-			samp->BindIndex = resourceDesc.BindPoint;			// Shader bind point
+			samp->BindIndex = resource.bindIndex;				// Shader bind point
 			samp->Index = (unsigned int)samplerStates.size();	// Raw index
 
-			samplerTable.insert(std::pair<std::string, SimpleSampler*>(resourceDesc.Name, samp));
+			samplerTable.insert(std::pair<std::string, SimpleSampler*>(resource.name, samp));
 			samplerStates.push_back(samp);
 		}
-		break;
-		}
 	}
 
+	// Get the number of buffers and make the resource array
+	constantBufferCount = (unsigned int)reflection.buffers.size();
+	constantBuffers = new SimpleConstantBuffer[constantBufferCount];
+
 	// Loop through all constant buffers
 	for (unsigned int b = 0; b < constantBufferCount; b++)
 	{
-		// Get this buffer
-		ID3D11ShaderReflectionConstantBuffer* cb =
-			refl->GetConstantBufferByIndex(b);
-
-		// Get the description of this buffer
-		D3D11_SHADER_BUFFER_DESC bufferDesc;
-		cb->GetDesc(&bufferDesc);
+		const ShaderReflectionCache::Buffer& buffer = reflection.buffers[b];
 
 		// Save the type, which we reference when setting these buffers
-		constantBuffers[b].Type = bufferDesc.Type;
-
-		// Get the description of the resource binding, so
-		// we know exactly how it's bound in the shader
-		D3D11_SHADER_INPUT_BIND_DESC bindDesc;
-		refl->GetResourceBindingDescByName(bufferDesc.Name, &bindDesc);
+		constantBuffers[b].Type = (D3D_CBUFFER_TYPE)buffer.type;
 
 		// Set up the buffer and put its pointer in the table
-		constantBuffers[b].BindIndex = bindDesc.BindPoint;
-		constantBuffers[b].Name = bufferDesc.Name;
-		cbTable.insert(std::pair<std::string, SimpleConstantBuffer*>(bufferDesc.Name, &constantBuffers[b]));
+		constantBuffers[b].BindIndex = buffer.bindIndex;
+		constantBuffers[b].Name = buffer.name;
+		cbTable.insert(std::pair<std::string, SimpleConstantBuffer*>(buffer.name, &constantBuffers[b]));
 
 		// Create this constant buffer
 		D3D11_BUFFER_DESC newBuffDesc;
 		newBuffDesc.Usage = D3D11_USAGE_DEFAULT;
-		newBuffDesc.ByteWidth = max(bufferDesc.Size, 16); // NEW: Must be multiple of 16
+		newBuffDesc.ByteWidth = max(buffer.size, 16); // NEW: Must be multiple of 16
 		newBuffDesc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
 		newBuffDesc.CPUAccessFlags = 0;
 		newBuffDesc.MiscFlags = 0;
 		newBuffDesc.StructureByteStride = 0;
 		device->CreateBuffer(&newBuffDesc, 0, &constantBuffers[b].ConstantBuffer);
 
-		// Set up the data buffer for this constant buffer
-		constantBuffers[b].Size = bufferDesc.Size;
-		constantBuffers[b].LocalDataBuffer = new unsigned char[bufferDesc.Size];
-		ZeroMemory(constantBuffers[b].LocalDataBuffer, bufferDesc.Size);
+		// Set up the data buffer for this constant buffer - all
+		// of it needs copying the first time
+		constantBuffers[b].Size = buffer.size;
+		constantBuffers[b].LocalDataBuffer = new unsigned char[buffer.size];
+		ZeroMemory(constantBuffers[b].LocalDataBuffer, buffer.size);
+		constantBuffers[b].Dirty = true;
+		constantBuffers[b].DirtyBegin = 0;
+		constantBuffers[b].DirtyEnd = buffer.size;
 
 		// Loop through all variables in this buffer
-		for (unsigned int v = 0; v < bufferDesc.Variables; v++)
+		constantBuffers[b].Variables.reserve(buffer.variables.size());
+		for (const ShaderReflectionCache::Variable& variable : buffer.variables)
 		{
-			// Get this variable
-			ID3D11ShaderReflectionVariable* var =
-				cb->GetVariableByIndex(v);
-
-			// Get the description of the variable and its type
-			D3D11_SHADER_VARIABLE_DESC varDesc;
-			var->GetDesc(&varDesc);
-
 			// Create the variable struct
 			SimpleShaderVariable varStruct;
 			varStruct.ConstantBufferIndex = b;
-			varStruct.ByteOffset = varDesc.StartOffset;
-			varStruct.Size = varDesc.Size;
-
-			// Get a string version
-			std::string varName(varDesc.Name);
+			varStruct.ByteOffset = variable.offset;
+			varStruct.Size = variable.size;
 
 			// Add this variable to the table and the constant buffer
-			varTable.insert(std::pair<std::string, SimpleShaderVariable>(varName, varStruct));
+			varTable.insert(std::pair<std::string, SimpleShaderVariable>(variable.name, varStruct));
 			constantBuffers[b].Variables.push_back(varStruct);
 		}
 	}
+}
 
-	// All set
-	refl->Release();
-	return true;
+// --------------------------------------------------------
+// Reads a cached reflection, in one read
+//
+// path       - The sidecar file
+// hash       - ShaderReflectionCache::Hash() of the shader blob
+// reflection - Receives the cached reflection
+//
+// Returns false if there's no sidecar, or it's for another
+// version of the shader
+// --------------------------------------------------------
+bool ISimpleShader::ReadReflectionCache(const std::wstring& path, unsigned long long hash, ShaderReflectionCache::Reflection* reflection)
+{
+	std::ifstream file(path, std::ios::binary | std::ios::ate);
+	if (!file.is_open())
+		return false;
+
+	std::streamoff size = file.tellg();
+	if (size <= 0)
+		return false;
+
+	std::vector<unsigned char> bytes((size_t)size);
+	file.seekg(0);
+	if (!file.read((char*)bytes.data(), size))
+		return false;
+
+	return ShaderReflectionCache::Deserialize(bytes.data(), bytes.size(), hash, reflection);
+}
+
+// --------------------------------------------------------
+// Writes a reflection to its sidecar for the next run.  A
+// sidecar that can't be written (say, a read-only folder)
+// only costs reflecting again next time
+//
+// path       - The sidecar file
+// hash       - ShaderReflectionCache::Hash() of the shader blob
+// reflection - What was reflected
+// --------------------------------------------------------
+void ISimpleShader::WriteReflectionCache(const std::wstring& path, unsigned long long hash, const ShaderReflectionCache::Reflection& reflection)
+{
+	std::vector<unsigned char> bytes;
+	ShaderReflectionCache::Serialize(reflection, hash, &bytes);
+
+	std::ofstream file(path, std::ios::binary | std::ios::trunc);
+	if (file.is_open())
+		file.write((const char*)bytes.data(), bytes.size());
 }
 
 // --------------------------------------------------------
@@ -259,6 +474,97 @@ SimpleConstantBuffer* ISimpleShader::FindConstantBuffer(std::string name)
 	return result->second;
 }
 
+// --------------------------------------------------------
+// Helper for setting bytes of a buffer's local data.  Bytes
+// that already hold the data are left alone (and the buffer
+// clean); otherwise the dirty range grows to cover them
+//
+// cb     - The buffer
+// offset - Where the data goes in the buffer
+// data   - The data to set
+// size   - The size of the data
+// --------------------------------------------------------
+void ISimpleShader::WriteLocalData(SimpleConstantBuffer* cb, unsigned int offset, const void* data, unsigned int size)
+{
+	unsigned char* dest = cb->LocalDataBuffer + offset;
+	if (memcmp(dest, data, size) == 0)
+		return;
+
+	memcpy(dest, data, size);
+
+	// Widen to whole 16 byte constants
+	unsigned int begin = offset & ~15u;
+	unsigned int end = (offset + size + 15) & ~15u;
+	if (end > cb->Size)
+		end = cb->Size;
+
+	if (!cb->Dirty)
+	{
+		cb->DirtyBegin = begin;
+		cb->DirtyEnd = end;
+		cb->Dirty = true;
+		return;
+	}
+
+	if (begin < cb->DirtyBegin) cb->DirtyBegin = begin;
+	if (end > cb->DirtyEnd) cb->DirtyEnd = end;
+}
+
+// --------------------------------------------------------
+// Helper for copying a buffer's dirty range to the GPU.  The
+// whole buffer is copied if the driver can't do partial
+// updates, or if the whole buffer changed anyway
+//
+// cb - The buffer
+// --------------------------------------------------------
+void ISimpleShader::CopyDirtyData(SimpleConstantBuffer* cb)
+{
+	if (!deviceContext1 || (cb->DirtyBegin == 0 && cb->DirtyEnd == cb->Size))
+	{
+		CopyWholeBuffer(cb);
+		return;
+	}
+
+	// The source pointer is where the box starts, not the
+	// start of the resource
+	D3D11_BOX box = {};
+	box.left = cb->DirtyBegin;
+	box.right = cb->DirtyEnd;
+	box.bottom = 1;
+	box.back = 1;
+	deviceContext1->UpdateSubresource1(
+		cb->ConstantBuffer, 0, &box,
+		cb->LocalDataBuffer + cb->DirtyBegin, 0, 0, 0);
+	RenderCounters::Add(RenderCounters::RC_CONSTANT_BYTES, cb->DirtyEnd - cb->DirtyBegin);
+	MarkClean(cb);
+}
+
+// --------------------------------------------------------
+// Helper for copying a buffer's entire local data to the GPU
+//
+// cb - The buffer
+// --------------------------------------------------------
+void ISimpleShader::CopyWholeBuffer(SimpleConstantBuffer* cb)
+{
+	deviceContext->UpdateSubresource(
+		cb->ConstantBuffer, 0, 0,
+		cb->LocalDataBuffer, 0, 0);
+	RenderCounters::Add(RenderCounters::RC_CONSTANT_BYTES, cb->Size);
+	MarkClean(cb);
+}
+
+// --------------------------------------------------------
+// Helper for emptying a buffer's dirty range
+//
+// cb - The buffer
+// --------------------------------------------------------
+void ISimpleShader::MarkClean(SimpleConstantBuffer* cb)
+{
+	cb->Dirty = false;
+	cb->DirtyBegin = 0;
+	cb->DirtyEnd = 0;
+}
+
 // --------------------------------------------------------
 // Sets the shader and associated constant buffers in DirectX
 // --------------------------------------------------------
@@ -276,19 +582,21 @@ void ISimpleShader::SetShader()
 // Copies the relevant data to the all of this
 // shader's constant buffers.  To just copy one
 // buffer, use CopyBufferData()
+//
+// Buffers that haven't changed since their last copy
+// are skipped, and only the changed range of the others
+// is copied when the driver allows partial updates
 // --------------------------------------------------------
 void ISimpleShader::CopyAllBufferData()
 {
 	// Ensure the shader is valid
 	if (!shaderValid) return;
 
-	// Loop through the constant buffers and copy all data
+	// Loop through the constant buffers and copy what changed
 	for (unsigned int i = 0; i < constantBufferCount; i++)
 	{
-		// Copy the entire local data buffer
-		deviceContext->UpdateSubresource(
-			constantBuffers[i].ConstantBuffer, 0, 0,
-			constantBuffers[i].LocalDataBuffer, 0, 0);
+		if (constantBuffers[i].Dirty)
+			CopyDirtyData(&constantBuffers[i]);
 	}
 }
 
@@ -317,9 +625,7 @@ void ISimpleShader::CopyBufferData(unsigned int index)
 	if (!cb) return;
 
 	// Copy the data and get out
-	deviceContext->UpdateSubresource(
-		cb->ConstantBuffer, 0, 0,
-		cb->LocalDataBuffer, 0, 0);
+	CopyWholeBuffer(cb);
 }
 
 // --------------------------------------------------------
@@ -339,9 +645,53 @@ void ISimpleShader::CopyBufferData(std::string bufferName)
 	if (!cb) return;
 
 	// Copy the data and get out
-	deviceContext->UpdateSubresource(
-		cb->ConstantBuffer, 0, 0,
-		cb->LocalDataBuffer, 0, 0);
+	CopyWholeBuffer(cb);
+}
+
+// --------------------------------------------------------
+// Has the specified constant buffer's local data changed
+// since it was last copied?  Unknown buffers are never dirty.
+//
+// bufferName - Specifies the name of the buffer to check
+// --------------------------------------------------------
+bool ISimpleShader::IsBufferDirty(std::string bufferName)
+{
+	SimpleConstantBuffer* cb = this->FindConstantBuffer(bufferName);
+	return cb && cb->Dirty;
+}
+
+// --------------------------------------------------------
+// Has the specified constant buffer's local data changed
+// since it was last copied?  Invalid indices are never dirty.
+//
+// index - The index of the buffer (see GetBufferIndex)
+// --------------------------------------------------------
+bool ISimpleShader::IsBufferDirty(unsigned int index)
+{
+	return index < constantBufferCount && constantBuffers[index].Dirty;
+}
+
+// --------------------------------------------------------
+// Marks the specified constant buffer as up to date, for
+// callers that copy its local data to the GPU themselves
+//
+// bufferName - Specifies the name of the buffer
+// --------------------------------------------------------
+void ISimpleShader::MarkBufferClean(std::string bufferName)
+{
+	SimpleConstantBuffer* cb = this->FindConstantBuffer(bufferName);
+	if (cb) MarkClean(cb);
+}
+
+// --------------------------------------------------------
+// Marks the specified constant buffer as up to date
+//
+// index - The index of the buffer (see GetBufferIndex)
+// --------------------------------------------------------
+void ISimpleShader::MarkBufferClean(unsigned int index)
+{
+	if (index < constantBufferCount)
+		MarkClean(&constantBuffers[index]);
 }
 
 
@@ -354,6 +704,9 @@ void ISimpleShader::CopyBufferData(std::string bufferName)
 //
 // Returns true if data is copied, false if variable doesn't
 // exist or sizes don't match
+//
+// Setting a variable to the value it already holds leaves
+// its buffer clean, so it won't need to be copied again
 // --------------------------------------------------------
 bool ISimpleShader::SetData(std::string name, const void* data, unsigned int size)
 {
@@ -362,11 +715,8 @@ bool ISimpleShader::SetData(std::string name, const void* data, unsigned int siz
 	if (var == 0)
 		return false;
 
-	// Set the data in the local data buffer
-	memcpy(
-		constantBuffers[var->ConstantBufferIndex].LocalDataBuffer + var->ByteOffset,
-		data,
-		size);
+	// Set the data in the local data buffer, if it changed
+	WriteLocalData(&constantBuffers[var->ConstantBufferIndex], var->ByteOffset, data, size);
 
 	// Success
 	return true;
@@ -452,6 +802,169 @@ bool ISimpleShader::SetMatrix4x4(std::string name, const DirectX::XMFLOAT4X4 dat
 	return this->SetData(name, &data, sizeof(float) * 16);
 }
 
+// --------------------------------------------------------
+// Sets a whole constant buffer at once, e.g. from one of the
+// structs CBufferGen writes to ShaderConstants.h
+//
+// bufferName - The name of the buffer
+// data       - The buffer's contents, laid out as HLSL packs them
+// size       - The size of the data (this must match the buffer's size)
+//
+// Returns true if data is copied, false if the buffer doesn't
+// exist or sizes don't match
+// --------------------------------------------------------
+bool ISimpleShader::SetBufferData(std::string bufferName, const void* data, unsigned int size)
+{
+	int index = GetBufferIndex(bufferName);
+	if (index < 0)
+		return false;
+
+	return SetBufferData((unsigned int)index, data, size);
+}
+
+// --------------------------------------------------------
+// Sets a whole constant buffer at once, by index
+//
+// Compared a constant (16 bytes) at a time, so the dirty range
+// only covers what actually changed, as it would have with
+// a SetData() call per variable
+// --------------------------------------------------------
+bool ISimpleShader::SetBufferData(unsigned int index, const void* data, unsigned int size)
+{
+	if (index >= constantBufferCount || constantBuffers[index].Size != size)
+		return false;
+
+	SimpleConstantBuffer* cb = &constantBuffers[index];
+	const unsigned char* bytes = (const unsigned char*)data;
+	for (unsigned int offset = 0; offset < size; offset += 16)
+		WriteLocalData(cb, offset, bytes + offset, 16);
+
+	return true;
+}
+
+// --------------------------------------------------------
+// Looks a variable up once, so it can be set through the
+// handle from then on without any string work
+//
+// name - The name of the shader variable
+//
+// Returns an invalid handle if the variable doesn't exist
+// --------------------------------------------------------
+SimpleShaderVariableHandle ISimpleShader::GetVariableHandle(const std::string& name)
+{
+	SimpleShaderVariableHandle handle;
+	SimpleShaderVariable* var = FindVariable(name, -1);
+	if (var == 0)
+		return handle;
+
+	handle.ConstantBufferIndex = var->ConstantBufferIndex;
+	handle.ByteOffset = var->ByteOffset;
+	handle.Size = var->Size;
+#if defined(DEBUG) || defined(_DEBUG)
+	handle.Owner = this;
+#endif
+	return handle;
+}
+
+// --------------------------------------------------------
+// Gets the index of a constant buffer, for the index-based
+// buffer methods
+//
+// bufferName - The name of the constant buffer
+//
+// Returns -1 if the shader has no such buffer
+// --------------------------------------------------------
+int ISimpleShader::GetBufferIndex(const std::string& bufferName)
+{
+	SimpleConstantBuffer* cb = FindConstantBuffer(bufferName);
+	if (cb == 0)
+		return -1;
+
+	return (int)(cb - constantBuffers);
+}
+
+// --------------------------------------------------------
+// Sets a variable through a handle with arbitrary data of
+// the specified size
+//
+// handle - The variable, from GetVariableHandle()
+// data   - The data to set in the buffer
+// size   - The size of the data (this must match the variable's size)
+//
+// Returns true if data is copied, false if the handle is
+// invalid or the sizes don't match.  Debug builds also
+// refuse handles from other shaders, or from before the
+// shader was reloaded with a smaller buffer
+// --------------------------------------------------------
+bool ISimpleShader::SetData(const SimpleShaderVariableHandle& handle, const void* data, unsigned int size)
+{
+	if (!handle.IsValid() || handle.Size != size)
+		return false;
+
+#if defined(DEBUG) || defined(_DEBUG)
+	if (handle.Owner != this ||
+		handle.ConstantBufferIndex >= constantBufferCount ||
+		handle.ByteOffset + handle.Size > constantBuffers[handle.ConstantBufferIndex].Size)
+	{
+		OutputDebugStringA("SimpleShader: variable handle doesn't belong to this shader\n");
+		return false;
+	}
+#endif
+
+	// Set the data in the local data buffer, if it changed
+	WriteLocalData(&constantBuffers[handle.ConstantBufferIndex], handle.ByteOffset, data, size);
+
+	return true;
+}
+
+// --------------------------------------------------------
+// Sets INTEGER data through a handle
+// --------------------------------------------------------
+bool ISimpleShader::SetInt(const SimpleShaderVariableHandle& handle, int data)
+{
+	return this->SetData(handle, &data, sizeof(int));
+}
+
+// --------------------------------------------------------
+// Sets a FLOAT variable through a handle
+// --------------------------------------------------------
+bool ISimpleShader::SetFloat(const SimpleShaderVariableHandle& handle, float data)
+{
+	return this->SetData(handle, &data, sizeof(float));
+}
+
+// --------------------------------------------------------
+// Sets a FLOAT2 variable through a handle
+// --------------------------------------------------------
+bool ISimpleShader::SetFloat2(const SimpleShaderVariableHandle& handle, const DirectX::XMFLOAT2& data)
+{
+	return this->SetData(handle, &data, sizeof(float) * 2);
+}
+
+// --------------------------------------------------------
+// Sets a FLOAT3 variable through a handle
+// --------------------------------------------------------
+bool ISimpleShader::SetFloat3(const SimpleShaderVariableHandle& handle, const DirectX::XMFLOAT3& data)
+{
+	return this->SetData(handle, &data, sizeof(float) * 3);
+}
+
+// --------------------------------------------------------
+// Sets a FLOAT4 variable through a handle
+// --------------------------------------------------------
+bool ISimpleShader::SetFloat4(const SimpleShaderVariableHandle& handle, const DirectX::XMFLOAT4& data)
+{
+	return this->SetData(handle, &data, sizeof(float) * 4);
+}
+
+// --------------------------------------------------------
+// Sets a MATRIX (4x4) variable through a handle
+// --------------------------------------------------------
+bool ISimpleShader::SetMatrix4x4(const SimpleShaderVariableHandle& handle, const DirectX::XMFLOAT4X4& data)
+{
+	return this->SetData(handle, &data, sizeof(float) * 16);
+}
+
 // --------------------------------------------------------
 // Gets info about a shader variable, if it exists
 // --------------------------------------------------------
@@ -632,10 +1145,11 @@ void SimpleVertexShader::CleanUp()
 // Creates the DirectX vertex shader
 //
 // shaderBlob - The shader's compiled code
+// reflection - What reflecting it (or its sidecar) found
 //
 // Returns true if shader is created correctly, false otherwise
 // --------------------------------------------------------
-bool SimpleVertexShader::CreateShader(ID3DBlob* shaderBlob)
+bool SimpleVertexShader::CreateShader(ID3DBlob* shaderBlob, const ShaderReflectionCache::Reflection& reflection)
 {
 	// Clean up first, in the event this method is
 	// called more than once on the same object
@@ -658,96 +1172,45 @@ bool SimpleVertexShader::CreateShader(ID3DBlob* shaderBlob)
 		return true;
 
 	// Vertex shader was created successfully, so we now use the
-	// shader code to re-reflect and create an input layout that
-	// matches what the vertex shader expects.  Code adapted from:
+	// input signature from its reflection to create an input layout
+	// that matches what the vertex shader expects.  Code adapted from:
 	// https://takinginitiative.wordpress.com/2011/12/11/directx-1011-basic-shader-reflection-automatic-input-layout-creation/
-
-	// Reflect shader info
-	ID3D11ShaderReflection* refl;
-	D3DReflect(
-		shaderBlob->GetBufferPointer(),
-		shaderBlob->GetBufferSize(),
-		IID_ID3D11ShaderReflection,
-		(void**)&refl);
-
-	// Get shader info
-	D3D11_SHADER_DESC shaderDesc;
-	refl->GetDesc(&shaderDesc);
-
-	// Read input layout description from shader info
 	std::vector<D3D11_INPUT_ELEMENT_DESC> inputLayoutDesc;
-	for (unsigned int i = 0; i < shaderDesc.InputParameters; i++)
+	for (const ShaderReflectionCache::Input& input : reflection.inputs)
 	{
-		D3D11_SIGNATURE_PARAMETER_DESC paramDesc;
-		refl->GetInputParameterDesc(i, &paramDesc);
-
-		// Check the semantic name for "_PER_INSTANCE"
-		std::string perInstanceStr = "_PER_INSTANCE";
-		std::string sem = paramDesc.SemanticName;
-		int lenDiff = (int)sem.size() - (int)perInstanceStr.size();
-		bool isPerInstance =
-			lenDiff >= 0 &&
-			sem.compare(lenDiff, perInstanceStr.size(), perInstanceStr) == 0;
-
 		// Fill out input element desc
 		D3D11_INPUT_ELEMENT_DESC elementDesc;
-		elementDesc.SemanticName = paramDesc.SemanticName;
-		elementDesc.SemanticIndex = paramDesc.SemanticIndex;
-		elementDesc.InputSlot = 0;
+		elementDesc.SemanticName = input.semanticName.c_str();
+		elementDesc.SemanticIndex = input.semanticIndex;
+		elementDesc.Format = (DXGI_FORMAT)ShaderReflectionCache::GetInputFormat(input.componentType, input.mask);
+		elementDesc.InputSlot = input.inputSlot;
 		elementDesc.AlignedByteOffset = D3D11_APPEND_ALIGNED_ELEMENT;
 		elementDesc.InputSlotClass = D3D11_INPUT_PER_VERTEX_DATA;
 		elementDesc.InstanceDataStepRate = 0;
 
 		// Replace anything affected by "per instance" data
-		if (isPerInstance)
+		// (semantics ending in "_PER_INSTANCE", in their own slot)
+		if (input.inputSlot == ShaderReflectionCache::INSTANCE_SLOT)
 		{
-			elementDesc.InputSlot = 1; // Assume per instance data comes from another input slot!
 			elementDesc.InputSlotClass = D3D11_INPUT_PER_INSTANCE_DATA;
 			elementDesc.InstanceDataStepRate = 1;
 
 			perInstanceCompatible = true;
 		}
 
-		// Determine DXGI format
-		if (paramDesc.Mask == 1)
-		{
-			if (paramDesc.ComponentType == D3D_REGISTER_COMPONENT_UINT32) elementDesc.Format = DXGI_FORMAT_R32_UINT;
-			else if (paramDesc.ComponentType == D3D_REGISTER_COMPONENT_SINT32) elementDesc.Format = DXGI_FORMAT_R32_SINT;
-			else if (paramDesc.ComponentType == D3D_REGISTER_COMPONENT_FLOAT32) elementDesc.Format = DXGI_FORMAT_R32_FLOAT;
-		}
-		else if (paramDesc.Mask <= 3)
-		{
-			if (paramDesc.ComponentType == D3D_REGISTER_COMPONENT_UINT32) elementDesc.Format = DXGI_FORMAT_R32G32_UINT;
-			else if (paramDesc.ComponentType == D3D_REGISTER_COMPONENT_SINT32) elementDesc.Format = DXGI_FORMAT_R32G32_SINT;
-			else if (paramDesc.ComponentType == D3D_REGISTER_COMPONENT_FLOAT32) elementDesc.Format = DXGI_FORMAT_R32G32_FLOAT;
-		}
-		else if (paramDesc.Mask <= 7)
-		{
-			if (paramDesc.ComponentType == D3D_REGISTER_COMPONENT_UINT32) elementDesc.Format = DXGI_FORMAT_R32G32B32_UINT;
-			else if (paramDesc.ComponentType == D3D_REGISTER_COMPONENT_SINT32) elementDesc.Format = DXGI_FORMAT_R32G32B32_SINT;
-			else if (paramDesc.ComponentType == D3D_REGISTER_COMPONENT_FLOAT32) elementDesc.Format = DXGI_FORMAT_R32G32B32_FLOAT;
-		}
-		else if (paramDesc.Mask <= 15)
-		{
-			if (paramDesc.ComponentType == D3D_REGISTER_COMPONENT_UINT32) elementDesc.Format = DXGI_FORMAT_R32G32B32A32_UINT;
-			else if (paramDesc.ComponentType == D3D_REGISTER_COMPONENT_SINT32) elementDesc.Format = DXGI_FORMAT_R32G32B32A32_SINT;
-			else if (paramDesc.ComponentType == D3D_REGISTER_COMPONENT_FLOAT32) elementDesc.Format = DXGI_FORMAT_R32G32B32A32_FLOAT;
-		}
-
 		// Save element desc
 		inputLayoutDesc.push_back(elementDesc);
 	}
 
 	// Try to create Input Layout
 	HRESULT hr = device->CreateInputLayout(
-		&inputLayoutDesc[0],
+		inputLayoutDesc.data(),
 		(unsigned int)inputLayoutDesc.size(),
 		shaderBlob->GetBufferPointer(),
 		shaderBlob->GetBufferSize(),
 		&inputLayout);
 
-	// All done, clean up
-	refl->Release();
+	// All done
 	return true;
 }
 
@@ -858,10 +1321,11 @@ void SimplePixelShader::CleanUp()
 // Creates the DirectX pixel shader
 //
 // shaderBlob - The shader's compiled code
+// reflection - What reflecting it (or its sidecar) found
 //
 // Returns true if shader is created correctly, false otherwise
 // --------------------------------------------------------
-bool SimplePixelShader::CreateShader(ID3DBlob* shaderBlob)
+bool SimplePixelShader::CreateShader(ID3DBlob* shaderBlob, const ShaderReflectionCache::Reflection& reflection)
 {
 	// Clean up first, in the event this method is
 	// called more than once on the same object
@@ -986,10 +1450,11 @@ void SimpleDomainShader::CleanUp()
 // Creates the DirectX domain shader
 //
 // shaderBlob - The shader's compiled code
+// reflection - What reflecting it (or its sidecar) found
 //
 // Returns true if shader is created correctly, false otherwise
 // --------------------------------------------------------
-bool SimpleDomainShader::CreateShader(ID3DBlob* shaderBlob)
+bool SimpleDomainShader::CreateShader(ID3DBlob* shaderBlob, const ShaderReflectionCache::Reflection& reflection)
 {
 	// Clean up first, in the event this method is
 	// called more than once on the same object
@@ -1113,10 +1578,11 @@ void SimpleHullShader::CleanUp()
 // Creates the DirectX hull shader
 //
 // shaderBlob - The shader's compiled code
+// reflection - What reflecting it (or its sidecar) found
 //
 // Returns true if shader is created correctly, false otherwise
 // --------------------------------------------------------
-bool SimpleHullShader::CreateShader(ID3DBlob* shaderBlob)
+bool SimpleHullShader::CreateShader(ID3DBlob* shaderBlob, const ShaderReflectionCache::Reflection& reflection)
 {
 	// Clean up first, in the event this method is
 	// called more than once on the same object
@@ -1244,10 +1710,11 @@ void SimpleGeometryShader::CleanUp()
 // Creates the DirectX Geometry shader
 //
 // shaderBlob - The shader's compiled code
+// reflection - What reflecting it (or its sidecar) found
 //
 // Returns true if shader is created correctly, false otherwise
 // --------------------------------------------------------
-bool SimpleGeometryShader::CreateShader(ID3DBlob* shaderBlob)
+bool SimpleGeometryShader::CreateShader(ID3DBlob* shaderBlob, const ShaderReflectionCache::Reflection& reflection)
 {
 	// Clean up first, in the event this method is
 	// called more than once on the same object
@@ -1509,10 +1976,11 @@ void SimpleComputeShader::CleanUp()
 // Creates the DirectX Compute shader
 //
 // shaderBlob - The shader's compiled code
+// reflection - What reflecting it (or its sidecar) found
 //
 // Returns true if shader is created correctly, false otherwise
 // --------------------------------------------------------
-bool SimpleComputeShader::CreateShader(ID3DBlob* shaderBlob)
+bool SimpleComputeShader::CreateShader(ID3DBlob* shaderBlob, const ShaderReflectionCache::Reflection& reflection)
 {
 	// Clean up first, in the event this method is
 	// called more than once on the same object
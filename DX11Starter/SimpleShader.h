@@ -2,10 +2,12 @@
 #pragma comment(lib, "dxguid.lib")
 #pragma comment(lib, "d3dcompiler.lib")
 
-#include <d3d11.h>
+#include <d3d11_1.h>
 #include <d3dcompiler.h>
 #include <DirectXMath.h>
 
+#include "ShaderReflectionCache.h"
+
 #include <unordered_map>
 #include <vector>
 #include <string>
@@ -21,6 +23,29 @@ struct SimpleShaderVariable
 	unsigned int ConstantBufferIndex;
 };
 
+class ISimpleShader;
+
+// --------------------------------------------------------
+// A shader variable resolved once by name, so it can be
+// set every draw without hashing (or copying) the name.
+// Handles for names the shader doesn't have are invalid,
+// and setting one does nothing.
+//
+// Debug builds also remember the shader the handle came
+// from, and check it each time the handle is used
+// --------------------------------------------------------
+struct SimpleShaderVariableHandle
+{
+	unsigned int ConstantBufferIndex = 0;
+	unsigned int ByteOffset = 0;
+	unsigned int Size = 0; // Zero for an invalid handle
+#if defined(DEBUG) || defined(_DEBUG)
+	const ISimpleShader* Owner = nullptr;
+#endif
+
+	bool IsValid() const { return Size > 0; }
+};
+
 #pragma warning( push )
 #pragma warning( disable : 26495 )
 
@@ -28,6 +53,11 @@ struct SimpleShaderVariable
 // Contains information about a specific
 // constant buffer in a shader, as well as
 // the local data buffer for it
+//
+// The dirty range covers every byte changed since the
+// last copy, widened to 16 byte constants (the unit of a
+// partial update).  It's empty exactly when the buffer
+// isn't dirty.
 // --------------------------------------------------------
 struct SimpleConstantBuffer
 {
@@ -37,6 +67,9 @@ struct SimpleConstantBuffer
 	unsigned int BindIndex = 0;
 	ID3D11Buffer* ConstantBuffer;
 	unsigned char* LocalDataBuffer;
+	bool Dirty = true; // Local data changed since the last copy?
+	unsigned int DirtyBegin = 0; // First changed byte
+	unsigned int DirtyEnd = 0;   // One past the last changed byte
 	std::vector<SimpleShaderVariable> Variables;
 };
 
@@ -78,10 +111,16 @@ public:
 
 	// Activating the shader and copying data
 	void SetShader();
-	void CopyAllBufferData();
-	void CopyBufferData(unsigned int index);
+	void CopyAllBufferData(); // Only what changed
+	void CopyBufferData(unsigned int index); // Whole buffer, changed or not
 	void CopyBufferData(std::string bufferName);
 
+	// Tracking changes, so unchanged buffers can skip the copy
+	bool IsBufferDirty(std::string bufferName);
+	bool IsBufferDirty(unsigned int index);
+	void MarkBufferClean(std::string bufferName);
+	void MarkBufferClean(unsigned int index);
+
 	// Sets arbitrary shader data
 	bool SetData(std::string name, const void* data, unsigned int size);
 
@@ -96,6 +135,26 @@ public:
 	bool SetMatrix4x4(std::string name, const float data[16]);
 	bool SetMatrix4x4(std::string name, const DirectX::XMFLOAT4X4 data);
 
+	// Sets a whole buffer at once (see ShaderConstants.h)
+	bool SetBufferData(std::string bufferName, const void* data, unsigned int size);
+	bool SetBufferData(unsigned int index, const void* data, unsigned int size);
+	template <typename T> bool SetBufferData(const T& data) { return SetBufferData(T::Name(), &data, sizeof(T)); }
+
+	// Resolves names once, for the per-draw setters below
+	//  - Reloading the shader invalidates its handles
+	SimpleShaderVariableHandle GetVariableHandle(const std::string& name);
+	int GetBufferIndex(const std::string& bufferName); // -1 if there's no such buffer
+
+	// Sets shader data through handles (no name lookups)
+	bool SetData(const SimpleShaderVariableHandle& handle, const void* data, unsigned int size);
+
+	bool SetInt(const SimpleShaderVariableHandle& handle, int data);
+	bool SetFloat(const SimpleShaderVariableHandle& handle, float data);
+	bool SetFloat2(const SimpleShaderVariableHandle& handle, const DirectX::XMFLOAT2& data);
+	bool SetFloat3(const SimpleShaderVariableHandle& handle, const DirectX::XMFLOAT3& data);
+	bool SetFloat4(const SimpleShaderVariableHandle& handle, const DirectX::XMFLOAT4& data);
+	bool SetMatrix4x4(const SimpleShaderVariableHandle& handle, const DirectX::XMFLOAT4X4& data);
+
 	// Setting shader resources
 	virtual bool SetShaderResourceView(std::string name, ID3D11ShaderResourceView* srv) = 0;
 	virtual bool SetSamplerState(std::string name, ID3D11SamplerState* samplerState) = 0;
@@ -126,6 +185,8 @@ protected:
 	ID3DBlob* shaderBlob;
 	ID3D11Device* device;
 	ID3D11DeviceContext* deviceContext;
+	ID3D11DeviceContext1* deviceContext1; // Only if the driver does partial constant buffer updates
+	bool sharesProbe; // Counted in probeUsers
 
 	// Resource counts
 	unsigned int constantBufferCount = 0;
@@ -140,14 +201,35 @@ protected:
 	std::unordered_map<std::string, SimpleSampler*> samplerTable;
 
 	// Pure virtual functions for dealing with shader types
-	virtual bool CreateShader(ID3DBlob* shaderBlob) = 0;
+	virtual bool CreateShader(ID3DBlob* shaderBlob, const ShaderReflectionCache::Reflection& reflection) = 0;
 	virtual void SetShaderAndCBs() = 0;
 
 	virtual void CleanUp();
 
+	// Helpers for reflecting (or reading the cached reflection)
+	bool ReflectShader(ShaderReflectionCache::Reflection* reflection);
+	void BuildTables(const ShaderReflectionCache::Reflection& reflection);
+	bool ReadReflectionCache(const std::wstring& path, unsigned long long hash, ShaderReflectionCache::Reflection* reflection);
+	void WriteReflectionCache(const std::wstring& path, unsigned long long hash, const ShaderReflectionCache::Reflection& reflection);
+
 	// Helpers for finding data by name
 	SimpleShaderVariable* FindVariable(std::string name, int size);
 	SimpleConstantBuffer* FindConstantBuffer(std::string name);
+
+	// Helpers for the dirty range and copying it
+	void WriteLocalData(SimpleConstantBuffer* cb, unsigned int offset, const void* data, unsigned int size);
+	void CopyDirtyData(SimpleConstantBuffer* cb);
+	void CopyWholeBuffer(SimpleConstantBuffer* cb);
+	static void MarkClean(SimpleConstantBuffer* cb);
+
+	// Partial update support, probed once per context and shared
+	// by all of its shaders (holding one reference while any of
+	// them is alive) rather than queried by every shader
+	static ID3D11DeviceContext* probedContext;
+	static ID3D11DeviceContext1* probedContext1; // Null if unsupported
+	static unsigned int probeUsers;
+	static ID3D11DeviceContext1* AcquireContext1(ID3D11Device* device, ID3D11DeviceContext* context, bool* shared);
+	static void ReleaseContext1();
 };
 
 // --------------------------------------------------------
@@ -170,7 +252,7 @@ protected:
 	bool perInstanceCompatible;
 	ID3D11InputLayout* inputLayout;
 	ID3D11VertexShader* shader;
-	bool CreateShader(ID3DBlob* shaderBlob);
+	bool CreateShader(ID3DBlob* shaderBlob, const ShaderReflectionCache::Reflection& reflection);
 	void SetShaderAndCBs();
 	void CleanUp();
 };
@@ -191,7 +273,7 @@ public:
 
 protected:
 	ID3D11PixelShader* shader;
-	bool CreateShader(ID3DBlob* shaderBlob);
+	bool CreateShader(ID3DBlob* shaderBlob, const ShaderReflectionCache::Reflection& reflection);
 	void SetShaderAndCBs();
 	void CleanUp();
 };
@@ -211,7 +293,7 @@ public:
 
 protected:
 	ID3D11DomainShader* shader;
-	bool CreateShader(ID3DBlob* shaderBlob);
+	bool CreateShader(ID3DBlob* shaderBlob, const ShaderReflectionCache::Reflection& reflection);
 	void SetShaderAndCBs();
 	void CleanUp();
 };
@@ -231,7 +313,7 @@ public:
 
 protected:
 	ID3D11HullShader* shader;
-	bool CreateShader(ID3DBlob* shaderBlob);
+	bool CreateShader(ID3DBlob* shaderBlob, const ShaderReflectionCache::Reflection& reflection);
 	void SetShaderAndCBs();
 	void CleanUp();
 };
@@ -262,7 +344,7 @@ protected:
 	bool allowStreamOutRasterization;
 	unsigned int streamOutVertexSize;
 
-	bool CreateShader(ID3DBlob* shaderBlob);
+	bool CreateShader(ID3DBlob* shaderBlob, const ShaderReflectionCache::Reflection& reflection);
 	bool CreateShaderWithStreamOut(ID3DBlob* shaderBlob);
 	void SetShaderAndCBs();
 	void CleanUp();
@@ -300,7 +382,7 @@ protected:
 	unsigned int threadsZ = 0;
 	unsigned int threadsTotal = 0;
 
-	bool CreateShader(ID3DBlob* shaderBlob);
+	bool CreateShader(ID3DBlob* shaderBlob, const ShaderReflectionCache::Reflection& reflection);
 	void SetShaderAndCBs();
 	void CleanUp();
 };
\ No newline at end of file
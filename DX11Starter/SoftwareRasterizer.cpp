@@ -0,0 +1,608 @@
+// -----------------------------------------------
+// Include statements.
+// -----------------------------------------------
+#include "SoftwareRasterizer.h"
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <emmintrin.h>
+
+// -----------------------------------------------
+// Namespace statements.
+// -----------------------------------------------
+using namespace DirectX;
+
+// -----------------------------------------------
+// Constants.
+// -----------------------------------------------
+
+// Number of set bits in a 4 bit lane mask.
+static const unsigned int LANE_COUNTS[16] = { 0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4 };
+
+// Clamp a float to [low, high] before converting to int.
+static int ClampToInt(float value, int low, int high)
+{
+	if (!(value > (float)low)) return low; // Also catches NaN.
+	if (value > (float)high) return high;
+	return (int)value;
+}
+
+// Scale a vector to unit length (zero stays zero).
+static void Normalize(float* vector, unsigned int size)
+{
+	float lengthSquared = 0.0f;
+	for (unsigned int i = 0; i < size; i++)
+		lengthSquared += vector[i] * vector[i];
+
+	float scale = (lengthSquared > 0.0f) ? 1.0f / sqrtf(lengthSquared) : 0.0f;
+	for (unsigned int i = 0; i < size; i++)
+		vector[i] *= scale;
+}
+
+// -----------------------------------------------
+// Constructors.
+// -----------------------------------------------
+
+/// <summary>
+/// Start the worker threads. Nothing can be drawn until Resize().
+/// </summary>
+/// <param name="threadCount">Worker threads (see WorkerPool).</param>
+SoftwareRasterizer::SoftwareRasterizer(unsigned int threadCount)
+	: width(0), height(0), tilesX(0), tilesY(0), clearColor(0), lights{}, stats{},
+	workers(threadCount)
+{
+	XMStoreFloat4x4(&viewProjection, XMMatrixIdentity());
+}
+
+/// <summary>
+/// Nothing to release; the worker pool joins its threads.
+/// </summary>
+SoftwareRasterizer::~SoftwareRasterizer() {}
+
+// -----------------------------------------------
+// Static methods.
+// -----------------------------------------------
+
+/// <summary>
+/// Convert a color to 8 bits per channel, rounding to nearest
+/// (as the GPU does when writing an R8G8B8A8_UNORM target).
+/// </summary>
+/// <param name="color">Red, green, blue, alpha. Clamped to [0, 1].</param>
+/// <returns>Returns red in the low byte, alpha in the high byte.</returns>
+unsigned int SoftwareRasterizer::PackColor(const float color[4])
+{
+	unsigned int packed = 0;
+	for (unsigned int c = 0; c < 4; c++)
+	{
+		float value = (color[c] > 0.0f) ? ((color[c] < 1.0f) ? color[c] : 1.0f) : 0.0f;
+		packed |= (unsigned int)(value * 255.0f + 0.5f) << (c * 8);
+	}
+	return packed;
+}
+
+// -----------------------------------------------
+// Accessors.
+// -----------------------------------------------
+
+/// <summary>
+/// Width of the image, in pixels.
+/// </summary>
+unsigned int SoftwareRasterizer::GetWidth() const
+{
+	return width;
+}
+
+/// <summary>
+/// Height of the image, in pixels.
+/// </summary>
+unsigned int SoftwareRasterizer::GetHeight() const
+{
+	return height;
+}
+
+/// <summary>
+/// Row pitch of the color and depth buffers, in pixels.
+/// </summary>
+unsigned int SoftwareRasterizer::GetPitch() const
+{
+	return tilesX * TILE_SIZE;
+}
+
+/// <summary>
+/// The color buffer from the last Render().
+/// </summary>
+const unsigned int* SoftwareRasterizer::GetColorBuffer() const
+{
+	return color.data();
+}
+
+/// <summary>
+/// The depth buffer from the last Render().
+/// </summary>
+const float* SoftwareRasterizer::GetDepthBuffer() const
+{
+	return depth.data();
+}
+
+/// <summary>
+/// Triangles and pixels drawn since the last BeginFrame().
+/// </summary>
+const SoftwareRasterizer::Statistics& SoftwareRasterizer::GetStatistics() const
+{
+	return stats;
+}
+
+/// <summary>
+/// Number of worker threads.
+/// </summary>
+unsigned int SoftwareRasterizer::GetThreadCount() const
+{
+	return workers.GetThreadCount();
+}
+
+// -----------------------------------------------
+// Service methods.
+// -----------------------------------------------
+
+/// <summary>
+/// Set the image size. The buffers are rounded up to whole
+/// tiles, so every tile can be drawn without bounds checks.
+/// </summary>
+/// <param name="newWidth">Width, in pixels.</param>
+/// <param name="newHeight">Height, in pixels.</param>
+void SoftwareRasterizer::Resize(unsigned int newWidth, unsigned int newHeight)
+{
+	width = newWidth;
+	height = newHeight;
+	tilesX = (width + TILE_SIZE - 1) / TILE_SIZE;
+	tilesY = (height + TILE_SIZE - 1) / TILE_SIZE;
+
+	size_t pixels = (size_t)tilesX * tilesY * TILE_SIZE * TILE_SIZE;
+	color.assign(pixels, clearColor);
+	depth.assign(pixels, 1.0f);
+	bins.assign(tilesX * tilesY, std::vector<unsigned int>());
+	tilePixels.assign(tilesX * tilesY, 0);
+	triangles.clear();
+}
+
+/// <summary>
+/// Start a frame: set the camera, lights and clear color, and
+/// drop last frame's triangles.
+/// </summary>
+/// <param name="camera">View-projection matrix, as used with row vectors (not transposed).</param>
+/// <param name="light1">First light, as sent to PixelShader.hlsl.</param>
+/// <param name="light2">Second light.</param>
+/// <param name="clear">Color the image is cleared to.</param>
+void SoftwareRasterizer::BeginFrame(const XMMATRIX& camera, const DirectionalLight& light1, const DirectionalLight& light2, const float clear[4])
+{
+	XMStoreFloat4x4(&viewProjection, camera);
+	clearColor = PackColor(clear);
+
+	const DirectionalLight* sources[2] = { &light1, &light2 };
+	for (unsigned int l = 0; l < 2; l++)
+	{
+		const DirectionalLight& source = *sources[l];
+		Light& light = lights[l];
+		light.ambient[0] = source.AmbientColor.x; light.ambient[1] = source.AmbientColor.y;
+		light.ambient[2] = source.AmbientColor.z; light.ambient[3] = source.AmbientColor.w;
+		light.diffuse[0] = source.DiffuseColor.x; light.diffuse[1] = source.DiffuseColor.y;
+		light.diffuse[2] = source.DiffuseColor.z; light.diffuse[3] = source.DiffuseColor.w;
+
+		// The shader lights along normalize(-Direction).
+		light.direction[0] = -source.Direction.x;
+		light.direction[1] = -source.Direction.y;
+		light.direction[2] = -source.Direction.z;
+		Normalize(light.direction, 3);
+	}
+
+	triangles.clear();
+	for (std::vector<unsigned int>& bin : bins)
+		bin.clear();
+	stats = {};
+}
+
+/// <summary>
+/// Run a mesh through the vertex shader, then clip, cull and
+/// bin its triangles. Nothing is drawn until Render().
+/// </summary>
+/// <param name="positions">Vertex positions, in local space.</param>
+/// <param name="normals">Vertex normals, in local space.</param>
+/// <param name="indices">Three indices per triangle.</param>
+/// <param name="indexCount">Number of indices.</param>
+/// <param name="world">World matrix (row vector, not transposed).</param>
+/// <param name="surface">Surface color, as sent to VertexShader.hlsl.</param>
+void SoftwareRasterizer::DrawMesh(const XMFLOAT3* positions, const XMFLOAT3* normals, const unsigned int* indices, unsigned int indexCount,
+	const XMMATRIX& world, const XMFLOAT4& surface)
+{
+	XMMATRIX toClip = XMMatrixMultiply(world, XMLoadFloat4x4(&viewProjection));
+
+	// The pixel shader only ever uses the normalized surface color.
+	float normalizedSurface[4] = { surface.x, surface.y, surface.z, surface.w };
+	Normalize(normalizedSurface, 4);
+
+	for (unsigned int i = 0; i + 2 < indexCount; i += 3)
+	{
+		ClipVertex vertices[3];
+		for (unsigned int v = 0; v < 3; v++)
+		{
+			unsigned int index = indices[i + v];
+			XMStoreFloat4(&vertices[v].position, XMVector3Transform(XMLoadFloat3(&positions[index]), toClip));
+
+			// mul(normal, (float3x3)world), as in the vertex shader.
+			XMStoreFloat3(&vertices[v].normal, XMVector3TransformNormal(XMLoadFloat3(&normals[index]), world));
+		}
+
+		stats.triangles++;
+		AddTriangle(vertices[0], vertices[1], vertices[2], normalizedSurface);
+	}
+}
+
+/// <summary>
+/// Clear the image and rasterize every binned triangle, one
+/// task per tile.
+/// </summary>
+void SoftwareRasterizer::Render()
+{
+	if (bins.empty())
+		return;
+
+	workers.Run((unsigned int)bins.size(), [this](unsigned int tile) { RasterizeTile(tile); });
+
+	stats.pixels = 0;
+	for (unsigned long long pixels : tilePixels)
+		stats.pixels += pixels;
+}
+
+/// <summary>
+/// Write the image as an uncompressed 32 bit TGA, top row first.
+/// </summary>
+/// <param name="filename">File to create.</param>
+/// <returns>Returns false if the file couldn't be written.</returns>
+bool SoftwareRasterizer::SaveTGA(const std::string& filename) const
+{
+	if (width == 0 || height == 0 || width > 0xFFFF || height > 0xFFFF)
+		return false;
+
+	std::ofstream file(filename, std::ios::binary);
+	if (!file.is_open())
+		return false;
+
+	unsigned char header[18] = {};
+	header[2] = 2;		// Uncompressed true color.
+	header[12] = (unsigned char)(width & 0xFF);
+	header[13] = (unsigned char)(width >> 8);
+	header[14] = (unsigned char)(height & 0xFF);
+	header[15] = (unsigned char)(height >> 8);
+	header[16] = 32;	// Bits per pixel.
+	header[17] = 0x28;	// Top left origin, 8 alpha bits.
+	file.write((const char*)header, sizeof(header));
+
+	// TGA stores blue, green, red, alpha.
+	std::vector<unsigned char> row(width * 4);
+	for (unsigned int y = 0; y < height; y++)
+	{
+		const unsigned int* source = &color[(size_t)y * GetPitch()];
+		for (unsigned int x = 0; x < width; x++)
+		{
+			unsigned int pixel = source[x];
+			row[x * 4 + 0] = (unsigned char)(pixel >> 16);
+			row[x * 4 + 1] = (unsigned char)(pixel >> 8);
+			row[x * 4 + 2] = (unsigned char)pixel;
+			row[x * 4 + 3] = (unsigned char)(pixel >> 24);
+		}
+		file.write((const char*)row.data(), row.size());
+	}
+
+	return file.good();
+}
+
+// -----------------------------------------------
+// Helper methods.
+// -----------------------------------------------
+
+/// <summary>
+/// Clip a triangle against the near plane (z >= 0 in clip
+/// space) and set up what's left - none, one or two triangles.
+/// Other planes aren't clipped: the screen bounds and the
+/// depth test take care of them.
+/// </summary>
+/// <param name="a">First vertex.</param>
+/// <param name="b">Second vertex.</param>
+/// <param name="c">Third vertex.</param>
+/// <param name="surface">Normalized surface color.</param>
+void SoftwareRasterizer::AddTriangle(const ClipVertex& a, const ClipVertex& b, const ClipVertex& c, const float surface[4])
+{
+	const ClipVertex* input[3] = { &a, &b, &c };
+	bool inside[3] = { a.position.z >= 0.0f, b.position.z >= 0.0f, c.position.z >= 0.0f };
+
+	if (inside[0] && inside[1] && inside[2])
+	{
+		SetupTriangle(input, surface);
+		return;
+	}
+	if (!inside[0] && !inside[1] && !inside[2])
+		return;
+
+	// Walk the edges, keeping inside vertices and adding one
+	// where each edge crosses the plane (at most four in all).
+	ClipVertex clipped[4];
+	unsigned int count = 0;
+	for (unsigned int e = 0; e < 3; e++)
+	{
+		const ClipVertex& from = *input[e];
+		const ClipVertex& to = *input[(e + 1) % 3];
+		if (inside[e])
+			clipped[count++] = from;
+
+		if (inside[e] != inside[(e + 1) % 3])
+		{
+			float t = from.position.z / (from.position.z - to.position.z);
+			XMStoreFloat4(&clipped[count].position, XMVectorLerp(XMLoadFloat4(&from.position), XMLoadFloat4(&to.position), t));
+			XMStoreFloat3(&clipped[count].normal, XMVectorLerp(XMLoadFloat3(&from.normal), XMLoadFloat3(&to.normal), t));
+			clipped[count].position.z = 0.0f;
+			count++;
+		}
+	}
+
+	for (unsigned int v = 1; v + 1 < count; v++)
+	{
+		const ClipVertex* fan[3] = { &clipped[0], &clipped[v], &clipped[v + 1] };
+		SetupTriangle(fan, surface);
+	}
+}
+
+/// <summary>
+/// Project a clipped triangle to the screen, drop it if it faces
+/// away, then compute its edge functions, attribute planes and
+/// pixel bounds and bin it to every tile its bounds touch.
+/// </summary>
+/// <param name="vertices">Three vertices, in clip space (w > 0).</param>
+/// <param name="surface">Normalized surface color.</param>
+void SoftwareRasterizer::SetupTriangle(const ClipVertex* vertices[3], const float surface[4])
+{
+	float x[3], y[3], z[3], normal[3][3];
+	for (unsigned int v = 0; v < 3; v++)
+	{
+		const XMFLOAT4& position = vertices[v]->position;
+		if (!(position.w > 0.0f))
+			return;
+
+		// Normalized device coordinates to pixels (y down).
+		float inverseW = 1.0f / position.w;
+		x[v] = (position.x * inverseW * 0.5f + 0.5f) * width;
+		y[v] = (0.5f - position.y * inverseW * 0.5f) * height;
+		z[v] = position.z * inverseW;
+		normal[0][v] = vertices[v]->normal.x * inverseW;
+		normal[1][v] = vertices[v]->normal.y * inverseW;
+		normal[2][v] = vertices[v]->normal.z * inverseW;
+	}
+
+	// Clockwise on screen (y down) is the front; this also
+	// drops degenerate triangles.
+	float dx1 = x[1] - x[0], dy1 = y[1] - y[0];
+	float dx2 = x[2] - x[0], dy2 = y[2] - y[0];
+	float area = dx1 * dy2 - dy1 * dx2;
+	if (!(area > 0.0f))
+		return;
+
+	float lowX = fminf(fminf(x[0], x[1]), x[2]), highX = fmaxf(fmaxf(x[0], x[1]), x[2]);
+	float lowY = fminf(fminf(y[0], y[1]), y[2]), highY = fmaxf(fmaxf(y[0], y[1]), y[2]);
+	if (highX < 0.0f || highY < 0.0f || lowX >= (float)width || lowY >= (float)height)
+		return;
+
+	Triangle triangle;
+	for (unsigned int e = 0; e < 3; e++)
+	{
+		unsigned int from = e, to = (e + 1) % 3;
+		Plane& edge = triangle.edges[e];
+		edge.x = y[from] - y[to];
+		edge.y = x[to] - x[from];
+		edge.c = -(edge.x * x[from] + edge.y * y[from]);
+
+		// Pixel centers exactly on an edge belong to the triangle
+		// only if it's a top edge or a left edge.
+		float edgeDX = x[to] - x[from], edgeDY = y[to] - y[from];
+		triangle.topLeft[e] = (edgeDY < 0.0f) || (edgeDY == 0.0f && edgeDX > 0.0f);
+	}
+
+	// Values divided by w are linear in screen space.
+	auto makePlane = [&](const float* values) -> Plane
+	{
+		float d1 = values[1] - values[0], d2 = values[2] - values[0];
+		Plane plane;
+		plane.x = (d1 * dy2 - d2 * dy1) / area;
+		plane.y = (d2 * dx1 - d1 * dx2) / area;
+		plane.c = values[0] - plane.x * x[0] - plane.y * y[0];
+		return plane;
+	};
+	triangle.depth = makePlane(z);
+	for (unsigned int axis = 0; axis < 3; axis++)
+		triangle.normal[axis] = makePlane(normal[axis]);
+	for (unsigned int c = 0; c < 4; c++)
+		triangle.surface[c] = surface[c];
+
+	triangle.minX = ClampToInt(floorf(lowX), 0, width - 1);
+	triangle.maxX = ClampToInt(ceilf(highX), 0, width - 1);
+	triangle.minY = ClampToInt(floorf(lowY), 0, height - 1);
+	triangle.maxY = ClampToInt(ceilf(highY), 0, height - 1);
+
+	unsigned int index = (unsigned int)triangles.size();
+	triangles.push_back(triangle);
+	stats.rasterized++;
+
+	for (int ty = triangle.minY / (int)TILE_SIZE; ty <= triangle.maxY / (int)TILE_SIZE; ty++)
+	{
+		for (int tx = triangle.minX / (int)TILE_SIZE; tx <= triangle.maxX / (int)TILE_SIZE; tx++)
+		{
+			bins[ty * tilesX + tx].push_back(index);
+			stats.binned++;
+		}
+	}
+}
+
+/// <summary>
+/// Clear a tile, then draw its triangles four pixels at a time:
+/// test the edges and depth, shade as PixelShader.hlsl does,
+/// and write the pixels that pass.
+/// </summary>
+/// <param name="tile">Tile index (row major).</param>
+void SoftwareRasterizer::RasterizeTile(unsigned int tile)
+{
+	const unsigned int pitch = GetPitch();
+	const int tileX0 = (tile % tilesX) * TILE_SIZE;
+	const int tileY0 = (tile / tilesX) * TILE_SIZE;
+	const int tileX1 = tileX0 + TILE_SIZE - 1;
+	const int tileY1 = tileY0 + TILE_SIZE - 1;
+
+	for (int y = tileY0; y <= tileY1; y++)
+	{
+		std::fill_n(&color[(size_t)y * pitch + tileX0], TILE_SIZE, clearColor);
+		std::fill_n(&depth[(size_t)y * pitch + tileX0], TILE_SIZE, 1.0f);
+	}
+
+	const __m128 laneOffsets = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 one = _mm_set1_ps(1.0f);
+	const __m128 allLanes = _mm_castsi128_ps(_mm_set1_epi32(-1));
+	const __m128 screenWidth = _mm_set1_ps((float)width);
+	const __m128 tiny = _mm_set1_ps(1e-30f);
+	const __m128 scale = _mm_set1_ps(255.0f);
+
+	// Light terms that don't depend on the pixel.
+	__m128 lightDirection[2][3], diffuse[2][4], ambient[4];
+	for (unsigned int l = 0; l < 2; l++)
+	{
+		for (unsigned int axis = 0; axis < 3; axis++)
+			lightDirection[l][axis] = _mm_set1_ps(lights[l].direction[axis]);
+		for (unsigned int c = 0; c < 4; c++)
+			diffuse[l][c] = _mm_set1_ps(lights[l].diffuse[c]);
+	}
+	for (unsigned int c = 0; c < 4; c++)
+		ambient[c] = _mm_set1_ps(lights[0].ambient[c] + lights[1].ambient[c]);
+
+	unsigned long long shaded = 0;
+	for (unsigned int index : bins[tile])
+	{
+		const Triangle& triangle = triangles[index];
+
+		// Start on a multiple of four; tiles are too, so
+		// every group of four stays inside the tile.
+		int x0 = (triangle.minX > tileX0 ? triangle.minX : tileX0) & ~3;
+		int x1 = triangle.maxX < tileX1 ? triangle.maxX : tileX1;
+		int y0 = triangle.minY > tileY0 ? triangle.minY : tileY0;
+		int y1 = triangle.maxY < tileY1 ? triangle.maxY : tileY1;
+
+		__m128 edgeX[3], onEdge[3];
+		for (int e = 0; e < 3; e++)
+		{
+			edgeX[e] = _mm_set1_ps(triangle.edges[e].x);
+			onEdge[e] = triangle.topLeft[e] ? allLanes : zero;
+		}
+		__m128 depthX = _mm_set1_ps(triangle.depth.x);
+		__m128 normalX[3];
+		for (int axis = 0; axis < 3; axis++)
+			normalX[axis] = _mm_set1_ps(triangle.normal[axis].x);
+		__m128 surface[4];
+		for (int c = 0; c < 4; c++)
+			surface[c] = _mm_set1_ps(triangle.surface[c]);
+
+		for (int y = y0; y <= y1; y++)
+		{
+			float pixelY = (float)y + 0.5f;
+			__m128 edgeRow[3], normalRow[3];
+			for (int e = 0; e < 3; e++)
+				edgeRow[e] = _mm_set1_ps(triangle.edges[e].y * pixelY + triangle.edges[e].c);
+			for (int axis = 0; axis < 3; axis++)
+				normalRow[axis] = _mm_set1_ps(triangle.normal[axis].y * pixelY + triangle.normal[axis].c);
+			__m128 depthRow = _mm_set1_ps(triangle.depth.y * pixelY + triangle.depth.c);
+
+			float* depthPixels = &depth[(size_t)y * pitch];
+			unsigned int* colorPixels = &color[(size_t)y * pitch];
+			for (int x = x0; x <= x1; x += 4)
+			{
+				__m128 pixelX = _mm_add_ps(_mm_set1_ps((float)x), laneOffsets);
+
+				// ----------
+				// Coverage: inside all three edges, and on screen.
+				__m128 covered = _mm_cmplt_ps(pixelX, screenWidth);
+				for (int e = 0; e < 3; e++)
+				{
+					__m128 distance = _mm_add_ps(_mm_mul_ps(edgeX[e], pixelX), edgeRow[e]);
+					__m128 inside = _mm_or_ps(_mm_cmpgt_ps(distance, zero), _mm_and_ps(_mm_cmpeq_ps(distance, zero), onEdge[e]));
+					covered = _mm_and_ps(covered, inside);
+				}
+				if (_mm_movemask_ps(covered) == 0)
+					continue;
+
+				// ----------
+				// Depth test (LESS).
+				__m128 pixelDepth = _mm_add_ps(_mm_mul_ps(depthX, pixelX), depthRow);
+				__m128 currentDepth = _mm_loadu_ps(depthPixels + x);
+				__m128 pass = _mm_and_ps(covered, _mm_cmplt_ps(pixelDepth, currentDepth));
+				int passMask = _mm_movemask_ps(pass);
+				if (passMask == 0)
+					continue;
+				_mm_storeu_ps(depthPixels + x, _mm_or_ps(_mm_and_ps(pass, pixelDepth), _mm_andnot_ps(pass, currentDepth)));
+				shaded += LANE_COUNTS[passMask];
+
+				// ----------
+				// input.normal = normalize(input.normal)
+				__m128 n[3];
+				for (int axis = 0; axis < 3; axis++)
+					n[axis] = _mm_add_ps(_mm_mul_ps(normalX[axis], pixelX), normalRow[axis]);
+				__m128 lengthSquared = _mm_add_ps(_mm_add_ps(_mm_mul_ps(n[0], n[0]), _mm_mul_ps(n[1], n[1])), _mm_mul_ps(n[2], n[2]));
+				__m128 inverseLength = _mm_div_ps(one, _mm_sqrt_ps(_mm_max_ps(lengthSquared, tiny)));
+				for (int axis = 0; axis < 3; axis++)
+					n[axis] = _mm_mul_ps(n[axis], inverseLength);
+
+				// ----------
+				// calculateLight() for both lights, summed:
+				// saturate(dot(n, -direction)) * diffuse + ambient
+				__m128 intensity[2];
+				for (int l = 0; l < 2; l++)
+				{
+					__m128 dot = _mm_add_ps(_mm_add_ps(
+						_mm_mul_ps(n[0], lightDirection[l][0]),
+						_mm_mul_ps(n[1], lightDirection[l][1])),
+						_mm_mul_ps(n[2], lightDirection[l][2]));
+					intensity[l] = _mm_min_ps(_mm_max_ps(dot, zero), one);
+				}
+
+				__m128 lit[4];
+				for (int c = 0; c < 4; c++)
+				{
+					lit[c] = _mm_add_ps(_mm_add_ps(
+						_mm_mul_ps(intensity[0], diffuse[0][c]),
+						_mm_mul_ps(intensity[1], diffuse[1][c])),
+						ambient[c]);
+				}
+
+				// ----------
+				// normalize(normalize(lit) * normalize(surface)) -
+				// the inner scale cancels, so normalize once.
+				__m128 shadedColor[4];
+				for (int c = 0; c < 4; c++)
+					shadedColor[c] = _mm_mul_ps(lit[c], surface[c]);
+				__m128 colorLengthSquared = _mm_add_ps(
+					_mm_add_ps(_mm_mul_ps(shadedColor[0], shadedColor[0]), _mm_mul_ps(shadedColor[1], shadedColor[1])),
+					_mm_add_ps(_mm_mul_ps(shadedColor[2], shadedColor[2]), _mm_mul_ps(shadedColor[3], shadedColor[3])));
+				__m128 colorScale = _mm_mul_ps(scale, _mm_div_ps(one, _mm_sqrt_ps(_mm_max_ps(colorLengthSquared, tiny))));
+
+				// ----------
+				// Convert to 8 bits (rounding) and pack as RGBA.
+				__m128i channels[4];
+				for (int c = 0; c < 4; c++)
+					channels[c] = _mm_cvtps_epi32(_mm_min_ps(_mm_max_ps(_mm_mul_ps(shadedColor[c], colorScale), zero), scale));
+				__m128i packed = _mm_or_si128(
+					_mm_or_si128(channels[0], _mm_slli_epi32(channels[1], 8)),
+					_mm_or_si128(_mm_slli_epi32(channels[2], 16), _mm_slli_epi32(channels[3], 24)));
+
+				__m128i passBits = _mm_castps_si128(pass);
+				__m128i current = _mm_loadu_si128((const __m128i*)(colorPixels + x));
+				_mm_storeu_si128((__m128i*)(colorPixels + x), _mm_or_si128(_mm_and_si128(passBits, packed), _mm_andnot_si128(passBits, current)));
+			}
+		}
+	}
+
+	tilePixels[tile] = shaded;
+}
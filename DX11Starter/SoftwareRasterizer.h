@@ -0,0 +1,170 @@
+#pragma once
+
+// -----------------------------------------------
+// Include statements.
+// -----------------------------------------------
+#include "WorkerPool.h"
+#include "Lights.h"
+#include <DirectXMath.h>
+#include <string>
+#include <vector>
+
+// -----------------------------------------------
+// SoftwareRasterizer.h
+// ---
+// Draws meshes on the CPU the way the GPU draws
+// them with VertexShader.hlsl and PixelShader.hlsl:
+// world/view/projection transform, near plane
+// clipping, back face culling (clockwise is the
+// front, as in the default rasterizer state), the
+// top-left fill rule, a LESS depth test, and the
+// two directional light shading model.
+//
+// Triangles are set up and binned to screen tiles
+// as meshes are added. Render() then gives each
+// tile to a worker (see WorkerPool), which clears
+// it and shades 4 pixels at a time with SSE. Each
+// tile keeps its triangles in the order they were
+// added, so the image doesn't depend on the
+// number of threads.
+//
+// Needs no device: the result can be saved (e.g.
+// for image comparisons on machines without a
+// GPU, as Tools/RasterScene does) or copied into
+// a texture.
+// -----------------------------------------------
+
+class SoftwareRasterizer
+{
+public:
+	// -----------------------------------------------
+	// Internal structs.
+	// -----------------------------------------------
+
+	/// <summary>
+	/// Counts from the last frame.
+	/// </summary>
+	struct Statistics
+	{
+		unsigned int triangles;			// Given to DrawMesh().
+		unsigned int rasterized;		// Survived clipping and culling (after clipping splits).
+		unsigned int binned;			// Triangle/tile pairs.
+		unsigned long long pixels;		// Passed the depth test and were shaded.
+	};
+
+	// Tiles are rasterized independently. A multiple of 4.
+	static const unsigned int TILE_SIZE = 64;
+
+	// -----------------------------------------------
+	// Constructors.
+	// -----------------------------------------------
+
+	SoftwareRasterizer(unsigned int threadCount = WorkerPool::DEFAULT_THREADS);	// 0 renders on the calling thread only.
+	~SoftwareRasterizer();
+
+	// -----------------------------------------------
+	// Static methods.
+	// -----------------------------------------------
+
+	static unsigned int PackColor(const float color[4]);	// RGBA, 8 bits each, red in the low byte.
+
+	// -----------------------------------------------
+	// Accessors.
+	// -----------------------------------------------
+
+	unsigned int GetWidth() const;
+	unsigned int GetHeight() const;
+	unsigned int GetPitch() const;	// Pixels from one row to the next (rounded up to whole tiles).
+	const unsigned int* GetColorBuffer() const;	// Packed RGBA (see PackColor), row major.
+	const float* GetDepthBuffer() const;	// Same layout. 1 is the far plane.
+	const Statistics& GetStatistics() const;
+	unsigned int GetThreadCount() const;	// Worker threads, not counting the caller.
+
+	// -----------------------------------------------
+	// Service methods.
+	// -----------------------------------------------
+
+	void Resize(unsigned int width, unsigned int height);
+	void BeginFrame(const DirectX::XMMATRIX& viewProjection, const DirectionalLight& light1, const DirectionalLight& light2, const float clearColor[4]);	// Row vector, not transposed.
+	void DrawMesh(const DirectX::XMFLOAT3* positions, const DirectX::XMFLOAT3* normals, const unsigned int* indices, unsigned int indexCount,
+		const DirectX::XMMATRIX& world, const DirectX::XMFLOAT4& surface);	// World is row vector, not transposed.
+	void Render();	// Clear, then draw every triangle added since BeginFrame().
+	bool SaveTGA(const std::string& filename) const;	// 32 bit, uncompressed.
+
+private:
+
+	// -----------------------------------------------
+	// Internal structs.
+	// -----------------------------------------------
+
+	/// <summary>
+	/// A value that varies linearly across the screen:
+	/// value = x * pixelX + y * pixelY + c.
+	/// </summary>
+	struct Plane
+	{
+		float x, y, c;
+	};
+
+	/// <summary>
+	/// A screen space triangle, set up for rasterizing.
+	/// </summary>
+	struct Triangle
+	{
+		Plane edges[3];			// >= 0 inside (> 0 for edges that aren't top or left).
+		bool topLeft[3];
+		Plane depth;			// z / w.
+		Plane normal[3];		// Normal / w - normalized per pixel, so the 1 / w cancels.
+		float surface[4];		// Normalized surface color.
+		int minX, minY, maxX, maxY;	// Pixel bounds, clamped to the screen.
+	};
+
+	/// <summary>
+	/// A vertex after the vertex shader.
+	/// </summary>
+	struct ClipVertex
+	{
+		DirectX::XMFLOAT4 position;	// Clip space.
+		DirectX::XMFLOAT3 normal;	// World space, not normalized.
+	};
+
+	/// <summary>
+	/// A light, ready for shading.
+	/// </summary>
+	struct Light
+	{
+		float ambient[4];
+		float diffuse[4];
+		float direction[3];		// Normalized, towards the light.
+	};
+
+	// -----------------------------------------------
+	// Data members.
+	// -----------------------------------------------
+
+	unsigned int width;
+	unsigned int height;
+	unsigned int tilesX;
+	unsigned int tilesY;
+	std::vector<unsigned int> color;	// Pitch x (tilesY * TILE_SIZE).
+	std::vector<float> depth;
+	unsigned int clearColor;
+
+	DirectX::XMFLOAT4X4 viewProjection;
+	Light lights[2];
+
+	std::vector<Triangle> triangles;
+	std::vector<std::vector<unsigned int>> bins;	// Triangles touching each tile.
+	std::vector<unsigned long long> tilePixels;		// Shaded per tile, summed after Render().
+	Statistics stats;
+
+	WorkerPool workers;
+
+	// -----------------------------------------------
+	// Helper methods.
+	// -----------------------------------------------
+
+	void AddTriangle(const ClipVertex& a, const ClipVertex& b, const ClipVertex& c, const float surface[4]);	// Clips against the near plane.
+	void SetupTriangle(const ClipVertex* vertices[3], const float surface[4]);	// Culls, sets up and bins.
+	void RasterizeTile(unsigned int tile);
+};
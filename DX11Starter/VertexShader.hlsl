@@ -4,14 +4,21 @@
 //    which will (eventually) hold data from our C++ code
 // - All non-pipeline variables that get their values from 
 //    our C++ code must be defined inside a Constant Buffer
-// - The name of the cbuffer itself is unimportant
-cbuffer externalData : register(b0)
+// - Buffers are split by how often their data changes, so
+//    each one is only copied to the GPU when it has to be
+//    (the C++ code refers to them by these names)
+cbuffer perFrame : register(b0)
 {
-	matrix world;
 	matrix view;
 	matrix projection;
 };
 
+cbuffer perObject : register(b1)
+{
+	matrix world;
+	float4 surface;
+};
+
 // Struct representing a single vertex worth of data
 // - This should match the vertex definition in our C++ code
 // - By "match", I mean the size, order and number of members
@@ -43,6 +50,7 @@ struct VertexToPixel
 	//  v    v                v
 	float4 position		: SV_POSITION;	// XYZW position (System Value Position)
 	float3 normal		: NORMAL;
+	float4 surface		: COLOR;		// Surface color
 };
 
 // --------------------------------------------------------
@@ -77,6 +85,7 @@ VertexToPixel main( VertexShaderInput input )
 	// - The values will be interpolated per-pixel by the rasterizer
 	// - We don't need to alter it here, but we do need to send it to the pixel shader
 	output.normal = mul(input.normal, (float3x3)world);
+	output.surface = surface;
 
 	// Whatever we return will make its way through the pipeline to the
 	// next programmable stage we're using (the pixel shader for now)
@@ -0,0 +1,137 @@
+// -----------------------------------------------
+// Include statements.
+// -----------------------------------------------
+#include "WorkerPool.h"
+
+// -----------------------------------------------
+// Constructors.
+// -----------------------------------------------
+
+/// <summary>
+/// Start the worker threads.
+/// </summary>
+/// <param name="threadCount">Worker threads. DEFAULT_THREADS picks one less than the hardware threads, up to 7.</param>
+WorkerPool::WorkerPool(unsigned int threadCount)
+	: generation{ 0 }, busyWorkers{ 0 }, stopping{ false },
+	current{ nullptr }, taskCount{ 0 }, nextTask{ 0 }
+{
+	if (threadCount == DEFAULT_THREADS)
+	{
+		unsigned int hardware = std::thread::hardware_concurrency();
+		threadCount = (hardware > 1) ? hardware - 1 : 0;
+		if (threadCount > 7) threadCount = 7;
+	}
+
+	for (unsigned int i = 0; i < threadCount; i++)
+		workers.emplace_back(&WorkerPool::WorkerLoop, this);
+}
+
+/// <summary>
+/// Stop and join the worker threads.
+/// </summary>
+WorkerPool::~WorkerPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+	}
+	wake.notify_all();
+
+	for (std::thread& worker : workers)
+		worker.join();
+}
+
+// -----------------------------------------------
+// Accessors.
+// -----------------------------------------------
+
+/// <summary>
+/// Number of worker threads.
+/// </summary>
+unsigned int WorkerPool::GetThreadCount() const
+{
+	return (unsigned int)workers.size();
+}
+
+// -----------------------------------------------
+// Service methods.
+// -----------------------------------------------
+
+/// <summary>
+/// Run task(0) to task(taskCount - 1) across the workers and
+/// the calling thread, in no particular order.
+/// </summary>
+/// <param name="count">Number of tasks.</param>
+/// <param name="task">Called once per task number.</param>
+void WorkerPool::Run(unsigned int count, const std::function<void(unsigned int task)>& task)
+{
+	current = &task;
+	taskCount = count;
+	nextTask.store(0);
+
+	// Not worth waking anyone for a single task.
+	bool parallel = !workers.empty() && count > 1;
+	if (parallel)
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			busyWorkers = (unsigned int)workers.size();
+			generation++;
+		}
+		wake.notify_all();
+	}
+
+	RunTasks();
+
+	if (parallel)
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		finished.wait(lock, [this] { return busyWorkers == 0; });
+	}
+	current = nullptr;
+}
+
+// -----------------------------------------------
+// Helper methods.
+// -----------------------------------------------
+
+/// <summary>
+/// Claim and run tasks until every task has been claimed.
+/// </summary>
+void WorkerPool::RunTasks()
+{
+	for (;;)
+	{
+		unsigned int task = nextTask.fetch_add(1);
+		if (task >= taskCount)
+			break;
+		(*current)(task);
+	}
+}
+
+/// <summary>
+/// Worker thread: wait for a Run(), help with its tasks,
+/// report back, repeat until stopped.
+/// </summary>
+void WorkerPool::WorkerLoop()
+{
+	unsigned int seen = 0;
+	for (;;)
+	{
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			wake.wait(lock, [this, seen] { return stopping || generation != seen; });
+			if (stopping)
+				return;
+			seen = generation;
+		}
+
+		RunTasks();
+
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			if (--busyWorkers == 0)
+				finished.notify_one();
+		}
+	}
+}
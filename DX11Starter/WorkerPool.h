@@ -0,0 +1,80 @@
+#pragma once
+
+// -----------------------------------------------
+// Include statements.
+// -----------------------------------------------
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// -----------------------------------------------
+// WorkerPool.h
+// ---
+// A fixed set of threads that run numbered tasks.
+// Run() hands out task numbers through an atomic
+// counter, works on them itself alongside the
+// workers, and returns once every task is done.
+//
+// Tasks of one Run() must not depend on each
+// other; anything they write should be split by
+// task number so no locking is needed.
+// -----------------------------------------------
+
+class WorkerPool
+{
+public:
+	// Pick the worker count from the hardware.
+	static const unsigned int DEFAULT_THREADS = 0xFFFFFFFF;
+
+	// -----------------------------------------------
+	// Constructors.
+	// -----------------------------------------------
+
+	WorkerPool(unsigned int threadCount = DEFAULT_THREADS);	// 0 runs every task on the calling thread.
+	~WorkerPool();
+
+	// -----------------------------------------------
+	// Accessors.
+	// -----------------------------------------------
+
+	unsigned int GetThreadCount() const;	// Workers, not counting the caller.
+
+	// -----------------------------------------------
+	// Service methods.
+	// -----------------------------------------------
+
+	void Run(unsigned int taskCount, const std::function<void(unsigned int task)>& task);	// Blocks until every task is done.
+
+private:
+
+	// -----------------------------------------------
+	// Data members.
+	// -----------------------------------------------
+
+	std::vector<std::thread> workers;
+	std::mutex mutex;
+	std::condition_variable wake;
+	std::condition_variable finished;
+	unsigned int generation;	// Bumped once per Run().
+	unsigned int busyWorkers;
+	bool stopping;
+
+	// The current Run().
+	const std::function<void(unsigned int)>* current;
+	unsigned int taskCount;
+	std::atomic<unsigned int> nextTask;
+
+	// -----------------------------------------------
+	// Helper methods.
+	// -----------------------------------------------
+
+	void RunTasks();	// Claims tasks until none are left.
+	void WorkerLoop();
+
+	// Not copyable - owns threads.
+	WorkerPool(const WorkerPool&) = delete;
+	WorkerPool& operator=(const WorkerPool&) = delete;
+};
@@ -0,0 +1,30 @@
+#include "UnitTests.h"
+#include <cstdio>
+#include <cstring>
+
+// --------------------------------------------------------
+// Entry point
+//
+// UnitTests              runs every test
+// UnitTests NAME...      runs the named tests
+// UnitTests --list       lists them
+//
+// Exits with 1 if any test failed, so ctest (or any other
+// runner) sees the failure.
+// --------------------------------------------------------
+int main(int argc, char* argv[])
+{
+	if (argc == 2 && strcmp(argv[1], "--list") == 0)
+	{
+		UnitTests::List();
+		return 0;
+	}
+
+	if (argc < 2)
+		return UnitTests::Run("all") ? 0 : 1;
+
+	bool passed = true;
+	for (int i = 1; i < argc; i++)
+		passed = UnitTests::Run(argv[i]) && passed;
+	return passed ? 0 : 1;
+}
@@ -0,0 +1,906 @@
+// -----------------------------------------------
+// Include statements.
+// -----------------------------------------------
+#include "UnitTests.h"
+#include "Check.h"
+#include "FrameGraph.h"
+#include "InputMap.h"
+#include "Logger.h"
+#include "RenderCounters.h"
+#include "RenderQueue.h"
+#include "RenderStateTracker.h"
+#include "RingAllocator.h"
+#include "ShaderReflectionCache.h"
+#include "WorkerPool.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+// -----------------------------------------------
+// Registered tests.
+// -----------------------------------------------
+
+const UnitTests::Entry UnitTests::entries[] =
+{
+	{ "render-queue", "Keys order by pass, material, mesh and depth, and sorting is stable", &UnitTests::RenderQueueOrder },
+	{ "state-tracker", "Only binds that change something are issued, per slot, until the state is forgotten", &UnitTests::StateTrackerFilter },
+	{ "ring-allocator", "Allocations wrap, discard when full and never land on a frame still in flight", &UnitTests::RingAllocatorFences },
+	{ "worker-pool", "Every task runs exactly once, with and without worker threads", &UnitTests::WorkerPoolTasks },
+	{ "render-counters", "Counts from every thread add up per frame, and budgets are enforced", &UnitTests::RenderCounterTotals },
+	{ "logger", "Queued messages reach the file in order, formatted, without overrunning a record", &UnitTests::LoggerOutput },
+	{ "frame-graph", "Passes are culled, ordered and their textures aliased; cycles and bad handles are refused", &UnitTests::FrameGraphCompile },
+	{ "input-map", "Taps, chords, keys shared by an action, focus loss and played back states resolve as the game expects", &UnitTests::InputMapActions },
+	{ "reflection-cache", "Shader reflections and input signatures read back the same, and stale or damaged sidecars are rejected", &UnitTests::ReflectionRoundTrip },
+	{ nullptr, nullptr, nullptr }
+};
+
+// -----------------------------------------------
+// Static methods.
+// -----------------------------------------------
+
+/// <summary>
+/// Run one test by name, or every test for "all".
+/// </summary>
+/// <param name="name">Test name.</param>
+/// <returns>Returns false if a test failed, or no test has that name.</returns>
+bool UnitTests::Run(const std::string& name)
+{
+	unsigned int tests = 0;
+	unsigned int failures = 0;
+	for (const Entry* entry = entries; entry->name; entry++)
+	{
+		if (name != "all" && name != entry->name)
+			continue;
+
+		printf("== %s: %s\n", entry->name, entry->description);
+		fflush(stdout);
+		bool passed = entry->function();
+		printf("  %s\n", passed ? "passed" : "FAILED");
+		fflush(stdout);
+		tests++;
+		failures += passed ? 0 : 1;
+	}
+
+	if (tests == 0)
+	{
+		printf("Unknown test '%s'.\n", name.c_str());
+		List();
+		return false;
+	}
+
+	if (failures > 0)
+		printf("UnitTests: FAILED (%u of %u tests)\n", failures, tests);
+	else
+		printf("UnitTests: passed (%u tests)\n", tests);
+	return failures == 0;
+}
+
+/// <summary>
+/// Print the available tests.
+/// </summary>
+void UnitTests::List()
+{
+	printf("Tests (run with UnitTests NAME, or UnitTests all):\n");
+	for (const Entry* entry = entries; entry->name; entry++)
+		printf("  %-16s %s\n", entry->name, entry->description);
+	fflush(stdout);
+}
+
+// -----------------------------------------------
+// Tests.
+// -----------------------------------------------
+
+/// <summary>
+/// Check the fields of a sort key order draws the way
+/// the renderer relies on, that batch keys ignore opaque
+/// depth, and that the radix sort gives the same result
+/// as std::stable_sort on random keys with many ties.
+/// </summary>
+bool UnitTests::RenderQueueOrder()
+{
+	bool passed = true;
+
+	// Pass first, then material, mesh and (for opaque draws) near to far.
+	typedef RenderQueue Queue;
+	CHECK(Queue::MakeKey(Queue::RP_OPAQUE, 65535, 65535, 1000) < Queue::MakeKey(Queue::RP_TRANSPARENT, 0, 0, 0));
+	CHECK(Queue::MakeKey(Queue::RP_OPAQUE, 1, 0, 0) > Queue::MakeKey(Queue::RP_OPAQUE, 0, 65535, 1000));
+	CHECK(Queue::MakeKey(Queue::RP_OPAQUE, 1, 2, 0) > Queue::MakeKey(Queue::RP_OPAQUE, 1, 1, 1000));
+	CHECK(Queue::MakeKey(Queue::RP_OPAQUE, 1, 1, 10) > Queue::MakeKey(Queue::RP_OPAQUE, 1, 1, 9));
+	CHECK(Queue::MakeKey(Queue::RP_TRANSPARENT, 0, 0, 10) < Queue::MakeKey(Queue::RP_TRANSPARENT, 0, 0, 9));
+	CHECK(Queue::GetPass(Queue::MakeKey(Queue::RP_TRANSPARENT, 5, 6, 7)) == Queue::RP_TRANSPARENT);
+
+	// Only opaque draws batch across depths.
+	CHECK(Queue::GetBatchKey(Queue::MakeKey(Queue::RP_OPAQUE, 3, 4, 10)) == Queue::GetBatchKey(Queue::MakeKey(Queue::RP_OPAQUE, 3, 4, 99)));
+	CHECK(Queue::GetBatchKey(Queue::MakeKey(Queue::RP_OPAQUE, 3, 4, 10)) != Queue::GetBatchKey(Queue::MakeKey(Queue::RP_OPAQUE, 3, 5, 10)));
+	CHECK(Queue::GetBatchKey(Queue::MakeKey(Queue::RP_TRANSPARENT, 3, 4, 10)) != Queue::GetBatchKey(Queue::MakeKey(Queue::RP_TRANSPARENT, 3, 4, 99)));
+
+	// Depth is clamped to the planes, and NaN goes to the front.
+	const unsigned int maxDepth = (1u << Queue::DEPTH_BITS) - 1;
+	CHECK(Queue::QuantizeDepth(0.0f, 0.1f, 100.0f) == 0);
+	CHECK(Queue::QuantizeDepth(1000.0f, 0.1f, 100.0f) == maxDepth);
+	CHECK(Queue::QuantizeDepth(std::nanf(""), 0.1f, 100.0f) == 0);
+	CHECK(Queue::QuantizeDepth(10.0f, 0.1f, 100.0f) < Queue::QuantizeDepth(10.5f, 0.1f, 100.0f));
+
+	// Few distinct keys, so most of them tie.
+	std::mt19937 random(12345);
+	std::uniform_int_distribution<unsigned int> small(0, 7);
+	RenderQueue queue;
+	std::vector<RenderQueue::Item> expected;
+	for (unsigned int i = 0; i < 10000; i++)
+	{
+		Queue::RenderPass pass = (small(random) == 0) ? Queue::RP_TRANSPARENT : Queue::RP_OPAQUE;
+		Queue::SortKey key = Queue::MakeKey(pass, small(random), small(random), small(random) << 20);
+		queue.Submit(key, i);
+		expected.push_back(RenderQueue::Item{ key, i });
+	}
+	queue.Sort();
+	std::stable_sort(expected.begin(), expected.end(), [](const RenderQueue::Item& a, const RenderQueue::Item& b)
+	{
+		return a.key < b.key;
+	});
+
+	CHECK(queue.GetCount() == expected.size());
+	bool same = queue.GetCount() == expected.size();
+	for (size_t i = 0; i < expected.size() && same; i++)
+		same = queue[i].key == expected[i].key && queue[i].index == expected[i].index;
+	CHECK(same);
+
+	// Clear keeps nothing.
+	queue.Clear();
+	CHECK(queue.GetCount() == 0);
+	queue.Sort();
+	CHECK(queue.begin() == queue.end());
+	return passed;
+}
+
+/// <summary>
+/// Bind each kind of state twice and check only the first
+/// is issued, then that what's forgotten (one constant
+/// slot, or everything) is issued again. Then send 10k
+/// draws, sorted by material and mesh, and compare what
+/// the tracker issues with the changes counted from the
+/// draw stream directly.
+/// </summary>
+bool UnitTests::StateTrackerFilter()
+{
+	typedef RenderStateTracker Tracker;
+	bool passed = true;
+
+	// Objects are only compared, so made up addresses do.
+	auto object = [](uintptr_t id) { return reinterpret_cast<const void*>(id << 4); };
+
+	Tracker tracker;
+	for (int call = 0; call < Tracker::SC_COUNT; call++)
+		CHECK(tracker.GetCounters().issued[call] == 0 && tracker.GetCounters().skipped[call] == 0);
+	CHECK(tracker.SetTopology(4) && !tracker.SetTopology(4) && tracker.SetTopology(5));
+	CHECK(tracker.SetInputLayout(object(1)) && !tracker.SetInputLayout(object(1)));
+	CHECK(tracker.SetVertexShader(object(2)) && !tracker.SetVertexShader(object(2)));
+	CHECK(tracker.SetPixelShader(object(2)) && !tracker.SetPixelShader(object(2)));
+	CHECK(tracker.SetIndexBuffer(object(3), 42, 0) && !tracker.SetIndexBuffer(object(3), 42, 0));
+	CHECK(tracker.SetIndexBuffer(object(3), 57, 0));
+
+	// The buffer, stride and offset all count.
+	CHECK(tracker.SetVertexBuffer(object(4), 32, 0) && !tracker.SetVertexBuffer(object(4), 32, 0));
+	CHECK(tracker.SetVertexBuffer(object(4), 48, 0) && tracker.SetVertexBuffer(object(4), 48, 16));
+	CHECK(tracker.SetInstanceBuffer(object(5), 64, 0) && !tracker.SetInstanceBuffer(object(5), 64, 0));
+
+	// A null object is state like any other.
+	CHECK(tracker.SetPixelShader(nullptr) && !tracker.SetPixelShader(nullptr));
+
+	// Constant buffer slots are tracked apart, and per stage.
+	CHECK(tracker.SetVSConstantBuffer(0, object(6)) && tracker.SetVSConstantBuffer(1, object(6)));
+	CHECK(!tracker.SetVSConstantBuffer(0, object(6)) && !tracker.SetVSConstantBuffer(1, object(6)));
+	CHECK(tracker.SetPSConstantBuffer(0, object(6)) && !tracker.SetPSConstantBuffer(0, object(6)));
+	CHECK(tracker.SetVSConstantBuffer(Tracker::CONSTANT_BUFFER_SLOTS, object(6)));
+	CHECK(tracker.SetVSConstantBuffer(Tracker::CONSTANT_BUFFER_SLOTS, object(6)));
+
+	// A slot written some other way (e.g. a ring slice) is issued
+	// again; the other slots aren't.
+	tracker.ForgetVSConstantBuffer(1);
+	CHECK(tracker.SetVSConstantBuffer(1, object(6)));
+	CHECK(!tracker.SetVSConstantBuffer(0, object(6)));
+	CHECK(!tracker.SetPSConstantBuffer(0, object(6)));
+
+	const Tracker::Counters& counters = tracker.GetCounters();
+	CHECK(counters.issued[Tracker::SC_TOPOLOGY] == 2 && counters.skipped[Tracker::SC_TOPOLOGY] == 1);
+	CHECK(counters.issued[Tracker::SC_VS_CONSTANT_BUFFER] == 5 && counters.skipped[Tracker::SC_VS_CONSTANT_BUFFER] == 3);
+	CHECK(counters.issued[Tracker::SC_VERTEX_BUFFER] == 3 && counters.skipped[Tracker::SC_VERTEX_BUFFER] == 1);
+
+	// After Invalidate(), the same binds are issued once more.
+	tracker.Invalidate();
+	tracker.ResetCounters();
+	CHECK(counters.issued[Tracker::SC_TOPOLOGY] == 0 && counters.skipped[Tracker::SC_TOPOLOGY] == 0);
+	CHECK(tracker.SetTopology(5) && tracker.SetInputLayout(object(1)) && tracker.SetVertexShader(object(2)));
+	CHECK(tracker.SetVSConstantBuffer(0, object(6)) && tracker.SetPSConstantBuffer(0, object(6)));
+	CHECK(tracker.SetVertexBuffer(object(4), 48, 16) && tracker.SetIndexBuffer(object(3), 57, 0));
+	CHECK(!tracker.SetTopology(5) && !tracker.SetVSConstantBuffer(0, object(6)));
+
+	// A sorted draw stream: the first of each bind, then only changes.
+	struct Draw { uintptr_t material; uintptr_t mesh; };
+	std::mt19937 random(12345);
+	std::uniform_int_distribution<unsigned int> materials(1, 64);
+	std::uniform_int_distribution<unsigned int> meshes(1, 256);
+	std::vector<Draw> draws(10000);
+	for (Draw& draw : draws)
+	{
+		draw.material = materials(random);
+		draw.mesh = meshes(random);
+	}
+	std::sort(draws.begin(), draws.end(), [](const Draw& a, const Draw& b)
+	{
+		return (a.material != b.material) ? a.material < b.material : a.mesh < b.mesh;
+	});
+
+	unsigned long long expected[Tracker::SC_COUNT] = {};
+	expected[Tracker::SC_TOPOLOGY] = 1;
+	expected[Tracker::SC_VS_CONSTANT_BUFFER] = 2;
+	expected[Tracker::SC_PS_CONSTANT_BUFFER] = 1;
+	for (size_t i = 0; i < draws.size(); i++)
+	{
+		bool first = (i == 0);
+		bool newMaterial = first || draws[i].material != draws[i - 1].material;
+		bool newLayout = first || draws[i].material % 4 != draws[i - 1].material % 4;
+		bool newMesh = newMaterial || draws[i].mesh != draws[i - 1].mesh;
+		expected[Tracker::SC_INPUT_LAYOUT] += newLayout ? 1 : 0;
+		expected[Tracker::SC_VERTEX_SHADER] += newMaterial ? 1 : 0;
+		expected[Tracker::SC_PIXEL_SHADER] += newMaterial ? 1 : 0;
+		expected[Tracker::SC_VERTEX_BUFFER] += newMesh ? 1 : 0;
+		expected[Tracker::SC_INDEX_BUFFER] += newMesh ? 1 : 0;
+	}
+
+	tracker.Invalidate();
+	tracker.ResetCounters();
+	for (const Draw& draw : draws)
+	{
+		tracker.SetTopology(4);
+		tracker.SetInputLayout(object(draw.material % 4 + 1));
+		tracker.SetVertexShader(object(draw.material << 8));
+		tracker.SetPixelShader(object(draw.material << 8));
+		tracker.SetVSConstantBuffer(0, object(0x100));
+		tracker.SetVSConstantBuffer(1, object(0x200));
+		tracker.SetPSConstantBuffer(0, object(0x100));
+		tracker.SetVertexBuffer(object(draw.mesh << 16), 32, 0);
+		tracker.SetIndexBuffer(object((draw.mesh << 16) | 1), 42, 0);
+	}
+
+	bool counted = true;
+	for (int call = 0; call < Tracker::SC_COUNT; call++)
+	{
+		unsigned long long sent = (call == Tracker::SC_INSTANCE_BUFFER) ? 0 : draws.size();
+		if (call == Tracker::SC_VS_CONSTANT_BUFFER)
+			sent *= 2;
+		if (counters.issued[call] != expected[call] || counters.issued[call] + counters.skipped[call] != sent)
+		{
+			printf("  %s: %llu issued and %llu skipped, expected %llu of %llu\n", Tracker::GetCallName((Tracker::StateCall)call),
+				counters.issued[call], counters.skipped[call], expected[call], sent);
+			counted = false;
+		}
+	}
+	CHECK(counted);
+	return passed;
+}
+
+/// <summary>
+/// Walk a small ring through each case by hand (first
+/// write, wrap, discard, oversized), then run 500 random
+/// frames with the GPU two frames behind, marking which
+/// frame owns each block, and check no NO_OVERWRITE
+/// allocation lands on a block still in flight.
+/// </summary>
+bool UnitTests::RingAllocatorFences()
+{
+	bool passed = true;
+	unsigned int offset = 0;
+	RingAllocator::RingMap map = RingAllocator::RM_NO_OVERWRITE;
+
+	// The first write discards, later ones are aligned behind it.
+	RingAllocator ring(1024, 256);
+	CHECK(!ring.Allocate(0, &offset, &map));
+	CHECK(!ring.Allocate(1025, &offset, &map));
+	CHECK(ring.GetStatistics().failures == 2);
+	CHECK(ring.Allocate(512, &offset, &map) && offset == 0 && map == RingAllocator::RM_DISCARD);
+	CHECK(ring.Allocate(100, &offset, &map) && offset == 512 && map == RingAllocator::RM_NO_OVERWRITE);
+	CHECK(ring.GetUsed() == 768);
+	ring.EndFrame(1);
+	CHECK(ring.GetFramesInFlight() == 1);
+
+	// Once frame 1 is retired, a block too big for the end of
+	// the buffer skips it and starts again at 0.
+	ring.Retire(1);
+	CHECK(ring.GetFramesInFlight() == 0 && ring.GetUsed() == 0);
+	CHECK(ring.Allocate(512, &offset, &map) && offset == 0 && map == RingAllocator::RM_NO_OVERWRITE);
+	CHECK(ring.GetStatistics().wraps == 1);
+	CHECK(ring.GetUsed() == 768);
+	ring.EndFrame(2);
+
+	// Frame 2 is still in flight, so there's no room without a discard.
+	CHECK(ring.Allocate(512, &offset, &map) && offset == 0 && map == RingAllocator::RM_DISCARD);
+	CHECK(ring.GetStatistics().discards == 1);
+	CHECK(ring.GetFramesInFlight() == 0);
+
+	// Random frames. blockFence holds the fence of the frame that
+	// last wrote each block (0 if the ring was discarded since).
+	const unsigned int capacity = 64 * 1024;
+	const unsigned int alignment = 256;
+	const unsigned int latency = 2;
+	ring.Reset(capacity, alignment);
+	std::mt19937 random(12345);
+	std::uniform_int_distribution<unsigned int> sizes(1, 1024);
+	std::vector<unsigned long long> blockFence(capacity / alignment, 0);
+	unsigned long long completed = 0;
+	bool allocated = true, inRange = true, inFlight = false;
+	for (unsigned long long fence = 1; fence <= 500; fence++)
+	{
+		unsigned int allocations = (fence % 50 == 0) ? 200 : 40;
+		for (unsigned int a = 0; a < allocations; a++)
+		{
+			unsigned int size = sizes(random);
+			if (!ring.Allocate(size, &offset, &map))
+			{
+				allocated = false;
+				continue;
+			}
+			inRange = inRange && offset % alignment == 0 && offset + size <= capacity;
+			if (!inRange)
+				continue;
+
+			if (map == RingAllocator::RM_DISCARD)
+				std::fill(blockFence.begin(), blockFence.end(), 0);
+			for (unsigned int b = offset / alignment; b <= (offset + size - 1) / alignment; b++)
+			{
+				inFlight = inFlight || (blockFence[b] > completed && blockFence[b] != fence);
+				blockFence[b] = fence;
+			}
+		}
+
+		ring.EndFrame(fence);
+		if (fence > latency)
+		{
+			completed = fence - latency;
+			ring.Retire(completed);
+		}
+	}
+	CHECK(allocated);
+	CHECK(inRange);
+	CHECK(!inFlight);
+	CHECK(ring.GetStatistics().wraps > 0);
+	CHECK(ring.GetStatistics().discards > 0);
+	return passed;
+}
+
+/// <summary>
+/// Run batches of tasks on pools of 0, 1 and 3 workers,
+/// counting how often each task index runs, and run many
+/// small batches back to back so a worker finishing late
+/// would be caught running the wrong batch.
+/// </summary>
+bool UnitTests::WorkerPoolTasks()
+{
+	bool passed = true;
+	const unsigned int threadCounts[3] = { 0, 1, 3 };
+	for (unsigned int threads : threadCounts)
+	{
+		WorkerPool workers(threads);
+		CHECK(workers.GetThreadCount() == threads);
+
+		const unsigned int taskCount = 1000;
+		std::unique_ptr<std::atomic<unsigned int>[]> runs(new std::atomic<unsigned int>[taskCount]);
+		for (unsigned int t = 0; t < taskCount; t++)
+			runs[t] = 0;
+		std::atomic<unsigned int>* counts = runs.get();
+		workers.Run(taskCount, [counts](unsigned int task) { counts[task]++; });
+
+		bool once = true;
+		for (unsigned int t = 0; t < taskCount; t++)
+			once = once && runs[t] == 1;
+		CHECK(once);
+
+		// Nothing to do returns at once.
+		workers.Run(0, [counts](unsigned int task) { counts[task]++; });
+
+		std::atomic<unsigned int> total(0);
+		for (unsigned int batch = 1; batch <= 200; batch++)
+			workers.Run(batch % 7, [&total, batch](unsigned int) { total += batch; });
+		unsigned int expected = 0;
+		for (unsigned int batch = 1; batch <= 200; batch++)
+			expected += batch * (batch % 7);
+		CHECK(total == expected);
+	}
+	return passed;
+}
+
+/// <summary>
+/// Count from every worker, and from a thread that exits
+/// before the frame ends, and check the frame's totals,
+/// peaks and budgets.
+/// </summary>
+bool UnitTests::RenderCounterTotals()
+{
+	bool passed = true;
+	RenderCounters& counters = RenderCounters::Get();
+	counters.Reset();
+	counters.ClearBudgets();
+
+	WorkerPool workers(3);
+	const unsigned int tasks = 8;
+	const unsigned int addsPerTask = 10000;
+	workers.Run(tasks, [addsPerTask](unsigned int)
+	{
+		for (unsigned int i = 0; i < addsPerTask; i++)
+		{
+			RenderCounters::Add(RenderCounters::RC_DRAWS);
+			RenderCounters::Add(RenderCounters::RC_TRIANGLES, 12);
+		}
+	});
+
+	// A thread's counts outlive it.
+	std::thread exiting([]() { RenderCounters::Add(RenderCounters::RC_DRAWS, 5); });
+	exiting.join();
+
+	const unsigned long long draws = (unsigned long long)tasks * addsPerTask + 5;
+	CHECK(counters.GetTotals().counts[RenderCounters::RC_DRAWS] == draws);
+	counters.EndFrame();
+	CHECK(counters.GetFrameCount() == 1);
+	CHECK(counters.GetLastFrame().counts[RenderCounters::RC_DRAWS] == draws);
+	CHECK(counters.GetLastFrame().counts[RenderCounters::RC_TRIANGLES] == (unsigned long long)tasks * addsPerTask * 12);
+	CHECK(counters.GetLastFrame().counts[RenderCounters::RC_CONSTANT_BYTES] == 0);
+
+	// The next frame counts from zero, the peak keeps the largest.
+	RenderCounters::Add(RenderCounters::RC_DRAWS, 3);
+	counters.EndFrame();
+	CHECK(counters.GetLastFrame().counts[RenderCounters::RC_DRAWS] == 3);
+	CHECK(counters.GetPeak().counts[RenderCounters::RC_DRAWS] == draws);
+	CHECK(counters.GetTotals().counts[RenderCounters::RC_DRAWS] == draws + 3);
+
+	// Budgets by name.
+	RenderCounters::Counter counter;
+	CHECK(RenderCounters::FindCounter("draws", &counter) && counter == RenderCounters::RC_DRAWS);
+	CHECK(!counters.SetBudget("frames=10"));
+	CHECK(!counters.SetBudget("draws"));
+	CHECK(counters.SetBudget("draws=10"));
+	CHECK(counters.HasBudget(RenderCounters::RC_DRAWS) && counters.GetBudget(RenderCounters::RC_DRAWS) == 10);
+	CHECK(counters.IsOverBudget(RenderCounters::RC_DRAWS));
+
+	counters.Reset();
+	CHECK(counters.GetTotals().counts[RenderCounters::RC_DRAWS] == 0);
+	CHECK(!counters.IsOverBudget(RenderCounters::RC_DRAWS));
+	RenderCounters::Add(RenderCounters::RC_DRAWS, 11);
+	counters.EndFrame();
+	CHECK(counters.IsOverBudget(RenderCounters::RC_DRAWS));
+
+	// Don't leave the test's counts or budgets behind.
+	counters.ClearBudgets();
+	counters.Reset();
+	return passed;
+}
+
+/// <summary>
+/// Queue messages with each kind of argument, including
+/// string arguments that don't all fit in a record, write
+/// them to a file and read it back.
+/// </summary>
+bool UnitTests::LoggerOutput()
+{
+	bool passed = true;
+	const char* filename = "UnitTests.log";
+
+	Logger& logger = Logger::Get();
+	logger.SetConsoleOutput(false);
+	CHECK(logger.OpenFile(filename));
+	logger.Start();
+
+	std::string full(Logger::TEXT_CAPACITY - 1, 'a');
+	std::string overrun(40, 'b');
+	logger.Write(Logger::LL_INFO, Logger::LC_CORE, "first %d %u %s", -3, 7u, "text");
+	logger.Write(Logger::LL_WARN, Logger::LC_RENDER, "%.2f|%c|%%", 1.5, 'x');
+	logger.Write(Logger::LL_ERROR, Logger::LC_INPUT, "%s|%s|%d", full.c_str(), overrun.c_str(), 9);
+	logger.Write(Logger::LL_INFO, Logger::LC_CORE, "last");
+	logger.Stop();
+
+	std::ifstream file(filename);
+	std::vector<std::string> lines;
+	std::string line;
+	while (std::getline(file, line))
+		lines.push_back(line);
+	file.close();
+	std::remove(filename);
+
+	CHECK(lines.size() == 4);
+	if (lines.size() == 4)
+	{
+		CHECK(lines[0].find("INFO") != std::string::npos && lines[0].find("core") != std::string::npos);
+		CHECK(lines[0].find(": first -3 7 text") != std::string::npos);
+		CHECK(lines[1].find("WARN") != std::string::npos && lines[1].find("render") != std::string::npos);
+		CHECK(lines[1].find(": 1.50|x|%") != std::string::npos);
+
+		// The string that doesn't fit is left out, not written past the record.
+		CHECK(lines[2].find(": " + full + "||9") != std::string::npos);
+		CHECK(lines[2].find('b') == std::string::npos);
+		CHECK(lines[3].find(": last") != std::string::npos);
+	}
+	CHECK(logger.GetDroppedCount() == 0);
+	return passed;
+}
+
+/// <summary>
+/// Compile a small graph declared out of order, with a
+/// pass nobody needs, and check what runs, in what order,
+/// and which textures share. Then check a cycle and a bad
+/// handle are refused.
+/// </summary>
+bool UnitTests::FrameGraphCompile()
+{
+	bool passed = true;
+	const FrameGraph::TextureDesc hdr = { 1280, 720, 10 };	// DXGI_FORMAT_R16G16B16A16_FLOAT
+	const FrameGraph::TextureDesc ldr = { 1280, 720, 28 };	// DXGI_FORMAT_R8G8B8A8_UNORM
+
+	CHECK(FrameGraph::GetBytesPerPixel(hdr.format) == 8);
+	CHECK(FrameGraph::GetTextureBytes(ldr) == 1280ull * 720 * 4);
+
+	// present reads tonemapped, which reads lit, which reads
+	// gbuffer. Declared backwards. debug's output is never read.
+	FrameGraph graph;
+	std::vector<std::string> executed;
+	auto record = [&executed](const char* name) { return [&executed, name]() { executed.push_back(name); }; };
+	FrameGraph::Handle backBuffer = graph.ImportTexture("back buffer", ldr);
+	FrameGraph::Handle gbuffer = graph.CreateTexture("gbuffer", hdr);
+	FrameGraph::Handle lit = graph.CreateTexture("lit", hdr);
+	FrameGraph::Handle tonemapped = graph.CreateTexture("tonemapped", hdr);
+	FrameGraph::Handle debugOutput = graph.CreateTexture("debug", hdr);
+
+	FrameGraph::Handle present = graph.AddPass("present", record("present"));
+	graph.Read(present, tonemapped);
+	graph.Write(present, backBuffer);
+	FrameGraph::Handle tonemap = graph.AddPass("tonemap", record("tonemap"));
+	graph.Read(tonemap, lit);
+	graph.Write(tonemap, tonemapped);
+	FrameGraph::Handle light = graph.AddPass("light", record("light"));
+	graph.Read(light, gbuffer);
+	graph.Write(light, lit);
+	FrameGraph::Handle geometry = graph.AddPass("geometry", record("geometry"));
+	graph.Write(geometry, gbuffer);
+	FrameGraph::Handle debug = graph.AddPass("debug", record("debug"));
+	graph.Read(debug, gbuffer);
+	graph.Write(debug, debugOutput);
+
+	std::string error;
+	CHECK(graph.Compile(&error));
+	CHECK(graph.IsCompiled());
+	CHECK(graph.IsCulled(debug));
+	CHECK(!graph.IsCulled(geometry));
+	const std::vector<FrameGraph::Handle> expectedOrder = { geometry, light, tonemap, present };
+	CHECK(graph.GetOrder() == expectedOrder);
+
+	// gbuffer is done with before tonemapped is written, so they
+	// share; lit overlaps both. The back buffer is never aliased.
+	CHECK(graph.GetPhysicalTexture(gbuffer) == graph.GetPhysicalTexture(tonemapped));
+	CHECK(graph.GetPhysicalTexture(gbuffer) != graph.GetPhysicalTexture(lit));
+	CHECK(graph.GetPhysicalTexture(backBuffer) == FrameGraph::INVALID_HANDLE);
+	CHECK(graph.GetPhysicalTexture(debugOutput) == FrameGraph::INVALID_HANDLE);
+	unsigned int first = 0, last = 0;
+	CHECK(graph.GetLifetime(lit, &first, &last) && first == 1 && last == 2);
+	CHECK(!graph.GetLifetime(debugOutput, &first, &last));
+
+	const FrameGraph::Statistics& stats = graph.GetStatistics();
+	CHECK(stats.passes == 5 && stats.culledPasses == 1);
+	CHECK(stats.transientTextures == 3 && stats.physicalTextures == 2);
+	CHECK(stats.requestedBytes == 3 * FrameGraph::GetTextureBytes(hdr));
+	CHECK(stats.allocatedBytes == 2 * FrameGraph::GetTextureBytes(hdr));
+
+	graph.Execute();
+	const std::vector<std::string> expectedRuns = { "geometry", "light", "tonemap", "present" };
+	CHECK(executed == expectedRuns);
+
+	// Textures of another format don't share.
+	graph.Clear();
+	backBuffer = graph.ImportTexture("back buffer", ldr);
+	FrameGraph::Handle a = graph.CreateTexture("a", hdr);
+	FrameGraph::Handle b = graph.CreateTexture("b", hdr);
+	FrameGraph::Handle c = graph.CreateTexture("c", ldr);
+	FrameGraph::Handle passes[4];
+	for (FrameGraph::Handle& pass : passes)
+		pass = graph.AddPass("pass");
+	graph.Write(passes[0], a);
+	graph.Read(passes[1], a);
+	graph.Write(passes[1], b);
+	graph.Read(passes[2], b);
+	graph.Write(passes[2], c);
+	graph.Read(passes[3], c);
+	graph.Write(passes[3], backBuffer);
+	CHECK(graph.Compile());
+	CHECK(graph.GetPhysicalTexture(a) != graph.GetPhysicalTexture(c));
+	CHECK(graph.GetStatistics().physicalTextures == 3);
+
+	// A cycle.
+	graph.Clear();
+	backBuffer = graph.ImportTexture("back buffer", ldr);
+	FrameGraph::Handle x = graph.CreateTexture("x", hdr);
+	FrameGraph::Handle y = graph.CreateTexture("y", hdr);
+	FrameGraph::Handle one = graph.AddPass("one");
+	FrameGraph::Handle two = graph.AddPass("two");
+	graph.Read(one, x);
+	graph.Write(one, y);
+	graph.Read(two, y);
+	graph.Write(two, x);
+	graph.Write(two, backBuffer);
+	error.clear();
+	CHECK(!graph.Compile(&error));
+	CHECK(!error.empty());
+	CHECK(!graph.IsCompiled());
+
+	// A handle that doesn't exist.
+	graph.Clear();
+	one = graph.AddPass("one");
+	graph.Read(one, 42);
+	error.clear();
+	CHECK(!graph.Compile(&error));
+	CHECK(!error.empty());
+	return passed;
+}
+
+/// <summary>
+/// Bind actions as Game binds its camera - a key alone,
+/// a chord, one action on either of two keys - and step
+/// through key events frame by frame.
+/// </summary>
+bool UnitTests::InputMapActions()
+{
+	bool passed = true;
+	const InputMap::KeyCode space = 0x20;	// VK_SPACE
+
+	enum { JUMP, FORWARD, PITCH_UP, FIRE, RECORDED };
+	InputMap input;
+	input.Bind(JUMP, { space });
+	input.Bind(FORWARD, "W");
+	input.Bind(PITCH_UP, "RW");
+	input.Bind(FIRE, "F");
+	input.Bind(FIRE, "G");
+	input.Update();
+	CHECK(!input.AnyDown());
+
+	// A tap inside one frame is down for that frame only.
+	input.OnKeyDown(space);
+	input.OnKeyUp(space);
+	input.Update();
+	CHECK(input.IsDown(JUMP) && input.WasPressed(JUMP) && !input.WasReleased(JUMP));
+	input.Update();
+	CHECK(!input.IsDown(JUMP) && input.WasReleased(JUMP) && !input.WasPressed(JUMP));
+	input.Update();
+	CHECK(!input.IsDown(JUMP) && !input.WasReleased(JUMP));
+
+	// A chord is down only while all its keys are, and holding
+	// it holds its own keys' actions too.
+	input.OnKeyDown('W');
+	input.Update();
+	CHECK(input.IsDown(FORWARD) && !input.IsDown(PITCH_UP));
+	input.OnKeyDown('R');
+	input.Update();
+	CHECK(input.IsDown(PITCH_UP) && input.WasPressed(PITCH_UP));
+	CHECK(input.IsDown(FORWARD) && !input.WasPressed(FORWARD));
+	input.Update();
+	CHECK(input.IsDown(PITCH_UP) && !input.WasPressed(PITCH_UP));
+	input.OnKeyUp('W');
+	input.Update();
+	CHECK(!input.IsDown(PITCH_UP) && input.WasReleased(PITCH_UP) && input.WasReleased(FORWARD));
+	input.OnKeyUp('R');
+	input.Update();
+	CHECK(!input.AnyDown());
+
+	// Moving from one binding to another keeps the action down.
+	input.OnKeyDown('F');
+	input.Update();
+	CHECK(input.IsDown(FIRE) && input.WasPressed(FIRE));
+	input.OnKeyDown('G');
+	input.OnKeyUp('F');
+	input.Update();
+	CHECK(input.IsDown(FIRE) && !input.WasPressed(FIRE) && !input.WasReleased(FIRE));
+
+	// Losing focus lifts everything, including a key pressed
+	// this frame, since its key up will never arrive.
+	input.OnKeyDown('R');
+	input.OnKeyDown('W');
+	input.Update();
+	input.OnKeyDown(space);
+	input.ReleaseAll();
+	input.Update();
+	CHECK(!input.AnyDown() && !input.IsKeyDown('G'));
+	CHECK(input.WasReleased(FIRE) && input.WasReleased(PITCH_UP) && !input.WasPressed(JUMP));
+	input.Update();
+	CHECK(!input.WasReleased(FIRE));
+
+	// With no key events Update() keeps the last states rather
+	// than resolving them again, so even a played back state
+	// no binding would give survives until a key changes.
+	InputMap::ActionSet recorded;
+	recorded.set(RECORDED);
+	input.Apply(recorded);
+	input.Update();
+	CHECK(input.IsDown(RECORDED) && !input.WasPressed(RECORDED));
+	input.Update();
+	CHECK(input.IsDown(RECORDED));
+	input.OnKeyDown(space);
+	input.Update();
+	CHECK(!input.IsDown(RECORDED) && input.WasReleased(RECORDED) && input.IsDown(JUMP));
+	return passed;
+}
+
+/// <summary>
+/// Serialize made up reflections as SimpleShader does for
+/// its sidecar files and read them back, then check that a
+/// wrong shader hash, every truncation of a sidecar (which
+/// must leave nothing behind), and buffer sizes or inputs
+/// Direct3D couldn't have given are all rejected. Also
+/// checks the slots and formats input layouts are built
+/// with.
+/// </summary>
+bool UnitTests::ReflectionRoundTrip()
+{
+	typedef ShaderReflectionCache Cache;
+	bool passed = true;
+
+	std::mt19937 random(12345);
+	std::uniform_int_distribution<unsigned int> counts(1, 4);
+
+	std::vector<Cache::Reflection> library(50);
+	for (unsigned int s = 0; s < library.size(); s++)
+	{
+		Cache::Reflection& reflection = library[s];
+		for (unsigned int r = 0; r < 5; r++)
+		{
+			Cache::Resource resource;
+			resource.name = (r < 3 ? "texture" : "sampler") + std::to_string(r);
+			resource.kind = (r < 3) ? Cache::RK_TEXTURE : Cache::RK_SAMPLER;
+			resource.bindIndex = (r < 3) ? r : r - 3;
+			reflection.resources.push_back(resource);
+		}
+		for (unsigned int b = 0; b < 4; b++)
+		{
+			Cache::Buffer buffer;
+			buffer.name = "buffer" + std::to_string(b);
+			buffer.type = b % 2;
+			buffer.bindIndex = b;
+			buffer.size = 0;
+			for (unsigned int v = 0; v < 12; v++)
+			{
+				// Whole 16 byte constants, as HLSL packs a float4.
+				Cache::Variable variable;
+				variable.name = "shader" + std::to_string(s) + "_variable" + std::to_string(v);
+				variable.offset = buffer.size;
+				variable.size = 16 * counts(random);
+				buffer.size += variable.size;
+				buffer.variables.push_back(variable);
+			}
+			reflection.buffers.push_back(buffer);
+		}
+
+		// A vertex with a position, normal and UV, then a
+		// per instance matrix and index.
+		const char* semantics[] = { "POSITION", "NORMAL", "TEXCOORD", "WORLD_PER_INSTANCE", "INDEX_PER_INSTANCE" };
+		const unsigned int masks[] = { 7, 7, 3, 15, 1 };
+		for (unsigned int i = 0; i < 5; i++)
+		{
+			for (unsigned int row = 0; row < (i == 3 ? 4u : 1u); row++)
+			{
+				Cache::Input input;
+				input.semanticName = semantics[i];
+				input.semanticIndex = row;
+				input.componentType = (i == 4) ? 1 : 3;	// UINT32, else FLOAT32.
+				input.mask = masks[i];
+				input.inputSlot = Cache::GetInputSlot(input.semanticName);
+				reflection.inputs.push_back(input);
+			}
+		}
+	}
+
+	// Every field reads back.
+	std::vector<unsigned char> sidecar;
+	bool match = true;
+	for (unsigned int s = 0; s < library.size() && match; s++)
+	{
+		Cache::Serialize(library[s], Cache::Hash(&s, sizeof(s)), &sidecar);
+		Cache::Reflection b;
+		match = Cache::Deserialize(sidecar.data(), sidecar.size(), Cache::Hash(&s, sizeof(s)), &b);
+
+		const Cache::Reflection& a = library[s];
+		match = match && a.resources.size() == b.resources.size() && a.buffers.size() == b.buffers.size()
+			&& a.inputs.size() == b.inputs.size();
+		for (size_t r = 0; r < a.resources.size() && match; r++)
+		{
+			match = a.resources[r].name == b.resources[r].name && a.resources[r].kind == b.resources[r].kind
+				&& a.resources[r].bindIndex == b.resources[r].bindIndex;
+		}
+		for (size_t c = 0; c < a.buffers.size() && match; c++)
+		{
+			const Cache::Buffer& x = a.buffers[c];
+			const Cache::Buffer& y = b.buffers[c];
+			match = x.name == y.name && x.type == y.type && x.size == y.size && x.bindIndex == y.bindIndex
+				&& x.variables.size() == y.variables.size();
+			for (size_t v = 0; v < x.variables.size() && match; v++)
+			{
+				match = x.variables[v].name == y.variables[v].name && x.variables[v].offset == y.variables[v].offset
+					&& x.variables[v].size == y.variables[v].size;
+			}
+		}
+		for (size_t i = 0; i < a.inputs.size() && match; i++)
+		{
+			const Cache::Input& x = a.inputs[i];
+			const Cache::Input& y = b.inputs[i];
+			match = x.semanticName == y.semanticName && x.semanticIndex == y.semanticIndex
+				&& x.componentType == y.componentType && x.mask == y.mask && x.inputSlot == y.inputSlot;
+		}
+	}
+	CHECK(match);
+
+	// Only "..._PER_INSTANCE" semantics read from the instance slot.
+	CHECK(Cache::GetInputSlot("WORLD_PER_INSTANCE") == Cache::INSTANCE_SLOT);
+	CHECK(Cache::GetInputSlot("_PER_INSTANCE") == Cache::INSTANCE_SLOT);
+	CHECK(Cache::GetInputSlot("POSITION") == 0);
+	CHECK(Cache::GetInputSlot("PER_INSTANCE") == 0);
+	CHECK(Cache::GetInputSlot("WORLD_PER_INSTANCE1") == 0);
+	CHECK(Cache::GetInputSlot("") == 0);
+
+	// Formats follow the highest component used (DXGI_FORMAT values).
+	CHECK(Cache::GetInputFormat(3, 1) == 41);	// R32_FLOAT
+	CHECK(Cache::GetInputFormat(1, 1) == 42);	// R32_UINT
+	CHECK(Cache::GetInputFormat(2, 2) == 18);	// R32G32_SINT
+	CHECK(Cache::GetInputFormat(3, 3) == 16);	// R32G32_FLOAT
+	CHECK(Cache::GetInputFormat(3, 7) == 6);	// R32G32B32_FLOAT
+	CHECK(Cache::GetInputFormat(1, 4) == 7);	// R32G32B32_UINT
+	CHECK(Cache::GetInputFormat(3, 15) == 2);	// R32G32B32A32_FLOAT
+	CHECK(Cache::GetInputFormat(2, 8) == 4);	// R32G32B32A32_SINT
+	CHECK(Cache::GetInputFormat(0, 15) == 0);	// Unknown type.
+	CHECK(Cache::GetInputFormat(3, 0) == 0);	// No components.
+
+	// A recompiled shader (new hash) or a cut off file must be
+	// reflected again, not trusted.
+	const unsigned long long hash = Cache::Hash("shader", 6);
+	Cache::Serialize(library[0], hash, &sidecar);
+	Cache::Reflection rejected;
+	CHECK(!Cache::Deserialize(sidecar.data(), sidecar.size(), hash + 1, &rejected));
+	bool truncated = true;
+	for (size_t size = 0; size < sidecar.size() && truncated; size++)
+	{
+		truncated = !Cache::Deserialize(sidecar.data(), size, hash, &rejected)
+			&& rejected.resources.empty() && rejected.buffers.empty() && rejected.inputs.empty();
+	}
+	CHECK(truncated);
+
+	// Nor one whose buffer sizes Direct3D couldn't have given
+	// (past 4096 constants, or not whole constants).
+	const unsigned int badSizes[] = { 4096 * 16 + 16, 0xFFFFFFF0u, 20 };
+	for (unsigned int badSize : badSizes)
+	{
+		Cache::Reflection damaged = library[0];
+		damaged.buffers[0].size = badSize;
+		damaged.buffers[0].variables.clear();
+		std::vector<unsigned char> bytes;
+		Cache::Serialize(damaged, hash, &bytes);
+		CHECK(!Cache::Deserialize(bytes.data(), bytes.size(), hash, &rejected));
+	}
+
+	// Nor inputs with a component type or mask reflection
+	// couldn't have given, or a slot their semantic doesn't.
+	for (unsigned int damage = 0; damage < 3; damage++)
+	{
+		Cache::Reflection damaged = library[0];
+		Cache::Input& input = damaged.inputs[0];
+		if (damage == 0)
+			input.componentType = 4;
+		else if (damage == 1)
+			input.mask = 16;
+		else
+			input.inputSlot = Cache::INSTANCE_SLOT;
+		std::vector<unsigned char> bytes;
+		Cache::Serialize(damaged, hash, &bytes);
+		CHECK(!Cache::Deserialize(bytes.data(), bytes.size(), hash, &rejected));
+	}
+	return passed;
+}
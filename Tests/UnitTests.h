@@ -0,0 +1,60 @@
+#pragma once
+
+// -----------------------------------------------
+// Include statements.
+// -----------------------------------------------
+#include <string>
+
+// -----------------------------------------------
+// UnitTests.h
+// ---
+// Checks for the engine systems that don't need
+// Direct3D or a window, run with "UnitTests NAME"
+// (or "all", the default). Every failed check is
+// printed with its file and line, and any failure
+// makes the process exit with an error, so the
+// tests can run from ctest on any platform.
+// -----------------------------------------------
+
+class UnitTests
+{
+public:
+	// -----------------------------------------------
+	// Static methods.
+	// -----------------------------------------------
+
+	static bool Run(const std::string& name);	// Prints each failure, then a summary. False if anything failed or nothing matched.
+	static void List();
+
+private:
+
+	// -----------------------------------------------
+	// Internal structs.
+	// -----------------------------------------------
+
+	/// <summary>
+	/// A named test.
+	/// </summary>
+	struct Entry
+	{
+		const char* name;
+		const char* description;
+		bool (*function)();
+	};
+
+	static const Entry entries[];
+
+	// -----------------------------------------------
+	// Tests.
+	// -----------------------------------------------
+
+	static bool RenderQueueOrder();
+	static bool StateTrackerFilter();
+	static bool RingAllocatorFences();
+	static bool WorkerPoolTasks();
+	static bool RenderCounterTotals();
+	static bool LoggerOutput();
+	static bool FrameGraphCompile();
+	static bool InputMapActions();
+	static bool ReflectionRoundTrip();
+};
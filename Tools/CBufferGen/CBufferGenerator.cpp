@@ -0,0 +1,293 @@
+// -----------------------------------------------
+// Include statements.
+// -----------------------------------------------
+#include "CBufferGenerator.h"
+
+// -----------------------------------------------
+// Constants.
+// -----------------------------------------------
+
+// Round up to a whole number of registers.
+static unsigned int RoundUp(unsigned int bytes)
+{
+	return (bytes + HlslLayout::REGISTER_SIZE - 1) / HlslLayout::REGISTER_SIZE * HlslLayout::REGISTER_SIZE;
+}
+
+// C++ type of a scalar or vector with the given components.
+static std::string GetVectorType(HlslLayout::BaseType base, unsigned int components)
+{
+	static const char* const scalars[] = { "float", "int", "unsigned int", "int" };	// HLSL bool is 32 bits.
+	static const char* const vectors[] = { "DirectX::XMFLOAT", "DirectX::XMINT", "DirectX::XMUINT", "DirectX::XMINT" };
+	if (components == 1)
+		return scalars[base];
+	return vectors[base] + std::to_string(components);
+}
+
+// -----------------------------------------------
+// Constructors.
+// -----------------------------------------------
+
+/// <summary>
+/// Start with an empty header.
+/// </summary>
+CBufferGenerator::CBufferGenerator()
+	: usesArrayElement{ false }
+{}
+
+// -----------------------------------------------
+// Accessors.
+// -----------------------------------------------
+
+/// <summary>
+/// The header for every shader added so far.
+/// </summary>
+std::string CBufferGenerator::GetHeader() const
+{
+	std::string header =
+		"#pragma once\n"
+		"\n"
+		"// -----------------------------------------------\n"
+		"// ShaderConstants.h\n"
+		"// ---\n"
+		"// Generated by CBufferGen from:\n";
+	for (const std::string& source : sources)
+		header += "//  - " + source + "\n";
+	header +=
+		"// Edit the shaders and rebuild rather than\n"
+		"// editing this file.\n"
+		"//\n"
+		"// One struct per cbuffer, with every member\n"
+		"// where HLSL packs it (checked below), so a\n"
+		"// whole buffer can be filled and handed to\n"
+		"// ISimpleShader::SetBufferData() at once.\n"
+		"// Padding is spelled out as members: create the\n"
+		"// structs with \"= {}\" so it's zero, and an\n"
+		"// unchanged buffer compares equal.\n"
+		"// -----------------------------------------------\n"
+		"#include <DirectXMath.h>\n"
+		"#include <cstddef>\n"
+		"\n"
+		"namespace ShaderConstants\n"
+		"{\n";
+
+	if (usesArrayElement)
+	{
+		header +=
+			"\t// An array element padded to a whole register,\n"
+			"\t// as HLSL lays out arrays of smaller types.\n"
+			"\ttemplate <typename T, unsigned int Stride>\n"
+			"\tstruct ArrayElement\n"
+			"\t{\n"
+			"\t\tT value;\n"
+			"\t\tunsigned char padding[Stride - sizeof(T)];\n"
+			"\t};\n"
+			"\n";
+	}
+
+	header += body;
+	if (!header.empty() && header.compare(header.size() - 2, 2, "\n\n") == 0)
+		header.pop_back();
+	header += "}\n";
+	return header;
+}
+
+/// <summary>
+/// Why the last AddShader() failed, as "file(line): error: message".
+/// </summary>
+const std::string& CBufferGenerator::GetError() const
+{
+	return error;
+}
+
+// -----------------------------------------------
+// Service methods.
+// -----------------------------------------------
+
+/// <summary>
+/// Add the cbuffers of one shader, and the structs they use.
+/// </summary>
+/// <param name="name">Namespace for the shader's structs (e.g. "PixelShader").</param>
+/// <param name="fileName">The shader's path, for errors (the header comment only names the file).</param>
+/// <param name="layout">The shader, parsed.</param>
+/// <returns>Returns false (see GetError()) if a layout can't be written as a C++ struct.</returns>
+bool CBufferGenerator::AddShader(const std::string& name, const std::string& fileName, const HlslLayout& layout)
+{
+	this->fileName = fileName;
+	const std::vector<HlslLayout::Block>& structs = layout.GetStructs();
+	const std::vector<HlslLayout::Block>& buffers = layout.GetBuffers();
+	sources.push_back(fileName.substr(fileName.find_last_of("/\\") + 1));
+	if (buffers.empty())
+		return true;
+
+	// Only the structs a cbuffer uses, directly or not. A struct
+	// can only use ones declared before it, so one pass from the
+	// back finds them all.
+	std::vector<bool> used(structs.size(), false);
+	for (const HlslLayout::Block& buffer : buffers)
+	{
+		for (const HlslLayout::Member& member : buffer.members)
+		{
+			if (member.type.base == HlslLayout::BT_STRUCT)
+				used[member.type.structIndex] = true;
+		}
+	}
+	for (size_t s = structs.size(); s-- > 0;)
+	{
+		for (const HlslLayout::Member& member : structs[s].members)
+		{
+			if (used[s] && member.type.base == HlslLayout::BT_STRUCT)
+				used[member.type.structIndex] = true;
+		}
+	}
+
+	std::string text = "\tnamespace " + name + "\n\t{\n";
+	std::vector<unsigned int> structSizes(structs.size(), 0);
+	for (size_t s = 0; s < structs.size(); s++)
+	{
+		if (used[s] && !WriteBlock(layout, structs[s], false, structSizes, &text, &structSizes[s]))
+			return false;
+	}
+	for (const HlslLayout::Block& buffer : buffers)
+	{
+		unsigned int size = 0;
+		if (!WriteBlock(layout, buffer, true, structSizes, &text, &size))
+			return false;
+	}
+	text.pop_back();	// The blank line after the last struct.
+	text += "\t}\n\n";
+
+	body += text;
+	return true;
+}
+
+// -----------------------------------------------
+// Helper methods.
+// -----------------------------------------------
+
+/// <summary>
+/// Write one struct (or cbuffer) and its static_asserts.
+/// </summary>
+/// <param name="structSizes">C++ size of each struct written so far.</param>
+/// <param name="out">Appended to.</param>
+/// <param name="size">Receives the C++ size of the struct.</param>
+bool CBufferGenerator::WriteBlock(const HlslLayout& layout, const HlslLayout::Block& block, bool cbuffer,
+	const std::vector<unsigned int>& structSizes, std::string* out, unsigned int* size)
+{
+	std::string text;
+	std::string asserts;
+	if (cbuffer)
+	{
+		// alignas(16) so a whole buffer can be copied with
+		// aligned loads and stores.
+		text += "\t\tstruct alignas(16) " + block.name + "\n\t\t{\n";
+		text += "\t\t\tstatic const char* Name() { return \"" + block.name + "\"; }\n";
+		text += "\t\t\tstatic const int Register = " + std::to_string(block.bindRegister) + ";\n\n";
+	}
+	else
+		text += "\t\tstruct " + block.name + "\n\t\t{\n";
+
+	unsigned int cursor = 0;
+	unsigned int paddingCount = 0;
+	const HlslLayout::Member* previous = nullptr;
+	for (const HlslLayout::Member& member : block.members)
+	{
+		if (member.offset < cursor)
+		{
+			return Fail(member.line, "'" + member.name + "' is packed into the padding of '" + previous->name +
+				"', which C++ can't express; move it, or make the array's elements whole registers");
+		}
+		if (member.offset > cursor)
+			text += "\t\t\tunsigned int padding" + std::to_string(paddingCount++) + "[" + std::to_string((member.offset - cursor) / 4) + "];\n";
+
+		std::string type, suffix;
+		unsigned int footprint = 0;
+		if (!GetMemberType(layout, member, structSizes, &type, &suffix, &footprint))
+			return false;
+		text += "\t\t\t" + type + " " + member.name + suffix + ";\n";
+		asserts += "\t\tstatic_assert(offsetof(" + block.name + ", " + member.name + ") == " + std::to_string(member.offset) +
+			", \"" + block.name + "." + member.name + " isn't where HLSL packs it\");\n";
+
+		cursor = member.offset + footprint;
+		previous = &member;
+	}
+
+	// Cbuffers are padded out to their (register rounded) size.
+	if (cbuffer && cursor < block.size)
+	{
+		text += "\t\t\tunsigned int padding" + std::to_string(paddingCount++) + "[" + std::to_string((block.size - cursor) / 4) + "];\n";
+		cursor = block.size;
+	}
+	text += "\t\t};\n";
+	asserts += "\t\tstatic_assert(sizeof(" + block.name + ") == " + std::to_string(cursor) +
+		", \"" + block.name + (cbuffer ? " isn't the size of the HLSL cbuffer\");\n" : " isn't the size HLSL gives it\");\n");
+
+	*out += text + asserts + "\n";
+	*size = cursor;
+	return true;
+}
+
+/// <summary>
+/// The C++ type of a variable.
+/// </summary>
+/// <param name="structSizes">C++ size of each struct written so far.</param>
+/// <param name="type">Receives the type, e.g. "DirectX::XMFLOAT3".</param>
+/// <param name="suffix">Receives the array size, e.g. "[4]", if any.</param>
+/// <param name="size">Receives the bytes the C++ member takes.</param>
+bool CBufferGenerator::GetMemberType(const HlslLayout& layout, const HlslLayout::Member& member,
+	const std::vector<unsigned int>& structSizes, std::string* type, std::string* suffix, unsigned int* size)
+{
+	const HlslLayout::Type& hlsl = member.type;
+	unsigned int count = member.arrayCount;
+	unsigned int elementSize = member.elementSize;	// HLSL.
+	unsigned int cppSize = elementSize;
+
+	if (hlsl.base == HlslLayout::BT_STRUCT)
+	{
+		*type = layout.GetStructs()[hlsl.structIndex].name;
+		cppSize = structSizes[hlsl.structIndex];
+	}
+	else if (hlsl.matrix)
+	{
+		unsigned int registers = hlsl.rowMajor ? hlsl.rows : hlsl.columns;
+		unsigned int components = hlsl.rowMajor ? hlsl.columns : hlsl.rows;
+		if (hlsl.base == HlslLayout::BT_FLOAT && registers == 4 && components == 4)
+			*type = "DirectX::XMFLOAT4X4";
+		else if (count > 0)
+			return Fail(member.line, "arrays of '" + member.typeName + "' aren't supported; use float4x4 or float4 arrays");
+		else
+		{
+			// An array of its columns (or rows).
+			*type = GetVectorType(hlsl.base, components);
+			count = registers;
+			elementSize = components * 4;
+			cppSize = elementSize;
+		}
+	}
+	else
+		*type = GetVectorType(hlsl.base, hlsl.columns);
+
+	suffix->clear();
+	*size = cppSize;
+	if (count > 0)
+	{
+		unsigned int stride = RoundUp(elementSize);
+		if (cppSize != stride)
+		{
+			*type = "ArrayElement<" + *type + ", " + std::to_string(stride) + ">";
+			usesArrayElement = true;
+		}
+		*suffix = "[" + std::to_string(count) + "]";
+		*size = count * stride;
+	}
+	return true;
+}
+
+/// <summary>
+/// Record an error at a line of the shader being added.
+/// </summary>
+/// <returns>Returns false, to be returned in turn.</returns>
+bool CBufferGenerator::Fail(unsigned int line, const std::string& message)
+{
+	error = fileName + "(" + std::to_string(line) + "): error: " + message;
+	return false;
+}
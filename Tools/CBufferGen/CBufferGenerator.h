@@ -0,0 +1,74 @@
+#pragma once
+
+// -----------------------------------------------
+// Include statements.
+// -----------------------------------------------
+#include "HlslLayout.h"
+#include <string>
+#include <vector>
+
+// -----------------------------------------------
+// CBufferGenerator.h
+// ---
+// Writes a C++ header with a struct for every
+// cbuffer HlslLayout found (and the HLSL structs
+// they use), one namespace per shader. Each
+// struct has its members exactly where HLSL puts
+// them, with the gaps between them spelled out as
+// padding members, and static_asserts on every
+// offset and size so a change to a shader that
+// isn't regenerated fails to compile.
+//
+// HLSL array elements take a whole register; ones
+// smaller than that are wrapped in ArrayElement<>
+// so the C++ array has the same stride. A variable
+// HLSL packs into the end of an array's last
+// element can't be written as a C++ member, so
+// that's reported as an error rather than
+// generating something wrong.
+// -----------------------------------------------
+
+class CBufferGenerator
+{
+public:
+	// -----------------------------------------------
+	// Constructors.
+	// -----------------------------------------------
+
+	CBufferGenerator();
+
+	// -----------------------------------------------
+	// Accessors.
+	// -----------------------------------------------
+
+	std::string GetHeader() const;		// Everything added so far.
+	const std::string& GetError() const;	// "file(line): error: message", from the last failed AddShader().
+
+	// -----------------------------------------------
+	// Service methods.
+	// -----------------------------------------------
+
+	bool AddShader(const std::string& name, const std::string& fileName, const HlslLayout& layout);	// name becomes the namespace.
+
+private:
+
+	// -----------------------------------------------
+	// Data members.
+	// -----------------------------------------------
+
+	std::vector<std::string> sources;	// File names, for the header comment.
+	std::string body;
+	bool usesArrayElement;
+	std::string error;
+	std::string fileName;	// Being added, for errors.
+
+	// -----------------------------------------------
+	// Helper methods.
+	// -----------------------------------------------
+
+	bool WriteBlock(const HlslLayout& layout, const HlslLayout::Block& block, bool cbuffer,
+		const std::vector<unsigned int>& structSizes, std::string* out, unsigned int* size);
+	bool GetMemberType(const HlslLayout& layout, const HlslLayout::Member& member,
+		const std::vector<unsigned int>& structSizes, std::string* type, std::string* suffix, unsigned int* size);
+	bool Fail(unsigned int line, const std::string& message);
+};
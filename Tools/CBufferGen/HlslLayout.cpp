@@ -0,0 +1,523 @@
+// -----------------------------------------------
+// Include statements.
+// -----------------------------------------------
+#include "HlslLayout.h"
+#include <cctype>
+#include <cstring>
+
+// -----------------------------------------------
+// Constants.
+// -----------------------------------------------
+
+// Returned by Peek() past the last token.
+static const char* const END_OF_FILE = "";
+
+// Words that can come before a variable's type and don't
+// change its layout.
+static const char* const MODIFIERS[] = {
+	"precise", "uniform", "const", "nointerpolation", "linear",
+	"centroid", "noperspective", "sample", "snorm", "unorm" };
+
+// Round up to a whole number of registers.
+static unsigned int RoundUp(unsigned int bytes)
+{
+	return (bytes + HlslLayout::REGISTER_SIZE - 1) / HlslLayout::REGISTER_SIZE * HlslLayout::REGISTER_SIZE;
+}
+
+// Can the text be a name?
+static bool IsIdentifier(const std::string& text)
+{
+	return !text.empty() && (isalpha((unsigned char)text[0]) || text[0] == '_');
+}
+
+// -----------------------------------------------
+// Constructors.
+// -----------------------------------------------
+
+/// <summary>
+/// Start with nothing parsed.
+/// </summary>
+HlslLayout::HlslLayout()
+	: position{ 0 }
+{}
+
+// -----------------------------------------------
+// Accessors.
+// -----------------------------------------------
+
+/// <summary>
+/// Structs the last Parse() found, laid out as they would be
+/// inside a cbuffer.
+/// </summary>
+const std::vector<HlslLayout::Block>& HlslLayout::GetStructs() const
+{
+	return structs;
+}
+
+/// <summary>
+/// Cbuffers the last Parse() found.
+/// </summary>
+const std::vector<HlslLayout::Block>& HlslLayout::GetBuffers() const
+{
+	return buffers;
+}
+
+/// <summary>
+/// Why the last Parse() failed, as "file(line): error: message".
+/// </summary>
+const std::string& HlslLayout::GetError() const
+{
+	return error;
+}
+
+// -----------------------------------------------
+// Service methods.
+// -----------------------------------------------
+
+/// <summary>
+/// Find and lay out every struct and cbuffer in an HLSL file.
+/// </summary>
+/// <param name="source">The file's contents.</param>
+/// <param name="fileName">Used in error messages.</param>
+/// <returns>Returns false (see GetError()) on the first thing it can't handle.</returns>
+bool HlslLayout::Parse(const std::string& source, const std::string& fileName)
+{
+	structs.clear();
+	buffers.clear();
+	error.clear();
+	this->fileName = fileName;
+	Tokenize(source);
+	position = 0;
+
+	bool ok = true;
+	while (ok && Peek().text != END_OF_FILE)
+	{
+		// "struct Name {" declares a type; "struct Name;" and
+		// "struct Name name" don't.
+		if (Peek().text == "struct" && Peek(2).text == "{")
+		{
+			position++;
+			ok = ParseBlock(false);
+		}
+		else if (Peek().text == "cbuffer")
+		{
+			position++;
+			ok = ParseBlock(true);
+		}
+		else if (Peek().text == "{")
+			SkipBraces();	// Function bodies.
+		else
+			position++;
+	}
+
+	tokens.clear();
+	return ok;
+}
+
+// -----------------------------------------------
+// Helper methods.
+// -----------------------------------------------
+
+/// <summary>
+/// Split the source into tokens, dropping comments, strings
+/// and preprocessor lines.
+/// </summary>
+void HlslLayout::Tokenize(const std::string& source)
+{
+	tokens.clear();
+
+	unsigned int line = 1;
+	bool lineStart = true;
+	size_t i = 0;
+	size_t length = source.size();
+	while (i < length)
+	{
+		char c = source[i];
+		if (c == '\n')
+		{
+			line++;
+			lineStart = true;
+			i++;
+		}
+		else if (isspace((unsigned char)c))
+			i++;
+		else if (c == '/' && i + 1 < length && source[i + 1] == '/')
+		{
+			while (i < length && source[i] != '\n')
+				i++;
+		}
+		else if (c == '/' && i + 1 < length && source[i + 1] == '*')
+		{
+			i += 2;
+			while (i < length && !(source[i] == '*' && i + 1 < length && source[i + 1] == '/'))
+			{
+				if (source[i] == '\n')
+					line++;
+				i++;
+			}
+			i += 2;
+		}
+		else if (c == '#' && lineStart)
+		{
+			// Up to the end of the line, and any continued lines.
+			while (i < length && source[i] != '\n')
+			{
+				if (source[i] == '\\' && i + 1 < length && source[i + 1] == '\n')
+				{
+					line++;
+					i++;
+				}
+				i++;
+			}
+		}
+		else if (c == '"')
+		{
+			i++;
+			while (i < length && source[i] != '"' && source[i] != '\n')
+				i++;
+			i++;
+		}
+		else if (isalnum((unsigned char)c) || c == '_')
+		{
+			// Words, and numbers with their suffixes ("1.0f").
+			size_t start = i;
+			while (i < length && (isalnum((unsigned char)source[i]) || source[i] == '_' || source[i] == '.'))
+				i++;
+			tokens.push_back({ source.substr(start, i - start), line });
+			lineStart = false;
+		}
+		else
+		{
+			tokens.push_back({ std::string(1, c), line });
+			lineStart = false;
+			i++;
+		}
+	}
+}
+
+/// <summary>
+/// A token ahead of the current one, or END_OF_FILE.
+/// </summary>
+const HlslLayout::Token& HlslLayout::Peek(size_t ahead) const
+{
+	static const Token end = { END_OF_FILE, 0 };
+	return (position + ahead < tokens.size()) ? tokens[position + ahead] : end;
+}
+
+/// <summary>
+/// Move past the current token if it's the given text.
+/// </summary>
+bool HlslLayout::Accept(const char* text)
+{
+	if (Peek().text != text)
+		return false;
+	position++;
+	return true;
+}
+
+/// <summary>
+/// Move past the current token, which must be the given text.
+/// </summary>
+bool HlslLayout::Expect(const char* text)
+{
+	if (Accept(text))
+		return true;
+	return Fail(std::string("expected '") + text + "'" +
+		(Peek().text == END_OF_FILE ? " before the end of the file" : ", found '" + Peek().text + "'"));
+}
+
+/// <summary>
+/// Record an error at the current token.
+/// </summary>
+/// <returns>Returns false, to be returned in turn.</returns>
+bool HlslLayout::Fail(const std::string& message)
+{
+	unsigned int line = Peek().line;
+	if (line == 0 && !tokens.empty())
+		line = tokens.back().line;
+	return Fail(message, line);
+}
+
+/// <summary>
+/// Record an error at a line.
+/// </summary>
+/// <returns>Returns false, to be returned in turn.</returns>
+bool HlslLayout::Fail(const std::string& message, unsigned int line)
+{
+	error = fileName + "(" + std::to_string(line) + "): error: " + message;
+	return false;
+}
+
+/// <summary>
+/// Parse a struct or cbuffer, from its name to its closing
+/// brace, and lay it out.
+/// </summary>
+bool HlslLayout::ParseBlock(bool cbuffer)
+{
+	Block block;
+	block.line = Peek().line;
+	block.name = Peek().text;
+	block.bindRegister = -1;
+	block.size = 0;
+	if (!IsIdentifier(block.name))
+		return Fail(cbuffer ? "expected a cbuffer name" : "expected a struct name");
+	position++;
+
+	if (cbuffer && Accept(":"))
+	{
+		if (!Expect("register") || !Expect("("))
+			return false;
+
+		// "b0", "b1", ...
+		const std::string& slot = Peek().text;
+		if (slot.size() < 2 || slot[0] != 'b' || slot.find_first_not_of("0123456789", 1) != std::string::npos)
+			return Fail("expected a b register, found '" + slot + "'");
+		block.bindRegister = std::stoi(slot.substr(1));
+		position++;
+
+		if (!Expect(")"))
+			return false;
+	}
+
+	if (!Expect("{") || !ParseMembers(&block) || !Expect("}"))
+		return false;
+	Accept(";");
+
+	if (block.members.empty())
+		return Fail((cbuffer ? "cbuffer '" : "struct '") + block.name + "' is empty", block.line);
+
+	LayOut(&block, cbuffer);
+	(cbuffer ? buffers : structs).push_back(block);
+	return true;
+}
+
+/// <summary>
+/// Parse variable declarations up to (not including) a
+/// closing brace.
+/// </summary>
+bool HlslLayout::ParseMembers(Block* block)
+{
+	while (Peek().text != "}")
+	{
+		if (Peek().text == END_OF_FILE)
+			return Fail("'" + block->name + "' isn't closed");
+
+		bool rowMajor = false;
+		for (;;)
+		{
+			const std::string& word = Peek().text;
+			bool modifier = false;
+			for (const char* known : MODIFIERS)
+				modifier = modifier || word == known;
+
+			if (word == "row_major")
+				rowMajor = true;
+			else if (word == "column_major")
+				rowMajor = false;
+			else if (word == "static" || word == "groupshared")
+				return Fail("'" + word + "' variables aren't in the constant buffer");
+			else if (!modifier)
+				break;
+			position++;
+		}
+
+		// matrix<float, 4, 4> and vector<float, 4> are spelled
+		// out as float4x4 and float4.
+		unsigned int line = Peek().line;
+		std::string typeName = Peek().text;
+		position++;
+		if ((typeName == "matrix" || typeName == "vector") && Accept("<"))
+		{
+			std::string component = Peek().text;
+			unsigned int rows = 0, columns = 0;
+			position++;
+			if (!Expect(",") || !ParseUnsigned(&rows))
+				return false;
+			if (typeName == "matrix" && (!Expect(",") || !ParseUnsigned(&columns)))
+				return false;
+			if (!Expect(">"))
+				return false;
+			typeName = component + std::to_string(rows) + (columns ? "x" + std::to_string(columns) : "");
+		}
+
+		Type type;
+		if (!ParseType(typeName, rowMajor, &type))
+			return false;
+
+		// One or more names, each possibly an array.
+		do
+		{
+			Member member = {};
+			member.name = Peek().text;
+			member.typeName = typeName;
+			member.type = type;
+			member.line = line;
+			if (!IsIdentifier(member.name))
+				return Fail("expected a variable name, found '" + member.name + "'");
+			position++;
+
+			if (Accept("["))
+			{
+				if (!ParseUnsigned(&member.arrayCount) || !Expect("]"))
+					return false;
+				if (member.arrayCount == 0)
+					return Fail("'" + member.name + "' has no elements");
+				if (Peek().text == "[")
+					return Fail("multi-dimensional arrays aren't supported");
+			}
+
+			if (Accept(":"))
+			{
+				if (Peek().text == "packoffset" || Peek().text == "register")
+					return Fail("'" + Peek().text + "' isn't supported; let the compiler pack the cbuffer");
+				position++;	// A semantic, which doesn't affect layout.
+			}
+
+			// Default values aren't used by Direct3D 11; skip them.
+			if (Accept("="))
+			{
+				int depth = 0;
+				while (Peek().text != END_OF_FILE && (depth > 0 || (Peek().text != "," && Peek().text != ";")))
+				{
+					depth += (Peek().text == "{") ? 1 : (Peek().text == "}") ? -1 : 0;
+					position++;
+				}
+			}
+
+			block->members.push_back(member);
+		} while (Accept(","));
+
+		if (!Expect(";"))
+			return false;
+	}
+	return true;
+}
+
+/// <summary>
+/// Work out a type from its name: a struct declared earlier,
+/// or a scalar, vector or matrix.
+/// </summary>
+bool HlslLayout::ParseType(const std::string& name, bool rowMajor, Type* type)
+{
+	*type = {};
+	type->rows = 1;
+	type->columns = 1;
+	type->rowMajor = rowMajor;
+
+	for (size_t s = 0; s < structs.size(); s++)
+	{
+		if (structs[s].name == name)
+		{
+			type->base = BT_STRUCT;
+			type->structIndex = s;
+			return true;
+		}
+	}
+
+	std::string spelled = (name == "matrix") ? "float4x4" : (name == "vector") ? "float4" : name;
+
+	static const struct { const char* prefix; BaseType base; } bases[] = {
+		{ "float", BT_FLOAT }, { "half", BT_FLOAT }, { "int", BT_INT },
+		{ "uint", BT_UINT }, { "dword", BT_UINT }, { "bool", BT_BOOL } };
+	for (const auto& candidate : bases)
+	{
+		size_t length = strlen(candidate.prefix);
+		if (spelled.compare(0, length, candidate.prefix) != 0)
+			continue;
+
+		// "", "N" or "NxM", each from 1 to 4.
+		std::string shape = spelled.substr(length);
+		auto dimension = [](char c) { return c >= '1' && c <= '4'; };
+		type->base = candidate.base;
+		if (shape.empty())
+			return true;
+		if (shape.size() == 1 && dimension(shape[0]))
+		{
+			type->columns = shape[0] - '0';
+			return true;
+		}
+		if (shape.size() == 3 && dimension(shape[0]) && shape[1] == 'x' && dimension(shape[2]))
+		{
+			type->matrix = true;
+			type->rows = shape[0] - '0';
+			type->columns = shape[2] - '0';
+			return true;
+		}
+	}
+
+	if (spelled.compare(0, 6, "double") == 0 || spelled.compare(0, 3, "min") == 0)
+		return Fail("'" + name + "' isn't supported in generated constant buffers");
+	return Fail("unknown type '" + name + "'");
+}
+
+/// <summary>
+/// Read a whole number, such as an array size.
+/// </summary>
+bool HlslLayout::ParseUnsigned(unsigned int* value)
+{
+	const std::string& text = Peek().text;
+	if (text.empty() || text.find_first_not_of("0123456789") != std::string::npos || text.size() > 6)
+		return Fail("expected a number, found '" + text + "'");
+	*value = (unsigned int)std::stoul(text);
+	position++;
+	return true;
+}
+
+/// <summary>
+/// Move past a brace and everything up to its matching one.
+/// </summary>
+void HlslLayout::SkipBraces()
+{
+	int depth = 0;
+	do
+	{
+		depth += (Peek().text == "{") ? 1 : (Peek().text == "}") ? -1 : 0;
+		position++;
+	} while (depth > 0 && Peek().text != END_OF_FILE);
+}
+
+/// <summary>
+/// Place each variable of a struct or cbuffer (see the
+/// packing rules in the header).
+/// </summary>
+void HlslLayout::LayOut(Block* block, bool cbuffer)
+{
+	unsigned int cursor = 0;
+	unsigned int end = 0;
+	for (Member& member : block->members)
+	{
+		member.elementSize = GetElementSize(member.type);
+		member.size = member.arrayCount
+			? (member.arrayCount - 1) * RoundUp(member.elementSize) + member.elementSize
+			: member.elementSize;
+
+		bool isStruct = member.type.base == BT_STRUCT;
+		bool wholeRegisters = member.arrayCount > 0 || isStruct || member.type.matrix;
+		unsigned int start = cursor;
+		if (wholeRegisters || start % REGISTER_SIZE + member.size > REGISTER_SIZE)
+			start = RoundUp(start);
+
+		member.offset = start;
+		end = start + member.size;
+		cursor = isStruct ? RoundUp(end) : end;
+	}
+
+	block->size = cbuffer ? RoundUp(end) : end;
+}
+
+/// <summary>
+/// Bytes one value of a type takes, up to its last component.
+/// </summary>
+unsigned int HlslLayout::GetElementSize(const Type& type) const
+{
+	if (type.base == BT_STRUCT)
+		return structs[type.structIndex].size;
+
+	if (!type.matrix)
+		return type.columns * 4;
+
+	// Each column (or row, if row_major) takes a register.
+	unsigned int registers = type.rowMajor ? type.rows : type.columns;
+	unsigned int components = type.rowMajor ? type.columns : type.rows;
+	return (registers - 1) * REGISTER_SIZE + components * 4;
+}
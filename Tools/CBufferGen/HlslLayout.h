@@ -0,0 +1,174 @@
+#pragma once
+
+// -----------------------------------------------
+// Include statements.
+// -----------------------------------------------
+#include <string>
+#include <vector>
+
+// -----------------------------------------------
+// HlslLayout.h
+// ---
+// Reads the struct and cbuffer declarations out
+// of an HLSL source file and works out where the
+// compiler puts each variable in a constant
+// buffer, following the HLSL packing rules:
+//
+//  - Variables are packed into 16 byte registers
+//    and never straddle two of them; one that
+//    would starts the next register.
+//  - Structs, arrays and matrices always start a
+//    register. Each array element (and matrix
+//    column, or row if row_major) takes a whole
+//    register, except the last, so the next
+//    variable can pack in after it.
+//  - The variable after a struct starts a new
+//    register.
+//  - A cbuffer's size is rounded up to 16 bytes.
+//
+// Everything else in the file (functions, input
+// structs' semantics, preprocessor lines) is
+// skipped. Only the types that can appear in
+// constant buffers are understood: float, half,
+// int, uint, dword and bool scalars, vectors and
+// matrices (and "matrix"/"vector"), structs and
+// arrays of them. packoffset is refused rather
+// than half supported.
+//
+// Plain C++ with no Direct3D, so it runs (and
+// can be checked) anywhere.
+// -----------------------------------------------
+
+class HlslLayout
+{
+public:
+	// -----------------------------------------------
+	// Internal enum/structs.
+	// -----------------------------------------------
+
+	/// <summary>
+	/// BASE_TYPE determines what a variable's components are.
+	/// </summary>
+	typedef enum _BASE_TYPE
+	{
+		BT_FLOAT = 0,	// float and half (32 bits in constant buffers).
+		BT_INT = 1,
+		BT_UINT = 2,	// uint and dword.
+		BT_BOOL = 3,	// 32 bits.
+		BT_STRUCT = 4
+	} BASE_TYPE;
+
+	/// <summary>
+	/// Wrapper for BASE_TYPE enum.
+	/// </summary>
+	typedef BASE_TYPE BaseType;
+
+	/// <summary>
+	/// A variable's type, without any array size.
+	/// </summary>
+	struct Type
+	{
+		BaseType base;
+		unsigned int rows;		// 1 for scalars and vectors.
+		unsigned int columns;	// Components of a scalar or vector.
+		bool matrix;			// floatRxC, even 1x1.
+		bool rowMajor;			// Matrices are column_major unless declared otherwise.
+		size_t structIndex;		// Into GetStructs(), for BT_STRUCT.
+	};
+
+	/// <summary>
+	/// A variable in a struct or cbuffer, and where it goes.
+	/// </summary>
+	struct Member
+	{
+		std::string name;
+		std::string typeName;		// As written, e.g. "float3" or "DirectionalLight".
+		Type type;
+		unsigned int arrayCount;	// 0 if not an array.
+		unsigned int offset;		// Bytes from the start of the struct or cbuffer.
+		unsigned int size;			// Bytes, up to the end of the last element.
+		unsigned int elementSize;	// One element (or the whole variable, if not an array).
+		unsigned int line;
+	};
+
+	/// <summary>
+	/// A struct or cbuffer and its variables.
+	/// </summary>
+	struct Block
+	{
+		std::string name;
+		std::vector<Member> members;
+		unsigned int size;		// Structs: end of the last variable. Cbuffers: rounded up to 16.
+		int bindRegister;		// Cbuffers: the b register, or -1 if not given.
+		unsigned int line;
+	};
+
+	// Bytes in a constant buffer register.
+	static const unsigned int REGISTER_SIZE = 16;
+
+	// -----------------------------------------------
+	// Constructors.
+	// -----------------------------------------------
+
+	HlslLayout();
+
+	// -----------------------------------------------
+	// Accessors.
+	// -----------------------------------------------
+
+	const std::vector<Block>& GetStructs() const;	// In the order they were declared.
+	const std::vector<Block>& GetBuffers() const;	// Same.
+	const std::string& GetError() const;	// "file(line): error: message", from the last failed Parse().
+
+	// -----------------------------------------------
+	// Service methods.
+	// -----------------------------------------------
+
+	bool Parse(const std::string& source, const std::string& fileName);	// Replaces everything. False on the first error.
+
+private:
+
+	// -----------------------------------------------
+	// Internal structs.
+	// -----------------------------------------------
+
+	/// <summary>
+	/// A word, number or single punctuation character.
+	/// </summary>
+	struct Token
+	{
+		std::string text;
+		unsigned int line;
+	};
+
+	// -----------------------------------------------
+	// Data members.
+	// -----------------------------------------------
+
+	std::vector<Block> structs;
+	std::vector<Block> buffers;
+	std::string error;
+
+	// Used while parsing.
+	std::vector<Token> tokens;
+	size_t position;
+	std::string fileName;
+
+	// -----------------------------------------------
+	// Helper methods.
+	// -----------------------------------------------
+
+	void Tokenize(const std::string& source);
+	const Token& Peek(size_t ahead = 0) const;
+	bool Accept(const char* text);
+	bool Expect(const char* text);
+	bool Fail(const std::string& message);
+	bool Fail(const std::string& message, unsigned int line);
+	bool ParseBlock(bool cbuffer);
+	bool ParseMembers(Block* block);
+	bool ParseType(const std::string& name, bool rowMajor, Type* type);
+	bool ParseUnsigned(unsigned int* value);
+	void SkipBraces();
+	void LayOut(Block* block, bool cbuffer);
+	unsigned int GetElementSize(const Type& type) const;
+};
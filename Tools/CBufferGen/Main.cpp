@@ -0,0 +1,116 @@
+#include "HlslLayout.h"
+#include "CBufferGenerator.h"
+#include "SelfTest.h"
+#include <cctype>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+// --------------------------------------------------------
+// Reads a whole file into a string
+//
+// Returns false if the file can't be opened
+// --------------------------------------------------------
+static bool ReadFile(const std::string& path, std::string* contents)
+{
+	std::ifstream file(path, std::ios::binary);
+	if (!file.is_open())
+		return false;
+
+	std::ostringstream stream;
+	stream << file.rdbuf();
+	*contents = stream.str();
+	return true;
+}
+
+// --------------------------------------------------------
+// The namespace for a shader: its file name without the
+// folder or extension, e.g. "PixelShader"
+// --------------------------------------------------------
+static std::string GetShaderName(const std::string& path)
+{
+	size_t slash = path.find_last_of("/\\");
+	std::string name = (slash == std::string::npos) ? path : path.substr(slash + 1);
+	size_t dot = name.find('.');
+	if (dot != std::string::npos)
+		name.erase(dot);
+
+	for (char& c : name)
+	{
+		if (!isalnum((unsigned char)c))
+			c = '_';
+	}
+	if (name.empty() || isdigit((unsigned char)name[0]))
+		name.insert(0, "_");
+	return name;
+}
+
+// --------------------------------------------------------
+// Entry point
+//
+// CBufferGen -o ShaderConstants.h VertexShader.hlsl PixelShader.hlsl ...
+// CBufferGen --self-test
+//
+// Writes the output only if it changed, so a pre-build step
+// doesn't make everything that includes it rebuild.  Errors
+// are printed as "file(line): error: ..." so Visual Studio
+// can jump to them.
+// --------------------------------------------------------
+int main(int argc, char* argv[])
+{
+	if (argc == 2 && strcmp(argv[1], "--self-test") == 0)
+		return SelfTest::Run() ? 0 : 1;
+
+	std::string output;
+	std::vector<std::string> inputs;
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "-o") == 0 && i + 1 < argc)
+			output = argv[++i];
+		else
+			inputs.push_back(argv[i]);
+	}
+
+	if (output.empty() || inputs.empty())
+	{
+		fprintf(stderr, "usage: CBufferGen -o <header.h> <shader.hlsl>...\n       CBufferGen --self-test\n");
+		return 2;
+	}
+
+	CBufferGenerator generator;
+	for (const std::string& input : inputs)
+	{
+		std::string source;
+		if (!ReadFile(input, &source))
+		{
+			fprintf(stderr, "%s: error: can't read the file\n", input.c_str());
+			return 1;
+		}
+
+		HlslLayout layout;
+		if (!layout.Parse(source, input) || !generator.AddShader(GetShaderName(input), input, layout))
+		{
+			fprintf(stderr, "%s\n", (layout.GetError().empty() ? generator.GetError() : layout.GetError()).c_str());
+			return 1;
+		}
+	}
+
+	std::string header = generator.GetHeader();
+	std::string existing;
+	if (ReadFile(output, &existing) && existing == header)
+	{
+		printf("CBufferGen: %s is up to date\n", output.c_str());
+		return 0;
+	}
+
+	std::ofstream file(output, std::ios::binary | std::ios::trunc);
+	if (!file.is_open() || !(file << header))
+	{
+		fprintf(stderr, "%s: error: can't write the file\n", output.c_str());
+		return 1;
+	}
+
+	printf("CBufferGen: wrote %s\n", output.c_str());
+	return 0;
+}
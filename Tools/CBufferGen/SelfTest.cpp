@@ -0,0 +1,314 @@
+// -----------------------------------------------
+// Include statements.
+// -----------------------------------------------
+#include "SelfTest.h"
+#include "CBufferGenerator.h"
+#include <cstdio>
+#include <sstream>
+
+// -----------------------------------------------
+// Constants.
+// -----------------------------------------------
+
+// A shader and where fxc puts everything in it. Each word of
+// the expectation is "Block.member=offset,size", "Block=size"
+// (a cbuffer's size is rounded up, a struct's isn't),
+// "Block@register", or "!Block" for one that mustn't be found.
+struct LayoutCase
+{
+	const char* name;
+	const char* source;
+	const char* expected;
+};
+
+static const LayoutCase LAYOUT_CASES[] =
+{
+	{ "scalars and vectors share registers",
+		"cbuffer Pack : register(b3) { float s1, s2; float2 v2; float3 v3; float after; };",
+		"Pack@3 Pack.s1=0,4 Pack.s2=4,4 Pack.v2=8,8 Pack.v3=16,12 Pack.after=28,4 Pack=32" },
+
+	{ "nothing straddles a register",
+		"cbuffer Straddle { float3 a; float2 b; float c; float2 d; float3 e; };",
+		"Straddle.a=0,12 Straddle.b=16,8 Straddle.c=24,4 Straddle.d=32,8 Straddle.e=48,12 Straddle=64" },
+
+	{ "bool, int, half, uint and dword are 32 bits",
+		"cbuffer Types { bool f; int i; half h; uint u; dword d; int2 i2; bool3 b3; };",
+		"Types.f=0,4 Types.i=4,4 Types.h=8,4 Types.u=12,4 Types.d=16,4 Types.i2=20,8 Types.b3=32,12 Types=48" },
+
+	{ "array elements take whole registers but the last",
+		"cbuffer Arrays { float arr[3]; float tail; float4 f4[2]; float x; float2 v2[2]; };",
+		"Arrays.arr=0,36 Arrays.tail=36,4 Arrays.f4=48,32 Arrays.x=80,4 Arrays.v2=96,24 Arrays=128" },
+
+	{ "matrices take a register per column, or per row if row_major",
+		"cbuffer Matrices\n"
+		"{\n"
+		"	float4x4 m; float a;\n"
+		"	row_major float3x4 rm; float b;\n"
+		"	float3x3 cm; float c;\n"
+		"	float2x3 cm23;\n"
+		"	row_major float2x3 rm23;\n"
+		"	matrix<float, 2, 2> m22; float d;\n"
+		"};",
+		"Matrices.m=0,64 Matrices.a=64,4 Matrices.rm=80,48 Matrices.b=128,4 Matrices.cm=144,44 Matrices.c=188,4 "
+		"Matrices.cm23=192,40 Matrices.rm23=240,28 Matrices.m22=272,24 Matrices.d=296,4 Matrices=304" },
+
+	{ "structs start a register, and so does what follows them",
+		"struct Inner { float2 a; float b; };\n"
+		"struct Outer { Inner i; float3 v; float4x4 m; };\n"
+		"cbuffer Structs { float x; Outer o; float y; Inner s[2]; float z; };",
+		"Inner.a=0,8 Inner.b=8,4 Inner=12 Outer.i=0,12 Outer.v=16,12 Outer.m=32,64 Outer=96 "
+		"Structs.x=0,4 Structs.o=16,96 Structs.y=112,4 Structs.s=128,28 Structs.z=160,4 Structs=176" },
+
+	{ "comments, preprocessor lines, semantics and code are skipped",
+		"// cbuffer Comment { float x; };\n"
+		"/* cbuffer Block { float y; }; */\n"
+		"#define MACRO cbuffer Macro { float z; };\n"
+		"struct VertexToPixel { float4 position : SV_POSITION; float2 uv : TEXCOORD0; };\n"
+		"cbuffer Real : register(b1) { uniform float a = 1.0f; const float3 b; };\n"
+		"float4 main(VertexToPixel input) : SV_TARGET { float3 c = { 1, 2, 3 }; return float4(c, a); }\n",
+		"!Comment !Block !Macro Real@1 Real.a=0,4 Real.b=4,12 Real=16" },
+
+	{ "the per-frame lights",
+		"struct DirectionalLight { float4 AmbientColor; float4 DiffuseColor; float3 Direction; };\n"
+		"cbuffer perFrame : register(b0) { DirectionalLight light1; DirectionalLight light2; };",
+		"DirectionalLight=44 perFrame.light1=0,44 perFrame.light2=48,44 perFrame=96" },
+};
+
+// A shader that must be refused, where, and why.
+struct ErrorCase
+{
+	const char* name;
+	const char* source;
+	unsigned int line;
+	const char* message;	// Part of it.
+};
+
+static const ErrorCase ERROR_CASES[] =
+{
+	{ "packoffset", "cbuffer A\n{\n\tfloat4 x : packoffset(c0);\n};", 3, "'packoffset' isn't supported" },
+	{ "double", "cbuffer A\n{\n\tdouble d;\n};", 3, "'double' isn't supported" },
+	{ "unknown type", "cbuffer A { Foo f; };", 1, "unknown type 'Foo'" },
+	{ "empty cbuffer", "\ncbuffer A { };", 2, "cbuffer 'A' is empty" },
+	{ "multi-dimensional array", "cbuffer A { float a[2][2]; };", 1, "multi-dimensional arrays aren't supported" },
+	{ "texture register", "cbuffer A : register(t0) { float a; };", 1, "expected a b register, found 't0'" },
+	{ "unfinished", "cbuffer A { float a", 1, "before the end of the file" },
+	{ "static", "cbuffer A { static float a; };", 1, "'static' variables aren't in the constant buffer" },
+	{ "packed into array padding", "cbuffer A\n{\n\tfloat2 arr[2];\n\tfloat2 tail;\n};", 4, "'tail' is packed into the padding of 'arr'" },
+};
+
+// A shader and lines its generated C++ must contain,
+// separated by '|'.
+struct HeaderCase
+{
+	const char* name;
+	const char* source;
+	const char* expected;
+};
+
+static const HeaderCase HEADER_CASES[] =
+{
+	{ "struct members and padding",
+		"struct DirectionalLight { float4 AmbientColor; float4 DiffuseColor; float3 Direction; };\n"
+		"cbuffer perFrame : register(b0) { DirectionalLight light1; DirectionalLight light2; };",
+		"struct alignas(16) perFrame|static const int Register = 0;|DirectionalLight light1;|unsigned int padding0[1];"
+		"|static_assert(offsetof(perFrame, light2) == 48|static_assert(sizeof(perFrame) == 96" },
+
+	{ "padded array elements and matrices",
+		"cbuffer A { float arr[2]; float4 v; float3x3 cm; float4x4 m; };",
+		"struct ArrayElement|ArrayElement<float, 16> arr[2];|DirectX::XMFLOAT4 v;"
+		"|ArrayElement<DirectX::XMFLOAT3, 16> cm[3];|DirectX::XMFLOAT4X4 m;|static_assert(sizeof(A) == 160" },
+};
+
+// -----------------------------------------------
+// Static methods.
+// -----------------------------------------------
+
+/// <summary>
+/// Run every case.
+/// </summary>
+/// <returns>Returns false if any failed.</returns>
+bool SelfTest::Run()
+{
+	unsigned int cases = 0;
+	unsigned int failures = 0;
+	for (const LayoutCase& test : LAYOUT_CASES)
+	{
+		cases++;
+		failures += CheckLayout(test.name, test.source, test.expected) ? 0 : 1;
+	}
+	for (const ErrorCase& test : ERROR_CASES)
+	{
+		cases++;
+		failures += CheckError(test.name, test.source, test.line, test.message) ? 0 : 1;
+	}
+	for (const HeaderCase& test : HEADER_CASES)
+	{
+		cases++;
+		failures += CheckHeader(test.name, test.source, test.expected) ? 0 : 1;
+	}
+
+	if (failures > 0)
+		printf("CBufferGen: self-test FAILED (%u of %u cases)\n", failures, cases);
+	else
+		printf("CBufferGen: self-test passed (%u cases)\n", cases);
+	return failures == 0;
+}
+
+// -----------------------------------------------
+// Helper methods.
+// -----------------------------------------------
+
+/// <summary>
+/// Lay out a shader and compare it with the expectation.
+/// </summary>
+/// <returns>Returns false (after printing why) on any difference.</returns>
+bool SelfTest::CheckLayout(const char* name, const char* source, const char* expected)
+{
+	HlslLayout layout;
+	if (!layout.Parse(source, "self-test"))
+	{
+		printf("%s: %s\n", name, layout.GetError().c_str());
+		return false;
+	}
+
+	bool ok = true;
+	std::istringstream words(expected);
+	std::string word;
+	while (words >> word)
+	{
+		size_t dot = word.find('.');
+		size_t equals = word.find('=');
+		size_t at = word.find('@');
+		bool absent = word[0] == '!';
+		size_t start = absent ? 1 : 0;
+		std::string blockName = word.substr(start, word.find_first_of(".=@") - start);
+		const HlslLayout::Block* block = FindBlock(layout, blockName);
+
+		if (absent || !block)
+		{
+			if (absent != !block)
+			{
+				printf("%s: '%s' %s\n", name, blockName.c_str(), absent ? "was found" : "wasn't found");
+				ok = false;
+			}
+			continue;
+		}
+
+		if (at != std::string::npos)
+		{
+			int bindRegister = std::stoi(word.substr(at + 1));
+			if (block->bindRegister != bindRegister)
+			{
+				printf("%s: '%s' is in b%d, expected b%d\n", name, blockName.c_str(), block->bindRegister, bindRegister);
+				ok = false;
+			}
+		}
+		else if (dot == std::string::npos)
+		{
+			unsigned int size = (unsigned int)std::stoul(word.substr(equals + 1));
+			if (block->size != size)
+			{
+				printf("%s: '%s' is %u bytes, expected %u\n", name, blockName.c_str(), block->size, size);
+				ok = false;
+			}
+		}
+		else
+		{
+			std::string memberName = word.substr(dot + 1, equals - dot - 1);
+			size_t comma = word.find(',', equals);
+			unsigned int offset = (unsigned int)std::stoul(word.substr(equals + 1, comma - equals - 1));
+			unsigned int size = (unsigned int)std::stoul(word.substr(comma + 1));
+
+			const HlslLayout::Member* member = nullptr;
+			for (const HlslLayout::Member& candidate : block->members)
+			{
+				if (candidate.name == memberName)
+					member = &candidate;
+			}
+			if (!member)
+			{
+				printf("%s: '%s.%s' wasn't found\n", name, blockName.c_str(), memberName.c_str());
+				ok = false;
+			}
+			else if (member->offset != offset || member->size != size)
+			{
+				printf("%s: '%s.%s' is at %u (%u bytes), expected %u (%u bytes)\n", name, blockName.c_str(),
+					memberName.c_str(), member->offset, member->size, offset, size);
+				ok = false;
+			}
+		}
+	}
+	return ok;
+}
+
+/// <summary>
+/// Check a shader is refused, at the right line, for the
+/// right reason - by the parser or by the generator.
+/// </summary>
+/// <returns>Returns false (after printing why) if it isn't.</returns>
+bool SelfTest::CheckError(const char* name, const char* source, unsigned int line, const char* message)
+{
+	HlslLayout layout;
+	CBufferGenerator generator;
+	std::string error;
+	if (!layout.Parse(source, "self-test"))
+		error = layout.GetError();
+	else if (!generator.AddShader("Test", "self-test", layout))
+		error = generator.GetError();
+
+	std::string where = "self-test(" + std::to_string(line) + "): error: ";
+	if (error.compare(0, where.size(), where) != 0 || error.find(message) == std::string::npos)
+	{
+		printf("%s: expected \"%s%s\", got \"%s\"\n", name, where.c_str(), message,
+			error.empty() ? "no error" : error.c_str());
+		return false;
+	}
+	return true;
+}
+
+/// <summary>
+/// Generate the C++ for a shader and look for each expected line.
+/// </summary>
+/// <returns>Returns false (after printing why) if any is missing.</returns>
+bool SelfTest::CheckHeader(const char* name, const char* source, const char* expected)
+{
+	HlslLayout layout;
+	CBufferGenerator generator;
+	if (!layout.Parse(source, "self-test") || !generator.AddShader("Test", "self-test", layout))
+	{
+		printf("%s: %s\n", name, layout.GetError().empty() ? generator.GetError().c_str() : layout.GetError().c_str());
+		return false;
+	}
+
+	std::string header = generator.GetHeader();
+	bool ok = true;
+	std::istringstream lines(expected);
+	std::string line;
+	while (std::getline(lines, line, '|'))
+	{
+		if (header.find(line) == std::string::npos)
+		{
+			printf("%s: the header has no \"%s\"\n", name, line.c_str());
+			ok = false;
+		}
+	}
+	return ok;
+}
+
+/// <summary>
+/// A struct or cbuffer by name, or null.
+/// </summary>
+const HlslLayout::Block* SelfTest::FindBlock(const HlslLayout& layout, const std::string& name)
+{
+	for (const HlslLayout::Block& block : layout.GetStructs())
+	{
+		if (block.name == name)
+			return &block;
+	}
+	for (const HlslLayout::Block& block : layout.GetBuffers())
+	{
+		if (block.name == name)
+			return &block;
+	}
+	return nullptr;
+}
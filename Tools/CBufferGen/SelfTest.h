@@ -0,0 +1,41 @@
+#pragma once
+
+// -----------------------------------------------
+// Include statements.
+// -----------------------------------------------
+#include "HlslLayout.h"
+#include <string>
+
+// -----------------------------------------------
+// SelfTest.h
+// ---
+// "CBufferGen --self-test": lays out a set of
+// made up shaders and compares every offset and
+// size against what fxc gives them, checks each
+// kind of declaration that should be refused is
+// refused at the right line, and checks the
+// generated C++ for a couple of them. The cases
+// are written into SelfTest.cpp, so it needs no
+// files and runs wherever the tool builds.
+// -----------------------------------------------
+
+class SelfTest
+{
+public:
+	// -----------------------------------------------
+	// Static methods.
+	// -----------------------------------------------
+
+	static bool Run();	// Prints each failure, then a summary. False if anything failed.
+
+private:
+
+	// -----------------------------------------------
+	// Helper methods.
+	// -----------------------------------------------
+
+	static bool CheckLayout(const char* name, const char* source, const char* expected);
+	static bool CheckError(const char* name, const char* source, unsigned int line, const char* message);
+	static bool CheckHeader(const char* name, const char* source, const char* expected);
+	static const HlslLayout::Block* FindBlock(const HlslLayout& layout, const std::string& name);
+};
@@ -0,0 +1,178 @@
+#include "SceneFile.h"
+#include "SoftwareRasterizer.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+// A channel can be this far from the reference without the
+// pixel counting as different (rounding in other math
+// libraries or compilers)...
+static const int CHANNEL_TOLERANCE = 3;
+
+// ...and this many pixels in a thousand can differ (edge
+// pixels that land on the other side of a triangle edge).
+static const unsigned int DIFFERENT_PER_THOUSAND = 1;
+
+// --------------------------------------------------------
+// Reads a whole file into a string
+//
+// Returns false if the file can't be opened
+// --------------------------------------------------------
+static bool ReadFile(const std::string& path, std::string* contents)
+{
+	std::ifstream file(path, std::ios::binary);
+	if (!file.is_open())
+		return false;
+
+	std::ostringstream stream;
+	stream << file.rdbuf();
+	*contents = stream.str();
+	return true;
+}
+
+// --------------------------------------------------------
+// Reads a TGA written by SoftwareRasterizer::SaveTGA (32 bit,
+// uncompressed, top left origin) as packed RGBA pixels
+//
+// Returns false if the file can't be read or is any other kind
+// --------------------------------------------------------
+static bool ReadTGA(const std::string& path, unsigned int* width, unsigned int* height, std::vector<unsigned int>* pixels)
+{
+	std::string contents;
+	if (!ReadFile(path, &contents) || contents.size() < 18)
+		return false;
+
+	const unsigned char* header = (const unsigned char*)contents.data();
+	*width = header[12] | (header[13] << 8);
+	*height = header[14] | (header[15] << 8);
+	if (header[0] != 0 || header[1] != 0 || header[2] != 2 || header[16] != 32 || header[17] != 0x28
+		|| contents.size() != 18 + (size_t)*width * *height * 4)
+		return false;
+
+	// TGA stores blue, green, red, alpha.
+	const unsigned char* source = header + 18;
+	pixels->resize((size_t)*width * *height);
+	for (size_t i = 0; i < pixels->size(); i++, source += 4)
+		(*pixels)[i] = source[2] | (source[1] << 8) | (source[0] << 16) | ((unsigned int)source[3] << 24);
+	return true;
+}
+
+// --------------------------------------------------------
+// Compares what was drawn with a reference image, printing
+// how far apart they are
+//
+// Returns false if they're different sizes, or too many
+// pixels differ by more than the tolerance
+// --------------------------------------------------------
+static bool CompareWithReference(const SoftwareRasterizer& rasterizer, const std::string& path)
+{
+	unsigned int width = 0, height = 0;
+	std::vector<unsigned int> reference;
+	if (!ReadTGA(path, &width, &height, &reference))
+	{
+		fprintf(stderr, "%s: error: can't read the reference image (a 32 bit TGA from RasterScene)\n", path.c_str());
+		return false;
+	}
+	if (width != rasterizer.GetWidth() || height != rasterizer.GetHeight())
+	{
+		fprintf(stderr, "%s: error: the reference is %ux%u, the scene is %ux%u\n",
+			path.c_str(), width, height, rasterizer.GetWidth(), rasterizer.GetHeight());
+		return false;
+	}
+
+	unsigned int different = 0;
+	int largest = 0;
+	for (unsigned int y = 0; y < height; y++)
+	{
+		const unsigned int* drawn = rasterizer.GetColorBuffer() + (size_t)y * rasterizer.GetPitch();
+		for (unsigned int x = 0; x < width; x++)
+		{
+			unsigned int a = drawn[x];
+			unsigned int b = reference[(size_t)y * width + x];
+			int difference = 0;
+			for (unsigned int shift = 0; shift < 32; shift += 8)
+			{
+				int channel = abs((int)((a >> shift) & 0xFF) - (int)((b >> shift) & 0xFF));
+				difference = (channel > difference) ? channel : difference;
+			}
+			largest = (difference > largest) ? difference : largest;
+			different += (difference > CHANNEL_TOLERANCE) ? 1 : 0;
+		}
+	}
+
+	unsigned long long allowed = (unsigned long long)width * height * DIFFERENT_PER_THOUSAND / 1000;
+	bool passed = different <= allowed;
+	printf("RasterScene: %u of %u pixels differ from %s (%llu allowed), by at most %d: %s\n",
+		different, width * height, path.c_str(), allowed, largest, passed ? "ok" : "FAILED");
+	return passed;
+}
+
+// --------------------------------------------------------
+// Entry point
+//
+// RasterScene <scene.txt> -o <image.tga> [--threads N] [--compare <reference.tga>]
+//
+// Draws a scene file (see SceneFile.h) with the software
+// rasterizer and saves it.  With --compare, the image must
+// also match a reference, so a change to the rasterizer can
+// be checked on any machine, with no GPU or window.
+// --------------------------------------------------------
+int main(int argc, char* argv[])
+{
+	std::string input;
+	std::string output;
+	std::string reference;
+	unsigned int threads = WorkerPool::DEFAULT_THREADS;
+	bool extra = false;
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "-o") == 0 && i + 1 < argc)
+			output = argv[++i];
+		else if (strcmp(argv[i], "--compare") == 0 && i + 1 < argc)
+			reference = argv[++i];
+		else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+			threads = (unsigned int)strtoul(argv[++i], nullptr, 10);
+		else if (input.empty())
+			input = argv[i];
+		else
+			extra = true;
+	}
+
+	if (input.empty() || output.empty() || extra)
+	{
+		fprintf(stderr, "usage: RasterScene <scene.txt> -o <image.tga> [--threads N] [--compare <reference.tga>]\n");
+		return 2;
+	}
+
+	std::string source;
+	if (!ReadFile(input, &source))
+	{
+		fprintf(stderr, "%s: error: can't read the file\n", input.c_str());
+		return 1;
+	}
+
+	SceneFile scene;
+	if (!scene.Parse(source, input))
+	{
+		fprintf(stderr, "%s\n", scene.GetError().c_str());
+		return 1;
+	}
+
+	SoftwareRasterizer rasterizer(threads);
+	scene.Draw(&rasterizer);
+	if (!rasterizer.SaveTGA(output))
+	{
+		fprintf(stderr, "%s: error: can't write the file\n", output.c_str());
+		return 1;
+	}
+
+	const SoftwareRasterizer::Statistics& stats = rasterizer.GetStatistics();
+	printf("RasterScene: wrote %s (%ux%u, %u cubes, %u triangles rasterized, %llu pixels shaded)\n",
+		output.c_str(), scene.GetWidth(), scene.GetHeight(), (unsigned int)scene.GetCubes().size(), stats.rasterized, stats.pixels);
+
+	if (!reference.empty() && !CompareWithReference(rasterizer, reference))
+		return 1;
+	return 0;
+}
@@ -0,0 +1,248 @@
+// -----------------------------------------------
+// Include statements.
+// -----------------------------------------------
+#include "SceneFile.h"
+#include <cmath>
+#include <sstream>
+
+using namespace DirectX;
+
+// -----------------------------------------------
+// Constants.
+// -----------------------------------------------
+
+// Largest image a scene can ask for.
+static const unsigned int MAX_SIZE = 8192;
+
+// The game's clip planes.
+static const float NEAR_PLANE = 0.1f;
+static const float FAR_PLANE = 100.0f;
+
+// A unit cube, 12 triangles, with corner normals (smooth
+// shaded), as the SoftwareRaster benchmark draws.
+static const XMFLOAT3 CUBE_POSITIONS[8] = {
+	XMFLOAT3(-0.5f, -0.5f, -0.5f), XMFLOAT3(0.5f, -0.5f, -0.5f), XMFLOAT3(0.5f, 0.5f, -0.5f), XMFLOAT3(-0.5f, 0.5f, -0.5f),
+	XMFLOAT3(-0.5f, -0.5f, 0.5f), XMFLOAT3(0.5f, -0.5f, 0.5f), XMFLOAT3(0.5f, 0.5f, 0.5f), XMFLOAT3(-0.5f, 0.5f, 0.5f)
+};
+static const unsigned int CUBE_INDICES[36] = {
+	0, 2, 1, 0, 3, 2,	4, 5, 6, 4, 6, 7,	0, 1, 5, 0, 5, 4,
+	3, 6, 2, 3, 7, 6,	0, 4, 7, 0, 7, 3,	1, 2, 6, 1, 6, 5
+};
+
+// Read exactly count numbers from the rest of a line.
+static bool ReadNumbers(std::istringstream& line, float* numbers, unsigned int count)
+{
+	for (unsigned int i = 0; i < count; i++)
+	{
+		if (!(line >> numbers[i]) || !std::isfinite(numbers[i]))
+			return false;
+	}
+	std::string extra;
+	return !(line >> extra);
+}
+
+// -----------------------------------------------
+// Constructors.
+// -----------------------------------------------
+
+/// <summary>
+/// Start with an empty scene.
+/// </summary>
+SceneFile::SceneFile()
+{
+	Reset();
+}
+
+// -----------------------------------------------
+// Accessors.
+// -----------------------------------------------
+
+/// <summary>
+/// Image width the scene asks for.
+/// </summary>
+unsigned int SceneFile::GetWidth() const
+{
+	return width;
+}
+
+/// <summary>
+/// Image height the scene asks for.
+/// </summary>
+unsigned int SceneFile::GetHeight() const
+{
+	return height;
+}
+
+/// <summary>
+/// Cubes the last Parse() found, in file order.
+/// </summary>
+const std::vector<SceneFile::Cube>& SceneFile::GetCubes() const
+{
+	return cubes;
+}
+
+/// <summary>
+/// Why the last Parse() failed, as "file(line): error: message".
+/// </summary>
+const std::string& SceneFile::GetError() const
+{
+	return error;
+}
+
+// -----------------------------------------------
+// Service methods.
+// -----------------------------------------------
+
+/// <summary>
+/// Read a scene (see SceneFile.h for the statements).
+/// </summary>
+/// <param name="source">The file's contents.</param>
+/// <param name="fileName">Used in error messages.</param>
+/// <returns>Returns false (see GetError()) on the first line it can't read.</returns>
+bool SceneFile::Parse(const std::string& source, const std::string& fileName)
+{
+	Reset();
+
+	std::istringstream lines(source);
+	std::string text;
+	for (unsigned int number = 1; std::getline(lines, text); number++)
+	{
+		size_t comment = text.find('#');
+		if (comment != std::string::npos)
+			text.erase(comment);
+
+		std::istringstream line(text);
+		std::string keyword;
+		if (!(line >> keyword))
+			continue;
+
+		float values[12];
+		if (keyword == "size")
+		{
+			if (!ReadNumbers(line, values, 2))
+				return Fail(fileName, number, "expected 'size WIDTH HEIGHT'");
+			if (values[0] < 1.0f || values[1] < 1.0f || values[0] > MAX_SIZE || values[1] > MAX_SIZE
+				|| values[0] != std::floor(values[0]) || values[1] != std::floor(values[1]))
+				return Fail(fileName, number, "the size must be whole pixels, from 1 to " + std::to_string(MAX_SIZE));
+			width = (unsigned int)values[0];
+			height = (unsigned int)values[1];
+		}
+		else if (keyword == "camera")
+		{
+			if (!ReadNumbers(line, values, 7))
+				return Fail(fileName, number, "expected 'camera X Y Z DX DY DZ FOV'");
+
+			// y is up, so the camera can't look straight along it.
+			if (values[3] == 0.0f && values[5] == 0.0f)
+				return Fail(fileName, number, "the camera can't look straight up or down");
+			if (values[6] <= 0.0f || values[6] >= 180.0f)
+				return Fail(fileName, number, "the field of view must be between 0 and 180 degrees");
+			cameraPosition = XMFLOAT3(values[0], values[1], values[2]);
+			cameraDirection = XMFLOAT3(values[3], values[4], values[5]);
+			fieldOfView = values[6];
+		}
+		else if (keyword == "clear")
+		{
+			if (!ReadNumbers(line, values, 3))
+				return Fail(fileName, number, "expected 'clear R G B'");
+			clearColor[0] = values[0];
+			clearColor[1] = values[1];
+			clearColor[2] = values[2];
+		}
+		else if (keyword == "light")
+		{
+			if (!ReadNumbers(line, values, 9))
+				return Fail(fileName, number, "expected 'light AR AG AB DR DG DB DX DY DZ'");
+			if (lights.size() == 2)
+				return Fail(fileName, number, "a scene has at most two lights");
+			if (values[6] == 0.0f && values[7] == 0.0f && values[8] == 0.0f)
+				return Fail(fileName, number, "the light has no direction");
+			DirectionalLight light = {
+				XMFLOAT4(values[0], values[1], values[2], 1.0f),
+				XMFLOAT4(values[3], values[4], values[5], 1.0f),
+				XMFLOAT3(values[6], values[7], values[8]) };
+			lights.push_back(light);
+		}
+		else if (keyword == "cube")
+		{
+			if (!ReadNumbers(line, values, 12))
+				return Fail(fileName, number, "expected 'cube X Y Z PITCH YAW ROLL SX SY SZ R G B'");
+			Cube cube;
+			cube.position = XMFLOAT3(values[0], values[1], values[2]);
+			cube.rotation = XMFLOAT3(values[3], values[4], values[5]);
+			cube.scale = XMFLOAT3(values[6], values[7], values[8]);
+			cube.surface = XMFLOAT4(values[9], values[10], values[11], 1.0f);
+			cubes.push_back(cube);
+		}
+		else
+		{
+			return Fail(fileName, number, "unknown statement '" + keyword + "'");
+		}
+	}
+
+	return true;
+}
+
+/// <summary>
+/// Draw the scene: resize the rasterizer to the scene's
+/// size, then draw and render one frame.
+/// </summary>
+void SceneFile::Draw(SoftwareRasterizer* rasterizer) const
+{
+	XMFLOAT3 normals[8];
+	for (unsigned int v = 0; v < 8; v++)
+		XMStoreFloat3(&normals[v], XMVector3Normalize(XMLoadFloat3(&CUBE_POSITIONS[v])));
+
+	// Missing lights add nothing.
+	const DirectionalLight black = { XMFLOAT4(0.0f, 0.0f, 0.0f, 1.0f), XMFLOAT4(0.0f, 0.0f, 0.0f, 1.0f), XMFLOAT3(0.0f, 0.0f, 1.0f) };
+	const DirectionalLight& light1 = (lights.size() > 0) ? lights[0] : black;
+	const DirectionalLight& light2 = (lights.size() > 1) ? lights[1] : black;
+
+	XMMATRIX view = XMMatrixLookToLH(XMLoadFloat3(&cameraPosition), XMLoadFloat3(&cameraDirection), XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f));
+	XMMATRIX projection = XMMatrixPerspectiveFovLH(XMConvertToRadians(fieldOfView), (float)width / height, NEAR_PLANE, FAR_PLANE);
+
+	rasterizer->Resize(width, height);
+	rasterizer->BeginFrame(XMMatrixMultiply(view, projection), light1, light2, clearColor);
+	for (const Cube& cube : cubes)
+	{
+		XMMATRIX world = XMMatrixMultiply(
+			XMMatrixMultiply(
+				XMMatrixScaling(cube.scale.x, cube.scale.y, cube.scale.z),
+				XMMatrixRotationRollPitchYaw(XMConvertToRadians(cube.rotation.x), XMConvertToRadians(cube.rotation.y), XMConvertToRadians(cube.rotation.z))),
+			XMMatrixTranslation(cube.position.x, cube.position.y, cube.position.z));
+		rasterizer->DrawMesh(CUBE_POSITIONS, normals, CUBE_INDICES, 36, world, cube.surface);
+	}
+	rasterizer->Render();
+}
+
+// -----------------------------------------------
+// Helper methods.
+// -----------------------------------------------
+
+/// <summary>
+/// Go back to the defaults: 640x360, looking along z from
+/// 5 units back, a black background and no lights or cubes.
+/// </summary>
+void SceneFile::Reset()
+{
+	width = 640;
+	height = 360;
+	cameraPosition = XMFLOAT3(0.0f, 0.0f, -5.0f);
+	cameraDirection = XMFLOAT3(0.0f, 0.0f, 1.0f);
+	fieldOfView = 45.0f;
+	clearColor[0] = clearColor[1] = clearColor[2] = 0.0f;
+	clearColor[3] = 1.0f;
+	lights.clear();
+	cubes.clear();
+	error.clear();
+}
+
+/// <summary>
+/// Record an error at a line.
+/// </summary>
+/// <returns>Returns false, to be returned in turn.</returns>
+bool SceneFile::Fail(const std::string& fileName, unsigned int line, const std::string& message)
+{
+	error = fileName + "(" + std::to_string(line) + "): error: " + message;
+	return false;
+}
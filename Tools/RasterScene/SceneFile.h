@@ -0,0 +1,100 @@
+#pragma once
+
+// -----------------------------------------------
+// Include statements.
+// -----------------------------------------------
+#include "Lights.h"
+#include "SoftwareRasterizer.h"
+#include <DirectXMath.h>
+#include <string>
+#include <vector>
+
+// -----------------------------------------------
+// SceneFile.h
+// ---
+// A scene for the software rasterizer, read from
+// a small text file, one statement per line:
+//
+//   size   WIDTH HEIGHT
+//   camera X Y Z  DX DY DZ  FOV
+//   clear  R G B
+//   light  AR AG AB  DR DG DB  DX DY DZ
+//   cube   X Y Z  PITCH YAW ROLL  SX SY SZ  R G B
+//
+// The camera is at X Y Z looking along DX DY DZ
+// (y is up), with a vertical field of view in
+// degrees. Lights are the game's directional
+// lights (ambient, diffuse, direction), at most
+// two; missing ones are black. Cubes are the
+// unit cube, scaled, rotated (in degrees, as
+// XMMatrixRotationRollPitchYaw) and then moved.
+// "#" starts a comment.
+//
+// Needs no device or window, so a scene can be
+// drawn (and its image compared) anywhere the
+// rasterizer builds.
+// -----------------------------------------------
+
+class SceneFile
+{
+public:
+	// -----------------------------------------------
+	// Internal structs.
+	// -----------------------------------------------
+
+	/// <summary>
+	/// A cube, as given in the file.
+	/// </summary>
+	struct Cube
+	{
+		DirectX::XMFLOAT3 position;
+		DirectX::XMFLOAT3 rotation;		// Pitch, yaw and roll, in degrees.
+		DirectX::XMFLOAT3 scale;
+		DirectX::XMFLOAT4 surface;
+	};
+
+	// -----------------------------------------------
+	// Constructors.
+	// -----------------------------------------------
+
+	SceneFile();
+
+	// -----------------------------------------------
+	// Accessors.
+	// -----------------------------------------------
+
+	unsigned int GetWidth() const;
+	unsigned int GetHeight() const;
+	const std::vector<Cube>& GetCubes() const;
+	const std::string& GetError() const;	// "file(line): error: message", from the last failed Parse().
+
+	// -----------------------------------------------
+	// Service methods.
+	// -----------------------------------------------
+
+	bool Parse(const std::string& source, const std::string& fileName);	// Replaces what was parsed before.
+	void Draw(SoftwareRasterizer* rasterizer) const;	// Resizes it, then draws one frame.
+
+private:
+
+	// -----------------------------------------------
+	// Data members.
+	// -----------------------------------------------
+
+	unsigned int width;
+	unsigned int height;
+	DirectX::XMFLOAT3 cameraPosition;
+	DirectX::XMFLOAT3 cameraDirection;
+	float fieldOfView;					// Vertical, in degrees.
+	float clearColor[4];
+	std::vector<DirectionalLight> lights;
+	std::vector<Cube> cubes;
+	std::string error;
+
+	// -----------------------------------------------
+	// Helper methods.
+	// -----------------------------------------------
+
+	void Reset();
+	bool Fail(const std::string& fileName, unsigned int line, const std::string& message);
+};